@@ -4,6 +4,15 @@ namespace lra::bus {  // no logunit should be used
 
 // CRTP Impl
 bool I2c::InitImpl(const I2cInit_S& init_s) {
+  if (init_s.mock_ioctl_) {  // fake i2c-dev, no device node
+    I2cResetThisBus();
+    mock_ioctl_ = init_s.mock_ioctl_;
+    name_ = init_s.name_;
+    I2cUpdateThisBusFunc();
+    speed_ = 0;
+    return true;
+  }
+
   if (InitImpl(init_s.name_)) {
     // TODO: Init other param
     return true;
@@ -58,6 +67,68 @@ void I2c::I2cResetThisBus() {
   func_ = -1;
   name_ = "";
   last_slave_addr_ = 0;
+  mock_ioctl_ = nullptr;
+}
+
+ssize_t I2c::Commit(I2cBatch& batch) {
+  if (batch.overflow_) return -1;
+  if (batch.n_msgs_ == 0) return 0;
+
+  const bool mangling = func_ & I2C_FUNC_PROTOCOL_MANGLING;
+  ssize_t total = 0;
+  uint16_t start = 0;
+
+  for (uint16_t i = 0; i < batch.n_msgs_; i++) {
+    i2c_msg& msg = batch.msgs_[i];
+    const bool last = (i == batch.n_msgs_ - 1);
+
+    msg.flags &= ~I2C_M_STOP;
+    if (batch.stop_after_[i] && mangling && !last) msg.flags |= I2C_M_STOP;
+
+    total += msg.len;
+
+    // cut at the end, or where a STOP is required and the adapter can't place it inside one transfer
+    if (last || (batch.stop_after_[i] && !mangling)) {
+      i2c_rdwr_ioctl_data data{.msgs = batch.msgs_ + start, .nmsgs = (uint32_t)(i - start + 1)};
+      if (I2cIoctl(I2C_RDWR, &data) < 0) return -1;
+      start = i + 1;
+    }
+  }
+
+  return total;
+}
+
+// smbus functions, same as i2c-tools smbus.c
+
+__s32 I2c::SmbusAccess(char read_write, uint8_t command, int size, i2c_smbus_data* data) {
+  i2c_smbus_ioctl_data args{.read_write = (__u8)read_write, .command = command, .size = (__u32)size, .data = data};
+  return I2cIoctl(I2C_SMBUS, &args);
+}
+
+__s32 I2c::SmbusReadByte() {
+  i2c_smbus_data data;
+  if (SmbusAccess(I2C_SMBUS_READ, 0, I2C_SMBUS_BYTE, &data)) return -1;
+  return 0x0FF & data.byte;
+}
+
+__s32 I2c::SmbusWriteByte(uint8_t value) { return SmbusAccess(I2C_SMBUS_WRITE, value, I2C_SMBUS_BYTE, nullptr); }
+
+__s32 I2c::SmbusReadI2cBlock(uint8_t command, uint8_t len, uint8_t* values) {
+  i2c_smbus_data data;
+  if (len > I2C_SMBUS_BLOCK_MAX) len = I2C_SMBUS_BLOCK_MAX;
+  data.block[0] = len;
+  if (SmbusAccess(I2C_SMBUS_READ, command, (len == 32) ? I2C_SMBUS_I2C_BLOCK_BROKEN : I2C_SMBUS_I2C_BLOCK_DATA, &data))
+    return -1;
+  memcpy(values, data.block + 1, data.block[0]);
+  return data.block[0];
+}
+
+__s32 I2c::SmbusWriteI2cBlock(uint8_t command, uint8_t len, const uint8_t* values) {
+  i2c_smbus_data data;
+  if (len > I2C_SMBUS_BLOCK_MAX) len = I2C_SMBUS_BLOCK_MAX;
+  memcpy(data.block + 1, values, len);
+  data.block[0] = len;
+  return SmbusAccess(I2C_SMBUS_WRITE, command, I2C_SMBUS_I2C_BLOCK_BROKEN, &data);
 }
 
 // i2c sub functions
@@ -69,7 +140,7 @@ uint64_t I2c::I2cUpdateThisBusFunc() {
   // if we use uint32_t, we get stack failed
   uint64_t funcs = 0;
 
-  if (ioctl(fd_, I2C_FUNCS, &funcs)) {  // successful return 0
+  if (I2cIoctl(I2C_FUNCS, &funcs)) {  // successful return 0
     return -1;
   }
 
@@ -6,12 +6,14 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
-#include <i2c/smbus.h>
 #include <linux/i2c-dev.h>
+#include <linux/i2c.h>
 #ifdef __cplusplus
 }
 #endif
 
+#include <cstring>
+#include <functional>
 #include <memory>
 #include <string_view>
 
@@ -23,6 +25,9 @@ namespace lra::bus {
 
 struct I2cInit_S {
   const char* name_;
+
+  // fake i2c-dev, if set no device is opened and every ioctl (I2C_FUNCS, I2C_SLAVE, I2C_SMBUS, I2C_RDWR) goes here
+  std::function<int(unsigned long, void*)> mock_ioctl_{nullptr};
 };
 
 // corresponding type for smbus to i2c_rdwr_ioctl_data
@@ -34,6 +39,82 @@ struct i2c_rdwr_smbus_data {
   uint8_t* value_{nullptr};
 };
 
+/**
+ * @brief i2c_msg queue sent by I2c::Commit, as few I2C_RDWR ioctls as the adapter allows
+ *
+ * @note
+ *   1. Messages of one I2C_RDWR are joined by repeated START, STOP only comes at the end.
+ *   2. Some devices act on STOP only, e.g. TCA9548A switches channel after STOP, queue them with stop_after.
+ *      With I2C_FUNC_PROTOCOL_MANGLING the message gets I2C_M_STOP and the batch stays in one ioctl,
+ *      otherwise the batch is split after it (bcm2835 has no protocol mangling).
+ *   3. Write data is copied into the batch arena, read buffers are filled in place on Commit.
+ */
+class I2cBatch {
+ public:
+  static constexpr uint16_t kMaxMsgs = I2C_RDWR_IOCTL_MAX_MSGS;  // 42, kernel limit per I2C_RDWR
+  static constexpr uint16_t kArenaBytes = 512;
+
+  // copy iaddr (big-endian, iaddr_bytes) + val into the arena
+  bool AddWrite(uint16_t addr, uint16_t flags, uint32_t iaddr, uint8_t iaddr_bytes, const uint8_t* val, uint16_t len,
+                bool stop_after = false) {
+    if (n_msgs_ >= kMaxMsgs || arena_used_ + iaddr_bytes + len > kArenaBytes || iaddr_bytes > sizeof(uint32_t)) {
+      overflow_ = true;
+      return false;
+    }
+
+    uint8_t* buf = arena_ + arena_used_;
+    for (int16_t i = iaddr_bytes - 1; i >= 0; i--) {
+      buf[i] = (uint8_t)iaddr;
+      iaddr >>= 8;
+    }
+    if (len) memcpy(buf + iaddr_bytes, val, len);
+    arena_used_ += iaddr_bytes + len;
+
+    Push(addr, flags, buf, iaddr_bytes + len, stop_after);
+    return true;
+  }
+
+  // write iaddr then read len bytes into val
+  bool AddRead(uint16_t addr, uint16_t flags, uint32_t iaddr, uint8_t iaddr_bytes, uint8_t* val, uint16_t len) {
+    if (n_msgs_ + (iaddr_bytes ? 2 : 1) > kMaxMsgs) {
+      overflow_ = true;
+      return false;
+    }
+    if (iaddr_bytes && !AddWrite(addr, flags, iaddr, iaddr_bytes, nullptr, 0)) return false;
+
+    Push(addr, flags | I2C_M_RD, val, len, false);
+    return true;
+  }
+
+  inline void Clear() {
+    n_msgs_ = 0;
+    arena_used_ = 0;
+    overflow_ = false;
+  }
+
+  inline uint16_t Size() const { return n_msgs_; }
+
+  inline bool Empty() const { return n_msgs_ == 0; }
+
+  inline bool Overflow() const { return overflow_; }
+
+ private:
+  friend class I2c;
+
+  i2c_msg msgs_[kMaxMsgs];
+  bool stop_after_[kMaxMsgs];
+  uint8_t arena_[kArenaBytes];
+  uint16_t n_msgs_{0};
+  uint16_t arena_used_{0};
+  bool overflow_{false};
+
+  inline void Push(uint16_t addr, uint16_t flags, uint8_t* buf, uint16_t len, bool stop_after) {
+    msgs_[n_msgs_] = i2c_msg{.addr = addr, .flags = flags, .len = len, .buf = buf};
+    stop_after_[n_msgs_] = stop_after;
+    n_msgs_++;
+  }
+};
+
 class I2c : public Bus<I2c> {
  public:
   // vars
@@ -41,12 +122,21 @@ class I2c : public Bus<I2c> {
   uint64_t func_{0};   // from ioctl(fd, I2C_FUNC, &funcs); // uint32_t
   uint32_t speed_{0};  // 0 for unknown, invalid
   const char* name_{""};
+  uint64_t ioctl_count_{0};  // every ioctl issued on this bus, including I2C_SLAVE
 
   // enum
   enum class I2cMethod { kPlain, kSmbus };
 
   ~I2c();
 
+  /**
+   * @brief send queued messages, one I2C_RDWR if protocol mangling is supported or no STOP is requested inside
+   *
+   * @param batch
+   * @return ssize_t total bytes of all messages, -1 for failure (messages before the failed ioctl were sent)
+   */
+  ssize_t Commit(I2cBatch& batch);
+
  private:
   // let base class becomes friend to use impl func
   friend Bus;
@@ -99,6 +189,7 @@ class I2c : public Bus<I2c> {
   // I2C_SLAVE is independent for each open fd:
   // https://stackoverflow.com/questions/41172797/linuxs-i2c-dev-interface-with-multiple-processes
   uint16_t last_slave_addr_{0};
+  std::function<int(unsigned long, void*)> mock_ioctl_{nullptr};
 
   // i2c core function
 
@@ -116,6 +207,12 @@ class I2c : public Bus<I2c> {
 
   void I2cResetThisBus();
 
+  // all ioctls go through here, counted and redirected to mock_ioctl_ if set
+  inline int I2cIoctl(unsigned long request, void* arg) {
+    ioctl_count_++;
+    return mock_ioctl_ ? mock_ioctl_(request, arg) : ioctl(fd_, request, arg);
+  }
+
   template <typename T>
     requires std::same_as<std::remove_const_t<T>, i2c_rdwr_ioctl_data>
   ssize_t PlainRW(T* data) {
@@ -135,7 +232,7 @@ class I2c : public Bus<I2c> {
     spdlog::fmt_lib::print("\n\n");
     return data->msgs[data->nmsgs - 1].len;
 #else
-    if (ioctl(fd_, I2C_RDWR, (unsigned long)data) < 0) {
+    if (I2cIoctl(I2C_RDWR, (void*)data) < 0) {
       return -1;
     }
 
@@ -158,7 +255,7 @@ class I2c : public Bus<I2c> {
     requires std::same_as<std::remove_const_t<T>, i2c_rdwr_smbus_data>
   ssize_t SmbusRW(T* data) {
     if (last_slave_addr_ != data->slave_addr_) {  // change to target slave device
-      if (ioctl(fd_, I2C_SLAVE, data->slave_addr_) < 0) return -1;
+      if (I2cIoctl(I2C_SLAVE, (void*)(unsigned long)data->slave_addr_) < 0) return -1;
       last_slave_addr_ = data->slave_addr_;
     }
 
@@ -166,7 +263,7 @@ class I2c : public Bus<I2c> {
       // Assume no internal address -> only one register
       if (data->no_internal_reg_) {
         if (data->len_ == 1) {
-          __s32 val = i2c_smbus_read_byte(fd_);
+          __s32 val = SmbusReadByte();
           if (val > -1) *(data->value_) = val;
           return (val > -1) ? 1 : val /*errno*/;
         } else {
@@ -176,13 +273,13 @@ class I2c : public Bus<I2c> {
         }
 
       } else
-        return i2c_smbus_read_i2c_block_data(fd_, data->command_, data->len_, data->value_);
+        return SmbusReadI2cBlock(data->command_, data->len_, data->value_);
 
     } else {  // write
       // Assume no internal address -> only one register
       if (data->no_internal_reg_) {
         if (data->len_ == 1) {
-          __s32 val = i2c_smbus_write_byte(fd_, *(data->value_));
+          __s32 val = SmbusWriteByte(*(data->value_));
           return (val > -1) ? 1 : val /*errno*/;
         } else {
           assert(data->len_ == 1 &&
@@ -191,10 +288,21 @@ class I2c : public Bus<I2c> {
         }
 
       } else
-        return i2c_smbus_write_i2c_block_data(fd_, data->command_, data->len_, data->value_);
+        return SmbusWriteI2cBlock(data->command_, data->len_, data->value_);
     }
   }
 
+  // smbus transfers as in i2c-tools smbus.c, but through I2cIoctl
+  __s32 SmbusAccess(char read_write, uint8_t command, int size, i2c_smbus_data* data);
+
+  __s32 SmbusReadByte();
+
+  __s32 SmbusWriteByte(uint8_t value);
+
+  __s32 SmbusReadI2cBlock(uint8_t command, uint8_t len, uint8_t* values);
+
+  __s32 SmbusWriteI2cBlock(uint8_t command, uint8_t len, const uint8_t* values);
+
   // i2c sub functions
 
   /**
@@ -0,0 +1,112 @@
+#include <bus/spi/spi.h>
+
+#include <cstring>
+
+namespace lra::bus {  // no logunit should be used
+
+// CRTP Impl
+bool Spi::InitImpl(const char* bus_name) {
+  SpiInit_S s;
+  s.name_ = bus_name;
+  return InitImpl(s);
+}
+
+bool Spi::InitImpl(const SpiInit_S& init_s) {
+  SpiResetThisBus();
+
+  if (init_s.mock_xfer_) {  // no device
+    mock_xfer_ = init_s.mock_xfer_;
+    name_ = init_s.name_;
+    mode_ = init_s.mode_;
+    bits_per_word_ = init_s.bits_per_word_;
+    speed_hz_ = init_s.speed_hz_;
+    return true;
+  }
+
+  int fd = SpiOpen(init_s.name_);
+  if (fd < 0) {  // failed
+    return false;
+  }
+
+  fd_ = fd;
+  name_ = init_s.name_;
+
+  if (!SpiConfig(init_s.mode_, init_s.bits_per_word_, init_s.speed_hz_)) {
+    SpiResetThisBus();
+    return false;
+  }
+  return true;
+}
+
+// spi core functions
+int Spi::SpiOpen(const char* bus_name) {
+  int fd;
+
+  // Open spidev device
+  if ((fd = open(bus_name, O_RDWR)) == -1) {
+    return -1;
+  }
+  return fd;
+}
+
+void Spi::SpiClose(int fd) {
+  if (fd >= 0 && FdValid(fd)) {
+    close(fd);
+  }
+}
+
+void Spi::SpiResetThisBus() {
+  SpiClose(fd_);
+  fd_ = -1;
+  mode_ = 0;
+  bits_per_word_ = 0;
+  speed_hz_ = 0;
+  name_ = "";
+  mock_xfer_ = nullptr;
+}
+
+bool Spi::SpiConfig(uint8_t mode, uint8_t bits_per_word, uint32_t speed_hz) {
+  if (ioctl(fd_, SPI_IOC_WR_MODE, &mode) < 0) return false;
+  if (ioctl(fd_, SPI_IOC_WR_BITS_PER_WORD, &bits_per_word) < 0) return false;
+  if (ioctl(fd_, SPI_IOC_WR_MAX_SPEED_HZ, &speed_hz) < 0) return false;
+
+  // driver may round speed
+  if (ioctl(fd_, SPI_IOC_RD_MODE, &mode_) < 0) return false;
+  if (ioctl(fd_, SPI_IOC_RD_BITS_PER_WORD, &bits_per_word_) < 0) return false;
+  if (ioctl(fd_, SPI_IOC_RD_MAX_SPEED_HZ, &speed_hz_) < 0) return false;
+  return true;
+}
+
+ssize_t Spi::IocXfer(const spi_ioc_transfer* xfer, uint16_t n) {
+  if (n == 0) return 0;
+  if (n > kMaxXfers) return -1;
+
+  ioctl_count_.fetch_add(1, std::memory_order_relaxed);
+
+  if (mock_xfer_) return mock_xfer_(xfer, n);
+
+  // same as SPI_IOC_MESSAGE(n) with runtime n
+  unsigned long request = _IOC(_IOC_WRITE, SPI_IOC_MAGIC, 0, SPI_MSGSIZE(n));
+  int ret = ioctl(fd_, request, xfer);
+  return (ret < 0) ? -1 : ret;  // total bytes of all segments
+}
+
+ssize_t Spi::Loopback(const spi_ioc_transfer* xfer, uint16_t n) {
+  ssize_t total = 0;
+  for (uint16_t i = 0; i < n; i++) {
+    auto tx = reinterpret_cast<const uint8_t*>(xfer[i].tx_buf);
+    auto rx = reinterpret_cast<uint8_t*>(xfer[i].rx_buf);
+    if (rx != nullptr) {
+      if (tx != nullptr)
+        memmove(rx, tx, xfer[i].len);
+      else
+        memset(rx, 0, xfer[i].len);
+    }
+    total += xfer[i].len;
+  }
+  return total;
+}
+
+// destructor
+Spi::~Spi() { SpiClose(fd_); }
+}  // namespace lra::bus
@@ -2,19 +2,118 @@
 #define LRA_BUS_SPI_H_
 
 #include <bus/bus.h>
+#include <linux/spi/spidev.h>
+
+#include <atomic>
+#include <functional>
+
+/**
+ * @notice:
+ *   1. One SPI_IOC_MESSAGE(N) ioctl is one kernel spi_sync(), segments are clocked back to back and CS stays
+ *      asserted between them unless cs_change is set. So a register burst or several register reads cost one syscall.
+ *   2. N is limited by _IOC_SIZEBITS (14): 16384 / sizeof(spi_ioc_transfer) (32 bytes) -> 512.
+ *   3. SPI_IOC_MESSAGE(N) uses sizeof(char[N]) to build the request, which needs N at compile time,
+ *      we build the same request with _IOC() for runtime N.
+ */
 
 namespace lra::bus {
-struct SpiInit_S {};
+
+struct SpiInit_S {
+  const char* name_{"/dev/spidev0.0"};
+  uint8_t mode_{SPI_MODE_0};
+  uint8_t bits_per_word_{8};
+  uint32_t speed_hz_{1000000};  // max speed, each transfer can run slower with spi_ioc_transfer.speed_hz
+
+  // mock device, if set no spidev is opened and every SPI_IOC_MESSAGE is handed to it instead, return total bytes
+  std::function<ssize_t(const spi_ioc_transfer*, uint16_t)> mock_xfer_{nullptr};
+};
 
 class Spi : public Bus<Spi> {
-  public:
+ public:
+  // vars
+  int32_t fd_{-1};
+  uint8_t mode_{0};
+  uint8_t bits_per_word_{0};
+  uint32_t speed_hz_{0};
+  const char* name_{""};
+
+  static constexpr uint16_t kMaxXfers = 512;
 
-  enum class SpiMethod {kIoc};
+  // enum
+  enum class SpiMethod { kIoc };
 
-  private:
+  Spi() = default;
+  Spi(const Spi&) = delete;  // owns fd
+  Spi& operator=(const Spi&) = delete;
+
+  ~Spi();
+
+  // number of SPI_IOC_MESSAGE issued
+  inline uint64_t GetIoctlCount() { return ioctl_count_.load(std::memory_order_relaxed); }
+
+  // MOSI wired to MISO, rx gets tx (zeros for tx_buf == 0)
+  static ssize_t Loopback(const spi_ioc_transfer* xfer, uint16_t n);
+
+ private:
+  // let base class becomes friend to use impl func
   friend Bus;
+
+  // CRTP Impl
+  bool InitImpl(const char* bus_name);
+
+  bool InitImpl(const SpiInit_S& init_s);
+
+  // single transfer, full-duplex, so write and read are the same ioctl
+  template <SpiMethod method>
+  ssize_t WriteImpl(const spi_ioc_transfer* xfer) {
+    return WriteMultiImpl<method>(xfer, 1);
+  }
+
+  template <SpiMethod method>
+  ssize_t WriteMultiImpl(const spi_ioc_transfer* xfer, uint16_t n) {
+    if constexpr (SpiMethod::kIoc == method) {
+      return IocXfer(xfer, n);
+    }
+  }
+
+  template <SpiMethod method>
+  ssize_t ReadImpl(spi_ioc_transfer* xfer) {
+    return ReadMultiImpl<method>(xfer, 1);
+  }
+
+  template <SpiMethod method>
+  ssize_t ReadMultiImpl(spi_ioc_transfer* xfer, uint16_t n) {
+    if constexpr (SpiMethod::kIoc == method) {
+      return IocXfer(xfer, n);
+    }
+  }
+
+  // vars
+  std::function<ssize_t(const spi_ioc_transfer*, uint16_t)> mock_xfer_{nullptr};
+  std::atomic<uint64_t> ioctl_count_{0};
+
+  // spi core function
+
+  /**
+   * @brief spidev open function
+   *
+   * @param bus_name
+   * @return int
+   * @details spidev nodes are /dev/spidev<bus>.<cs>, enable with dtparam=spi=on on the Pi
+   */
+  int SpiOpen(const char* bus_name);
+
+  void SpiClose(int fd);
+
+  void SpiResetThisBus();
+
+  // write mode, bits per word and max speed, then read them back
+  bool SpiConfig(uint8_t mode, uint8_t bits_per_word, uint32_t speed_hz);
+
+  // n segments in one SPI_IOC_MESSAGE(n), return total bytes or -1
+  ssize_t IocXfer(const spi_ioc_transfer* xfer, uint16_t n);
 };
 
 }  // namespace lra::bus
 
-#endif
\ No newline at end of file
+#endif
@@ -149,6 +149,39 @@ ssize_t I2cAdapter::ReadImpl(const uint64_t& iaddr, uint8_t* val, const uint16_t
   return ret_size;
 }
 
+// batch
+
+bool I2cAdapter::QueueWrite(I2cBatch& batch, const uint64_t& iaddr, const uint8_t* val, const uint16_t len,
+                            bool stop_after) {
+  if (!I2cInternalAddrCheck(info_.dev_info_->iaddr_bytes_, iaddr) || I2cPlainCheckFail()) return false;
+
+  uint16_t flags = info_.dev_info_->tenbit_ ? (info_.dev_info_->flags_ | I2C_M_TEN) : info_.dev_info_->flags_;
+  return batch.AddWrite(info_.dev_info_->addr_, flags, (uint32_t)iaddr, info_.dev_info_->iaddr_bytes_, val, len,
+                        stop_after);
+}
+
+bool I2cAdapter::QueueRead(I2cBatch& batch, const uint64_t& iaddr, uint8_t* val, const uint16_t len) {
+  if (!I2cInternalAddrCheck(info_.dev_info_->iaddr_bytes_, iaddr) || I2cPlainCheckFail()) return false;
+
+  uint16_t flags = info_.dev_info_->tenbit_ ? (info_.dev_info_->flags_ | I2C_M_TEN) : info_.dev_info_->flags_;
+  return batch.AddRead(info_.dev_info_->addr_, flags, (uint32_t)iaddr, info_.dev_info_->iaddr_bytes_, val, len);
+}
+
+bool I2cAdapter::QueueWriteRaw(I2cBatch& batch, const uint8_t* val, const uint16_t len, bool stop_after) {
+  if (I2cPlainCheckFail()) return false;
+
+  uint16_t flags = info_.dev_info_->tenbit_ ? (info_.dev_info_->flags_ | I2C_M_TEN) : info_.dev_info_->flags_;
+  return batch.AddWrite(info_.dev_info_->addr_, flags, 0, 0, val, len, stop_after);
+}
+
+ssize_t I2cAdapter::Commit(I2cBatch& batch) {
+  ssize_t ret_size = info_.bus_->Commit(batch);
+
+  if (ret_size > 0) I2cDelay(info_.delay_);
+
+  return ret_size;
+}
+
 // convert to big-endain and store into to_buf
 // e.g. covert 0x01020304 -> to_buf[0x01, 0x02, 0x03, 0x04, ...];
 void I2cAdapter::I2cInternalAddrConvert(uint32_t iaddr, uint8_t nbyte, uint8_t* to_buf) {
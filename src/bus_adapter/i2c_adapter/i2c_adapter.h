@@ -51,6 +51,7 @@
 
 namespace lra::bus_adapter::i2c {
 using ::lra::bus::I2c;
+using ::lra::bus::I2cBatch;
 using ::lra::bus::i2c_rdwr_smbus_data;
 using ::lra::device::I2cDeviceInfo;
 
@@ -80,6 +81,22 @@ class I2cAdapter : public BusAdapter<I2cAdapter> {
   // members
   I2cAdapter_S info_;
 
+  /**
+   * batch interface, plain I2C only (I2C_RDWR), whatever info_.method_ is
+   * Queue*() only fill the batch with this device's address, flags and internal address layout,
+   * messages of several devices on the same bus can share one batch, nothing is sent until Commit()
+   */
+  bool QueueWrite(I2cBatch& batch, const uint64_t& iaddr, const uint8_t* val, const uint16_t len,
+                  bool stop_after = false);
+
+  bool QueueRead(I2cBatch& batch, const uint64_t& iaddr, uint8_t* val, const uint16_t len);
+
+  // bytes without internal address, e.g. TCA9548A control byte
+  bool QueueWriteRaw(I2cBatch& batch, const uint8_t* val, const uint16_t len, bool stop_after = false);
+
+  // return total bytes of all messages, -1 for failure
+  ssize_t Commit(I2cBatch& batch);
+
  private:
   friend BusAdapter;
 
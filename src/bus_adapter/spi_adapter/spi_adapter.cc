@@ -1,43 +1,131 @@
 #include <bus_adapter/spi_adapter/spi_adapter.h>
 
-// TODO: Implement it, also spi bus
+#include <cstring>
 
 namespace lra::bus_adapter::spi {
 
+using ::lra::log_util::loglevel;
+
 ssize_t SpiAdapter::Xfer(uint8_t* val, const uint32_t& len) {
   spi_ioc_transfer xfer = GenSpiIocXfer();
 
-  // TODO: find out a better way to avoid memcpy
+  // in place, spidev copies tx into its bounce buffer before writing rx back
   xfer.len = len;
   xfer.rx_buf = (unsigned long)val;
   xfer.tx_buf = (unsigned long)val;
 
-  info_.bus_->Write<Spi::SpiMethod::kIoc>(&xfer);
+  return info_.bus_->Write<Spi::SpiMethod::kIoc>(&xfer);
 }
 
-ssize_t SpiAdapter::XferMulti(uint8_t** buf_arr, const uint32_t* const len_arr,
-                  const bool* const chip_select_arr, uint16_t len_of_arr /* should make this < 512 */){}
+ssize_t SpiAdapter::XferMulti(uint8_t** const buf_arr, const uint32_t* const len_arr,
+                              const bool* const chip_select_arr, uint16_t len_of_arr) {
+  if (len_of_arr > Spi::kMaxXfers) {
+    logunit_->LogToDefault(loglevel::err, "spi adapter: {} XferMulti failed: {} segments > {}\n", info_.name_,
+                           len_of_arr, Spi::kMaxXfers);
+    return -1;
+  }
+
+  spi_ioc_transfer xfers[Spi::kMaxXfers];
+  const spi_ioc_transfer tmpl = GenSpiIocXfer();
+
+  for (uint16_t i = 0; i < len_of_arr; i++) {
+    xfers[i] = tmpl;
+    xfers[i].len = len_arr[i];
+    xfers[i].rx_buf = (unsigned long)buf_arr[i];
+    xfers[i].tx_buf = (unsigned long)buf_arr[i];
+    // cs_change on the last segment would keep CS asserted after the message
+    xfers[i].cs_change = (chip_select_arr != nullptr && chip_select_arr[i] && i != len_of_arr - 1);
+  }
+
+  return info_.bus_->WriteMulti<Spi::SpiMethod::kIoc>(xfers, len_of_arr);
+}
 
-// private
-bool SpiAdapter::InitImpl(const SpiAdapterInit_S& init_s){
+ssize_t SpiAdapter::XferRegMulti(const SpiRegXfer* regs, uint16_t n) {
+  spi_ioc_transfer xfers[Spi::kMaxXfers];
+  uint8_t cmds[kMaxRegXfers];
+  const spi_ioc_transfer tmpl = GenSpiIocXfer();
+
+  ssize_t total = 0;
+
+  for (uint16_t base = 0; base < n; base += kMaxRegXfers) {
+    const uint16_t chunk = (n - base < kMaxRegXfers) ? n - base : kMaxRegXfers;
+    uint32_t data_len = 0;
+
+    for (uint16_t i = 0; i < chunk; i++) {
+      const SpiRegXfer& r = regs[base + i];
+      if (!SpiInternalAddrCheck(r.iaddr_)) {
+        logunit_->LogToDefault(loglevel::err, "spi adapter: {} iaddr: {:#x} > 0x7F\n", info_.name_, r.iaddr_);
+        return -1;
+      }
+
+      cmds[i] = SpiCmd(r.iaddr_, r.read_);
+
+      spi_ioc_transfer& cmd = xfers[2 * i];
+      cmd = tmpl;
+      cmd.len = 1;
+      cmd.tx_buf = (unsigned long)(cmds + i);
+
+      spi_ioc_transfer& data = xfers[2 * i + 1];
+      data = tmpl;
+      data.len = r.len_;
+      if (r.read_)
+        data.rx_buf = (unsigned long)r.val_;
+      else
+        data.tx_buf = (unsigned long)r.val_;
+      data.cs_change = (i != chunk - 1);  // end this frame, next register starts a new one
+
+      data_len += r.len_;
+    }
+
+    ssize_t ret = info_.bus_->WriteMulti<Spi::SpiMethod::kIoc>(xfers, 2 * chunk);
+    if (ret != data_len + chunk) {
+      logunit_->LogToDefault(loglevel::err, "spi adapter: {} XferRegMulti failed: rtn: {} != len: {}\n", info_.name_,
+                             ret, data_len + chunk);
+      return -1;
+    }
+    total += data_len;
+  }
+
+  return total;
+}
 
+// private
+bool SpiAdapter::InitImpl(const char* adapter_name) {
+  SpiAdapterInit_S s;
+  s.name_ = adapter_name;
+  return InitImpl(s);
 }
 
-ssize_t SpiAdapter::WriteImpl(const uint64_t& iaddr, const uint8_t* val, const uint32_t& len){
-  // decide addr len
-  uint8_t addr_len = FindAddrLen(iaddr);
+bool SpiAdapter::InitImpl(const SpiAdapterInit_S& init_s) {
+  info_ = init_s;
+  logunit_ = ::lra::log_util::LogUnit::CreateLogUnit(info_.name_);
 
+  if (info_.bus_ == nullptr) {
+    logunit_->LogToDefault(loglevel::err, "spi adapter: {} init failed: no bus\n", info_.name_);
+    return false;
+  }
+  return true;
+}
 
-  // create a buf 
-  uint8_t buf[len + sizeof(uint64_t)];
+ssize_t SpiAdapter::WriteImpl(const uint64_t& iaddr, const uint8_t* val, const uint32_t& len) {
+  // tx only, val won't be modified
+  return RegXfer(iaddr, const_cast<uint8_t*>(val), len, false);
+}
 
+ssize_t SpiAdapter::WriteImpl(const uint64_t& iaddr, const std::vector<uint8_t>& val) {
+  return WriteImpl(iaddr, val.data(), val.size());
 }
 
-ssize_t SpiAdapter::WriteImpl(const uint64_t& iaddr, const std::vector<uint8_t>& val){}
+ssize_t SpiAdapter::ReadImpl(const uint64_t& iaddr, uint8_t* val, const uint32_t& len) {
+  return RegXfer(iaddr, val, len, true);
+}
 
-ssize_t SpiAdapter::ReadImpl(const uint64_t& iaddr, uint8_t* val, const uint32_t& len){}
+ssize_t SpiAdapter::RegXfer(const uint64_t& iaddr, uint8_t* val, const uint32_t& len, bool read) {
+  SpiRegXfer r{.iaddr_{iaddr}, .val_{val}, .len_{len}, .read_{read}};
+  return XferRegMulti(&r, 1);
+}
 
-spi_ioc_transfer SpiAdapter::GenSpiIocXfer(){
+spi_ioc_transfer SpiAdapter::GenSpiIocXfer() {
   struct spi_ioc_transfer xfer;
   memset(&xfer, 0, sizeof(struct spi_ioc_transfer));
 
@@ -49,4 +137,4 @@ spi_ioc_transfer SpiAdapter::GenSpiIocXfer(){
   return xfer;
 }
 
-}  // namespace lra::bus_adapter::spi
\ No newline at end of file
+}  // namespace lra::bus_adapter::spi
@@ -1,3 +1,6 @@
+#ifndef LRA_BUS_ADAPTER_SPI_H_
+#define LRA_BUS_ADAPTER_SPI_H_
+
 #include <bus/spi/spi.h>
 #include <bus_adapter/bus_adapter.h>
 
@@ -5,11 +8,12 @@
 #include <linux/spi/spidev.h>
 
 #include <memory>
+#include <vector>
 
 /**
  * @issue_record:
- * 1. tx_buf 和 rx_buf 可以是 0?
- * 2. tx_buf 和 rx_buf 可以一樣?
+ * 1. tx_buf 和 rx_buf 可以是 0? -> 可以，tx_buf 為 0 時送出 0，rx_buf 為 0 時丟棄收到的資料
+ * 2. tx_buf 和 rx_buf 可以一樣? -> 可以，spidev 先複製 tx 到 bounce buffer，再把收到的資料寫回 rx
  *
  */
 
@@ -23,6 +27,9 @@
  *      該長度限制是 (1 << _IOC_SIZEBITS) == 16384，_IOC_SIZEBITS 被定義為 14。
  *      而 sizeof(struct spi_ioc_transfer) 總共 32 個 bytes，計算下來 N 不可以超過 512。
  *      ref: https://forum.odroid.com/viewtopic.php?t=8842
+ *   3. Register access is [cmd] + [data] in two segments of one CS frame, so data is never copied:
+ *      tx_buf points to user data for write, rx_buf points to user buffer for read.
+ *   4. cmd byte: isRWbitFirst_ ? (R/W << 7 | addr) : (addr << 1 | R/W), 1 for read.
  */
 
 namespace lra::bus_adapter::spi {
@@ -31,34 +38,67 @@ using lra::bus::Spi;
 
 // struct
 typedef struct SpiAdapterInit_S {
-  bool isMSB_{false};           // 0x12 -> 0x0 ... 0x12 or ->0x12, 0x0 ...
+  bool isMSB_{true};            // 0x1234 -> {0x12, 0x34} or {0x34, 0x12} for register write / read
   bool isRWbitFirst_{false};    // R/W | addr or addr | R/W
   uint8_t word_delay_us_{0};    // delay between word
   uint8_t bits_per_word_{8};    // n bits in one word
   uint16_t delay_us_{0};        // delay between spi transfer
   uint32_t flags_{0};           // see linux/spi/spidev.h, includeing all flags and mode
   uint32_t speed_hz_{1000000};  // default to 1M/sec
-  const char* name_{"/dev/spidev0.0"};
-  std::shared_ptr <Spi> bus_{nullptr};
+  const char* name_{"spi_adapter"};
+  std::shared_ptr<Spi> bus_{nullptr};
 } SpiAdapter_S;
 
+// one register access in a batch, every access is its own CS frame
+struct SpiRegXfer {
+  uint64_t iaddr_{0};
+  uint8_t* val_{nullptr};  // read into or write from
+  uint32_t len_{0};
+  bool read_{true};
+};
+
 // class
 class SpiAdapter : public BusAdapter<SpiAdapter> {
  public:
+  // members
+  SpiAdapter_S info_;
+
+  static constexpr uint16_t kMaxRegXfers = Spi::kMaxXfers / 2;  // cmd + data for each register access
+
   // external R/W functions
+
+  // full-duplex in place, one CS frame
   ssize_t Xfer(uint8_t* val, const uint32_t& len);
 
-  ssize_t XferMulti(uint8_t** const buf_arr, const uint32_t* const len_arr,
-                    const bool* const chip_select_arr, uint16_t len_of_arr /* should make this < 512 */);
+  // chain len_of_arr in place transfers in one ioctl, chip_select_arr[i] true to release CS after buf_arr[i]
+  ssize_t XferMulti(uint8_t** const buf_arr, const uint32_t* const len_arr, const bool* const chip_select_arr,
+                    uint16_t len_of_arr /* should make this < 512 */);
+
+  // batch of register reads / writes, one ioctl per kMaxRegXfers, return total data bytes or -1
+  ssize_t XferRegMulti(const SpiRegXfer* regs, uint16_t n);
 
  private:
   friend BusAdapter;
 
+  bool InitImpl(const char* adapter_name);
+
   bool InitImpl(const SpiAdapterInit_S& init_s);
 
+  /**
+   * write function related interface, same as i2c adapter
+   * 1. (register, single val)
+   * 2. (iaddr, val*, len)
+   * 3. (iaddr, vector)
+   * all return ssize_t (data bytes written, -1 for failure)
+   */
+
   // single register write
   template <is_register T, std::integral U>
-  ssize_t WriteImpl(const T& reg, const U& val) {}
+  ssize_t WriteImpl(const T& reg, const U& val) {
+    uint8_t val_buf[sizeof(typename T::val_t)]{0};
+    Integral2Array(reg.bytelen_, val, val_buf);
+    return WriteImpl(reg.addr_, val_buf, reg.bytelen_);
+  }
 
   // array write
   ssize_t WriteImpl(const uint64_t& iaddr, const uint8_t* val, const uint32_t& len);
@@ -66,13 +106,37 @@ class SpiAdapter : public BusAdapter<SpiAdapter> {
   // vector write
   ssize_t WriteImpl(const uint64_t& iaddr, const std::vector<uint8_t>& val);
 
+  /**
+   * read function related interface
+   * 1. (register, val&)
+   * 2. (iaddr, val&) [read one byte]
+   * 3. (iaddr, val*, len)
+   */
+
   // single register read
   template <is_register T, std::integral U>
-  ssize_t ReadImpl(const T& reg, U& val) {}
+  ssize_t ReadImpl(const T& reg, U& val) {
+    uint8_t tmp_buf[sizeof(typename T::val_t)]{0};
+    ssize_t ret_size = ReadImpl(reg.addr_, tmp_buf, reg.bytelen_);
+
+    if (ret_size == reg.bytelen_) {
+      val = 0;
+      if (info_.isMSB_)
+        Array2Integral_BE(val, tmp_buf);
+      else
+        Array2Integral_LE(val, tmp_buf);
+    }
+    return ret_size;
+  }
 
   // read one byte
   // use auto& instead of uint8_t& to enable integral type bind on val_r
-  ssize_t ReadImpl(const uint64_t& iaddr, std::integral auto& val_r) {}
+  ssize_t ReadImpl(const uint64_t& iaddr, std::integral auto& val_r) {
+    uint8_t val{0};
+    ssize_t ret_size = ReadImpl(iaddr, &val, sizeof(val));
+    if (ret_size == sizeof(val)) val_r = val;
+    return ret_size;
+  }
 
   // read to array
   ssize_t ReadImpl(const uint64_t& iaddr, uint8_t* val, const uint32_t& len);
@@ -81,6 +145,28 @@ class SpiAdapter : public BusAdapter<SpiAdapter> {
   // properties in SpiAdapterInit_S will be set in this functions
   spi_ioc_transfer GenSpiIocXfer();
 
-  SpiAdapter_S info_{0};
+  // 7 bit register address only
+  inline bool SpiInternalAddrCheck(const uint64_t& iaddr) { return iaddr <= 0x7F; }
+
+  inline uint8_t SpiCmd(const uint64_t& iaddr, bool read) {
+    return info_.isRWbitFirst_ ? (read << 7 | (uint8_t)iaddr) : ((uint8_t)iaddr << 1 | read);
+  }
+
+  template <std::integral U>
+  void Integral2Array(int16_t nbytes, U val, uint8_t* buf) {
+    if (info_.isMSB_) {
+      Integral2Array_BE(nbytes, val, buf);
+    } else {
+      for (int16_t i = 0; i < nbytes; i++) {
+        buf[i] = (uint8_t)val;
+        val >>= 8;
+      }
+    }
+  }
+
+  // cmd + data, two segments in one CS frame
+  ssize_t RegXfer(const uint64_t& iaddr, uint8_t* val, const uint32_t& len, bool read);
 };
-}  // namespace lra::bus_adapter::spi
\ No newline at end of file
+}  // namespace lra::bus_adapter::spi
+
+#endif
@@ -17,11 +17,13 @@
 
 namespace lra::controller {
 
-Controller::Controller() {
+Controller::Controller() : Controller(ControllerInit_S{}) {}
+
+Controller::Controller(const ControllerInit_S& init_s) {
   start_time_ = std::chrono::system_clock::now();
 
   // init bus
-  bool rtn = i2c_.Init("/dev/i2c-1");
+  bool rtn = i2c_.Init(init_s.i2c_);
   logunit_ = LogUnit::CreateLogUnit("MainController");
 
   logunit_->LogToDefault(loglevel::info, "MainController try to create, start time: {:%Y-%m-%d %H:%M:}{:%S}\n",
@@ -33,6 +35,15 @@ Controller::Controller() {
   } else {
     logunit_->LogToDefault(loglevel::critical, "MainController I2C bus init failed\n");
   }
+
+  spi_ = std::make_shared<Spi>();
+  if (spi_->Init(init_s.spi_)) {
+    logunit_->LogToDefault(loglevel::info, "MainController SPI bus init successfully, speed: {}\n", spi_->speed_hz_);
+  } else {
+    logunit_->LogToDefault(loglevel::critical, "MainController SPI bus init failed\n");
+  }
+
+  acc_irq_ = init_s.acc_irq_;
 }
 
 void Controller::Init() {
@@ -58,10 +69,10 @@ void Controller::Init() {
   info_drv_.page_bytes_ = 32;
   info_drv_.tenbit_ = false;
 
-  /* SPI info init */
-  info_adxl_.channel_ = 0;
-  info_adxl_.mode_ = 0;
-  info_adxl_.speed_ = 10000000;
+  /* SPI adapter init */
+  spi_adapter_s_.bus_ = spi_;
+  spi_adapter_s_.speed_hz_ = 10000000;
+  spi_adapter_s_.name_ = "spi_adapter";
 
   /* I2c device creates new shared pointer */
   tca_ = std::make_shared<Tca9548a>(info_tca_);
@@ -77,26 +88,19 @@ void Controller::Init() {
   drv_x_->Init(i2c_adapter_s_);
   drv_y_->Init(i2c_adapter_s_);
   drv_z_->Init(i2c_adapter_s_);
-  adxl_->Init(info_adxl_, "acc1");
+  adxl_->Init(spi_adapter_s_, "acc1");
+  if (acc_fifo_mode_) adxl_->SetFifoMode(true);
 
   /* Can be deleted custom */
-  ChangeDrvCh('x');
-  drv_x_->SetToLraDefault();
-  ChangeDrvCh('y');
-  drv_y_->SetToLraDefault();
-  ChangeDrvCh('z');
-  drv_z_->SetToLraDefault();
+  SetDrvToLraDefault();
 
   /* IT pin settings */
-  const int interrupt_pin = 6;
-  wiringPiSetup();
-  pinMode(interrupt_pin, INPUT);
-  pullUpDnControl(interrupt_pin, PUD_DOWN);
-  wiringPiISR(interrupt_pin, INT_EDGE_RISING, ItCallback);
+  InitAccIrq();
 
   /* Run calibration */
   logunit_->LogToDefault(loglevel::info, "MainController go on init calibration\n");
-  auto [info_x, info_y, info_z, info_acc] = RunCalibration();
+  bool acc_ok = false;
+  auto [info_x, info_y, info_z, info_acc] = RunCalibration(&acc_ok);
 
   /* calibration ok? */
   logunit_->LogToDefault(loglevel::info, "x: id: {}, result:{}, freq: {:.3f} Hz, Vbat: {:.3f} V.\n", info_x.device_id_,
@@ -105,27 +109,59 @@ void Controller::Init() {
                          info_y.diag_result_ ? "Failed" : "Normal", info_y.lra_freq_, info_y.vbat_);
   logunit_->LogToDefault(loglevel::info, "z: id: {}, result:{}, freq: {:.3f} Hz, Vbat: {:.3f} V.\n", info_z.device_id_,
                          info_z.diag_result_ ? "Failed" : "Normal", info_z.lra_freq_, info_z.vbat_);
-  logunit_->LogToDefault(loglevel::info, "acc new offset: x:{:.4f} y:{:.4f} z:{:.4f}.\n", info_acc.data.x,
-                         info_acc.data.y, info_acc.data.z);
+  logunit_->LogToDefault(loglevel::info, "acc {} offset: x:{:.4f} y:{:.4f} z:{:.4f}.\n", acc_ok ? "new" : "kept",
+                         info_acc.data.x, info_acc.data.y, info_acc.data.z);
 
   /* Start measure task if threading not exist */
   StartMeasureTask();
 }
 
-void Controller::UpdateAllRtp(std::tuple<uint8_t, uint8_t, uint8_t> val) {
-  auto [val_x, val_y, val_z] = val;
+void Controller::SetAccIrqSource(std::shared_ptr<IrqSource> irq) {
+  if (adxl355_measure_t_.joinable()) {
+    logunit_->LogToDefault(loglevel::warn, "MainController SetAccIrqSource failed, measure task is running\n");
+    return;
+  }
+  acc_irq_ = irq;
+}
 
-  ChangeDrvCh('x');
-  drv_x_->UpdateRTP(val_x);
+void Controller::InitAccIrq() {
+  if (acc_irq_ != nullptr) {  // user defined source
+    if (!acc_irq_->Open()) logunit_->LogToDefault(loglevel::critical, "MainController acc irq source open failed\n");
+    return;
+  }
 
-  ChangeDrvCh('y');
-  drv_y_->UpdateRTP(val_y);
+  if (acc_irq_cdev_) {
+    acc_irq_ = std::make_shared<GpioLineIrq>("/dev/gpiochip0", acc_irq_line_);
+    if (acc_irq_->Open()) {
+      logunit_->LogToDefault(loglevel::info, "MainController acc irq on gpiochip0 line {}\n", acc_irq_line_);
+      return;
+    }
+    logunit_->LogToDefault(loglevel::err, "MainController gpiochip0 line {} open failed, use wiringPi ISR\n",
+                           acc_irq_line_);
+  }
 
-  ChangeDrvCh('z');
-  drv_z_->UpdateRTP(val_z);
+  auto isr_irq = std::make_shared<EventFdIrq>();
+  isr_irq->Open();
+  acc_irq_ = isr_irq;
+  isr_irq_.store(isr_irq.get(), std::memory_order_release);
+
+  wiringPiSetup();
+  pinMode(acc_irq_pin_, INPUT);
+  pullUpDnControl(acc_irq_pin_, PUD_DOWN);
+  wiringPiISR(acc_irq_pin_, INT_EDGE_RISING, ItCallback);
+}
+
+bool Controller::UpdateAllRtp(std::tuple<uint8_t, uint8_t, uint8_t> val) {
+  std::lock_guard<std::recursive_mutex> lock(drv_mutex_);
+  const std::array<uint8_t, 3> rtp{std::get<0>(val), std::get<1>(val), std::get<2>(val)};
+
+  batch_.Clear();
+  QueueDrvWrite(Drv2605l::RTP_INPUT.addr_, rtp);
+  return CommitDrvBatch("UpdateAllRtp");
 }
 
 void Controller::UpdateRtp(uint8_t val, char axis) {
+  std::lock_guard<std::recursive_mutex> lock(drv_mutex_);
   if (axis == 'x' || axis == 'y' || axis == 'z') {
     ChangeDrvCh(axis);
     switch (axis) {
@@ -145,75 +181,137 @@ void Controller::UpdateRtp(uint8_t val, char axis) {
 }
 
 void Controller::ChangeDrvCh(char axis) {
+  std::lock_guard<std::recursive_mutex> lock(drv_mutex_);
   switch (axis) {
     case 'x':
-      tca_->Write(tca_->CONTROL, drv_x_ch_);
-      tca_ch_ = 'x';
+      tca_->Select(drv_x_ch_);
       break;
     case 'y':
-      tca_->Write(tca_->CONTROL, drv_y_ch_);
-      tca_ch_ = 'y';
+      tca_->Select(drv_y_ch_);
       break;
     case 'z':
-      tca_->Write(tca_->CONTROL, drv_z_ch_);
-      tca_ch_ = 'z';
+      tca_->Select(drv_z_ch_);
       break;
     default:
       break;
   }
 }
 
-void Controller::RunDrv() {
-  if (!drv_x_->GetRun()) {
-    ChangeDrvCh('x');
-    drv_x_->Run(true);
+std::pair<uint64_t, uint64_t> Controller::GetMuxWriteCount() {
+  return std::make_pair(tca_->GetSelectWriteCount(), tca_->GetSelectSkipCount());
+}
+
+void Controller::RunDrv() { SetDrvRun(true); }
+
+/* Stop drv driving, should be called when disconnect of websocekt or pause being called by user */
+void Controller::PauseDrv() { SetDrvRun(false); }
+
+void Controller::SetDrvRun(bool run) {
+  std::lock_guard<std::recursive_mutex> lock(drv_mutex_);
+  const std::array<std::pair<char, Drv2605l*>, 3> drvs{
+      std::make_pair('x', drv_x_.get()), std::make_pair('y', drv_y_.get()), std::make_pair('z', drv_z_.get())};
+
+  if (std::all_of(drvs.begin(), drvs.end(), [&](auto& d) { return d.second->GetRun() == run; })) return;
+
+  // all three change and share the same MODE, one MODE + GO write with every channel open
+  if (drv_x_->GetModeCache() >= 0 &&
+      std::all_of(drvs.begin(), drvs.end(), [&](auto& d) {
+        return d.second->GetRun() != run && d.second->GetModeCache() == drv_x_->GetModeCache();
+      })) {
+    batch_.Clear();
+    tca_->QueueSelect(batch_, drv_all_ch_);
+    drv_x_->QueueRun(batch_, run);
+    bool ok = CommitDrvBatch(run ? "RunDrv(broadcast)" : "PauseDrv(broadcast)");
+    drv_x_->OnRunCommitted(run, ok);
+    drv_y_->MirrorState(*drv_x_);
+    drv_z_->MirrorState(*drv_x_);
+    return;
   }
 
-  if (!drv_y_->GetRun()) {
-    ChangeDrvCh('y');
-    drv_y_->Run(true);
+  // MODE not cached yet (e.g. before the first UpdateAllReg), read-modify-write one by one
+  bool cached = true;
+  batch_.Clear();
+  QueueEachDrv([&](Drv2605l& drv, size_t) {
+    if (drv.GetRun() == run) return true;
+    cached = drv.QueueRun(batch_, run);
+    return cached;
+  });
+
+  if (cached) {
+    bool ok = CommitDrvBatch(run ? "RunDrv" : "PauseDrv");
+    for (auto [axis, drv] : drvs)
+      if (drv->GetRun() != run) drv->OnRunCommitted(run, ok);
+    return;
   }
 
-  if (!drv_z_->GetRun()) {
-    ChangeDrvCh('z');
-    drv_z_->Run(true);
+  for (auto [axis, drv] : drvs) {
+    if (drv->GetRun() != run) {
+      ChangeDrvCh(axis);
+      drv->Run(run);
+    }
   }
 }
 
-/* Stop drv driving, should be called when disconnect of websocekt or pause being called by user */
-void Controller::PauseDrv() {
-  if (drv_x_->GetRun()) {
-    ChangeDrvCh('x');
-    drv_x_->Run(false);
-  }
+bool Controller::QueueDrvWrite(uint8_t addr, const std::array<uint8_t, 3>& val) {
+  if (val[0] == val[1] && val[1] == val[2])
+    return tca_->QueueSelect(batch_, drv_all_ch_) && drv_x_->QueueWrite(batch_, addr, &val[0], 1);
+
+  return QueueEachDrv([&](Drv2605l& drv, size_t i) { return drv.QueueWrite(batch_, addr, &val[i], 1); });
+}
 
-  if (drv_y_->GetRun()) {
-    ChangeDrvCh('y');
-    drv_y_->Run(false);
+void Controller::SetDrvToLraDefault() {
+  // identical sequence for every axis, run it once (one reset wait) with all channels open
+  if (tca_->Select(drv_all_ch_) >= 0) {
+    drv_x_->SetToLraDefault();
+    drv_y_->MirrorState(*drv_x_);
+    drv_z_->MirrorState(*drv_x_);
+    logunit_->LogToDefault(loglevel::info, "MainController drv x, y, z set to lra defaults by broadcast\n");
+    return;
   }
 
-  if (drv_z_->GetRun()) {
-    ChangeDrvCh('z');
-    drv_z_->Run(false);
+  ChangeDrvCh('x');
+  drv_x_->SetToLraDefault();
+  ChangeDrvCh('y');
+  drv_y_->SetToLraDefault();
+  ChangeDrvCh('z');
+  drv_z_->SetToLraDefault();
+}
+
+bool Controller::CommitDrvBatch(const char* what) {
+  if (batch_.Overflow()) {
+    logunit_->LogToDefault(loglevel::err, "MainController {} failed: i2c batch overflow\n", what);
+    return false;
   }
+
+  bool ok = tca_->Commit(batch_) >= 0;
+  if (!ok) logunit_->LogToDefault(loglevel::err, "MainController {} failed: i2c batch commit\n", what);
+  return ok;
 }
 
-std::tuple<Drv2605lInfo, Drv2605lInfo, Drv2605lInfo, Adxl355::Acc3> Controller::RunCalibration() {
+std::tuple<Drv2605lInfo, Drv2605lInfo, Drv2605lInfo, Adxl355::Acc3> Controller::RunCalibration(bool* acc_ok) {
+  // drv_mutex_ is taken per drv access, the control loop and the rtp actuator are not held off for the whole run
   bool no_measure_thread = (adxl355_measure_t_.get_id() == std::thread::id());
   bool origin_standby = adxl_->standby_;
 
-  /* three axis Drv2605 */
-  ChangeDrvCh('x');
-  auto cal_info_x = drv_x_->RunAutoCalibration();
-  ChangeDrvCh('y');
-  auto cal_info_y = drv_y_->RunAutoCalibration();
-  ChangeDrvCh('z');
-  auto cal_info_z = drv_z_->RunAutoCalibration();
+  /* three axis Drv2605, start back to back and poll GO, acc bias samples are collected in the same window */
+  const std::array<std::pair<char, Drv2605l*>, 3> drvs{
+      std::make_pair('x', drv_x_.get()), std::make_pair('y', drv_y_.get()), std::make_pair('z', drv_z_.get())};
+  std::array<Drv2605lInfo, 3> cal_info{};
+  std::array<bool, 3> cal_pending{};
+
+  for (size_t i = 0; i < drvs.size(); i++) {
+    std::lock_guard<std::recursive_mutex> lock(drv_mutex_);
+    ChangeDrvCh(drvs[i].first);
+    cal_pending[i] = drvs[i].second->StartAutoCalibration();
+    if (!cal_pending[i]) cal_info[i] = drvs[i].second->FinishAutoCalibration();
+  }
 
   /* acc bias correction */
   constexpr int data_num = 5000;
-  std::vector<Adxl355::Acc3> v;
-  v.reserve(data_num);
+  constexpr auto drv_timeout = std::chrono::milliseconds(2000);  // AUTO_CAL_TIME max 1.2 sec
+  constexpr auto drv_poll_period = std::chrono::milliseconds(5);
+  std::vector<Adxl355::Acc3> v(data_num);
+  size_t got = 0;
 
   // make sure thread is on and on measurement mode
   if (no_measure_thread) {
@@ -223,23 +321,47 @@ std::tuple<Drv2605lInfo, Drv2605lInfo, Drv2605lInfo, Adxl355::Acc3> Controller::
 
   adxl_->SetStandBy(false);
 
-  auto cali_start = std::chrono::system_clock::now();
+  auto cali_start = std::chrono::steady_clock::now();
+  auto next_poll = cali_start;
+
+  auto any_pending = [&]() { return std::find(cal_pending.begin(), cal_pending.end(), true) != cal_pending.end(); };
+
+  bool acc_timeout = false;
+  while ((got < data_num && !acc_timeout) || any_pending()) {
+    auto now = std::chrono::steady_clock::now();
+
+    if (any_pending() && now >= next_poll) {
+      next_poll = now + drv_poll_period;
+      for (size_t i = 0; i < drvs.size(); i++) {
+        if (!cal_pending[i]) continue;
+        std::lock_guard<std::recursive_mutex> lock(drv_mutex_);
+        ChangeDrvCh(drvs[i].first);
+        if (drvs[i].second->PollAutoCalibration() != 0 || now - cali_start > drv_timeout) {
+          cal_info[i] = drvs[i].second->FinishAutoCalibration();
+          cal_pending[i] = false;
+        }
+      }
+    }
 
-  for (int n = data_num - v.size(); n > 0; n = data_num - v.size()) {  // get data from dq
-    auto v_tmp = adxl_->AccPopFrontN(n);
-    v.insert(v.end(), v_tmp.begin(), v_tmp.end());
+    if (got < data_num && !acc_timeout) {  // get data from ring
+      got += adxl_->AccPopInto(std::span(v).subspan(got));
 
-    // wait for 5 seconds
-    if ((std::chrono::system_clock::now() - cali_start).count() / 1e9 > 5) {
-      logunit_->LogToDefault(loglevel::err, "Init calibration for adxl355 timeout (5 secs)");
-      break;
+      // wait for 5 seconds
+      if (now - cali_start > std::chrono::seconds(5)) {
+        logunit_->LogToDefault(loglevel::err, "Init calibration for adxl355 timeout (5 secs)");
+        acc_timeout = true;
+      }
     }
+
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
   }
 
   if (no_measure_thread) {
     CancelMeasureTask();
   }
 
+  v.resize(got);
+
   adxl_->SetStandBy(origin_standby);  // FIXME: multiple threading issue
 
   /* calculate average */
@@ -247,53 +369,84 @@ std::tuple<Drv2605lInfo, Drv2605lInfo, Drv2605lInfo, Adxl355::Acc3> Controller::
 
   acc_avg.time = (std::chrono::system_clock::now() - start_time_).count();
 
-  for (auto& ele : v) {  // TODO: struct opertor
-    acc_avg.data.x += ele.data.x;
-    acc_avg.data.y += ele.data.y;
-    acc_avg.data.z += ele.data.z;
-  }
+  auto origin_offset = adxl_->GetOffSet();
+  if (acc_ok) *acc_ok = !v.empty();
 
-  acc_avg.data.x /= v.size();
-  acc_avg.data.y /= v.size();
-  acc_avg.data.z /= v.size();
+  if (v.empty()) {  // measure thread got nothing (no irq, spi down), an average of nothing is NaN
+    logunit_->LogToDefault(loglevel::err, "MainController acc calibration got no sample, offset kept\n");
+    acc_avg.data = origin_offset.data;
+  } else {
+    for (auto& ele : v) {  // TODO: struct opertor
+      acc_avg.data.x += ele.data.x;
+      acc_avg.data.y += ele.data.y;
+      acc_avg.data.z += ele.data.z;
+    }
 
-  auto origin_offset = adxl_->GetOffSet();
+    acc_avg.data.x /= v.size();
+    acc_avg.data.y /= v.size();
+    acc_avg.data.z /= v.size();
 
-  // combine 
-  acc_avg.data.x += origin_offset.data.x;
-  acc_avg.data.y += origin_offset.data.y;
-  acc_avg.data.z += origin_offset.data.z;
+    // combine
+    acc_avg.data.x += origin_offset.data.x;
+    acc_avg.data.y += origin_offset.data.y;
+    acc_avg.data.z += origin_offset.data.z;
 
-  adxl_->SetOffSet(acc_avg); /*XXX: 包含了前面的校正，所以應該是先GetOffSet再 bias */
+    adxl_->SetOffSet(acc_avg); /*XXX: 包含了前面的校正，所以應該是先GetOffSet再 bias */
+  }
 
-  logunit_->LogToDefault(loglevel::info, "MainController finished calibration\n");
-  return std::make_tuple(cal_info_x, cal_info_y, cal_info_z, acc_avg);
+  logunit_->LogToDefault(loglevel::info,
+                         "MainController finished calibration in {:.3f} s, drv x: {:.3f} s, y: {:.3f} s, z: {:.3f} s\n",
+                         std::chrono::duration<float>(std::chrono::steady_clock::now() - cali_start).count(),
+                         cal_info[0].calibration_time_s_, cal_info[1].calibration_time_s_,
+                         cal_info[2].calibration_time_s_);
+  return std::make_tuple(cal_info[0], cal_info[1], cal_info[2], acc_avg);
 }
 
 void Controller::AccMeasureTask() {
   adxl355_measure_thread_exit_ = false;
+  lra::log_util::AsyncLog::SetThreadBudget(0);
 
-  while (!adxl355_measure_thread_exit_) {
-    // if (adxl_->standby_) { 如果是
-    if (Controller::new_acc_data_) {  // 當 standby mode 時不會觸發，所以若不是校正模式不用重開
-      Adxl355::Acc3 data = adxl_->GetAcc();
-      data.time = (std::chrono::system_clock::now() - start_time_).count();
-      adxl_->AccPushBack(data);
+  // per sample path works on these buffers only, no heap allocation
+  std::array<Adxl355::Acc3, Adxl355::kFifoMaxSamples> fifo_buf;
+  Adxl355::AccFrame frame;
 
-      if (adxl_->GetDataDequeSize() > max_number_in_deque_) {  // protect memory overflow
-        adxl_->AccPopFront();
+  while (!adxl355_measure_thread_exit_) {
+    // no edge in standby mode, timeout lets us check the exit flag
+    const WaitResult res = acc_irq_->Wait(acc_irq_timeout_ms_);
+    if (res == WaitResult::kTimeout && adxl_->fifo_mode_) {
+      /* FIFO_FULL is level triggered but caught on the rising edge: an edge missed (ISR attached late, INT_MAP / RESET
+       * rewritten) leaves the line high and no other edge comes, drain if the FIFO is over the watermark */
+      bool overrun = false;
+      if (adxl_->GetFifoEntries(&overrun) < adxl_->fifo_watermark_ * Adxl355::kFifoEntriesPerSample) continue;
+
+      if (overrun) {  // filled up and lost samples, when the kept ones were taken is unknown: drop, don't stamp now
+        adxl_->GetAccFifo(fifo_buf, 0);
+        logunit_->LogToDefault(loglevel::warn, "MainController acc irq timeout, FIFO overrun dropped, overruns: {}\n",
+                               adxl_->GetFifoOverrunCount());
+        continue;
       }
+      logunit_->LogToDefault(loglevel::warn, "MainController acc irq timeout with FIFO over watermark, drained\n");
+    } else if (res != WaitResult::kEdge) {
+      continue;
+    }
 
-      Controller::new_acc_data_ = false;
-    } else {
-      // XXX: may be a problem ?
-      // std::this_thread::yield();
+    if (adxl_->fifo_mode_) {  // watermark reached, drain all samples in FIFO
+      size_t n = adxl_->GetAccFifo(fifo_buf, (std::chrono::system_clock::now() - start_time_).count());
+      for (size_t k = 0; k < n; k++) {
+        adxl_->AccPushBack(fifo_buf[k]);
+      }
+    } else {  // coalesced edges are counted as missed in acc_irq_
+      Adxl355::Acc3 data = adxl_->GetAcc(frame);
+      data.time = (std::chrono::system_clock::now() - start_time_).count();
+      adxl_->AccPushBack(data);
     }
   }
   return;
 }
 
-void Controller::ItCallback() { Controller::new_acc_data_ = true; }
+void Controller::ItCallback() {
+  if (EventFdIrq* irq = isr_irq_.load(std::memory_order_acquire)) irq->Notify();
+}
 
 /* Should and only be called before destroy MainController */
 void Controller::CancelMeasureTask() {
@@ -301,6 +454,7 @@ void Controller::CancelMeasureTask() {
     return;
   } else {
     adxl355_measure_thread_exit_ = true;
+    acc_irq_->Wake();
 
     try {  // wait for the thread leaving
       adxl355_measure_t_.join();
@@ -323,6 +477,7 @@ void Controller::StartMeasureTask() {
 
 std::tuple<std::vector<uint8_t>, std::vector<uint8_t>, std::vector<uint8_t>, std::vector<uint8_t>, std::vector<uint8_t>>
 Controller::GetAllRegisters() {
+  std::lock_guard<std::recursive_mutex> lock(drv_mutex_);
   ChangeDrvCh('x');
   auto drv_x_v = drv_x_->GetAllReg();
   ChangeDrvCh('y');
@@ -336,18 +491,19 @@ Controller::GetAllRegisters() {
 }
 
 std::tuple<Drv2605lRtInfo, Drv2605lRtInfo, Drv2605lRtInfo> Controller::GetRt() {
-  ChangeDrvCh('x');
-  auto info_x = drv_x_->GetRt();
-  ChangeDrvCh('y');
-  auto info_y = drv_y_->GetRt();
-  ChangeDrvCh('z');
-  auto info_z = drv_z_->GetRt();
+  std::lock_guard<std::recursive_mutex> lock(drv_mutex_);
+  uint8_t rt_buf[3][2]{};
+
+  batch_.Clear();
+  QueueEachDrv([&](Drv2605l& drv, size_t i) { return drv.QueueGetRt(batch_, rt_buf[i]); });
+  CommitDrvBatch("GetRt");
 
-  return std::make_tuple(info_x, info_y, info_z);
+  return std::make_tuple(Drv2605l::ParseRt(rt_buf[0]), Drv2605l::ParseRt(rt_buf[1]), Drv2605l::ParseRt(rt_buf[2]));
 }
 
 void Controller::UpdateAllRegisters(
     std::tuple<std::vector<uint8_t>, std::vector<uint8_t>, std::vector<uint8_t>, std::vector<uint8_t>> tuple) {
+  std::lock_guard<std::recursive_mutex> lock(drv_mutex_);
   auto [v_x, v_y, v_z, v_acc_rw] = tuple;
 
   ChangeDrvCh('x');
@@ -362,6 +518,12 @@ void Controller::UpdateAllRegisters(
   logunit_->LogToDefault(loglevel::info, "MainController UpdateAllRegisters successfully\n");
 }
 
-Controller::~Controller() { CancelMeasureTask(); }
+Controller::~Controller() {
+  CancelMeasureTask();
+
+  // the ISR stays attached (wiringPi can't detach), it must not reach the source acc_irq_ is about to free
+  EventFdIrq* own = dynamic_cast<EventFdIrq*>(acc_irq_.get());
+  isr_irq_.compare_exchange_strong(own, nullptr, std::memory_order_acq_rel);
+}
 
 }  // namespace lra::controller
@@ -2,12 +2,16 @@
 #define LRA_CONTROLLER_H_
 
 #include <bus/i2c/i2c.h>
+#include <bus/spi/spi.h>
 #include <device/adxl355/adxl355.h>
 #include <device/drv2605l/drv2605l.h>
 #include <device/tca/tca.h>
+#include <util/interrupt/interrupt.h>
 #include <util/log/logunit.h>
 
+#include <atomic>
 #include <chrono>
+#include <mutex>
 #include <thread>
 
 extern "C" {
@@ -17,29 +21,48 @@ extern "C" {
 namespace lra::controller {
 
 using ::lra::bus::I2c;
+using ::lra::bus::I2cInit_S;
+using ::lra::bus::Spi;
+using ::lra::bus::SpiInit_S;
 using ::lra::bus_adapter::i2c::I2cAdapter_S;
+using ::lra::bus_adapter::spi::SpiAdapter_S;
 using ::lra::device::Adxl355;
+using ::lra::bus::I2cBatch;
 using ::lra::device::Drv2605l;
 using ::lra::device::Drv2605lInfo;
 using ::lra::device::Drv2605lRtInfo;
 using ::lra::device::I2cDeviceInfo;
-using ::lra::device::SpiInit_s;
 using ::lra::device::Tca9548a;
+using ::lra::interrupt_util::EventFdIrq;
+using ::lra::interrupt_util::GpioLineIrq;
+using ::lra::interrupt_util::IrqSource;
+using ::lra::interrupt_util::WaitResult;
 using ::lra::log_util::loglevel;
 using ::lra::log_util::LogUnit;
 
 
+// buses and acc interrupt source, defaults are the Pi wiring; tests plug mock_ioctl_ / mock_xfer_ / SimIrq here
+struct ControllerInit_S {
+  I2cInit_S i2c_{.name_ = "/dev/i2c-1"};
+  SpiInit_S spi_{.name_ = "/dev/spidev0.0", .mode_ = SPI_MODE_0, .speed_hz_ = 10000000};
+  std::shared_ptr<IrqSource> acc_irq_{nullptr};  // nullptr: GPIO line or wiringPi ISR, see acc_irq_cdev_
+};
+
 class Controller {  // FIXME: only one controller allows, for static function callback sake
  public:
   // const
   const uint8_t drv_x_ch_{0x80};  // ch3
   const uint8_t drv_y_ch_{0x10};  // ch4
   const uint8_t drv_z_ch_{0x08};  // ch7
-  const ssize_t max_number_in_deque_{1024 * 1024 * 5 /
-                                     sizeof(Adxl355::Acc3)};  // constrains to 5 MB => (1024 / 16) * 1024 * 5
+  const uint8_t drv_all_ch_{0x80 | 0x10 | 0x08};  // broadcast, every drv answers at 0x5a, write only
 
   // states
-  bool adxl355_measure_thread_exit_{false};
+  bool acc_fifo_mode_{true};  // drain adxl355 FIFO on watermark instead of reading every data ready
+  bool acc_irq_cdev_{false};  // wait on GPIO character device line events instead of wiringPi ISR
+  const int acc_irq_pin_{6};  // wiringPi pin, BCM 25 on gpiochip0
+  const uint32_t acc_irq_line_{25};
+  const int acc_irq_timeout_ms_{100};  // no edge in standby, measure thread wakes up to check exit flag
+  std::atomic<bool> adxl355_measure_thread_exit_{false};
   // bool on_calibration_{false};   // 應該是一個mutex, 掌管 disable input and ouput 或說不更新的功能 > 移到 main.cc
   // bool on_modify_{false};        // 應該是一個mutex, 掌管 disable input 或說不更新的功能 > 移到 main.cc
   std::thread adxl355_measure_t_{};
@@ -48,41 +71,53 @@ class Controller {  // FIXME: only one controller allows, for static function ca
   // bus & device info
   I2c i2c_;
   I2cAdapter_S i2c_adapter_s_;
+  std::shared_ptr<Spi> spi_{nullptr};
+  SpiAdapter_S spi_adapter_s_;
 
   I2cDeviceInfo info_tca_;
   I2cDeviceInfo info_drv_;
-  SpiInit_s info_adxl_;
 
   // members
   std::shared_ptr<Drv2605l> drv_x_{nullptr};
   std::shared_ptr<Drv2605l> drv_y_{nullptr};
   std::shared_ptr<Drv2605l> drv_z_{nullptr};
   std::shared_ptr<Adxl355> adxl_{nullptr};
+  std::shared_ptr<IrqSource> acc_irq_{nullptr};  // adxl355 INT2 (data ready / FIFO full)
 
   // callbacks
-  static bool new_acc_data_;
   static void ItCallback();
 
   // functions
   Controller();
+
+  explicit Controller(const ControllerInit_S& init_s);
   ~Controller();
 
   void Init();
 
+  // plug another interrupt source (e.g. SimIrq), call before Init()
+  void SetAccIrqSource(std::shared_ptr<IrqSource> irq);
+
   void RunDrv();
 
   void PauseDrv();
 
   void AccMeasureTask();
 
-  void UpdateAllRtp(std::tuple<uint8_t, uint8_t, uint8_t>);
+  // false on bus error
+  bool UpdateAllRtp(std::tuple<uint8_t, uint8_t, uint8_t>);
 
   void UpdateRtp(uint8_t, char);
 
-  std::tuple<Drv2605lInfo, Drv2605lInfo, Drv2605lInfo, Adxl355::Acc3> RunCalibration();
+  // drv autocalibration and acc offset; no acc sample within 5 s keeps the old offset (returned) and sets *acc_ok false
+  std::tuple<Drv2605lInfo, Drv2605lInfo, Drv2605lInfo, Adxl355::Acc3> RunCalibration(bool* acc_ok = nullptr);
 
+  // mux write skipped if the channel is already selected
   void ChangeDrvCh(char);
 
+  // mux CONTROL writes (issued, skipped by the channel cache)
+  std::pair<uint64_t, uint64_t> GetMuxWriteCount();
+
   void CancelMeasureTask();
 
   void StartMeasureTask();
@@ -117,6 +152,7 @@ class Controller {  // FIXME: only one controller allows, for static function ca
   /* Update Single Device Registers */
   template <class T>
   void UpdateRegisters(std::string target, std::vector<uint8_t> val) {  // drv_x, drv_y, drv_z, adxl
+    std::lock_guard<std::recursive_mutex> lock(drv_mutex_);
     if (target == "drv_x") {
       ChangeDrvCh('x');
       drv_x_->UpdateAllReg(val);
@@ -136,10 +172,38 @@ class Controller {  // FIXME: only one controller allows, for static function ca
  private:
   std::shared_ptr<LogUnit> logunit_{nullptr};
   std::shared_ptr<Tca9548a> tca_{nullptr};
-  char tca_ch_{'x'};
-};
+  // drv / mux access from the control loop, the rtp actuator and the websocket lanes, held per public call
+  std::recursive_mutex drv_mutex_;
+  I2cBatch batch_;  // reused by the batched drv paths, one I2C_RDWR when the adapter supports protocol mangling
+
+  // select + queue per axis, fn(drv, axis_idx) returns false on queue overflow
+  template <class F>
+  bool QueueEachDrv(F&& fn) {
+    const std::array<std::tuple<uint8_t, char, Drv2605l*>, 3> axes{std::make_tuple(drv_x_ch_, 'x', drv_x_.get()),
+                                                                   std::make_tuple(drv_y_ch_, 'y', drv_y_.get()),
+                                                                   std::make_tuple(drv_z_ch_, 'z', drv_z_.get())};
+    for (size_t i = 0; i < axes.size(); i++) {
+      auto [ch, axis, drv] = axes[i];
+      if (!tca_->QueueSelect(batch_, ch) || !fn(*drv, i)) return false;
+    }
+    return true;
+  }
+
+  // identical values go once with all channels open, per-axis otherwise
+  bool QueueDrvWrite(uint8_t addr, const std::array<uint8_t, 3>& val);
+
+  bool CommitDrvBatch(const char* what);
+
+  void SetDrvToLraDefault();
 
-bool Controller::new_acc_data_ = false;
+  void SetDrvRun(bool run);
+
+  // wiringPi ISR has no argument, forward to this source; set before wiringPiISR(), read by the ISR thread,
+  // owned by acc_irq_
+  static inline std::atomic<EventFdIrq*> isr_irq_{nullptr};
+
+  void InitAccIrq();
+};
 
 }  // namespace lra::controller
 
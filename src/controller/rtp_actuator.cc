@@ -0,0 +1,88 @@
+#include <controller/rtp_actuator.h>
+#include <util/thread/thread.h>
+
+#include <chrono>
+
+namespace lra::controller {
+
+using ::lra::log_util::loglevel;
+
+RtpActuator::~RtpActuator() { Stop(); }
+
+int64_t RtpActuator::NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+bool RtpActuator::Start(const RtpActuatorInit_S& init_s, Apply apply, Gate gate) {
+  if (run_.load() || t_.joinable()) return false;
+  if (!apply) return false;
+
+  init_s_ = init_s;
+  apply_fn_ = std::move(apply);
+  gate_fn_ = std::move(gate);
+  logunit_ = lra::log_util::LogUnit::CreateLogUnit(init_s_.name_);
+
+  run_.store(true);
+  t_ = std::thread(&RtpActuator::Run, this, mailbox_.Seq());
+  return true;
+}
+
+void RtpActuator::Stop() {
+  run_.store(false);
+  mailbox_.Notify();
+  if (t_.joinable()) t_.join();
+}
+
+void RtpActuator::Submit(const std::array<uint8_t, 3>& rtp, int64_t recv_ns) {
+  mailbox_.Publish(RtpCommand{.rtp_ = rtp, .recv_ns_ = recv_ns});
+}
+
+void RtpActuator::ResetStats() {
+  wake_.Reset();
+  apply_.Reset();
+  e2e_.Reset();
+  applied_.store(0, std::memory_order_relaxed);
+  coalesced_.store(0, std::memory_order_relaxed);
+  failed_.store(0, std::memory_order_relaxed);
+}
+
+void RtpActuator::Run(uint32_t seen) {
+  lra::thread_util::ApplyThreadSchedule(init_s_.name_, init_s_.rt_priority_, init_s_.cpu_, *logunit_);
+
+  logunit_->LogToDefault(loglevel::info, "{}: started\n", init_s_.name_);
+
+  while (run_.load(std::memory_order_relaxed)) {
+    mailbox_.Wait(seen);
+    if (!run_.load(std::memory_order_relaxed)) break;
+
+    // held back, the newest command is read after the gate opens
+    while (gate_fn_ && !gate_fn_() && run_.load(std::memory_order_relaxed))
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    if (!run_.load(std::memory_order_relaxed)) break;
+
+    RtpCommand cmd;
+    const uint32_t seq = mailbox_.Read(cmd);
+    if (seq - seen > 2) coalesced_.fetch_add((seq - seen) / 2 - 1, std::memory_order_relaxed);
+    seen = seq;
+
+    const int64_t start = NowNs();
+    const bool ok = apply_fn_(cmd.rtp_);
+    const int64_t done = NowNs();
+
+    if (!ok) {
+      failed_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    wake_.Record(start - cmd.recv_ns_);
+    apply_.Record(done - start);
+    e2e_.Record(done - cmd.recv_ns_);
+    applied_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  logunit_->LogToDefault(loglevel::info, "{}: stopped, applied: {}, coalesced: {}, failed: {}\n", init_s_.name_,
+                         GetAppliedCount(), GetCoalescedCount(), GetFailedCount());
+}
+
+}  // namespace lra::controller
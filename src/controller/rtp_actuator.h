@@ -0,0 +1,97 @@
+#ifndef LRA_RTP_ACTUATOR_H_
+#define LRA_RTP_ACTUATOR_H_
+
+#include <util/log/logunit.h>
+#include <util/mailbox/mailbox.h>
+#include <util/stats/stats.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace lra::controller {
+
+struct RtpCommand {
+  std::array<uint8_t, 3> rtp_{};  // x, y, z
+  int64_t recv_ns_{0};            // steady clock, when the command arrived
+};
+
+struct RtpActuatorInit_S {
+  std::string name_{"rtp_actuator"};
+  int rt_priority_{0};  // SCHED_FIFO priority 1 ~ 99, 0 keeps SCHED_OTHER (needs CAP_SYS_NICE)
+  int cpu_{-1};         // pin to this cpu, -1 for no affinity
+};
+
+/**
+ * @brief Applies RTP commands as soon as they arrive instead of on the next control loop tick.
+ * Submit() only publishes to a latest value mailbox and wakes the actuator thread, commands that arrive while one is
+ * being written are coalesced (only the newest is written). Every applied command is traced from receive to the end
+ * of the I2C write.
+ */
+class RtpActuator {
+ public:
+  // writes the three RTP values (e.g. Controller::UpdateAllRtp), false on bus error
+  using Apply = std::function<bool(const std::array<uint8_t, 3>&)>;
+  // false holds commands back (calibration, register update), the newest one is written once it turns true
+  using Gate = std::function<bool()>;
+
+  RtpActuator() = default;
+  RtpActuator(const RtpActuator&) = delete;
+  RtpActuator& operator=(const RtpActuator&) = delete;
+  ~RtpActuator();
+
+  bool Start(const RtpActuatorInit_S& init_s, Apply apply, Gate gate = nullptr);
+
+  void Stop();
+
+  // one producer (websocket control lane), never blocks
+  void Submit(const std::array<uint8_t, 3>& rtp, int64_t recv_ns = NowNs());
+
+  // steady clock ns, same clock as recv_ns_
+  static int64_t NowNs();
+
+  // stats (ns), readable from other threads
+  // receive -> actuator starts the write (wake up, gate)
+  inline const lra::stats_util::LatencyHistogram& GetWakeLatency() const { return wake_; }
+
+  // the I2C write itself
+  inline const lra::stats_util::LatencyHistogram& GetApplyTime() const { return apply_; }
+
+  // receive -> I2C write done
+  inline const lra::stats_util::LatencyHistogram& GetEndToEnd() const { return e2e_; }
+
+  inline uint64_t GetAppliedCount() const { return applied_.load(std::memory_order_relaxed); }
+
+  inline uint64_t GetCoalescedCount() const { return coalesced_.load(std::memory_order_relaxed); }
+
+  inline uint64_t GetFailedCount() const { return failed_.load(std::memory_order_relaxed); }
+
+  void ResetStats();
+
+ private:
+  std::shared_ptr<lra::log_util::LogUnit> logunit_{nullptr};
+  RtpActuatorInit_S init_s_;
+  Apply apply_fn_;
+  Gate gate_fn_;
+  std::thread t_;
+  std::atomic<bool> run_{false};
+
+  lra::mailbox_util::SeqlockMailbox<RtpCommand> mailbox_;
+
+  lra::stats_util::LatencyHistogram wake_;
+  lra::stats_util::LatencyHistogram apply_;
+  lra::stats_util::LatencyHistogram e2e_;
+  std::atomic<uint64_t> applied_{0};
+  std::atomic<uint64_t> coalesced_{0};
+  std::atomic<uint64_t> failed_{0};
+
+  // seen: mailbox seq at Start(), commands submitted after it are applied
+  void Run(uint32_t seen);
+};
+
+}  // namespace lra::controller
+
+#endif
@@ -1,5 +1,7 @@
 #include <device/adxl355/adxl355.h>
 
+#include <cmath>
+#include <cstring>
 #include <tuple>
 
 namespace lra::device {
@@ -31,57 +33,50 @@ std::string Adxl355::CheckDeviceReg() {  // device 繼承
   return s;
 }
 
-void Adxl355::Init(SpiInit_s s_init, std::string name) {
-  wiringPiSPISetupMode(s_init.channel_, s_init.speed_, s_init.mode_);
-  logunit_ = lra::log_util::LogUnit::CreateLogUnit(name);
+bool Adxl355::Init(SpiAdapter_S init_s, std::string name) {
+  name_ = name;
+  logunit_ = lra::log_util::LogUnit::CreateLogUnit(name_);
 
-  if (auto fd = wiringPiSPIGetFd(s_init.channel_); fd > 0) {
-    name_ = name;
-    init_ = s_init;
-    logunit_->LogToDefault(loglevel::info, "adxl: {} init succesfully, fd: {}\n, ", name_, fd);
-    SetToDefault();
-    standby_ = true;
-  } else {
-    logunit_->LogToDefault(loglevel::err, "adxl: {} init failed\n", name);
+  init_s.isRWbitFirst_ = false;
+  init_s.isMSB_ = true;
+
+  if (!adapter_.Init(init_s)) {
+    logunit_->LogToDefault(loglevel::err, "adxl: {} init failed\n", name_);
+    return false;
   }
 
-  // should call adapter_.Init();
+  logunit_->LogToDefault(loglevel::info, "adxl: {} init succesfully, bus: {}\n", name_, init_s.bus_->name_);
+  SetToDefault();
+  standby_ = true;
+  return true;
 }
 
 ssize_t Adxl355::Write(const uint8_t addr, const uint8_t* val, const uint16_t len) {
-  std::vector<uint8_t> v_tmp;
-  v_tmp.push_back(addr << 1 | 0x00);
-  v_tmp.insert(v_tmp.end(), val, val + len);
-
-  rw_mutex_.lock();
-  int num = wiringPiSPIDataRW(init_.channel_, v_tmp.data(), len + 1);
-  rw_mutex_.unlock();
-
-  if (num - 1 != len)
-    logunit_->LogToDefault(loglevel::err, "adxl: {} write failed: len mismatch, rtn: {} != len: {}\n", name_, num - 1,
-                           len);
-  return num - 1;
+  ssize_t num = adapter_.Write((uint64_t)addr, val, (uint32_t)len);
+
+  if (num != len)
+    logunit_->LogToDefault(loglevel::err, "adxl: {} write failed: len mismatch, rtn: {} != len: {}\n", name_, num, len);
+  return num;
 }
 
-std::vector<uint8_t> Adxl355::Read(const uint8_t addr, const uint16_t len) {
-  // ref: https://stackoverflow.com/questions/15004517/moving-elements-from-stdvector-to-another-one
-  std::vector<uint8_t> v_tmp, v_rtn;
-  v_tmp.resize(len + 1);
-  v_tmp[0] = addr << 1 | 0x01;  // 0 for write, 1 for read
-
-  rw_mutex_.lock();
-  int num = wiringPiSPIDataRW(init_.channel_, v_tmp.data(), len + 1);
-  rw_mutex_.unlock();
-
-  if (num - 1 != len) {
-    logunit_->LogToDefault(loglevel::err, "adxl: {} read failed: len mismatch, rtn: {} != len: {}\n", name_, num - 1,
-                           len);
-  } else {
-    v_rtn.insert(v_rtn.end(), std::make_move_iterator(v_tmp.begin() + 1), std::make_move_iterator(v_tmp.end()));
+ssize_t Adxl355::Read(const uint8_t addr, uint8_t* val, const uint16_t len) {
+  ssize_t num = adapter_.Read((uint64_t)addr, val, (uint32_t)len);
+
+  if (num != len) {
+    logunit_->LogToDefault(loglevel::err, "adxl: {} read failed: len mismatch, rtn: {} != len: {}\n", name_, num, len);
+    return -1;
   }
+  return num;
+}
+
+std::vector<uint8_t> Adxl355::Read(const uint8_t addr, const uint16_t len) {
+  std::vector<uint8_t> v_rtn(len);
+  if (Read(addr, v_rtn.data(), len) != len) v_rtn.clear();
   return v_rtn;
 }
 
+ssize_t Adxl355::Transfer(uint8_t* buf, const uint16_t len) { return adapter_.Xfer(buf, len + 1) - 1; }
+
 void Adxl355::SetToDefault() {
   /* reset device, standby mode; it's ok to write reset in measure mode */
   uint8_t val = 0x52;
@@ -98,6 +93,9 @@ void Adxl355::SetToDefault() {
   /* set sampling rate */
   val = (0b100 << 4) | 0x00;  // 10 Hz hpf, 4000 Hz sampling rate, 1000 Hz lpf
   Write(Filter.addr_, &val, 1);
+  odr_lpf_ = 0x00;
+
+  fifo_mode_ = false;
 }
 
 void Adxl355::SetStandBy(bool standby) {
@@ -131,6 +129,8 @@ void Adxl355::UpdateAllReg(const std::vector<uint8_t> v) {
   bool tmp = standby_;
   SetStandBy(true);
 
+  constexpr int filter_idx = 10;
+  constexpr int int_map_idx = 12;
   constexpr int range_idx = 14;
   constexpr int rw_reg_num = 18;
 
@@ -143,6 +143,8 @@ void Adxl355::UpdateAllReg(const std::vector<uint8_t> v) {
                              "adxl: {} UpdateAllReg range setting wrong, can't be 0x00 @ RANGE register\n", name_);
     }
     range_ = tmp_range;  // FIXME: when update only range registers -> cache failed -> GetCacheRange failed too
+    odr_lpf_ = v[filter_idx] & 0x0F;
+    fifo_mode_ = v[int_map_idx] & (0x01 << 5);  // FULL_EN2
     Write(OFFSET_X_H.addr_, v.data(), v.size());
   } else {
     logunit_->LogToDefault(loglevel::err, "adxl: {} UpdateAllReg failed: length mismatch, v.size(): {} should be {}\n",
@@ -209,37 +211,161 @@ Adxl355::Acc3 Adxl355::GetOffSet() {
 /* Important: You should confirm standby_ is false in the measuring thread */
 /* Assign time by your self */
 Adxl355::Acc3 Adxl355::GetAcc() {
-  constexpr int data_len = 9;
-  auto v = Read(XDATA3.addr_, data_len);
-  return ParseDigitalAcc(v);
+  AccFrame frame;
+  return GetAcc(frame);
 }
 
-Adxl355::Acc3 Adxl355::ParseDigitalAcc(std::vector<uint8_t> v) {
-  Acc3 tmp;
+Adxl355::Acc3 Adxl355::GetAcc(AccFrame& frame) {
+  constexpr uint16_t data_len = kAccFrameBytes - 1;
+  frame[0] = XDATA3.addr_ << 1 | 0x01;  // 0 for write, 1 for read
 
-  if (v.size() != 9) {  // 3 * 3 {
-    logunit_->LogToDefault(loglevel::err, "adxl: {} parse acc data failed: length mismatch, v.size(): {}\n", name_,
-                           v.size());
+  ssize_t num = Transfer(frame.data(), data_len);
+  if (num != data_len) {
+    logunit_->LogToDefault(loglevel::err, "adxl: {} parse acc data failed: length mismatch, rtn: {}\n", name_, num);
+    return Acc3{};
+  }
+  return ParseDigitalAcc(frame.data() + 1);
+}
 
-  } else {
-    uint32_t uintX = (v[0] << 12) | (v[1] << 4) | (v[2] >> 4);
-    uint32_t uintY = (v[3] << 12) | (v[4] << 4) | (v[5] >> 4);
-    uint32_t uintZ = (v[6] << 12) | (v[7] << 4) | (v[8] >> 4);
-
-    // do two component according to 19th bit, if 1 -> convert, 0 -> same
-    constexpr uint32_t mask_20 = (1 << 20) - 1;
-    int32_t intX = ((uintX & (1 << 19)) != 0) ? (uintX | ~mask_20) : uintX;
-    int32_t intY = ((uintY & (1 << 19)) != 0) ? (uintY | ~mask_20) : uintY;
-    int32_t intZ = ((uintZ & (1 << 19)) != 0) ? (uintZ | ~mask_20) : uintZ;
-
-    // int to float
-    constexpr uint32_t acc_adc_num = 1048576;  // (2^20)
-    const float dAccRange = GetCacheRange();
-
-    tmp.data.x = ((double)intX) * (1.0 / acc_adc_num) * dAccRange;
-    tmp.data.y = ((double)intY) * (1.0 / acc_adc_num) * dAccRange;
-    tmp.data.z = ((double)intZ) * (1.0 / acc_adc_num) * dAccRange;
+/* FIFO_SAMPLES counts entries, we set it with samples (x, y, z) */
+void Adxl355::SetFifoMode(bool enable, uint8_t watermark) {
+  bool tmp = standby_;
+  SetStandBy(true);
+
+  if (watermark == 0 || watermark > kFifoMaxSamples) {
+    logunit_->LogToDefault(loglevel::warn, "adxl: {} SetFifoMode watermark: {} out of range [1, {}], use {}\n", name_,
+                           watermark, kFifoMaxSamples, kFifoDefaultWatermark);
+    watermark = kFifoDefaultWatermark;
+  }
+
+  uint8_t val = watermark * kFifoEntriesPerSample;
+  Write(FIFO_SAMPLES.addr_, &val, 1);
+
+  /* INT2 on FIFO full (watermark) or on data ready */
+  val = enable ? (0x01 << 5) : (0x01 << 4);
+  Write(INT_MAP.addr_, &val, 1);
+
+  fifo_mode_ = enable;
+  fifo_watermark_ = watermark;
+
+  SetStandBy(tmp);
+}
+
+std::vector<Adxl355::Acc3> Adxl355::GetAccFifo(int64_t t_newest) {
+  std::vector<Acc3> samples(kFifoMaxSamples);
+  samples.resize(GetAccFifo(samples, t_newest));
+  return samples;
+}
+
+size_t Adxl355::GetAccFifo(std::span<Acc3> out, int64_t t_newest) {
+  std::array<uint8_t, kFifoMaxEntries * kFifoEntryBytes> buf;
+
+  // FIFO full interrupt guarantees at least watermark samples
+  uint16_t n_entries = fifo_watermark_ * kFifoEntriesPerSample;
+  size_t n = 0;
+
+  for (int pass = 0; pass < 2 && n_entries > 0 && n < out.size(); pass++) {
+    uint8_t remain = 0;
+    const SpiRegXfer regs[2] = {
+        {.iaddr_{FIFO_DATA.addr_},
+         .val_{buf.data()},
+         .len_{static_cast<uint32_t>(n_entries * kFifoEntryBytes)},
+         .read_{true}},
+        {.iaddr_{FIFO_ENTRIES.addr_}, .val_{&remain}, .len_{1}, .read_{true}}};
+
+    ssize_t num = adapter_.XferRegMulti(regs, 2);
+    if (num != n_entries * kFifoEntryBytes + 1) {
+      logunit_->LogToDefault(loglevel::err, "adxl: {} FIFO read failed: len mismatch, rtn: {} != len: {}\n", name_,
+                             num, n_entries * kFifoEntryBytes + 1);
+      break;
+    }
+
+    n += ParseFifo(buf.data(), n_entries, out.subspan(n));
+
+    /* entries left after the burst, whole samples only, a sample still being written stays in FIFO */
+    n_entries = remain & 0x7F;
+    n_entries -= n_entries % kFifoEntriesPerSample;
+    if (n_entries > kFifoMaxEntries) n_entries = kFifoMaxEntries;
   }
+
+  /* recover timestamps from ODR, ns */
+  const double period = 1e9 / static_cast<double>(GetOdr());
+  for (size_t k = 0; k < n; k++) {
+    out[k].time = t_newest - std::llround((n - 1 - k) * period);
+  }
+
+  return n;
+}
+
+uint8_t Adxl355::GetFifoEntries(bool* overrun) {
+  constexpr uint8_t fifo_ovr = 0x04;  // STATUS[2]
+  uint8_t v[2]{};                     // STATUS, FIFO_ENTRIES
+  if (Read(Status.addr_, v, 2) != 2) return 0;
+
+  if (v[0] & fifo_ovr) fifo_overrun_++;
+  if (overrun != nullptr) *overrun = v[0] & fifo_ovr;
+  return v[1] & 0x7F;
+}
+
+/**
+ * FIFO entry: [19:12], [11:4], [3:0] | 0 | 0 | empty | x marker
+ * FIFO_DATA doesn't auto increment address, so a long read drains the FIFO in one transfer.
+ * Reading past the last sample gives entries with empty marker, decoding stops there.
+ */
+size_t Adxl355::ParseFifo(const uint8_t* v, uint16_t n_entries, std::span<Acc3> out) {
+  constexpr uint8_t x_marker = 0x01;
+  constexpr uint8_t empty_marker = 0x02;
+
+  /* align to x axis, happens when FIFO overflowed or was read partially */
+  uint16_t i = 0;
+  while (i < n_entries && !(v[i * kFifoEntryBytes + 2] & (x_marker | empty_marker))) i++;
+
+  if (i != 0) {
+    fifo_misaligned_++;
+    logunit_->LogToDefault(loglevel::warn, "adxl: {} FIFO misaligned, drop {} entries\n", name_, i);
+  }
+
+  size_t n = 0;
+  for (; i + kFifoEntriesPerSample <= n_entries && n < out.size(); i += kFifoEntriesPerSample) {
+    const uint8_t* p = v + i * kFifoEntryBytes;
+    if ((p[2] | p[5] | p[8]) & empty_marker) break;
+    out[n++] = ParseDigitalAcc(p);
+  }
+
+  return n;
+}
+
+float Adxl355::GetOdr() {
+  constexpr float odr_max = 4000.0;
+  constexpr uint8_t odr_lpf_max = 0b1010;  // 3.906 Hz
+  uint8_t odr_lpf = (odr_lpf_ > odr_lpf_max) ? odr_lpf_max : odr_lpf_;
+  return odr_max / (1 << odr_lpf);
+}
+
+float Adxl355::GetRangeG() { return GetCacheRange() / 2; }
+
+/* v should be at least 9 bytes, XDATA3 to ZDATA1 or x, y, z FIFO entries */
+Adxl355::Acc3 Adxl355::ParseDigitalAcc(const uint8_t* v) {
+  Acc3 tmp;
+
+  uint32_t uintX = (v[0] << 12) | (v[1] << 4) | (v[2] >> 4);
+  uint32_t uintY = (v[3] << 12) | (v[4] << 4) | (v[5] >> 4);
+  uint32_t uintZ = (v[6] << 12) | (v[7] << 4) | (v[8] >> 4);
+
+  // do two component according to 19th bit, if 1 -> convert, 0 -> same
+  constexpr uint32_t mask_20 = (1 << 20) - 1;
+  int32_t intX = ((uintX & (1 << 19)) != 0) ? (uintX | ~mask_20) : uintX;
+  int32_t intY = ((uintY & (1 << 19)) != 0) ? (uintY | ~mask_20) : uintY;
+  int32_t intZ = ((uintZ & (1 << 19)) != 0) ? (uintZ | ~mask_20) : uintZ;
+
+  // int to float
+  constexpr uint32_t acc_adc_num = 1048576;  // (2^20)
+  const float dAccRange = GetCacheRange();
+
+  tmp.data.x = ((double)intX) * (1.0 / acc_adc_num) * dAccRange;
+  tmp.data.y = ((double)intY) * (1.0 / acc_adc_num) * dAccRange;
+  tmp.data.z = ((double)intZ) * (1.0 / acc_adc_num) * dAccRange;
+
   return tmp;
 }
 
@@ -262,39 +388,22 @@ float Adxl355::GetCacheRange() {
   return dAccRange;
 }
 
-/* should check deque's size by yourself, not safe so you need to avoid to use this function */
 Adxl355::Acc3 Adxl355::AccPopFront() {
-  std::lock_guard<std::mutex> lock(dq_mutex_);
-  auto tmp = data_.front();
-  data_.pop_front();
+  Acc3 tmp{};
+  data_.PopInto(std::span<Acc3>(&tmp, 1));
   return tmp;
 }
 
-std::vector<Adxl355::Acc3> Adxl355::AccPopAll() { return AccPopFrontN(data_.size()); }
+std::vector<Adxl355::Acc3> Adxl355::AccPopAll() { return AccPopFrontN(data_.Size()); }
 
 std::vector<Adxl355::Acc3> Adxl355::AccPopFrontN(size_t n) {
   std::vector<Acc3> tmp;
   if (n <= 0) return tmp;
 
-  std::lock_guard<std::mutex> lock(dq_mutex_);
-
-  if (data_.size() < n) {
-    n = data_.size();
-  }
-
-  tmp.reserve(n);
-
-  while (n--) {
-    tmp.push_back(data_.front());
-    data_.pop_front();
-  }
+  tmp.resize(n);
+  tmp.resize(data_.PopInto(tmp));
 
   return tmp;
 }
 
-void Adxl355::AccPushBack(Acc3 acc_data) {
-  std::lock_guard<std::mutex> lock(dq_mutex_);
-  data_.push_back(acc_data);
-}
-
 }  // namespace lra::device
\ No newline at end of file
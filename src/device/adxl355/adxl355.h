@@ -1,37 +1,27 @@
 #ifndef LRA_DEVICE_ADXL355_H_
 #define LRA_DEVICE_ADXL355_H_
 
-// TODO: 待 spi_adapter 和 spi_bus 寫好後重構
-
+#include <bus_adapter/spi_adapter/spi_adapter.h>
 #include <device/device.h>
 #include <memory/registers/registers.h>
 #include <util/log/logunit.h>
+#include <util/ring/spsc_ring.h>
 
 #include <array>
-#include <deque>
-
-// tmp
-extern "C" {
-#include <wiringPi.h>
-#include <wiringPiSPI.h>
-}
+#include <span>
 
 namespace lra::device {
 
+using ::lra::bus_adapter::spi::SpiAdapter;
+using ::lra::bus_adapter::spi::SpiAdapter_S;
+using ::lra::bus_adapter::spi::SpiRegXfer;
 using ::lra::log_util::loglevel;
 
-// tmp struct for spi channel
-struct SpiInit_s {
-  int mode_{0};
-  int channel_{0};
-  int speed_{10000000};
-};
-
 class Adxl355 {
  public:
-  struct Acc3 {  // 16 bytes
+  struct Acc3 {  // 24 bytes
     Float3 data;
-    float time;
+    int64_t time;  // ns since controller start, a float would round to ms after hours
   };
 
   // States
@@ -42,6 +32,21 @@ class Adxl355 {
   const float dRange_4g = 4.096 * 2;
   const float dRange_8g = 8.192 * 2;
 
+  // FIFO, 96 entries of 3 bytes, one sample (x, y, z) takes 3 entries
+  constexpr static uint8_t kFifoMaxEntries = 96;
+  constexpr static uint8_t kFifoEntryBytes = 3;
+  constexpr static uint8_t kFifoEntriesPerSample = 3;
+  constexpr static uint8_t kFifoMaxSamples = kFifoMaxEntries / kFifoEntriesPerSample;
+  constexpr static uint8_t kFifoDefaultWatermark = 20;  // samples, 5 ms @ 4 kHz
+
+  // in place SPI frame for GetAcc, command byte + payload
+  constexpr static uint16_t kAccFrameBytes = 1 + 9;  // cmd + XDATA3 ... ZDATA1
+
+  using AccFrame = std::array<uint8_t, kAccFrameBytes>;
+
+  bool fifo_mode_{false};
+  uint8_t fifo_watermark_{kFifoDefaultWatermark};  // samples
+
   // Register
   constexpr static Register_8 DEVID_AD{0x00, 0xAD};
   constexpr static Register_8 DEVID_MST{0x01, 0x1D};
@@ -91,12 +96,20 @@ class Adxl355 {
   // Init and IO
   Adxl355() = default;
 
-  void Init(SpiInit_s init, std::string name);
+  // cmd byte is addr << 1 | R/W, isRWbitFirst_ is overwritten
+  bool Init(SpiAdapter_S init_s, std::string name);
 
   ssize_t Write(const uint8_t addr, const uint8_t *val, const uint16_t len);
 
+  // copy len bytes into val, no allocation, returns bytes read or -1
+  ssize_t Read(const uint8_t addr, uint8_t *val, const uint16_t len);
+
+  // allocates, for configuration path only
   std::vector<uint8_t> Read(const uint8_t addr, const uint16_t len);
 
+  // full-duplex in place, buf[0] is the command byte (addr << 1 | R/W), payload is buf[1:], returns payload bytes
+  ssize_t Transfer(uint8_t *buf, const uint16_t len);
+
   // Functions
   std::string CheckDeviceReg();
 
@@ -121,32 +134,69 @@ class Adxl355 {
 
   Acc3 GetAcc();
 
+  // read XDATA3 ... ZDATA1 into caller's frame and decode from it
+  Acc3 GetAcc(AccFrame &frame);
+
+  // FIFO watermark acquisition, INT2 fires when watermark samples are stored
+  void SetFifoMode(bool enable, uint8_t watermark = kFifoDefaultWatermark);
+
+  // drain FIFO, t_newest is the time of the latest sample, the others are recovered from ODR
+  std::vector<Acc3> GetAccFifo(int64_t t_newest);
+
+  // no allocation, out should hold kFifoMaxSamples, returns number of samples written
+  // FIFO_DATA (watermark) and FIFO_ENTRIES are read in one SPI message, a second one only if more are left
+  size_t GetAccFifo(std::span<Acc3> out, int64_t t_newest);
+
+  // STATUS + FIFO_ENTRIES in one read: entries stored (kFifoEntriesPerSample per sample), 0 if the read failed;
+  // overrun: FIFO_OVR set, samples were lost while nobody drained (counted)
+  uint8_t GetFifoEntries(bool* overrun = nullptr);
+
+  // output data rate (Hz) from cached Filter register
+  float GetOdr();
+
+  // measurement range (+- g) from cached Range register
+  float GetRangeG();
+
+  inline uint64_t GetFifoMisalignedCount() { return fifo_misaligned_; }
+
+  inline uint64_t GetFifoOverrunCount() { return fifo_overrun_; }
+
   // int GetSamplingRate();
 
   // bool GetStandBy();
 
+  // single consumer, returns zero time Acc3 if empty
   Acc3 AccPopFront();
 
   std::vector<Acc3> AccPopFrontN(size_t n);
 
   std::vector<Acc3> AccPopAll();
 
-  void AccPushBack(Acc3 acc_data);
+  // single consumer, no allocation, returns number of samples copied into dst
+  inline size_t AccPopInto(std::span<Acc3> dst) { return data_.PopInto(dst); }
+
+  // single producer (measure thread), drops oldest sample when ring is full
+  inline void AccPushBack(const Acc3& acc_data) { data_.Push(acc_data); }
+
+  inline size_t GetDataSize() { return data_.Size(); }
 
-  inline ssize_t GetDataDequeSize() { return data_.size(); }
+  inline uint64_t GetAccOverflowCount() { return data_.OverflowCount(); }
+
+  static constexpr size_t kAccRingCapacity = 1 << 18;  // 6 MB of Acc3, about 65 secs at 4000 Hz
+  using AccRing = lra::ring_util::SpscRing<Acc3, kAccRingCapacity>;
 
  private:
-  std::deque<Acc3> data_{};
+  AccRing data_{};
   std::shared_ptr<lra::log_util::LogUnit> logunit_{nullptr};
-  std::mutex dq_mutex_{};
   std::string name_{};
-  SpiInit_s init_{};
-
-  // abort
-  std::mutex rw_mutex_{};  // FIXME: only one adxl355 can work on same spi bus
+  SpiAdapter adapter_;
+  uint8_t odr_lpf_{0};  // Filter[3:0], 0 for 4000 Hz
+  uint64_t fifo_misaligned_{0};
+  uint64_t fifo_overrun_{0};
 
   // functions
-  Acc3 ParseDigitalAcc(std::vector<uint8_t> v);
+  Acc3 ParseDigitalAcc(const uint8_t* v);
+  size_t ParseFifo(const uint8_t* v, uint16_t n_entries, std::span<Acc3> out);
   float GetCacheRange();
 };
 }  // namespace lra::device
@@ -48,7 +48,7 @@ void Drv2605l::UpdateAllReg(std::vector<uint8_t> v) {
     if (v[0] >> 7 == 1) {  // reset cmd
       logunit_->LogToDefault(loglevel::err, "drv: {} UpdateAllReg may failed: reset bit in Mode is set\n", name_);
     }
-    Write(MODE.addr_, v.data(), w_reg_len);
+    mode_ = (Write(MODE.addr_, v.data(), w_reg_len) >= 0) ? v[0] : -1;  // smbus write returns 0
   } else {
     logunit_->LogToDefault(loglevel::err, "drv: {} UpdateAllReg failed: length: {} mismatch {}\n", name_, v.size(),
                            w_reg_len);
@@ -61,7 +61,7 @@ void Drv2605l::SetToLraDefault() {
   usleep(1000000);
 
   /* necessary */
-  Write(MODE, 0x01 << 6 | 0x05);  // RTP mode, standby
+  mode_ = (Write(MODE, 0x01 << 6 | 0x05) >= 0) ? 0x01 << 6 | 0x05 : -1;  // RTP mode, standby
   Write(RTP_INPUT, 0x00);
   Write(LIBRARY_SELECTION, 0x06);  // LRA lib
   Write(RATED_VOLTAGE, 0x3E);      // voltage at steady state
@@ -131,13 +131,55 @@ Drv2605lInfo Drv2605l::GetCalibrationInfo() {
 }
 
 Drv2605lInfo Drv2605l::RunAutoCalibration() {
-  auto mode = Read(MODE) & 0x07;  // get current mode, with mask (00000111)
-  Write(MODE, 0x01 << 6 | 0x07);  // calibration mode, ready
-  Run(true);                      // take 1 ~ 1.2 sec
-  usleep(1200000);                // sleep 1.2 sec
-  Run(false);                     // fix internal state run_
-  Write(MODE, 0x01 << 6 | mode);  // resume previous mode, standby
-  return GetCalibrationInfo();
+  constexpr auto timeout = std::chrono::milliseconds(2000);  // AUTO_CAL_TIME max 1.2 sec
+
+  if (StartAutoCalibration()) {
+    while (PollAutoCalibration() == 0 && std::chrono::steady_clock::now() - cal_start_ < timeout) usleep(5000);
+  }
+  return FinishAutoCalibration();
+}
+
+bool Drv2605l::StartAutoCalibration() {
+  auto mode = Read(MODE);
+  if (mode < 0) {
+    logunit_->LogToDefault(loglevel::err, "drv: {} autocalibration not started, read MODE failed\n", name_);
+    return false;
+  }
+
+  cal_prev_mode_ = mode & 0x07;   // get current mode, with mask (00000111)
+  Write(MODE, 0x00 << 6 | 0x07);  // calibration mode, ready
+  mode_ = 0x07;
+  cal_start_ = std::chrono::steady_clock::now();
+  cal_done_ = {};
+  run_ = Write(GO, 0x01) >= 0;  // take 1 ~ 1.2 sec, GO clears itself when done
+  return run_;
+}
+
+int Drv2605l::PollAutoCalibration() {
+  if (cal_done_ != std::chrono::steady_clock::time_point{}) return 1;
+
+  auto go = Read(GO);
+  if (go < 0) return go;
+  if (go & 0x01) return 0;
+
+  cal_done_ = std::chrono::steady_clock::now();
+  return 1;
+}
+
+Drv2605lInfo Drv2605l::FinishAutoCalibration() {
+  if (cal_done_ == std::chrono::steady_clock::time_point{}) {  // timeout or never started, stop it
+    Write(GO, 0x00);
+    logunit_->LogToDefault(loglevel::err, "drv: {} autocalibration did not complete\n", name_);
+  }
+  run_ = false;
+
+  auto mode = (cal_prev_mode_ < 0) ? 0x05 : cal_prev_mode_;  // RTP if unknown
+  mode_ = (Write(MODE, 0x01 << 6 | mode) >= 0) ? 0x01 << 6 | mode : -1;  // resume previous mode, standby
+
+  auto info = GetCalibrationInfo();
+  if (cal_done_ != std::chrono::steady_clock::time_point{})
+    info.calibration_time_s_ = std::chrono::duration<float>(cal_done_ - cal_start_).count();
+  return info;
 }
 
 Drv2605lRtInfo Drv2605l::GetRt() {
@@ -149,20 +191,19 @@ Drv2605lRtInfo Drv2605l::GetRt() {
 
 float Drv2605l::GetHz() {
   auto val = Read(LRA_PERIOD);
-  return 1.0 / (val * 98.46 * 1e-6);
+  return PeriodToHz(val);
 }
 
 void Drv2605l::Ready(bool ready) {
   auto val = Read(MODE);
   if (val < 0) {
     logunit_->LogToDefault(loglevel::err, "drv: {}, execute Run() failed, due to read register MODE failed\n", name_);
+    mode_ = -1;
     return;
   } else {
     constexpr uint8_t sixth_bit_inverse_mask = 0b10111111;
-    if (ready)
-      Write(MODE, (val & sixth_bit_inverse_mask) | 0x00 << 6);
-    else
-      Write(MODE, (val & sixth_bit_inverse_mask) | 0x01 << 6);
+    uint8_t mode = ready ? ((val & sixth_bit_inverse_mask) | 0x00 << 6) : ((val & sixth_bit_inverse_mask) | 0x01 << 6);
+    mode_ = (Write(MODE, mode) >= 0) ? mode : -1;
   }
 }
 
@@ -176,4 +217,36 @@ void Drv2605l::Run(bool run) {
 
 void Drv2605l::UpdateRTP(uint8_t cmd) { Write(RTP_INPUT, cmd); }
 
+// batch
+
+bool Drv2605l::QueueGetRt(I2cBatch& batch, uint8_t* rt_buf) {
+  return QueueRead(batch, RTP_INPUT.addr_, rt_buf, 1) && QueueRead(batch, LRA_PERIOD.addr_, rt_buf + 1, 1);
+}
+
+Drv2605lRtInfo Drv2605l::ParseRt(const uint8_t* rt_buf) {
+  Drv2605lRtInfo tmp;
+  tmp.rtp_ = rt_buf[0];
+  tmp.lra_freq_ = PeriodToHz(rt_buf[1]);
+  return tmp;
+}
+
+bool Drv2605l::QueueRun(I2cBatch& batch, bool run) {
+  if (mode_ < 0) return false;  // can't read here, channel may not be selected until Commit
+
+  constexpr uint8_t sixth_bit_inverse_mask = 0b10111111;
+  pending_mode_ = (mode_ & sixth_bit_inverse_mask) | (run ? 0x00 : 0x01 << 6);
+  const uint8_t go = run;
+
+  return QueueWrite(batch, MODE.addr_, &pending_mode_, 1) && QueueWrite(batch, GO.addr_, &go, 1);
+}
+
+void Drv2605l::OnRunCommitted(bool run, bool ok) {
+  if (ok) {
+    run_ = run;
+    mode_ = pending_mode_;
+  } else {
+    mode_ = -1;
+  }
+}
+
 }  // namespace lra::device
\ No newline at end of file
@@ -7,9 +7,12 @@
 #include <memory/registers/registers.h>
 #include <util/log/logunit.h>
 
+#include <chrono>
+
 namespace lra::device {
 using ::lra::bus_adapter::i2c::I2cAdapter;
 using ::lra::bus_adapter::i2c::I2cAdapter_S;
+using ::lra::bus_adapter::i2c::I2cBatch;
 using ::lra::log_util::loglevel;
 
 // ref: device/tca
@@ -23,6 +26,7 @@ struct Drv2605lInfo {
   float lra_freq_{0.0};  // hz
   float compensation_coeff_{0.0};
   float back_emf_result_{0.0};
+  float calibration_time_s_{0.0};  // GO set -> GO cleared by device, polled
   std::string device_id_{""};
 };
 
@@ -90,6 +94,36 @@ class Drv2605l {  // DRV2605L
 
   // TODO: add modify
 
+  // batch, queue into a shared I2cBatch (e.g. after a TCA9548A channel select), nothing is sent until Commit
+  inline bool QueueWrite(I2cBatch& batch, const uint8_t addr, const uint8_t* val, const uint16_t len) {
+    return adapter_.QueueWrite(batch, addr, val, len);
+  }
+
+  inline bool QueueRead(I2cBatch& batch, const uint8_t addr, uint8_t* val, const uint16_t len) {
+    return adapter_.QueueRead(batch, addr, val, len);
+  }
+
+  inline ssize_t Commit(I2cBatch& batch) { return adapter_.Commit(batch); }
+
+  // queue RTP_INPUT and LRA_PERIOD reads, decode with ParseRt after Commit
+  bool QueueGetRt(I2cBatch& batch, uint8_t* rt_buf /* 2 bytes */);
+
+  static Drv2605lRtInfo ParseRt(const uint8_t* rt_buf);
+
+  // queue MODE (from cache) and GO writes, false if MODE is unknown, call OnRunCommitted after Commit
+  bool QueueRun(I2cBatch& batch, bool run);
+
+  void OnRunCommitted(bool run, bool ok);
+
+  // cached MODE, -1 for unknown
+  inline int16_t GetModeCache() const { return mode_; }
+
+  // this device received the same writes as src (broadcast with several mux channels open)
+  inline void MirrorState(const Drv2605l& src) {
+    run_ = src.run_;
+    mode_ = src.mode_;
+  }
+
   // registers
   constexpr static Register_8 STATUS{0x0, 0xE0};
   constexpr static Register_8 MODE{0x1, 0x40};
@@ -133,10 +167,20 @@ class Drv2605l {  // DRV2605L
 
   Drv2605lInfo RunAutoCalibration();
 
+  // non-blocking autocalibration, lets several drivers calibrate at once (the channel must be selected for each call)
+  // Start -> Poll until it returns 1 (GO cleared, 0 running, < 0 read failed) -> Finish
+  bool StartAutoCalibration();
+
+  int PollAutoCalibration();
+
+  Drv2605lInfo FinishAutoCalibration();
+
   void UpdateRTP(uint8_t val);
 
   float GetHz();
 
+  static inline float PeriodToHz(uint8_t lra_period) { return 1.0 / (lra_period * 98.46 * 1e-6); }
+
   Drv2605lRtInfo GetRt();
 
   void Run(bool);  // fire go or stop
@@ -149,6 +193,11 @@ class Drv2605l {  // DRV2605L
   I2cAdapter adapter_;
   std::string name_;
   bool run_{false};
+  int16_t mode_{-1};  // last MODE written, -1 for unknown; lets QueueRun skip the read-modify-write
+  uint8_t pending_mode_{0};
+  int16_t cal_prev_mode_{-1};
+  std::chrono::steady_clock::time_point cal_start_{};
+  std::chrono::steady_clock::time_point cal_done_{};
 };
 }  // namespace lra::device
 
@@ -15,6 +15,7 @@ bool Tca9548a::Init(I2cAdapter_S init_s) {
 ssize_t Tca9548a::Write(const uint8_t addr, const uint8_t* val, const uint32_t len) {
   // val will never be negative number
   // Write(const uint8_t&, const uint8_t*, uint32_t len)
+  mask_ = -1;
   return adapter_.Write(addr, val, len);
 }
 
@@ -26,6 +27,44 @@ std::vector<uint8_t> Tca9548a::Read(const uint8_t addr, const uint16_t len) {
   return vec;
 }
 
+ssize_t Tca9548a::Select(uint8_t mask) {
+  if (mask_ == mask) {
+    select_skips_++;
+    return 0;
+  }
+
+  select_writes_++;
+  auto ret = Write(CONTROL, mask);  // resets mask_
+  if (ret >= 0) mask_ = mask;       // smbus write returns 0
+  return ret;
+}
+
+bool Tca9548a::QueueSelect(I2cBatch& batch, uint8_t mask) {
+  if (queued_batch_ != &batch || batch.Empty()) {  // first select of this batch
+    queued_batch_ = &batch;
+    queued_mask_ = mask_;
+  }
+  if (queued_mask_ == mask) {
+    select_skips_++;
+    return true;
+  }
+
+  if (!adapter_.QueueWriteRaw(batch, &mask, 1, true)) return false;
+  select_writes_++;
+  queued_mask_ = mask;
+  return true;
+}
+
+ssize_t Tca9548a::Commit(I2cBatch& batch) {
+  auto ret = adapter_.Commit(batch);
+  if (ret < 0)
+    mask_ = -1;
+  else if (queued_batch_ == &batch)
+    mask_ = queued_mask_;
+  queued_batch_ = nullptr;
+  return ret;
+}
+
 int16_t Tca9548a::Read(const uint8_t addr) { 
   
   // you can use other integral type here to store read 1 byte value
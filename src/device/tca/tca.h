@@ -14,6 +14,7 @@ namespace lra::device {
 
 using ::lra::bus_adapter::i2c::I2cAdapter;
 using ::lra::bus_adapter::i2c::I2cAdapter_S;  // aka I2cAdapterInit_S
+using ::lra::bus_adapter::i2c::I2cBatch;
 
 class Tca9548a {
  public:
@@ -54,6 +55,7 @@ class Tca9548a {
     
     // It's ok to pass oversize val now (check in i2c_adapter layer), that is we don't need to write something like
     // ret = adapter_.Write(reg, (tpyename T::val_t)val);
+    mask_ = -1;  // bypasses Select(), channel state unknown
 
     if constexpr (is_register<U>)
       return adapter_.Write(reg, val.to_ullong());
@@ -73,6 +75,7 @@ class Tca9548a {
                                                                                                   const T& val) {
     // val will never be negative number
     // Write(const uint8_t&, const std::vector<uint8_t>& / const uint8_t& )
+    mask_ = -1;
     if constexpr (std::convertible_to<T, uint8_t>)
       return adapter_.Write(addr, (uint8_t)val);
     else
@@ -115,11 +118,40 @@ class Tca9548a {
   // single byte modify, device define
   // ssize_t Modify(const uint8_t addr, const uint8_t val, const uint8_t mask);
 
+  /**
+   * channel manager, mask is one bit per channel (several bits for broadcast writes to devices sharing an address)
+   * the last mask written is cached and CONTROL is only written on change, Write() to CONTROL invalidates the cache
+   */
+  ssize_t Select(uint8_t mask);
+
+  // current mask, -1 for unknown (before the first Select or after a failed write)
+  inline int16_t GetSelect() const { return mask_; }
+
+  inline void InvalidateSelect() { mask_ = -1; }
+
+  // profiling, CONTROL writes issued / skipped by the cache (batches included)
+  inline uint64_t GetSelectWriteCount() const { return select_writes_; }
+
+  inline uint64_t GetSelectSkipCount() const { return select_skips_; }
+
+  // batch, queue the control byte, the channels switch on the STOP after it
+  // skipped if the mask already matches what the batch leaves selected at this point
+  bool QueueSelect(I2cBatch& batch, uint8_t mask);
+
+  // commit and take over the last queued mask, cache invalidated on failure
+  ssize_t Commit(I2cBatch& batch);
+
   // registers
   constexpr static Register_8 CONTROL{0x0, 0x0};
 
  private:
   I2cAdapter adapter_;
+
+  int16_t mask_{-1};         // latched in device
+  int16_t queued_mask_{-1};  // selected after the batch being queued is committed
+  const I2cBatch* queued_batch_{nullptr};
+  uint64_t select_writes_{0};
+  uint64_t select_skips_{0};
 };
 }  // namespace lra::device
 
@@ -20,8 +20,6 @@
 int main(int argc, char *argv[]) {
   // create logunit settings
   std::shared_ptr<LogUnit> main_p = LogUnit::CreateLogUnit("main");
-  std::shared_ptr<LogUnit> acc_p = LogUnit::CreateLogUnit("acc_data");
-  std::shared_ptr<LogUnit> drv_p = LogUnit::CreateLogUnit("drv_data");
 
   // loggers pattern
   std::string system_normal = "[%Y-%m-%d %H:%M:%S.%e] [%l] [%s:%#] [ %! ] %v";
@@ -30,16 +28,8 @@ int main(int argc, char *argv[]) {
       "{\"time\": \"%Y-%m-%dT%H:%M:%S.%f%z\", \"name\": \"%n\", \"level\": \"%^%l%$\", \"process\": %P, \"thread\": "
       "%t, \"src\": \"%s:%#\", \"logunit\": \"%!\", \"message\": \"%v\"},"};
 
-  std::string data_json = {"%v"};
-
-  // generate runtime format string var, in main.h
-  auto acc_format = spdlog::fmt_lib::runtime(acc_format_str);
-  auto drv_format = spdlog::fmt_lib::runtime(drv_format_str);
-
   // loggers on open, on close
   spdlog::file_event_handlers sys_handlers;
-  spdlog::file_event_handlers acc_handlers;
-  spdlog::file_event_handlers drv_handlers;
 
   // callbacks
   sys_handlers.after_open = [](spdlog::filename_t filename, std::FILE *fstream) {
@@ -49,64 +39,46 @@ int main(int argc, char *argv[]) {
     fprintf(fstream, syslog_fformat_onopen, ctime(&t));
   };
 
-  acc_handlers.after_open = [](spdlog::filename_t filename, std::FILE *fstream) {
-    fprintf(fstream, "%s", acclog_fformat_onopen);
-  };
-
-  acc_handlers.before_close = [](spdlog::filename_t filename, std::FILE *fstream) {
-    fprintf(fstream, "%s", datalog_fformat_onclose);
-  };
-
-  drv_handlers.after_open = [](spdlog::filename_t filename, std::FILE *fstream) {
-    fprintf(fstream, "%s", drvlog_fformat_onopen);
-  };
-
-  drv_handlers.before_close = [](spdlog::filename_t filename, std::FILE *fstream) {
-    fprintf(fstream, "%s", datalog_fformat_onclose);
-  };
-
   // loggers
   auto system_logger = spdlog::rotating_logger_mt("system", "/home/ubuntu/LRA/data/log/lra/system.log", rot_max_size,
                                                   rot_max_files, true, sys_handlers);
-  auto acc_logger =
-      spdlog::basic_logger_mt("acc_data", "/home/ubuntu/LRA/data/log/lra/acc_data.log", true, acc_handlers);
-  auto drv_logger =
-      spdlog::basic_logger_mt("drv_data", "/home/ubuntu/LRA/data/log/lra/drv_data.log", true, drv_handlers);
 
   system_logger->set_pattern(system_normal);
   system_logger->set_level(loglevel::trace);
   spdlog::set_default_logger(system_logger);
 
-  acc_logger->set_pattern(data_json);
-  acc_logger->set_level(loglevel::info);
-
-  drv_logger->set_pattern(data_json);
-  drv_logger->set_level(loglevel::info);
-
   spdlog::flush_every(std::chrono::seconds(1));
 
-  // assign logger to acc_p and drv_p
-  acc_p->AddLogger(acc_logger);
-  drv_p->AddLogger(drv_logger);
+  // log calls only format into a ring from here on, file / console I/O on the writer thread
+  AsyncLog::Start(AsyncLogInit_S{.name_ = "log_writer", .capacity_ = log_ring_capacity,
+                                 .overflow_ = LogOverflow::kBlock, .cpu_ = log_writer_cpu});
 
   // create Controller -> Init -> Run
   auto controller_p = std::make_unique<lra::controller::Controller>();
   controller_p->Init();  // measure task start in another thread
 
-  // Timer
-  Timer timer;
-  uint32_t event_uid = timer.SetLoopEvent(TrigLoopExpired, 10.0);
+  // rtp commands are written as soon as they arrive, not on the next control loop tick
+  RtpActuator rtp_actuator;
+  RtpActuatorInit_S rtp_actuator_s;
+  rtp_actuator_s.name_ = "rtp_actuator";
+  rtp_actuator_s.rt_priority_ = rtp_actuator_rt_priority;
+  rtp_actuator_s.cpu_ = control_loop_cpu;
 
-  // control loop related
-  bool leave_control_loop = false;
-  std::vector<uint8_t> ws_rtp_cmd{0, 0, 0};  // use vectorToTuple to covert
+  rtp_actuator.Start(
+      rtp_actuator_s,
+      [&controller_p](const std::array<uint8_t, 3> &rtp) {
+        return controller_p->UpdateAllRtp(std::make_tuple(rtp[0], rtp[1], rtp[2]));
+      },
+      []() { return !on_calibration && !on_modify; });
 
   // server settings and callbacks
-  asio::io_service mainEventLoop;
+  // handlers run on lanes: kControl for latency critical commands, kDefault for the rest, kLong for calibration and
+  // the register access that must not overlap it (one at a time, in arrival order)
   lra::websocket::WebsocketServer ws_server;
+  WsDispatcher dispatcher;
 
-  ws_server.connect([&mainEventLoop, &ws_server, &main_p](ClientConnection conn) {
-    mainEventLoop.post([conn, &ws_server, &main_p]() {
+  ws_server.connect([&dispatcher, &ws_server, &main_p](ClientConnection conn) {
+    dispatcher.Post(WsLane::kDefault, [conn, &ws_server, &main_p]() {
       main_p->LogToDefault(loglevel::info, "ws_server new connection, total: {}", ws_server.numConnections());
 
       // Send a hello message to the client
@@ -114,262 +86,203 @@ int main(int argc, char *argv[]) {
     });
   });
 
-  ws_server.disconnect([&mainEventLoop, &ws_server, &main_p, &controller_p](ClientConnection conn) {
-    mainEventLoop.post([conn, &ws_server, &main_p, &controller_p]() {
+  ws_server.disconnect([&dispatcher, &ws_server, &main_p, &controller_p](ClientConnection conn) {
+    dispatcher.Post(WsLane::kDefault, [conn, &ws_server, &main_p, &controller_p]() {
       main_p->LogToDefault(loglevel::info, "ws_server disconnect, total: {}", ws_server.numConnections());
       if (ws_server.numConnections() == 0) {
-        // reset need_send_rt
-        need_send_rt = false;
         controller_p->PauseDrv();
       }
     });
   });
 
   /* send back module state: drv - run or stop, host name, update uuid */
-  ws_server.message("moduleInfoRequire", [&mainEventLoop, &ws_server, &main_p, &controller_p](ClientConnection conn,
-                                                                                              const Json::Value &args) {
-    mainEventLoop.post([conn, args, &ws_server, &main_p, &controller_p]() {
-      // get uuid of web
-
-      // XXX no uuid
-      std::string uuid_ = args["uuid"].asString();
-      uuid = uuid_;
-
-      Json::Value info;
-      Json::Value data;
-      char hostname[512];
-      gethostname(hostname, 511);
-      data["hostname"] = std::string(hostname);
-      data["activated"] = controller_p->drv_x_->GetRun();
+  dispatcher.Route(ws_server, "moduleInfoRequire", WsLane::kDefault,
+                   [&ws_server, &main_p, &controller_p](ClientConnection conn, const JsonView &args) {
+    // get uuid of web
 
-      auto now = std::chrono::system_clock::now();
-      info["uuid"] = uuid;
-      info["timestamp"] = spdlog::fmt_lib::format("{:%Y-%m-%d %H:%M:}{:%S}", now, now.time_since_epoch());
-      info["data"] = data;
-
-      // Echo the message pack to the client
-      ws_server.sendMessage(conn, "moduleInfoRequireResponse", info);
-
-      // log
-      main_p->LogToDefault(loglevel::info, "ws receive `moduleInfoRequire`, from uuid: {} ", uuid);
-    });
-  });
-
-  ws_server.message("drvDriveUpdate", [&mainEventLoop, &ws_server, &main_p, &controller_p](ClientConnection conn,
-                                                                                           const Json::Value &args) {
-    mainEventLoop.post([conn, args, &ws_server, &main_p, &controller_p]() {
-      bool to_run = args["data"]["run"].asBool();
+    // XXX no uuid
+    Uuid_S uuid_;
+    const std::string_view uuid_str = args["uuid"].asStringView();
+    uuid_.size_ = std::min(uuid_str.size(), sizeof(uuid_.str_));
+    memcpy(uuid_.str_, uuid_str.data(), uuid_.size_);
+    uuid.Publish(uuid_);
 
-      // XXX: set to_run, should compared to all run states
-      if (to_run != controller_p->drv_x_->GetRun()) {
-        to_run ? controller_p->RunDrv() : controller_p->PauseDrv();
-      }
-
-      Json::Value info;
-      Json::Value data;
-
-      data["msg"] = "ok";
-      data["run"] = controller_p->drv_x_->GetRun();
+    char hostname[512];
+    gethostname(hostname, 511);
 
-      auto now = std::chrono::system_clock::now();
-      info["uuid"] = uuid;
-      info["timestamp"] = spdlog::fmt_lib::format("{:%Y-%m-%d %H:%M:}{:%S}", now, now.time_since_epoch());
-      info["data"] = data;
-
-      // Echo the message pack to the client
-      ws_server.sendMessage(conn, "drvDriveUpdateRecv", info);
+    JsonWriter &w = BeginMessage("moduleInfoRequireResponse");
+    w.Member("hostname", hostname);
+    w.Member("activated", controller_p->drv_x_->GetRun());
 
-      // log
-      main_p->LogToDefault(loglevel::info, "ws receive `drvDriveUpdate`, to_run set to: {} ", to_run);
+    // Echo the message pack to the client
+    ws_server.sendMessage(conn, w.EndMessage());
 
-      // on_run
-      on_run = to_run;
-    });
+    // log
+    main_p->LogToDefault(loglevel::info, "ws receive `moduleInfoRequire`, from uuid: {} ", uuid_.View());
   });
 
-  ws_server.message("drvCmdUpdate", [&mainEventLoop, &ws_server, &main_p, &controller_p, &ws_rtp_cmd](
-                                        ClientConnection conn, const Json::Value &args) {
-    mainEventLoop.post([conn, args, &ws_server, &main_p, &controller_p, &ws_rtp_cmd]() {
-      uint8_t rtp_x = args["data"]["x"].asUInt();
-      uint8_t rtp_y = args["data"]["y"].asUInt();
-      uint8_t rtp_z = args["data"]["z"].asUInt();
+  dispatcher.Route(ws_server, "drvDriveUpdate", WsLane::kControl,
+                   [&ws_server, &main_p, &controller_p](ClientConnection conn, const JsonView &args) {
+    bool to_run = args["data"]["run"].asBool();
 
-      ws_rtp_cmd[0] = rtp_x;
-      ws_rtp_cmd[1] = rtp_y;
-      ws_rtp_cmd[2] = rtp_z;
-
-      on_update_cmd = true;
-
-      Json::Value info;
-      Json::Value data;
+    // runs beside the kLong lane, during calibration the control loop picks on_run up afterwards
+    // XXX: set to_run, should compared to all run states
+    if (!on_calibration && to_run != controller_p->drv_x_->GetRun()) {
+      to_run ? controller_p->RunDrv() : controller_p->PauseDrv();
+    }
 
-      data["msg"] = "ok";
+    JsonWriter &w = BeginMessage("drvDriveUpdateRecv");
+    w.Member("msg", "ok");
+    w.Member("run", controller_p->drv_x_->GetRun());
 
-      auto now = std::chrono::system_clock::now();
-      info["uuid"] = uuid;
-      info["timestamp"] = spdlog::fmt_lib::format("{:%Y-%m-%d %H:%M:}{:%S}", now, now.time_since_epoch());
-      info["data"] = data;
+    // Echo the message pack to the client
+    ws_server.sendMessage(conn, w.EndMessage());
 
-      // Echo the message pack to the client
-      ws_server.sendMessage(conn, "drvCmdUpdateRecv", info);
+    // log
+    main_p->LogToDefault(loglevel::info, "ws receive `drvDriveUpdate`, to_run set to: {} ", to_run);
 
-      // log
-      main_p->LogToDefault(loglevel::info, "ws receive `drvCmdUpdate`, new cmd x:{}, y:{}, z:{}", rtp_x, rtp_y, rtp_z);
-    });
+    // on_run
+    on_run = to_run;
   });
 
-  ws_server.message("regAllUpdate", [&mainEventLoop, &ws_server, &main_p, &controller_p](ClientConnection conn,
-                                                                                         const Json::Value &args) {
-    mainEventLoop.post([conn, args, &ws_server, &main_p, &controller_p]() {
-      // log
-      main_p->LogToDefault(loglevel::info, "ws receive `regAllUpdate starts`");
-
-      std::vector drv_x_arr = Uint8JsonArrayToVec(args["data"]["drv"]["x"]);
-      std::vector drv_y_arr = Uint8JsonArrayToVec(args["data"]["drv"]["y"]);
-      std::vector drv_z_arr = Uint8JsonArrayToVec(args["data"]["drv"]["z"]);
-      std::vector acc_arr = Uint8JsonArrayToVec(args["data"]["acc"]);  // spi 有 rw lock
-
-      on_modify = true;
-      controller_p->adxl_->SetStandBy(true);
-      /* write to  */
-      controller_p->UpdateAllRegisters(std::make_tuple(drv_x_arr, drv_y_arr, drv_z_arr, acc_arr));
-      if (!on_calibration) {
-        controller_p->adxl_->SetStandBy(false);  // XXX: 可能有誤提
-      }
-
-      on_modify = false;
-
-      Json::Value info;
-      Json::Value data;
+  dispatcher.Route(ws_server, "drvCmdUpdate", WsLane::kControl,
+                   [&ws_server, &main_p, &rtp_actuator](ClientConnection conn, const JsonView &args) {
+    uint8_t rtp_x = args["data"]["x"].asUInt();
+    uint8_t rtp_y = args["data"]["y"].asUInt();
+    uint8_t rtp_z = args["data"]["z"].asUInt();
 
-      data["msg"] = "ok";
+    // traced from the moment the server handed the message over
+    rtp_actuator.Submit({rtp_x, rtp_y, rtp_z}, WsDispatcher::PostedNs());
 
-      auto now = std::chrono::system_clock::now();
-      info["uuid"] = uuid;
-      info["timestamp"] = spdlog::fmt_lib::format("{:%Y-%m-%d %H:%M:}{:%S}", now, now.time_since_epoch());
-      info["data"] = data;
+    JsonWriter &w = BeginMessage("drvCmdUpdateRecv");
+    w.Member("msg", "ok");
 
-      // Echo the message pack to the client
-      ws_server.sendMessage(conn, "regAllUpdateRecv", info);
+    // Echo the message pack to the client
+    ws_server.sendMessage(conn, w.EndMessage());
 
-      // log
-      main_p->LogToDefault(loglevel::info, "ws receive `regAllUpdate` finished, size -- x: {}, y: {}, z: {}, acc: {}",
-                           drv_x_arr.size(), drv_y_arr.size(), drv_z_arr.size(), acc_arr.size());
-    });
+    // log
+    main_p->LogToDefault(loglevel::info, "ws receive `drvCmdUpdate`, new cmd x:{}, y:{}, z:{}", rtp_x, rtp_y, rtp_z);
   });
 
-  ws_server.message("calibrationRequire", [&mainEventLoop, &ws_server, &main_p, &controller_p](
-                                              ClientConnection conn, const Json::Value &args) {
-    mainEventLoop.post([conn, args, &ws_server, &main_p, &controller_p]() {
-      // log
-      auto start = std::chrono::system_clock::now();
-      main_p->LogToDefault(loglevel::info, "ws receive calibrationRequire");
-      auto origin = controller_p->adxl_->standby_;
-      on_calibration = true;
-      controller_p->adxl_->SetStandBy(true);
-      auto cal_result = controller_p->RunCalibration();
-      controller_p->adxl_->SetStandBy(origin);
-      on_calibration = false;
-
-      /* TODO: print local */
-
-      /* write to json */
-      auto [drv, acc] = CalibrationResultToJson(cal_result);
-
-      Json::Value info;
-      Json::Value data;
+  dispatcher.Route(ws_server, "regAllUpdate", WsLane::kLong,
+                   [&ws_server, &main_p, &controller_p](ClientConnection conn, const JsonView &args) {
+    // kLong: standby and register writes would change range / offset / filter under RunCalibration()
+    main_p->LogToDefault(loglevel::info, "ws receive `regAllUpdate starts`");
+
+    std::vector drv_x_arr = Uint8JsonArrayToVec(args["data"]["drv"]["x"]);
+    std::vector drv_y_arr = Uint8JsonArrayToVec(args["data"]["drv"]["y"]);
+    std::vector drv_z_arr = Uint8JsonArrayToVec(args["data"]["drv"]["z"]);
+    std::vector acc_arr = Uint8JsonArrayToVec(args["data"]["acc"]);  // spi 有 rw lock
+
+    on_modify = true;
+    controller_p->adxl_->SetStandBy(true);
+    /* write to  */
+    controller_p->UpdateAllRegisters(std::make_tuple(drv_x_arr, drv_y_arr, drv_z_arr, acc_arr));
+    if (!on_calibration) {
+      controller_p->adxl_->SetStandBy(false);  // XXX: 可能有誤提
+    }
 
-      data["msg"] = "ok";
-      data["drv"] = drv;
-      data["acc"] = acc;
+    on_modify = false;
 
-      auto now = std::chrono::system_clock::now();
-      info["uuid"] = uuid;
-      info["timestamp"] = spdlog::fmt_lib::format("{:%Y-%m-%d %H:%M:}{:%S}", now, now.time_since_epoch());
-      info["data"] = data;
+    JsonWriter &w = BeginMessage("regAllUpdateRecv");
+    w.Member("msg", "ok");
 
-      // Echo the message pack to the client
-      ws_server.sendMessage(conn, "calibrationRequireResponse", info);
+    // Echo the message pack to the client
+    ws_server.sendMessage(conn, w.EndMessage());
 
-      // log
-      main_p->LogToDefault(loglevel::info, "ws receive `calibrationRequire` finished, cost: {:.4f}(s)",
-                           (now - start).count() / 1e9);
-    });
+    // log
+    main_p->LogToDefault(loglevel::info, "ws receive `regAllUpdate` finished, size -- x: {}, y: {}, z: {}, acc: {}",
+                         drv_x_arr.size(), drv_y_arr.size(), drv_z_arr.size(), acc_arr.size());
   });
 
-  ws_server.message("regAllRequire", [&mainEventLoop, &ws_server, &main_p, &controller_p](ClientConnection conn,
-                                                                                          const Json::Value &args) {
-    mainEventLoop.post([conn, args, &ws_server, &main_p, &controller_p]() {
-      // log
+  dispatcher.Route(ws_server, "calibrationRequire", WsLane::kLong,
+                   [&ws_server, &main_p, &controller_p](ClientConnection conn, const JsonView &args) {
+    // log
+    auto start = std::chrono::system_clock::now();
+    main_p->LogToDefault(loglevel::info, "ws receive calibrationRequire");
+    auto origin = controller_p->adxl_->standby_;
+    on_calibration = true;
+    controller_p->adxl_->SetStandBy(true);
+    bool acc_ok = false;
+    auto cal_result = controller_p->RunCalibration(&acc_ok);
+    controller_p->adxl_->SetStandBy(origin);
+    on_calibration = false;
+
+    /* TODO: print local */
+
+    /* write to json */
+    auto now = std::chrono::system_clock::now();
+    JsonWriter &w = BeginMessage("calibrationRequireResponse", now);
+    w.Member("msg", acc_ok ? "ok" : "acc timeout, offset kept");
+    WriteCalibrationResult(w, cal_result);
 
-      auto [v_x, v_y, v_z, v_acc_ro, v_acc_rw] = controller_p->GetAllRegisters();  // seperate by FIFO
+    // Echo the message pack to the client
+    ws_server.sendMessage(conn, w.EndMessage());
 
-      /* TODO: print local */
+    // log
+    main_p->LogToDefault(loglevel::info, "ws receive `calibrationRequire` finished, cost: {:.4f}(s)",
+                         (now - start).count() / 1e9);
+  });
 
-      /* write to json */
+  dispatcher.Route(ws_server, "regAllRequire", WsLane::kLong,
+                   [&ws_server, &main_p, &controller_p](ClientConnection conn, const JsonView &args) {
+    // log
 
-      Json::Value info;
-      Json::Value data;
-      Json::Value drv;
-      Json::Value acc;
+    auto [v_x, v_y, v_z, v_acc_ro, v_acc_rw] = controller_p->GetAllRegisters();  // seperate by FIFO
 
-      drv["x"] = VecToJson(v_x);
-      drv["y"] = VecToJson(v_y);
-      drv["z"] = VecToJson(v_z);
-      acc["ro"] = VecToJson(v_acc_ro);
-      acc["rw"] = VecToJson(v_acc_rw);
+    /* TODO: print local */
 
-      data["msg"] = "ok";
-      data["drv"] = drv;
-      data["acc"] = acc;
+    /* write to json */
 
-      auto now = std::chrono::system_clock::now();
-      info["uuid"] = uuid;
-      info["timestamp"] = spdlog::fmt_lib::format("{:%Y-%m-%d %H:%M:}{:%S}", now, now.time_since_epoch());
-      info["data"] = data;
+    JsonWriter &w = BeginMessage("regAllRequireResponse");
+    w.Member("msg", "ok");
+    w.Key("drv").BeginObject();
+    w.Member("x", v_x).Member("y", v_y).Member("z", v_z);
+    w.EndObject();
+    w.Key("acc").BeginObject();
+    w.Member("ro", v_acc_ro).Member("rw", v_acc_rw);
+    w.EndObject();
 
-      // Echo the message pack to the client
-      ws_server.sendMessage(conn, "regAllRequireResponse", info);
+    // Echo the message pack to the client
+    ws_server.sendMessage(conn, w.EndMessage());
 
-      // log
-      main_p->LogToDefault(loglevel::info, "ws receive `regAllRequire`");
-    });
+    // log
+    main_p->LogToDefault(loglevel::info, "ws receive `regAllRequire`");
   });
 
-  ws_server.message("dataRTKeepRequire", [&mainEventLoop, &ws_server, &main_p, &controller_p](ClientConnection conn,
-                                                                                              const Json::Value &args) {
-    mainEventLoop.post([conn, args, &ws_server, &main_p, &controller_p]() {
-      // XXX
-      need_send_rt = true;
-
-      /* send back */
-
-      // log
-      main_p->LogToDefault(loglevel::info, "ws receive `dataRTKeepRequire`, start to send real time data");
-    });
+  dispatcher.Route(ws_server, "dataRTKeepRequire", WsLane::kControl,
+                   [&ws_server, &main_p, &controller_p](ClientConnection conn, const JsonView &args) {
+    // optional "format": "binary" / "json", otherwise keep what was negotiated on connect
+    const JsonView req = args["data"];
+    const std::string format = req["format"].asString();
+    if (format == "binary" || format == "json") ws_server.setRtBinary(conn, format == "binary");
+
+    // optional channels ("drv", "acc"), "decimation" and "policy": "drop_oldest" / "decimate"
+    RtSubscription sub;
+    sub.channels.drv = req["drv"].asBool(true);
+    sub.channels.acc = req["acc"].asBool(true);
+    sub.decimation = req["decimation"].asUInt(1);
+    if (req["policy"].asString() == "decimate") sub.policy = RtOverflowPolicy::kDecimate;
+    ws_server.subscribeRt(conn, sub);
+
+    /* send back */
+
+    // log
+    main_p->LogToDefault(loglevel::info,
+                         "ws receive `dataRTKeepRequire`, start to send real time data {}, drv: {}, acc: {}, "
+                         "decimation: {}, subscribers: {}",
+                         format.empty() ? "" : "(" + format + ")", sub.channels.drv, sub.channels.acc,
+                         sub.decimation, ws_server.numRtSubscribers());
   });
 
-  ws_server.message("dataRTStopRequire", [&mainEventLoop, &ws_server, &main_p, &controller_p](ClientConnection conn,
-                                                                                              const Json::Value &args) {
-    mainEventLoop.post([conn, args, &ws_server, &main_p, &controller_p]() {
-      // XXX
-      need_send_rt = false;
+  dispatcher.Route(ws_server, "dataRTStopRequire", WsLane::kControl,
+                   [&ws_server, &main_p, &controller_p](ClientConnection conn, const JsonView &args) {
+    ws_server.unsubscribeRt(conn);
 
-      Json::Value info;
-      Json::Value data;
+    /* send back */
 
-      data["msg"] = "ok";
-
-      auto now = std::chrono::system_clock::now();
-      info["uuid"] = uuid;
-      info["timestamp"] = spdlog::fmt_lib::format("{:%Y-%m-%d %H:%M:}{:%S}", now, now.time_since_epoch());
-      info["data"] = data;
-
-      /* send back */
-
-      // log
-      main_p->LogToDefault(loglevel::info, "ws receive `dataRTStopRequire`, stop to send real time data");
-    });
+    // log
+    main_p->LogToDefault(loglevel::info, "ws receive `dataRTStopRequire`, stop to send real time data");
   });
 
   // ws_server.message("drvDriveUpdate", [&mainEventLoop, &ws_server, &main_p, &controller_p](ClientConnection conn,
@@ -398,115 +311,190 @@ int main(int argc, char *argv[]) {
 
   
 
-  // create control loop thread
-  std::thread controller_t = std::thread([&controller_p, &leave_control_loop, &ws_rtp_cmd, &main_p, &ws_server]() {
-    int i = 0;
+  // control loop, absolute 10 ms deadlines on its own thread
+  // reused every tick, acc samples are copied out of the ring without allocation
+  constexpr size_t kAccPopMax = 4096;
+  std::vector<Adxl355::Acc3> acc_buf(kAccPopMax);
+
+  PeriodicLoop control_loop;
+  PeriodicLoopInit_S control_loop_s;
+  control_loop_s.name_ = "control_loop";
+  control_loop_s.period_ms_ = control_loop_period_ms;
+  control_loop_s.rt_priority_ = control_loop_rt_priority;
+  control_loop_s.cpu_ = control_loop_cpu;
+
+  // binary rt frames, buffer reused between ticks
+  RtFrameEncoder rt_encoder;
+  uint32_t rt_seq = 0;
+
+  // local data, fixed size ring record files (util/recorder) keeping the newest hours, continued across restarts
+  const Adxl355::Acc3 acc_offset = controller_p->adxl_->GetOffSet();
+  Recorder acc_rec;
+  acc_rec.Open(RecorderInit_S{.path_ = acc_record_path,
+                              .stream_ = "acc",
+                              .columns_ = {Column{"t", ColumnType::kI64}, Column{"x", ColumnType::kF32},
+                                           Column{"y", ColumnType::kF32}, Column{"z", ColumnType::kF32}},
+                              .ring_bytes_ = acc_ring_bytes,
+                              .odr_hz_ = controller_p->adxl_->GetOdr(),
+                              .range_g_ = controller_p->adxl_->GetRangeG(),
+                              .offset_g_ = {acc_offset.data.x, acc_offset.data.y, acc_offset.data.z}});
+
+  Recorder drv_rec;
+  drv_rec.Open(RecorderInit_S{.path_ = drv_record_path,
+                              .stream_ = "drv",
+                              .columns_ = {Column{"t", ColumnType::kF64}, Column{"rtp_x", ColumnType::kU8},
+                                           Column{"rtp_y", ColumnType::kU8}, Column{"rtp_z", ColumnType::kU8},
+                                           Column{"freq_x", ColumnType::kF32}, Column{"freq_y", ColumnType::kF32},
+                                           Column{"freq_z", ColumnType::kF32}},
+                              .ring_bytes_ = drv_ring_bytes,
+                              .odr_hz_ = static_cast<float>(1000.0 / control_loop_period_ms)});
+
+  control_loop.Start(control_loop_s, [&controller_p, &rtp_actuator, &main_p, &ws_server, &acc_buf, &rt_encoder,
+                                      &rt_seq, &control_loop, &dispatcher, &acc_rec, &drv_rec](uint64_t tick) {
+    if (!on_calibration) {
+      // test
+      // auto now = std::chrono::system_clock::now();
+      // main_p->LogToDefault(loglevel::info, "t: {0:%Y-%m-%d %H:%M:}{1:%S}", now, now.time_since_epoch());
+
+      if (!on_modify) {          // 沒收到 webpage 的更改指令，安全嗎? mutex
+        if (on_run) {
+        controller_p->RunDrv();  // 確保有在運作 >> 請更改這個
+        controller_p->adxl_->SetStandBy(false);
 
-    /* debug */
+        }
 
-    while (!leave_control_loop) {
-      if (control_loop_expired && !on_calibration) {
-        control_loop_expired = false;
-        // test
-        // auto now = std::chrono::system_clock::now();
-        // main_p->LogToDefault(loglevel::info, "t: {0:%Y-%m-%d %H:%M:}{1:%S}", now, now.time_since_epoch());
+        // per client subscriptions, a slow client only fills its own queue
+        const bool rt_subscribed = ws_server.numRtSubscribers() > 0;
+        if (on_run || rt_subscribed) {
+          // get real time info, once per tick for both the record files and the web
+          auto now = std::chrono::system_clock::now();
+          auto [rt_x, rt_y, rt_z] = controller_p->GetRt();  // if 0 might be wiring problem
+          size_t acc_n = controller_p->adxl_->AccPopInto(acc_buf);
+          const double t0 = (now - controller_p->start_time_).count();
+          const std::span<const Adxl355::Acc3> acc_span(acc_buf.data(), acc_n);
 
-        if (!on_modify) {          // 沒收到 webpage 的更改指令，安全嗎? mutex
+          /****************************** write to local *****************************/
           if (on_run) {
-          controller_p->RunDrv();  // 確保有在運作 >> 請更改這個
-          controller_p->adxl_->SetStandBy(false);
-
-          /* XXX: just for debug */
-          // ws_rtp_cmd[0] = 0x0;
-          // ws_rtp_cmd[1] = 0x0;
-          // ws_rtp_cmd[2] = 0x0;
-          // controller_p->UpdateAllRtp(VecToTuple<3, uint8_t>(ws_rtp_cmd));
-          }
-
-          if (on_update_cmd) {
-            controller_p->UpdateAllRtp(VecToTuple<3, uint8_t>(ws_rtp_cmd));
-            on_update_cmd = false;
-          }
-
-          // XXX: only allows one client and broadcast mode
-          if (need_send_rt) {
-            /****************************** write to web *****************************/
-
-            // get real time info
-            auto now = std::chrono::system_clock::now();
-            auto [rt_x, rt_y, rt_z] = controller_p->GetRt();  // if 0 might be wiring problem
-            auto v = controller_p->adxl_->AccPopAll();        // XXX: should be tune with PopN
-
-            // XXX rewrite this
-
-            Json::Value payload;
-            Json::Value data;
-            Json::Value drv;
-            Json::Value acc;
-
-            Json::Value drv_1axis;
-
-            /* time */
-            drv["t"] = (now - controller_p->start_time_).count();
-
-            /* drv */
-            drv_1axis["rtp"] = rt_x.rtp_;
-            drv_1axis["freq"] = rt_x.lra_freq_;
-
-            drv["x"] = drv_1axis;
-
-            drv_1axis["rtp"] = rt_y.rtp_;
-            drv_1axis["freq"] = rt_y.lra_freq_;
-
-            drv["y"] = drv_1axis;
-
-            drv_1axis["rtp"] = rt_z.rtp_;
-            drv_1axis["freq"] = rt_z.lra_freq_;
-
-            drv["z"] = drv_1axis;
-
-            /* acc */
-            for (auto &e : v) {
-              acc.append(Acc3ToJson(e));
+            for (size_t k = 0; k < acc_n; k++) {
+              acc_rec.Append(acc_buf[k].time, acc_buf[k].data.x, acc_buf[k].data.y, acc_buf[k].data.z);
             }
+            drv_rec.Append(t0, rt_x.rtp_, rt_y.rtp_, rt_z.rtp_, rt_x.lra_freq_, rt_y.lra_freq_, rt_z.lra_freq_);
 
-            data["drv"] = drv;
-            data["acc"] = acc;
-
-            // move to thread if cost to much time
-            std::string timestamp = spdlog::fmt_lib::format("{:%Y-%m-%d %H:%M:}{:%S}", now, now.time_since_epoch());
-
-            payload["uuid"] = uuid;
-            payload["timestamp"] = timestamp;
-            payload["data"] = data;
-
-            /*  XXX: can't get conn, so use broadcast*/
-            ws_server.broadcastMessage("dataRTKeepRequireResponse", payload);
-
-            /****************************** write to local *****************************/
-            // TODO
+            // bounds what a crash loses to ~1 s
+            if (tick % 100 == 99) {
+              acc_rec.Flush();
+              drv_rec.Flush();
+            }
           }
 
-        } else {
-          controller_p->PauseDrv();  // ensure module is not driven
+          /****************************** write to web *****************************/
+          if (rt_subscribed) {
+            RtDrv rt_drv;
+            rt_drv.rtp_[0] = rt_x.rtp_;
+            rt_drv.rtp_[1] = rt_y.rtp_;
+            rt_drv.rtp_[2] = rt_z.rtp_;
+            rt_drv.freq_[0] = rt_x.lra_freq_;
+            rt_drv.freq_[1] = rt_y.lra_freq_;
+            rt_drv.freq_[2] = rt_z.lra_freq_;
+
+            /* binary clients, one packed frame (rt_frame.h) */
+            auto to_binary = [&](RtChannels ch) {
+              return rt_encoder.Encode(rt_seq, t0, ch.drv ? &rt_drv : nullptr,
+                                       ch.acc ? acc_span : std::span<const Adxl355::Acc3>());
+            };
+
+            /* legacy JSON clients, written into this thread's writer buffer */
+            auto to_json = [&](RtChannels ch) {
+              JsonWriter &w = BeginMessage("dataRTKeepRequireResponse", now);
+
+              w.Key("drv").BeginObject();
+
+              /* time */
+              w.Member("t", t0);
+
+              /* drv */
+              if (ch.drv) {
+                w.Key("x").BeginObject().Member("rtp", rt_x.rtp_).Member("freq", rt_x.lra_freq_).EndObject();
+                w.Key("y").BeginObject().Member("rtp", rt_y.rtp_).Member("freq", rt_y.lra_freq_).EndObject();
+                w.Key("z").BeginObject().Member("rtp", rt_z.rtp_).Member("freq", rt_z.lra_freq_).EndObject();
+              }
+              w.EndObject();
+
+              /* acc */
+              w.Key("acc").BeginArray();
+              if (ch.acc) {
+                for (size_t k = 0; k < acc_n; k++) {
+                  WriteAcc3(w, acc_buf[k]);
+                }
+              }
+              w.EndArray();
+
+              return w.EndMessage();
+            };
+
+            ws_server.publishRt(to_json, to_binary);
+            rt_seq++;
+          }
         }
 
-        // DEBUG: alive log
-        i++;
-        if (i >= 500) {
-          i = 0;
-          /* get mode --DEBUG */
-          controller_p->ChangeDrvCh('x');
-          auto now = std::chrono::system_clock::now();
-          main_p->LogToDefault(loglevel::debug, "controller thread alive: : {:%Y-%m-%d %H:%M:}{:%S}", now,
-                               now.time_since_epoch());
-        }
       } else {
-        std::this_thread::yield();
+        controller_p->PauseDrv();  // ensure module is not driven
       }
     }
 
-    return;
+    // DEBUG: alive log
+    if (tick % 500 == 499) {
+      auto now = std::chrono::system_clock::now();
+      auto [mux_writes, mux_skips] = controller_p->GetMuxWriteCount();
+      auto& jitter = control_loop.GetJitter();
+      main_p->LogToDefault(loglevel::debug,
+                           "controller thread alive: : {:%Y-%m-%d %H:%M:}{:%S}, mux writes: {}, skipped: {}, "
+                           "jitter p99: {} us, max: {} us, exec p99: {} us, overruns: {}",
+                           now, now.time_since_epoch(), mux_writes, mux_skips, jitter.Percentile(99) / 1000,
+                           jitter.Max() / 1000, control_loop.GetExecTime().Percentile(99) / 1000,
+                           control_loop.GetOverrunCount());
+
+      auto &e2e = rtp_actuator.GetEndToEnd();
+      main_p->LogToDefault(loglevel::debug,
+                           "rtp cmd: applied: {}, coalesced: {}, failed: {}, receive to i2c done p50: {} us, "
+                           "p99: {} us, max: {} us, wake p99: {} us, i2c p99: {} us",
+                           rtp_actuator.GetAppliedCount(), rtp_actuator.GetCoalescedCount(),
+                           rtp_actuator.GetFailedCount(), e2e.Percentile(50) / 1000, e2e.Percentile(99) / 1000,
+                           e2e.Max() / 1000, rtp_actuator.GetWakeLatency().Percentile(99) / 1000,
+                           rtp_actuator.GetApplyTime().Percentile(99) / 1000);
+
+      for (auto lane : {WsLane::kControl, WsLane::kDefault, WsLane::kLong}) {
+        auto &wait = dispatcher.GetWait(lane);
+        main_p->LogToDefault(loglevel::debug, "ws lane {}: handled: {}, pending: {}, wait p99: {} us, max: {} us",
+                             WsDispatcher::LaneName(lane), wait.Count(), dispatcher.GetPending(lane),
+                             wait.Percentile(99) / 1000, wait.Max() / 1000);
+      }
+
+      const auto log_stats = AsyncLog::Instance().GetStats();
+      main_p->LogToDefault(loglevel::debug,
+                           "async log: logged: {}, written: {}, queued: {}, dropped: {}, blocked: {}, "
+                           "block p99: {} us, truncated: {}, sink errors: {}",
+                           log_stats.logged_, log_stats.written_, log_stats.queued_, log_stats.dropped_,
+                           log_stats.blocked_, AsyncLog::Instance().GetBlockTime().Percentile(99) / 1000,
+                           log_stats.truncated_, log_stats.sink_errors_);
+
+      for (auto *rec : {&acc_rec, &drv_rec}) {
+        main_p->LogToDefault(loglevel::debug,
+                             "record: rows: {}, dropped: {}, {} -> {} B, write errors: {}, chunk write p99: {} us, "
+                             "block msync p99: {} us",
+                             rec->GetRows(), rec->GetDroppedRows(), rec->GetRawBytes(), rec->GetStoredBytes(),
+                             rec->GetWriteErrors(), rec->GetWriteTime().Percentile(99) / 1000,
+                             rec->GetRing().GetSyncTime().Percentile(99) / 1000);
+      }
+
+      for (auto &client : ws_server.rtClientStats()) {
+        main_p->LogToDefault(loglevel::debug,
+                             "rt client ({}): sent: {}, dropped: {}, queued: {}, lag: {:.1f} ms, buffered: {} B, "
+                             "decimation: {}",
+                             client.binary ? "binary" : "json", client.sent, client.dropped, client.queued,
+                             client.lagMs, client.bufferedBytes, client.decimation);
+      }
+    }
   });
 
   main_p->LogToDefault(loglevel::info, "ws server on");
@@ -514,25 +502,23 @@ int main(int argc, char *argv[]) {
   // Start the networking thread
   std::thread serverThread([&ws_server]() { ws_server.run(8765); });
 
-  main_p->LogToDefault(loglevel::info, "mainEventLoop on\n");
+  main_p->LogToDefault(loglevel::info, "dispatcher on\n");
   system_logger->flush();
 
-  std::shared_ptr<asio::io_service::work> work = make_shared<asio::io_service::work>(mainEventLoop);
-
-  // std::thread usr_it([&work]() {
+  // std::thread usr_it([&dispatcher]() {
   //   while (true) {
   //     // get usr input
   //     char x;
   //     std::cin >> x;
   //     if (x == 'q') {
-  //       work.reset();
+  //       dispatcher.Stop();
   //       break;
   //     }
   //   }
   // });
 
-  // blocks here
-  mainEventLoop.run();
+  // blocks here, kDefault runs on this thread
+  dispatcher.Run();
   
   // usr_it.detach();
 
@@ -541,74 +527,74 @@ int main(int argc, char *argv[]) {
 
   // if server down
   std::cout <<  "going to leave";
-  leave_control_loop = true;
+  control_loop.Stop();
+  rtp_actuator.Stop();
+
+  // last partial chunks
+  acc_rec.Close();
+  drv_rec.Close();
 
   // drop controller
   controller_p->CancelMeasureTask();
   controller_p.reset();
 
-  // drop loop event
-  timer.CancelEvent(event_uid);
-
-  // drop loggers
+  // write what is queued, then drop loggers
+  AsyncLog::Stop();
   spdlog::drop_all();
 
   return 0;
 }
 
 // functions impl
-void TrigLoopExpired() { control_loop_expired = true; }
-
-std::tuple<Json::Value, Json::Value> CalibrationResultToJson(
-    const std::tuple<Drv2605lInfo, Drv2605lInfo, Drv2605lInfo, Adxl355::Acc3> &t) {
-  auto [s_x, s_y, s_z, s_acc] = t;
-
-  Json::Value drv_x = Drv2605lInfoToJson(s_x);
-  Json::Value drv_y = Drv2605lInfoToJson(s_y);
-  Json::Value drv_z = Drv2605lInfoToJson(s_z);
-  Json::Value acc = Acc3ToJson(s_acc);
-  Json::Value drv;
-
-  drv["x"] = drv_x;
-  drv["y"] = drv_y;
-  drv["z"] = drv_z;
-
-  return std::make_tuple(drv, acc);
+JsonWriter &BeginMessage(std::string_view type, std::chrono::system_clock::time_point now) {
+  Uuid_S uuid_;
+  uuid.Read(uuid_);
+  return JsonWriter::ThisThread().BeginMessage(type, uuid_.View(), now);
 }
 
-Json::Value Drv2605lInfoToJson(const Drv2605lInfo &data) {
-  Json::Value result;
-  result["id"] = data.device_id_;
-  result["result"] = data.diag_result_;
-  result["vbat"] = data.vbat_;
-  result["freq"] = data.lra_freq_;
-  result["bemf"] = data.back_emf_result_;
-  result["fb_coeff"] = data.compensation_coeff_;
-  return result;
+void WriteCalibrationResult(JsonWriter &w,
+                            const std::tuple<Drv2605lInfo, Drv2605lInfo, Drv2605lInfo, Adxl355::Acc3> &t) {
+  auto &[s_x, s_y, s_z, s_acc] = t;
+
+  w.Key("drv").BeginObject();
+  w.Key("x");
+  WriteDrv2605lInfo(w, s_x);
+  w.Key("y");
+  WriteDrv2605lInfo(w, s_y);
+  w.Key("z");
+  WriteDrv2605lInfo(w, s_z);
+  w.EndObject();
+
+  w.Key("acc");
+  WriteAcc3(w, s_acc);
 }
 
-Json::Value Acc3ToJson(const Adxl355::Acc3 &data) {
-  Json::Value result;
-  result["t"] = data.time;
-  result["x"] = data.data.x;
-  result["y"] = data.data.y;
-  result["z"] = data.data.z;
-  return result;
+void WriteDrv2605lInfo(JsonWriter &w, const Drv2605lInfo &data) {
+  w.BeginObject();
+  w.Member("id", data.device_id_);
+  w.Member("result", data.diag_result_);
+  w.Member("vbat", data.vbat_);
+  w.Member("freq", data.lra_freq_);
+  w.Member("bemf", data.back_emf_result_);
+  w.Member("fb_coeff", data.compensation_coeff_);
+  w.Member("cal_time", data.calibration_time_s_);
+  w.EndObject();
 }
 
-Json::Value VecToJson(const std::vector<uint8_t> v) {
-  Json::Value result;
-  for (auto &e : v) {
-    result.append(e);
-  }
-  return result;
+void WriteAcc3(JsonWriter &w, const Adxl355::Acc3 &data) {
+  w.BeginObject();
+  w.Member("t", data.time);
+  w.Member("x", data.data.x);
+  w.Member("y", data.data.y);
+  w.Member("z", data.data.z);
+  w.EndObject();
 }
 
-std::vector<uint8_t> Uint8JsonArrayToVec(const Json::Value &arr) {
+std::vector<uint8_t> Uint8JsonArrayToVec(const JsonView &arr) {
   std::vector<uint8_t> v;
   v.reserve(arr.size());
 
-  for (auto &e : arr) {
+  for (JsonView e : arr) {
     v.push_back(e.asUInt());
   }
 
@@ -2,42 +2,49 @@
 #define LRA_MAIN_H_
 
 #include <controller/controller.h>
+#include <controller/rtp_actuator.h>
 #include <util/log/logunit.h>
-#include <util/timer/timer.h>
+#include <util/mailbox/mailbox.h>
+#include <util/recorder/recorder.h>
+#include <util/timer/periodic_loop.h>
+#include <websocket/dispatcher.h>
+#include <websocket/json_writer.h>
 #include <websocket/websocket.h>
 
 /* spdlog */
-#include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 
+#include <atomic>
+
 constexpr auto rot_max_size = 1048576 * 5;  // 5 MB
 constexpr auto rot_max_files = 3;
 
 /* using */
+using ::lra::controller::RtpActuator;
+using ::lra::controller::RtpActuatorInit_S;
 using ::lra::device::Adxl355;
 using ::lra::device::Drv2605lInfo;
+using ::lra::log_util::AsyncLog;
+using ::lra::log_util::AsyncLogInit_S;
+using ::lra::log_util::LogOverflow;
 using ::lra::log_util::loglevel;
 using ::lra::log_util::LogUnit;
-using ::lra::timer_util::Timer;
+using ::lra::recorder_util::Column;
+using ::lra::recorder_util::ColumnType;
+using ::lra::recorder_util::Recorder;
+using ::lra::recorder_util::RecorderInit_S;
+using ::lra::timer_util::PeriodicLoop;
+using ::lra::timer_util::PeriodicLoopInit_S;
 using ::lra::websocket::ClientConnection;
-
-/* format string */
-std::string acc_format_str = {
-    "{{\"t\": \"{:.4f}\", "
-    "\"x\": \"{:.4f}\", "
-    "\"y\": \"{:.4f}\", "
-    "\"z\": \"{:.4f}\"}},"};
-
-std::string drv_1axis_str = {
-    "{{"
-    "\"cmd\": \"{:d}\", "
-    "\"freq\": \"{:.3f}\""
-    "}},"};
-
-std::string drv_format_str = {
-    "{{\"t\": \"{:.4f}\", "
-    "\"x\": " +
-    drv_1axis_str + "\"y\": " + drv_1axis_str + "\"z\": " + drv_1axis_str + "}},"};
+using ::lra::websocket::JsonView;
+using ::lra::websocket::JsonWriter;
+using ::lra::websocket::WsDispatcher;
+using ::lra::websocket::WsLane;
+using ::lra::websocket::RtChannels;
+using ::lra::websocket::RtDrv;
+using ::lra::websocket::RtFrameEncoder;
+using ::lra::websocket::RtOverflowPolicy;
+using ::lra::websocket::RtSubscription;
 
 // fprintf format
 const char* syslog_fformat_onopen =
@@ -48,41 +55,50 @@ const char* syslog_fformat_onopen =
     " start time: %s\n\n\n"
     "";
 
-const char* acclog_fformat_onopen =
-    "{"
-    "acc: ["
-    "";
+/* ring record files (util/recorder), lra_ring_extract for a time range, lra_record_convert for csv / json */
+const char* acc_record_path = "/home/ubuntu/LRA/data/log/lra/acc_data.lrg";
+const char* drv_record_path = "/home/ubuntu/LRA/data/log/lra/drv_data.lrg";
+constexpr uint64_t acc_ring_bytes = 2ull << 30;    // ~12 h at 4 kHz (~165 MB/h stored)
+constexpr uint64_t drv_ring_bytes = 256ull << 20;
 
-const char* drvlog_fformat_onopen =
-    "{"
-    "drv: ["
-    "";
-const char* datalog_fformat_onclose = "],}";
+/* async log */
+constexpr uint32_t log_ring_capacity = 8192;  // 4 MB of records
+constexpr int log_writer_cpu = 0;             // with the ws server, off the control loop's cpu
 
-/* global states */
-bool control_loop_expired{false};
-bool on_calibration{false};
-bool on_modify{false};
-bool on_update_cmd{false};
-bool on_run{false};
+/* control loop */
+constexpr double control_loop_period_ms = 10.0;
+constexpr int control_loop_rt_priority = 80;  // SCHED_FIFO, falls back to SCHED_OTHER without CAP_SYS_NICE
+constexpr int control_loop_cpu = 3;           // keep off cpu 0 (irq, ws server)
+constexpr int rtp_actuator_rt_priority = 85;  // above the control loop, a command preempts its tick
+
+/* global states, shared by ws handlers and the control loop */
+std::atomic<bool> on_calibration{false};
+std::atomic<bool> on_modify{false};
+std::atomic<bool> on_run{false};
 
 /* FIXME: should not be global */
-bool need_send_rt{false};
-std::string uuid{""};
+// uuid of the web page, set by moduleInfoRequire (kDefault lane), read by every outbound message
+struct Uuid_S {
+  char str_[64]{};
+  size_t size_{0};
+  std::string_view View() const { return std::string_view(str_, size_); }
+};
+lra::mailbox_util::SeqlockMailbox<Uuid_S> uuid;
 
 /* functions */
-void TrigLoopExpired();
-
-Json::Value Drv2605lInfoToJson(const Drv2605lInfo& data);
+// starts an outbound message on the calling thread's writer, fill "data" then EndMessage()
+JsonWriter& BeginMessage(std::string_view type,
+                         std::chrono::system_clock::time_point now = std::chrono::system_clock::now());
 
-Json::Value Acc3ToJson(const Adxl355::Acc3& data);
+void WriteDrv2605lInfo(JsonWriter& w, const Drv2605lInfo& data);
 
-Json::Value VecToJson(const std::vector<uint8_t> v);
+void WriteAcc3(JsonWriter& w, const Adxl355::Acc3& data);
 
-std::tuple<Json::Value, Json::Value> CalibrationResultToJson(
-    const std::tuple<Drv2605lInfo, Drv2605lInfo, Drv2605lInfo, Adxl355::Acc3>& t);
+// "drv": {x, y, z}, "acc"
+void WriteCalibrationResult(JsonWriter& w,
+                            const std::tuple<Drv2605lInfo, Drv2605lInfo, Drv2605lInfo, Adxl355::Acc3>& t);
 
-std::vector<uint8_t> Uint8JsonArrayToVec(const Json::Value& arr);
+std::vector<uint8_t> Uint8JsonArrayToVec(const JsonView& arr);
 
 template <typename T, std::size_t... Indices>
 auto vectorToTupleHelper(const std::vector<T>& v, std::index_sequence<Indices...>) {
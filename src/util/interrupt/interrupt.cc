@@ -0,0 +1,191 @@
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <util/interrupt/interrupt.h>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <random>
+
+namespace lra::interrupt_util {
+
+uint64_t MonotonicNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// IrqSource
+IrqSource::IrqSource() { wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC); }
+
+IrqSource::~IrqSource() {
+  if (fd_ >= 0) close(fd_);
+  if (wake_fd_ >= 0) close(wake_fd_);
+}
+
+void IrqSource::Close() {
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+WaitResult IrqSource::Wait(int timeout_ms, uint64_t* n_edges) {
+  if (n_edges) *n_edges = 0;
+  if (fd_ < 0) return WaitResult::kError;
+
+  pollfd fds[2] = {{fd_, POLLIN | POLLPRI, 0}, {wake_fd_, POLLIN, 0}};
+  int rtn = poll(fds, 2, timeout_ms);
+
+  if (rtn < 0) return (errno == EINTR) ? WaitResult::kTimeout : WaitResult::kError;
+
+  if (rtn == 0) {
+    timeouts_.fetch_add(1, std::memory_order_relaxed);
+    return WaitResult::kTimeout;
+  }
+
+  if (fds[1].revents & POLLIN) {
+    uint64_t val;
+    [[maybe_unused]] auto rd = read(wake_fd_, &val, sizeof(val));
+    return WaitResult::kWoken;
+  }
+
+  uint64_t t_edge = 0;
+  uint64_t n = Consume(t_edge);
+  if (n == 0) return WaitResult::kTimeout;  // spurious
+
+  edges_.fetch_add(n, std::memory_order_relaxed);
+  missed_.fetch_add(n - 1, std::memory_order_relaxed);
+
+  if (t_edge != 0) {
+    uint64_t now = MonotonicNs();
+    if (now > t_edge) latency_.Record(now - t_edge);
+  }
+
+  if (n_edges) *n_edges = n;
+  return WaitResult::kEdge;
+}
+
+void IrqSource::Wake() {
+  uint64_t one = 1;
+  [[maybe_unused]] auto wr = write(wake_fd_, &one, sizeof(one));
+}
+
+// EventFdIrq
+EventFdIrq::~EventFdIrq() { Close(); }
+
+bool EventFdIrq::Open() {
+  if (fd_ < 0) fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  return fd_ >= 0;
+}
+
+void EventFdIrq::Notify() {
+  t_last_edge_ns_.store(MonotonicNs(), std::memory_order_relaxed);
+  uint64_t one = 1;
+  [[maybe_unused]] auto wr = write(fd_, &one, sizeof(one));
+}
+
+uint64_t EventFdIrq::Consume(uint64_t& t_edge_ns) {
+  uint64_t n = 0;
+  if (read(fd_, &n, sizeof(n)) != sizeof(n)) return 0;
+  t_edge_ns = t_last_edge_ns_.load(std::memory_order_relaxed);
+  return n;
+}
+
+// GpioLineIrq
+GpioLineIrq::GpioLineIrq(std::string chip, uint32_t line, bool rising) : chip_(chip), line_(line), rising_(rising) {}
+
+GpioLineIrq::~GpioLineIrq() { Close(); }
+
+bool GpioLineIrq::Open() {
+  if (fd_ >= 0) return true;
+
+  int chip_fd = open(chip_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (chip_fd < 0) return false;
+
+  gpioevent_request req;
+  memset(&req, 0, sizeof(req));
+  req.lineoffset = line_;
+  req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+#ifdef GPIOHANDLE_REQUEST_BIAS_PULL_DOWN
+  req.handleflags |= GPIOHANDLE_REQUEST_BIAS_PULL_DOWN;
+#endif
+  req.eventflags = rising_ ? GPIOEVENT_REQUEST_RISING_EDGE : GPIOEVENT_REQUEST_FALLING_EDGE;
+  strncpy(req.consumer_label, "lra_irq", sizeof(req.consumer_label) - 1);
+
+  int rtn = ioctl(chip_fd, GPIO_GET_LINEEVENT_IOCTL, &req);
+  close(chip_fd);
+  if (rtn < 0) return false;
+
+  // non-blocking, Consume() drains all queued events
+  fcntl(req.fd, F_SETFL, fcntl(req.fd, F_GETFL) | O_NONBLOCK);
+  fd_ = req.fd;
+  return true;
+}
+
+uint64_t GpioLineIrq::Consume(uint64_t& t_edge_ns) {
+  constexpr int max_events = 16;
+  gpioevent_data events[max_events];
+  uint64_t n = 0;
+
+  ssize_t rd;
+  while ((rd = read(fd_, events, sizeof(events))) > 0) {
+    size_t got = rd / sizeof(gpioevent_data);
+    n += got;
+    t_edge_ns = events[got - 1].timestamp;  // CLOCK_MONOTONIC since linux 5.7
+    if (got < max_events) break;
+  }
+  return n;
+}
+
+// SimIrq
+SimIrq::SimIrq(double rate_hz, double jitter_us) : rate_hz_(rate_hz), jitter_us_(jitter_us) {}
+
+SimIrq::~SimIrq() { Close(); }
+
+bool SimIrq::Open() {
+  if (!EventFdIrq::Open()) return false;
+  if (!run_.exchange(true)) generator_ = std::thread(&SimIrq::Generate, this);
+  return true;
+}
+
+void SimIrq::Close() {
+  if (run_.exchange(false) && generator_.joinable()) generator_.join();
+  EventFdIrq::Close();
+}
+
+void SimIrq::Generate() {
+  const uint64_t period_ns = static_cast<uint64_t>(1e9 / rate_hz_);
+  std::mt19937 gen{std::random_device{}()};
+  std::uniform_int_distribution<int64_t> jitter(0, static_cast<int64_t>(jitter_us_ * 1000));
+
+  timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+
+  while (run_.load(std::memory_order_relaxed)) {
+    next.tv_nsec += period_ns;
+    while (next.tv_nsec >= 1000000000) {
+      next.tv_nsec -= 1000000000;
+      next.tv_sec++;
+    }
+
+    timespec t = next;
+    if (jitter_us_ > 0) {
+      t.tv_nsec += jitter(gen);
+      if (t.tv_nsec >= 1000000000) {
+        t.tv_nsec -= 1000000000;
+        t.tv_sec++;
+      }
+    }
+
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, nullptr);
+    Notify();
+    fired_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace lra::interrupt_util
@@ -0,0 +1,124 @@
+#ifndef LRA_UTIL_INTERRUPT_H_
+#define LRA_UTIL_INTERRUPT_H_
+
+/**
+ * @brief Pollable interrupt sources, a thread blocks in Wait() until an edge arrives instead of spinning on a flag.
+ *
+ * @note
+ *   1. EventFdIrq: Notify() from any callback (e.g. wiringPiISR), edges are counted by the eventfd
+ *   2. GpioLineIrq: GPIO character device line events (/dev/gpiochipN), edges are timestamped by kernel
+ *   3. SimIrq: edge generator thread for CI, no Pi needed
+ *   Edges that arrive between two Wait() are coalesced and counted as missed.
+ */
+
+#include <util/stats/stats.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace lra::interrupt_util {
+
+using ::lra::stats_util::LatencyHistogram;
+
+enum class WaitResult { kEdge, kTimeout, kWoken, kError };
+
+// CLOCK_MONOTONIC in ns, same clock as GPIO line event timestamps
+uint64_t MonotonicNs();
+
+class IrqSource {
+ public:
+  IrqSource();
+  virtual ~IrqSource();
+
+  IrqSource(const IrqSource&) = delete;
+  IrqSource& operator=(const IrqSource&) = delete;
+
+  virtual bool Open() = 0;
+  virtual void Close();
+
+  // block until edge, timeout (ms, -1 for infinite) or Wake(); n_edges gets edges since last Wait
+  WaitResult Wait(int timeout_ms, uint64_t* n_edges = nullptr);
+
+  // release a blocked Wait(), e.g. leaving measure thread
+  void Wake();
+
+  inline int GetFd() const { return fd_; }
+  inline uint64_t GetEdgeCount() const { return edges_.load(std::memory_order_relaxed); }
+  inline uint64_t GetMissedCount() const { return missed_.load(std::memory_order_relaxed); }
+  inline uint64_t GetTimeoutCount() const { return timeouts_.load(std::memory_order_relaxed); }
+
+  // edge to wakeup latency (ns)
+  inline const LatencyHistogram& GetLatency() const { return latency_; }
+
+ protected:
+  // read pending edges from fd_, return number of edges and time (MonotonicNs) of the newest edge, 0 if unknown
+  virtual uint64_t Consume(uint64_t& t_edge_ns) = 0;
+
+  int fd_{-1};
+
+ private:
+  int wake_fd_{-1};
+  std::atomic<uint64_t> edges_{0};
+  std::atomic<uint64_t> missed_{0};
+  std::atomic<uint64_t> timeouts_{0};
+  LatencyHistogram latency_{};
+};
+
+class EventFdIrq : public IrqSource {
+ public:
+  ~EventFdIrq() override;
+
+  bool Open() override;
+
+  // async-signal-safe, only eventfd write and atomic store
+  void Notify();
+
+ protected:
+  uint64_t Consume(uint64_t& t_edge_ns) override;
+
+ private:
+  std::atomic<uint64_t> t_last_edge_ns_{0};
+};
+
+class GpioLineIrq : public IrqSource {
+ public:
+  GpioLineIrq(std::string chip, uint32_t line, bool rising = true);
+  ~GpioLineIrq() override;
+
+  bool Open() override;
+
+ protected:
+  uint64_t Consume(uint64_t& t_edge_ns) override;
+
+ private:
+  std::string chip_;
+  uint32_t line_;
+  bool rising_;
+};
+
+// simulated data ready line, fires at rate_hz on absolute deadlines with optional uniform jitter
+class SimIrq : public EventFdIrq {
+ public:
+  explicit SimIrq(double rate_hz, double jitter_us = 0.0);
+  ~SimIrq() override;
+
+  bool Open() override;
+  void Close() override;
+
+  inline uint64_t GetFiredCount() const { return fired_.load(std::memory_order_relaxed); }
+
+ private:
+  double rate_hz_;
+  double jitter_us_;
+  std::atomic<bool> run_{false};
+  std::atomic<uint64_t> fired_{0};
+  std::thread generator_{};
+
+  void Generate();
+};
+
+}  // namespace lra::interrupt_util
+
+#endif
@@ -0,0 +1,212 @@
+#include <pthread.h>
+#include <spdlog/sinks/sink.h>
+#include <util/log/async_log.h>
+
+#include <bit>
+#include <chrono>
+#include <cstring>
+
+namespace lra::log_util {
+
+AsyncLog AsyncLog::instance_;
+
+AsyncLog::~AsyncLog() { Stop(); }
+
+bool AsyncLog::Start(const AsyncLogInit_S& init_s) {
+  AsyncLog& log = instance_;
+  if (log.run_.load(std::memory_order_relaxed)) return false;
+
+  log.init_s_ = init_s;
+  const uint64_t capacity = std::bit_ceil(std::max<uint64_t>(init_s.capacity_, 2));
+  if (capacity != log.mask_ + 1 || !log.records_) {
+    log.records_ = std::make_unique<Record[]>(capacity);
+    log.mask_ = capacity - 1;
+  }
+
+  // positions go on from the last run, a record is free when its seq equals the position that claims it
+  const uint64_t base = log.tail_.load(std::memory_order_relaxed);
+  for (uint64_t i = 0; i < capacity; i++) log.records_[(base + i) & log.mask_].seq_.store(base + i);
+  log.head_ = base;
+  log.head_pub_.store(base, std::memory_order_relaxed);
+
+  log.run_.store(true);
+  log.t_ = std::thread(&AsyncLog::Run, &log);
+  active_.store(true);
+  return true;
+}
+
+void AsyncLog::Stop() {
+  AsyncLog& log = instance_;
+  if (!log.run_.load(std::memory_order_relaxed)) return;
+
+  active_.store(false);
+  log.run_.store(false);
+  log.seq_.fetch_add(1);
+  log.seq_.notify_one();
+  if (log.t_.joinable()) log.t_.join();
+}
+
+AsyncLogStats AsyncLog::GetStats() const {
+  const uint64_t tail = tail_.load(std::memory_order_relaxed);
+  const uint64_t head = head_pub_.load(std::memory_order_relaxed);
+  return AsyncLogStats{.logged_ = logged_.load(std::memory_order_relaxed),
+                       .written_ = written_.load(std::memory_order_relaxed),
+                       .dropped_ = dropped_.load(std::memory_order_relaxed),
+                       .blocked_ = blocked_.load(std::memory_order_relaxed),
+                       .truncated_ = truncated_.load(std::memory_order_relaxed),
+                       .sink_errors_ = sink_errors_.load(std::memory_order_relaxed),
+                       .queued_ = static_cast<uint32_t>(tail > head ? tail - head : 0)};
+}
+
+// bounded MPSC (Vyukov): claim a position by CAS on tail_, the record's seq_ tells if it is free yet
+AsyncLog::Record* AsyncLog::Claim(uint64_t& pos) {
+  pos = tail_.load(std::memory_order_relaxed);
+  while (true) {
+    Record& r = records_[pos & mask_];
+    const int64_t diff = static_cast<int64_t>(r.seq_.load(std::memory_order_acquire) - pos);
+
+    if (diff == 0) {
+      if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return &r;
+    } else if (diff < 0) {  // full, the writer has not freed this record yet
+      const int64_t budget = (init_s_.overflow_ != LogOverflow::kBlock) ? 0
+                             : (thread_budget_ns_ < 0)                  ? init_s_.budget_ns_
+                                                                        : thread_budget_ns_;
+      if (!WaitForRoom(pos, budget)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        if (init_s_.overflow_ != LogOverflow::kDrop) counted_drops_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+      }
+      pos = tail_.load(std::memory_order_relaxed);
+    } else {  // another producer took pos
+      pos = tail_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+// yield first (the writer frees records in batches), then short sleeps, until the budget is spent
+bool AsyncLog::WaitForRoom(uint64_t pos, int64_t budget_ns) {
+  if (budget_ns <= 0) return false;
+
+  blocked_.fetch_add(1, std::memory_order_relaxed);
+  const Record& r = records_[pos & mask_];
+  const auto t0 = std::chrono::steady_clock::now();
+
+  for (uint32_t i = 0;; i++) {
+    if (static_cast<int64_t>(r.seq_.load(std::memory_order_acquire) - pos) >= 0 ||
+        !run_.load(std::memory_order_relaxed)) {
+      block_time_.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0)
+                             .count());
+      return run_.load(std::memory_order_relaxed);
+    }
+
+    const int64_t waited =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+    if (waited >= budget_ns) {
+      block_time_.Record(waited);
+      return false;
+    }
+
+    if (i < 64)
+      std::this_thread::yield();
+    else
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+}
+
+void AsyncLog::Publish(Record& r, uint64_t pos) {
+  logged_.fetch_add(1, std::memory_order_relaxed);
+  if (r.truncated_) truncated_.fetch_add(1, std::memory_order_relaxed);
+
+  // seq_cst pairs with the writer's sleeping_ store / seq_ load: either it sees this record or we see it sleeping
+  r.seq_.store(pos + 1, std::memory_order_seq_cst);
+  if (sleeping_.load(std::memory_order_seq_cst)) {
+    seq_.fetch_add(1, std::memory_order_release);
+    seq_.notify_one();
+  }
+}
+
+void AsyncLog::Run() {
+  ApplySchedule();
+
+  while (true) {
+    Record& r = records_[head_ & mask_];
+
+    if (r.seq_.load(std::memory_order_acquire) == head_ + 1) {
+      Write(r);
+      r.seq_.store(head_ + mask_ + 1, std::memory_order_release);  // free for the producer one lap later
+      head_++;
+      head_pub_.store(head_, std::memory_order_relaxed);
+      written_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    // caught up
+    ReportDrops();
+    if (!run_.load()) {
+      // a producer that claimed before Stop() publishes shortly, do not leave it in the ring
+      if (tail_.load() == head_) break;
+      std::this_thread::yield();
+      continue;
+    }
+
+    const uint32_t seen = seq_.load(std::memory_order_acquire);
+    sleeping_.store(true, std::memory_order_seq_cst);
+    if (r.seq_.load(std::memory_order_seq_cst) != head_ + 1 && run_.load()) seq_.wait(seen);
+    sleeping_.store(false, std::memory_order_relaxed);
+  }
+}
+
+// as spdlog's async_logger backend: straight to the sinks, the call's thread id is kept for %t
+void AsyncLog::Write(const Record& r) {
+  spdlog::logger* logger = r.logger_;
+  spdlog::details::log_msg msg(r.time_, r.loc_, logger->name(), r.level_,
+                               spdlog::string_view_t(r.text_, r.size_));
+  msg.thread_id = r.thread_id_;
+
+  for (const auto& sink : logger->sinks()) {
+    if (!sink->should_log(r.level_)) continue;
+    try {
+      sink->log(msg);
+    } catch (const std::exception&) {
+      sink_errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  if (r.level_ >= logger->flush_level()) {
+    for (const auto& sink : logger->sinks()) {
+      try {
+        sink->flush();
+      } catch (const std::exception&) {
+        sink_errors_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+// one line in the default logger where the gap is
+void AsyncLog::ReportDrops() {
+  const uint64_t counted = counted_drops_.load(std::memory_order_relaxed);
+  if (counted == reported_drops_) return;
+
+  if (spdlog::logger* default_logger = spdlog::default_logger_raw())
+    default_logger->log(spdlog::level::warn, "async log: {} messages dropped, ring of {} full",
+                        counted - reported_drops_, mask_ + 1);
+  reported_drops_ = counted;
+}
+
+void AsyncLog::ApplySchedule() {
+  pthread_setname_np(pthread_self(), init_s_.name_.substr(0, 15).c_str());
+
+  if (init_s_.cpu_ >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(init_s_.cpu_, &set);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    spdlog::logger* default_logger = spdlog::default_logger_raw();
+    if (err && default_logger)
+      default_logger->log(spdlog::level::warn, "{}: pin to cpu {} failed: {}", init_s_.name_, init_s_.cpu_,
+                          strerror(err));
+  }
+}
+
+}  // namespace lra::log_util
@@ -0,0 +1,172 @@
+#ifndef LRA_UTIL_LOG_ASYNC_LOG_H_
+#define LRA_UTIL_LOG_ASYNC_LOG_H_
+
+#include <spdlog/details/os.h>
+#include <spdlog/spdlog.h>
+#include <util/stats/stats.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace lra::log_util {
+
+// What a log call does when the ring is full
+enum class LogOverflow : uint8_t {
+  kBlock,  // wait for a free record, at most the calling thread's latency budget, then as kCount
+  kDrop,   // drop the message, only counted in the stats
+  kCount,  // drop the message, the writer logs how many were dropped once it caught up
+};
+
+struct AsyncLogInit_S {
+  std::string name_{"log_writer"};
+  uint32_t capacity_{8192};  // records (512 bytes each), rounded up to a power of 2
+  LogOverflow overflow_{LogOverflow::kBlock};
+  int64_t budget_ns_{INT64_MAX};  // kBlock wait of threads without SetThreadBudget()
+  int cpu_{-1};                   // pin the writer to this cpu, -1 for no affinity
+};
+
+// snapshot, see AsyncLog::GetStats()
+struct AsyncLogStats {
+  uint64_t logged_{0};     // records queued
+  uint64_t written_{0};    // records handed to the sinks
+  uint64_t dropped_{0};    // ring full, policy / budget
+  uint64_t blocked_{0};    // calls that waited for room
+  uint64_t truncated_{0};  // messages longer than kTextMax
+  uint64_t sink_errors_{0};
+  uint32_t queued_{0};  // records not written yet
+};
+
+/**
+ * @brief Asynchronous backend of LogUnit: a log call formats its message into a preallocated record of a bounded
+ * MPSC ring (lock-free, one CAS to claim), a writer thread hands records to the logger's sinks (file / console I/O,
+ * sink mutexes) in queue order.
+ *
+ * @note
+ *   1. Start() once the loggers are set up, Stop() drains the ring and must come before the loggers are dropped.
+ *      Loggers and LogUnits (the interned location string) have to outlive the records they are in.
+ *   2. Time, level, source and thread id of the call are kept, the message is cut at kTextMax bytes.
+ *   3. Hot threads call SetThreadBudget(0): under kBlock a full ring drops their message instead of waiting.
+ *      The worker threads get it from thread_util::ApplyThreadSchedule(), the timer daemon and the acc measure
+ *      thread set it themselves.
+ *   4. A logger's flush_on() level is honoured by the writer, periodic flush stays with spdlog::flush_every().
+ */
+class AsyncLog {
+ public:
+  static constexpr size_t kRecordBytes = 512;
+  static constexpr size_t kTextMax = kRecordBytes - 64;
+
+  AsyncLog(const AsyncLog&) = delete;
+  AsyncLog& operator=(const AsyncLog&) = delete;
+
+  // false if already running
+  static bool Start(const AsyncLogInit_S& init_s);
+
+  // writes what is queued and joins, log calls go synchronous again
+  static void Stop();
+
+  // one relaxed load, LogUnit checks it per call
+  static inline bool Active() { return active_.load(std::memory_order_relaxed); }
+
+  static inline AsyncLog& Instance() { return instance_; }
+
+  // longest kBlock wait of the calling thread (ns), 0: never wait, negative: AsyncLogInit_S::budget_ns_
+  static inline void SetThreadBudget(int64_t ns) { thread_budget_ns_ = ns; }
+
+  // false: dropped
+  template <typename... Args>
+  bool Log(spdlog::logger* logger, const spdlog::source_loc& loc, spdlog::level::level_enum level,
+           spdlog::format_string_t<Args...> fmt, Args&&... args) {
+    uint64_t pos;
+    Record* r = Claim(pos);
+    if (r == nullptr) return false;
+
+    r->logger_ = logger;
+    r->time_ = spdlog::log_clock::now();
+    r->loc_ = loc;
+    r->thread_id_ = spdlog::details::os::thread_id();
+    r->level_ = level;
+
+    try {
+      const auto res = spdlog::fmt_lib::format_to_n(r->text_, kTextMax, fmt, std::forward<Args>(args)...);
+      r->size_ = static_cast<uint16_t>(std::min(res.size, kTextMax));
+      r->truncated_ = res.size > kTextMax;
+    } catch (const std::exception& e) {
+      constexpr char kError[] = "[async log: format error] ";
+      r->size_ = sizeof(kError) - 1 + std::min(strlen(e.what()), kTextMax - sizeof(kError));
+      memcpy(r->text_, kError, sizeof(kError) - 1);
+      memcpy(r->text_ + sizeof(kError) - 1, e.what(), r->size_ - (sizeof(kError) - 1));
+      r->truncated_ = false;
+    }
+
+    Publish(*r, pos);
+    return true;
+  }
+
+  AsyncLogStats GetStats() const;
+
+  // time spent waiting for room by kBlock calls (ns)
+  inline const lra::stats_util::LatencyHistogram& GetBlockTime() const { return block_time_; }
+
+ private:
+  struct alignas(64) Record {
+    std::atomic<uint64_t> seq_{0};  // == position: free, position + 1: published
+    spdlog::logger* logger_{nullptr};
+    spdlog::log_clock::time_point time_;
+    spdlog::source_loc loc_;
+    size_t thread_id_{0};
+    spdlog::level::level_enum level_{spdlog::level::off};
+    uint16_t size_{0};
+    bool truncated_{false};
+    char text_[kTextMax];
+  };
+  static_assert(sizeof(Record) == kRecordBytes);
+
+  AsyncLog() = default;
+  ~AsyncLog();
+
+  static AsyncLog instance_;
+  static inline std::atomic<bool> active_{false};
+  static inline thread_local int64_t thread_budget_ns_{-1};
+
+  AsyncLogInit_S init_s_;
+  std::unique_ptr<Record[]> records_;
+  uint64_t mask_{0};
+  std::thread t_;
+  std::atomic<bool> run_{false};
+
+  alignas(64) std::atomic<uint64_t> tail_{0};  // next position to claim
+  alignas(64) uint64_t head_{0};              // writer only
+  std::atomic<uint64_t> head_pub_{0};         // head_ for GetStats()
+  std::atomic<bool> sleeping_{false};
+  std::atomic<uint32_t> seq_{0};  // +1 per wake up, the writer sleeps on it
+
+  std::atomic<uint64_t> logged_{0};
+  std::atomic<uint64_t> written_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> counted_drops_{0};  // kCount / budget drops, to report
+  std::atomic<uint64_t> blocked_{0};
+  std::atomic<uint64_t> truncated_{0};
+  std::atomic<uint64_t> sink_errors_{0};
+  uint64_t reported_drops_{0};  // writer only
+  lra::stats_util::LatencyHistogram block_time_;
+
+  // nullptr: ring full and the message dropped
+  Record* Claim(uint64_t& pos);
+  bool WaitForRoom(uint64_t pos, int64_t budget_ns);
+  void Publish(Record& r, uint64_t pos);
+
+  // writer
+  void Run();
+  void Write(const Record& r);
+  void ReportDrops();
+  void ApplySchedule();
+};
+
+}  // namespace lra::log_util
+
+#endif
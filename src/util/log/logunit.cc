@@ -1,3 +1,4 @@
+#include <spdlog/sinks/sink.h>
 #include <util/log/logunit.h>
 
 #include <algorithm>
@@ -29,17 +30,94 @@ std::string LogUnit::getName() { return name_; }
 
 void LogUnit::DropAllLogUnits() { logunits_.clear(); }
 
-void LogUnit::AddLogger(const std::string& logger_name) { loggers_.insert(logger_name); }
+void LogUnit::AddLogger(const std::string& logger_name) {
+  std::lock_guard lock(loggers_mutex_);
+  loggers_.try_emplace(logger_name, nullptr);
+  Resolve();
+}
+
+void LogUnit::AddLogger(const std::shared_ptr<spdlog::logger> logger_ptr) {
+  std::lock_guard lock(loggers_mutex_);
+  loggers_[logger_ptr->name()] = logger_ptr;
+  Resolve();
+}
+
+void LogUnit::AddLogger(const spdlog::logger& logger) { AddLogger(logger.name()); }
+
+void LogUnit::RemoveLogger(const std::string& logger_name) {
+  std::lock_guard lock(loggers_mutex_);
+  loggers_.erase(logger_name);
+  Resolve();
+}
+
+void LogUnit::RemoveLogger(const std::shared_ptr<spdlog::logger> logger_ptr) { RemoveLogger(logger_ptr->name()); }
 
-void LogUnit::AddLogger(const std::shared_ptr<spdlog::logger> logger_ptr) { loggers_.insert(logger_ptr->name()); }
+void LogUnit::RemoveLogger(const spdlog::logger& logger) { RemoveLogger(logger.name()); }
 
-void LogUnit::AddLogger(const spdlog::logger& logger) { loggers_.insert(logger.name()); }
+void LogUnit::Refresh() {
+  std::lock_guard lock(loggers_mutex_);
+  for (auto& [name, ptr] : loggers_) ptr = nullptr;  // look up again, a dropped logger goes
+  Resolve();
+}
 
-void LogUnit::RemoveLogger(const std::string& logger_name) { loggers_.erase(logger_name); }
+void LogUnit::RefreshAll() {
+  for (auto& [name, unit] : logunits_) unit->Refresh();
+}
 
-void LogUnit::RemoveLogger(const std::shared_ptr<spdlog::logger> logger_ptr) { loggers_.erase(logger_ptr->name()); }
+// a logger takes a message at max(logger level, lowest sink level)
+void LogUnit::Resolve() {
+  auto list = std::make_shared<LoggerList>();
+  int min_level = loglevel::off;
+
+  for (auto it = loggers_.begin(); it != loggers_.end();) {
+    auto& ptr = it->second;
+    if (!ptr) ptr = spdlog::get(it->first);
+    if (!ptr) {
+      it = loggers_.erase(it);
+      continue;
+    }
+
+    int sink_level = loglevel::off;
+    for (const auto& sink : ptr->sinks()) sink_level = std::min<int>(sink_level, sink->level());
+    const int level = std::max<int>(ptr->level(), sink_level);
+
+    list->push_back(CachedLogger{.ptr_ = ptr, .level_ = level});
+    min_level = std::min(min_level, level);
+    ++it;
+  }
 
-void LogUnit::RemoveLogger(const spdlog::logger& logger) { loggers_.erase(logger.name()); }
+  has_loggers_.store(!list->empty(), std::memory_order_relaxed);
+  loggers_level_.store(min_level, std::memory_order_relaxed);
+  logger_ptrs_.store(std::move(list), std::memory_order_release);
+}
+
+// a thread takes locations_mutex_ once per call site, later calls hit its own cache
+const char* LogUnit::InternLocation(const char* function_name) {
+  struct Key {
+    uint64_t unit_;  // id_, not the address: a new unit may reuse a dropped one's
+    const char* function_;
+    bool operator==(const Key&) const = default;
+  };
+  struct KeyHash {
+    size_t operator()(const Key& k) const {
+      return std::hash<const char*>{}(k.function_) ^ (k.unit_ * 0x9E3779B97F4A7C15ull);
+    }
+  };
+  thread_local std::unordered_map<Key, const char*, KeyHash> cache;
+
+  const Key key{id_, function_name};
+  if (auto hit = cache.find(key); hit != cache.end()) return hit->second;
+
+  const char* interned;
+  {
+    std::lock_guard lock(locations_mutex_);
+    auto [it, inserted] = locations_.try_emplace(function_name);
+    if (inserted) it->second = spdlog::fmt_lib::format("{} -> {}", function_name, name_);
+    interned = it->second.c_str();  // map nodes never move
+  }
+  cache.emplace(key, interned);
+  return interned;
+}
 
 std::shared_ptr<LogUnit> LogUnit::getLogUnit(const std::string& str) {
   return (logunits_.find(str) != logunits_.end()) ? logunits_[str] : nullptr;
@@ -12,17 +12,29 @@
  *       3. spdlog args change: fmt v8 requires compile time check (FMT_CONSTEVAL),
  *          leading const char* or string_view type args generating compile error
  *          -> use spdlog::format_string_t<Args...> instead.
+ *       4. disabled calls cost one branch: levels are filtered before anything else, against the default logger's
+ *          level and the cached effective level of loggers_ (logger level, raised to its lowest sink level).
+ *       5. loggers_ are resolved to shared_ptr once (no spdlog::get() per log), the "function -> unit" location string
+ *          is interned per call site and found in a per-thread cache, no lock after a thread's first call from a site.
+ *          Call Refresh() / RefreshAll() after changing a logger's / sink's level or dropping a logger.
+ *       6. after AsyncLog::Start() calls only format into a ring record, a writer thread does the sink / file I/O
+ *          (async_log.h).
  *
  */
 
 #include <spdlog/spdlog.h>
+#include <util/log/async_log.h>
 
 #include <boost/core/demangle.hpp>
+#include <atomic>
 #include <experimental/source_location>  // <--> <source_location>
+#include <memory>
+#include <mutex>
 #include <string_view>
 #include <typeinfo>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace lra::log_util {
 
@@ -61,6 +73,9 @@ class LogUnit {
   static std::vector<std::string> getAllLogUnitKeys();
   static ssize_t RefreshKeys();
 
+  // re-resolve loggers_ and their effective level, of every registered logunit
+  static void RefreshAll();
+
   // public functions
   void AddLogger(const std::string &logger_name);
   void AddLogger(const std::shared_ptr<spdlog::logger> logger_ptr);
@@ -72,41 +87,54 @@ class LogUnit {
   bool Drop(const std::string &logunit_name = "");
   std::string getName();
 
+  // re-resolve loggers_ and their effective level
+  void Refresh();
+
+  // would a LogToLoggers() at this level reach a logger
+  inline bool ShouldLogToLoggers(loglevel level) const {
+    return (SPDLOG_ACTIVE_LEVEL <= level) && (loggers_level_.load(std::memory_order_relaxed) <= level);
+  }
+
+  // would a LogToDefault() at this level reach the default logger, none after spdlog::drop_all()
+  static inline bool ShouldLogToDefault(loglevel level) {
+    if (SPDLOG_ACTIVE_LEVEL > level) return false;
+    spdlog::logger *default_logger = spdlog::default_logger_raw();
+    return (default_logger != nullptr) && default_logger->should_log(level);
+  }
+
   // critical
   static void DropAllLogUnits();
 
-  // TODO: How to improve performance from considering logger's level -> sink's level
   template <typename... Args>
   void LogToDefault(const Level_Loc &ll, spdlog::format_string_t<Args...> fmt, Args &&...args) {
     if (SPDLOG_ACTIVE_LEVEL > ll.level_) return;
 
-    auto default_logger = spdlog::default_logger();
-    if ((default_logger != nullptr) && (default_logger->level() > ll.level_)) return;
-
-   std::string new_function_name = spdlog::fmt_lib::format("{} -> {}", ll.loc_.function_name(), this->name_);
-
     // default logger's default value is color stdout: see spdlog/registry-inl.h
+    spdlog::logger *default_logger = spdlog::default_logger_raw();
+    if ((default_logger == nullptr) || !default_logger->should_log(ll.level_)) return;
 
-    default_logger->log(spdlog::source_loc{ll.loc_.file_name(), (int)ll.loc_.line(), new_function_name.c_str()}, ll.level_, fmt,
-                        std::forward<Args>(args)...);
+    if (AsyncLog::Active()) {
+      AsyncLog::Instance().Log(default_logger, SourceLoc(ll), ll.level_, fmt, std::forward<Args>(args)...);
+      return;
+    }
+    default_logger->log(SourceLoc(ll), ll.level_, fmt, std::forward<Args>(args)...);
   }
 
   template <typename... Args>
   void LogToLoggers(const Level_Loc &ll, spdlog::format_string_t<Args...> fmt, Args &&...args) {
-    if ((SPDLOG_ACTIVE_LEVEL > ll.level_) || (loggers_.size() == 0)) return;
+    if (!ShouldLogToLoggers(ll.level_)) return;
 
-    std::string new_function_name = spdlog::fmt_lib::format("{} -> {}", ll.loc_.function_name(), this->name_);
+    const spdlog::source_loc loc = SourceLoc(ll);
+    const auto loggers = logger_ptrs_.load(std::memory_order_acquire);
 
     // log -> spdlog::log_it_ has constant qualifier (), forward should be ok
-    for (const auto &logger_name : loggers_) {
-      if (auto logger = spdlog::get(logger_name); logger != nullptr) {
-        if (logger->level() > ll.level_) continue;
-
-        logger->log(spdlog::source_loc{ll.loc_.file_name(), (int)ll.loc_.line(), new_function_name.c_str()}, ll.level_, fmt,
-                    std::forward<Args>(args)...);
-      } else {
-        loggers_.erase(logger_name);
-      }
+    const bool async = AsyncLog::Active();
+    for (const auto &logger : *loggers) {
+      if (logger.level_ > ll.level_) continue;
+      if (async)
+        AsyncLog::Instance().Log(logger.ptr_.get(), loc, ll.level_, fmt, std::forward<Args>(args)...);
+      else
+        logger.ptr_->log(loc, ll.level_, fmt, std::forward<Args>(args)...);
     }
   }
 
@@ -122,8 +150,8 @@ class LogUnit {
   template <typename... Args>
   void LogToExist(const Level_Loc &ll, spdlog::format_string_t<Args...> fmt, Args &&...args) {
     // warning
-    loggers_.size() ? LogToLoggers(ll, fmt, std::forward<Args>(args)...)
-                    : LogToDefault(ll, fmt, std::forward<Args>(args)...);
+    has_loggers_.load(std::memory_order_relaxed) ? LogToLoggers(ll, fmt, std::forward<Args>(args)...)
+                                                 : LogToDefault(ll, fmt, std::forward<Args>(args)...);
   }
 
   // public static variables
@@ -151,12 +179,41 @@ class LogUnit {
   // private functions
   std::string CreateLogUnitName(const std::string &prefix);
 
+  // "function -> unit" of a call site, kept until the unit is destroyed, lock free once the calling thread saw the site
+  const char *InternLocation(const char *function_name);
+
+  inline spdlog::source_loc SourceLoc(const Level_Loc &ll) {
+    return spdlog::source_loc{ll.loc_.file_name(), (int)ll.loc_.line(), InternLocation(ll.loc_.function_name())};
+  }
+
+  // rebuild logger_ptrs_, loggers_level_ from loggers_ (locked)
+  void Resolve();
+
   // private member variables
   std::string name_{""};
-  std::unordered_set<std::string> loggers_{};
+  const uint64_t id_{next_id_.fetch_add(1, std::memory_order_relaxed)};  // key of the per-thread location cache
+
+  // names of added loggers, with the logger when added by pointer (not found in the registry: removed on Resolve)
+  std::mutex loggers_mutex_;
+  std::unordered_map<std::string, std::shared_ptr<spdlog::logger>> loggers_{};
+
+  // read by LogToLoggers() without lock
+  struct CachedLogger {
+    std::shared_ptr<spdlog::logger> ptr_;
+    int level_;  // effective
+  };
+  using LoggerList = std::vector<CachedLogger>;
+  std::atomic<std::shared_ptr<const LoggerList>> logger_ptrs_{std::make_shared<const LoggerList>()};
+  std::atomic<int> loggers_level_{loglevel::off};  // lowest level a logger in logger_ptrs_ takes
+  std::atomic<bool> has_loggers_{false};
+
+  // function_name (source_location, static storage) -> "function -> unit", filled on a thread cache miss
+  std::mutex locations_mutex_;
+  std::unordered_map<const char *, std::string> locations_{};
 
   // private static variables
   static std::unordered_map<std::string, std::shared_ptr<LogUnit>> logunits_;
+  static inline std::atomic<uint64_t> next_id_{0};
 };
 
 }  // namespace lra::log_util
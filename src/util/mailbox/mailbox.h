@@ -0,0 +1,85 @@
+#ifndef LRA_UTIL_MAILBOX_H_
+#define LRA_UTIL_MAILBOX_H_
+
+/**
+ * @brief Latest value mailbox (seqlock), one writer, any number of readers, nobody blocks the writer.
+ *
+ * @note
+ *   1. seq_ is odd while a write is in progress, readers retry until they copied a value between two equal even seqs.
+ *      A reader that keeps seeing an odd seq_ (writer preempted mid Publish(), maybe on the reader's own cpu under
+ *      SCHED_FIFO) sleeps on seq_ instead of spinning, the end of Publish() wakes it.
+ *   2. The value is stored in relaxed atomic words, a torn copy is never used but also never a data race.
+ *   3. Wait() sleeps on seq_ (futex), a Publish() wakes it, values published in between are coalesced.
+ */
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace lra::mailbox_util {
+
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+class SeqlockMailbox {
+ public:
+  SeqlockMailbox() = default;
+  SeqlockMailbox(const SeqlockMailbox&) = delete;
+  SeqlockMailbox& operator=(const SeqlockMailbox&) = delete;
+
+  // writer only
+  void Publish(const T& val) {
+    std::array<uint64_t, kWords> words{};
+    memcpy(words.data(), &val, sizeof(T));
+
+    const uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; i++) words_[i].store(words[i], std::memory_order_relaxed);
+    seq_.store(seq + 2, std::memory_order_release);
+    seq_.notify_all();
+  }
+
+  // writer only (or when no Publish() can run, e.g. at shutdown), wakes Wait() without a new value
+  void Notify() {
+    seq_.fetch_add(2, std::memory_order_release);
+    seq_.notify_all();
+  }
+
+  // latest value and its seq (0: nothing published yet)
+  uint32_t Read(T& out) const {
+    std::array<uint64_t, kWords> words;
+    for (uint32_t tries = 0;; tries++) {
+      const uint32_t before = seq_.load(std::memory_order_acquire);
+      if (before & 1) {
+        if (tries >= kSpinTries) seq_.wait(before, std::memory_order_acquire);
+        continue;
+      }
+
+      for (size_t i = 0; i < kWords; i++) words[i] = words_[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if (seq_.load(std::memory_order_relaxed) == before) {
+        memcpy(static_cast<void*>(&out), words.data(), sizeof(T));
+        return before;
+      }
+    }
+  }
+
+  inline uint32_t Seq() const { return seq_.load(std::memory_order_acquire); }
+
+  // blocks while Seq() == seen
+  void Wait(uint32_t seen) const { seq_.wait(seen, std::memory_order_acquire); }
+
+ private:
+  static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+  static constexpr uint32_t kSpinTries = 64;  // Read() retries on an odd seq_ before sleeping on it
+
+  alignas(64) std::atomic<uint32_t> seq_{0};
+  std::array<std::atomic<uint64_t>, kWords> words_{};
+};
+
+}  // namespace lra::mailbox_util
+
+#endif
@@ -0,0 +1,37 @@
+// record file (.lrr) to text
+// usage: lra_record_convert <file.lrr> [csv|json] [out], stdout without out
+
+#include <util/recorder/record_reader.h>
+
+#include <cstdio>
+#include <cstring>
+
+using lra::recorder_util::RecordReader;
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <file.lrr> [csv|json] [out]\n", argv[0]);
+    return 2;
+  }
+
+  const bool json = (argc > 2) && !strcmp(argv[2], "json");
+
+  RecordReader reader;
+  if (!reader.Open(argv[1])) {
+    fprintf(stderr, "%s: %.*s\n", argv[1], (int)reader.Error().size(), reader.Error().data());
+    return 1;
+  }
+
+  FILE* out = (argc > 3) ? fopen(argv[3], "w") : stdout;
+  if (!out) {
+    fprintf(stderr, "%s: cannot open\n", argv[3]);
+    return 1;
+  }
+
+  const bool ok = json ? WriteJson(reader, out) : WriteCsv(reader, out);
+  if (out != stdout) fclose(out);
+
+  // a crash leaves a partial last chunk, everything before it was converted
+  if (!ok) fprintf(stderr, "%s: stopped early: %.*s\n", argv[1], (int)reader.Error().size(), reader.Error().data());
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+#include <util/recorder/record_format.h>
+
+#include <cstring>
+
+namespace lra::recorder_util {
+
+namespace {
+
+// value i of a column as an integer of its size, XORed with value i - 1
+inline void XorShuffleColumn(const std::byte* in, size_t size, uint32_t rows, std::byte* out) {
+  uint64_t prev = 0;
+  for (uint32_t r = 0; r < rows; r++) {
+    uint64_t v = 0;
+    memcpy(&v, in + r * size, size);
+    const uint64_t d = v ^ prev;
+    prev = v;
+    for (size_t b = 0; b < size; b++) out[b * rows + r] = static_cast<std::byte>(d >> (8 * b));
+  }
+}
+
+inline void UnshuffleXorColumn(const std::byte* in, size_t size, uint32_t rows, std::byte* out) {
+  uint64_t prev = 0;
+  for (uint32_t r = 0; r < rows; r++) {
+    uint64_t d = 0;
+    for (size_t b = 0; b < size; b++) d |= static_cast<uint64_t>(in[b * rows + r]) << (8 * b);
+    prev ^= d;
+    memcpy(out + r * size, &prev, size);
+  }
+}
+
+}  // namespace
+
+uint32_t Fnv1a(std::span<const std::byte> data) {
+  uint32_t h = 2166136261u;
+  for (std::byte b : data) {
+    h ^= static_cast<uint32_t>(b);
+    h *= 16777619u;
+  }
+  return h;
+}
+
+void EncodeXorShuffleRle(std::span<const std::byte> raw, std::span<const size_t> sizes, uint32_t rows,
+                         std::vector<std::byte>& out) {
+  thread_local std::vector<std::byte> shuffled;
+  shuffled.resize(raw.size());
+
+  size_t off = 0;
+  for (size_t size : sizes) {
+    XorShuffleColumn(raw.data() + off, size, rows, shuffled.data() + off);
+    off += size * rows;
+  }
+
+  // worst case: one control byte per 128 literals
+  out.resize(shuffled.size() + shuffled.size() / 128 + 2);
+  size_t o = 0;
+  size_t i = 0;
+  const size_t n = shuffled.size();
+  while (i < n) {
+    if (shuffled[i] == std::byte{0}) {
+      size_t run = 1;
+      while (run < 128 && i + run < n && shuffled[i + run] == std::byte{0}) run++;
+      out[o++] = static_cast<std::byte>(0x80 | (run - 1));
+      i += run;
+      continue;
+    }
+
+    // literals until two zeros in a row (a single zero is cheaper kept literal)
+    size_t len = 1;
+    while (len < 128 && i + len < n &&
+           !(shuffled[i + len] == std::byte{0} && (i + len + 1 == n || shuffled[i + len + 1] == std::byte{0})))
+      len++;
+    out[o++] = static_cast<std::byte>(len - 1);
+    memcpy(out.data() + o, shuffled.data() + i, len);
+    o += len;
+    i += len;
+  }
+  out.resize(o);
+}
+
+bool DecodeXorShuffleRle(std::span<const std::byte> stored, std::span<const size_t> sizes, uint32_t rows,
+                         std::span<std::byte> raw) {
+  thread_local std::vector<std::byte> shuffled;
+  shuffled.resize(raw.size());
+
+  size_t o = 0;
+  for (size_t i = 0; i < stored.size();) {
+    const uint8_t c = static_cast<uint8_t>(stored[i++]);
+    const size_t len = (c & 0x7F) + 1;
+    if (o + len > shuffled.size()) return false;
+
+    if (c & 0x80) {
+      memset(shuffled.data() + o, 0, len);
+    } else {
+      if (i + len > stored.size()) return false;
+      memcpy(shuffled.data() + o, stored.data() + i, len);
+      i += len;
+    }
+    o += len;
+  }
+  if (o != shuffled.size()) return false;
+
+  size_t off = 0;
+  for (size_t size : sizes) {
+    UnshuffleXorColumn(shuffled.data() + off, size, rows, raw.data() + off);
+    off += size * rows;
+  }
+  return off == raw.size();
+}
+
+const char* DecodeChunk(const ChunkHeader& h, std::span<const std::byte> payload, std::span<const size_t> sizes,
+                        std::vector<std::byte>& raw) {
+  if (h.magic_ != kChunkMagic) return "bad chunk magic";
+
+  size_t row_bytes = 0;
+  for (size_t s : sizes) row_bytes += s;
+  if (static_cast<uint64_t>(h.rows_) * row_bytes != h.raw_bytes_) return "chunk size mismatch";
+  if (payload.size() != h.stored_bytes_) return "chunk size mismatch";
+
+  raw.resize(h.raw_bytes_);
+  switch (static_cast<Codec>(h.codec_)) {
+    case Codec::kRaw:
+      if (h.stored_bytes_ != h.raw_bytes_) return "chunk size mismatch";
+      memcpy(raw.data(), payload.data(), payload.size());
+      break;
+    case Codec::kXorShuffleRle:
+      if (!DecodeXorShuffleRle(payload, sizes, h.rows_, raw)) return "corrupt chunk";
+      break;
+    default:
+      return "unknown codec";
+  }
+  if (Fnv1a(raw) != h.checksum_) return "checksum mismatch";
+  return nullptr;
+}
+
+}  // namespace lra::recorder_util
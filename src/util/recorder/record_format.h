@@ -0,0 +1,111 @@
+#ifndef LRA_UTIL_RECORDER_RECORD_FORMAT_H_
+#define LRA_UTIL_RECORDER_RECORD_FORMAT_H_
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace lra::recorder_util {
+
+/**
+ * Record file (.lrr), fixed-type columns stored column by column in compressed chunks
+ *
+ * little endian (host order, as rt_frame.h), a file is a header followed by chunks until EOF
+ *
+ * header
+ *  offset  type       field
+ *  0       u32        magic 'LRR1'
+ *  4       u16        version
+ *  6       u16        column count (c)
+ *  8       u32        header bytes (64 + 16 * c)
+ *  12      u32        rows per chunk (max)
+ *  16      i64        start time, ns since unix epoch
+ *  24      f32        odr (Hz), 0 if not a sampled stream
+ *  28      f32        range (+- g), 0 if unknown
+ *  32      f32        offset[3] (g)
+ *  44      u32        reserved
+ *  48      char[16]   stream name, '\0' padded
+ *  64      column[c]  u8 type (ColumnType), u8 pad[3], char name[12] '\0' padded
+ *
+ * chunk
+ *  0       u32        magic 'LRC1'
+ *  4       u32        rows
+ *  8       u64        index of the first row in the file
+ *  16      u32        raw bytes (sum of rows * column size)
+ *  20      u32        stored bytes (payload)
+ *  24      u16        codec (Codec)
+ *  26      u16        reserved
+ *  28      u32        FNV-1a of the raw bytes
+ *  32      payload    columns back to back (column 0 rows, column 1 rows, ...), then the codec
+ *
+ * Codec::kXorShuffleRle: each column's values XOR the previous value (slowly changing samples keep sign / exponent
+ * bytes at zero), bytes are regrouped by position in the value (all byte 0, all byte 1, ...), then runs of zero bytes
+ * are run-length coded: control byte c, c & 0x80 -> (c & 0x7F) + 1 zeros, else c + 1 literal bytes follow.
+ * A chunk is stored raw when that does not make it smaller.
+ */
+constexpr uint32_t kRecordMagic = 0x3152524C;  // "LRR1"
+constexpr uint32_t kChunkMagic = 0x3143524C;   // "LRC1"
+constexpr uint16_t kRecordVersion = 1;
+constexpr size_t kRecordHeaderBytes = 64;
+constexpr size_t kColumnBytes = 16;
+constexpr size_t kChunkHeaderBytes = 32;
+constexpr size_t kStreamNameMax = 16;
+constexpr size_t kColumnNameMax = 12;
+
+static_assert(std::endian::native == std::endian::little, "record file is written in host order");
+
+enum class ColumnType : uint8_t { kF32 = 1, kF64 = 2, kU8 = 3, kU32 = 4, kI64 = 5 };
+
+enum class Codec : uint16_t { kRaw = 0, kXorShuffleRle = 1 };
+
+constexpr size_t ColumnSize(ColumnType type) {
+  switch (type) {
+    case ColumnType::kU8:
+      return 1;
+    case ColumnType::kF32:
+    case ColumnType::kU32:
+      return 4;
+    case ColumnType::kF64:
+    case ColumnType::kI64:
+      return 8;
+  }
+  return 0;
+}
+
+struct Column {
+  std::string name_;  // up to kColumnNameMax chars
+  ColumnType type_{ColumnType::kF32};
+};
+
+struct ChunkHeader {
+  uint32_t magic_{kChunkMagic};
+  uint32_t rows_{0};
+  uint64_t first_row_{0};
+  uint32_t raw_bytes_{0};
+  uint32_t stored_bytes_{0};
+  uint16_t codec_{0};
+  uint16_t reserved_{0};
+  uint32_t checksum_{0};
+};
+static_assert(sizeof(ChunkHeader) == kChunkHeaderBytes);
+
+uint32_t Fnv1a(std::span<const std::byte> data);
+
+// columns back to back, sizes[i] bytes per value of column i, rows values each; out is overwritten
+void EncodeXorShuffleRle(std::span<const std::byte> raw, std::span<const size_t> sizes, uint32_t rows,
+                         std::vector<std::byte>& out);
+
+// false if stored does not decode to exactly raw.size() bytes
+bool DecodeXorShuffleRle(std::span<const std::byte> stored, std::span<const size_t> sizes, uint32_t rows,
+                         std::span<std::byte> raw);
+
+// payload of a chunk (h.stored_bytes_) to raw, checksum checked; nullptr or what is wrong with it
+const char* DecodeChunk(const ChunkHeader& h, std::span<const std::byte> payload, std::span<const size_t> sizes,
+                        std::vector<std::byte>& raw);
+
+}  // namespace lra::recorder_util
+
+#endif
@@ -0,0 +1,215 @@
+#include <spdlog/common.h>
+#include <util/recorder/record_reader.h>
+
+#include <cstring>
+
+namespace lra::recorder_util {
+
+namespace {
+
+template <typename T>
+inline T Get(const std::byte* p) {
+  T v;
+  memcpy(&v, p, sizeof(T));
+  return v;
+}
+
+inline std::string GetName(const std::byte* p, size_t max) {
+  const char* s = reinterpret_cast<const char*>(p);
+  return std::string(s, strnlen(s, max));
+}
+
+// shortest text that reads back to the stored value
+void AppendValue(spdlog::memory_buf_t& out, const std::byte* p, ColumnType type) {
+  switch (type) {
+    case ColumnType::kF32:
+      spdlog::fmt_lib::format_to(std::back_inserter(out), "{}", Get<float>(p));
+      break;
+    case ColumnType::kF64:
+      spdlog::fmt_lib::format_to(std::back_inserter(out), "{}", Get<double>(p));
+      break;
+    case ColumnType::kU8:
+      spdlog::fmt_lib::format_to(std::back_inserter(out), "{}", Get<uint8_t>(p));
+      break;
+    case ColumnType::kU32:
+      spdlog::fmt_lib::format_to(std::back_inserter(out), "{}", Get<uint32_t>(p));
+      break;
+    case ColumnType::kI64:
+      spdlog::fmt_lib::format_to(std::back_inserter(out), "{}", Get<int64_t>(p));
+      break;
+  }
+}
+
+inline void Append(spdlog::memory_buf_t& out, std::string_view s) { out.append(s.data(), s.data() + s.size()); }
+
+inline void Drain(spdlog::memory_buf_t& out, FILE* f) {
+  fwrite(out.data(), 1, out.size(), f);
+  out.clear();
+}
+
+}  // namespace
+
+/* RecordChunk */
+
+double RecordChunk::Get(size_t c, uint32_t r) const {
+  const std::byte* p = raw_.data() + offset_[c] + r * size_[c];
+  switch (type_[c]) {
+    case ColumnType::kF32:
+      return recorder_util::Get<float>(p);
+    case ColumnType::kF64:
+      return recorder_util::Get<double>(p);
+    case ColumnType::kU8:
+      return recorder_util::Get<uint8_t>(p);
+    case ColumnType::kU32:
+      return recorder_util::Get<uint32_t>(p);
+    case ColumnType::kI64:
+      return static_cast<double>(recorder_util::Get<int64_t>(p));
+  }
+  return 0;
+}
+
+/* RecordReader */
+
+RecordReader::~RecordReader() { Close(); }
+
+void RecordReader::Close() {
+  if (file_) fclose(file_);
+  file_ = nullptr;
+}
+
+bool RecordReader::Fail(std::string_view what) {
+  error_ = what;
+  return false;
+}
+
+bool RecordReader::Open(const std::string& path) {
+  Close();
+  error_.clear();
+  header_ = RecordHeader{};
+
+  file_ = fopen(path.c_str(), "rb");
+  if (!file_) return Fail("cannot open file");
+
+  std::byte h[kRecordHeaderBytes];
+  if (fread(h, 1, sizeof(h), file_) != sizeof(h)) return Fail("truncated header");
+  if (Get<uint32_t>(h) != kRecordMagic) return Fail("not a record file");
+
+  header_.version_ = Get<uint16_t>(h + 4);
+  if (header_.version_ != kRecordVersion) return Fail("unsupported version");
+
+  const uint16_t n = Get<uint16_t>(h + 6);
+  const uint32_t header_bytes = Get<uint32_t>(h + 8);
+  if (header_bytes != kRecordHeaderBytes + kColumnBytes * n) return Fail("bad header size");
+
+  header_.chunk_rows_ = Get<uint32_t>(h + 12);
+  header_.start_ns_ = Get<int64_t>(h + 16);
+  header_.odr_hz_ = Get<float>(h + 24);
+  header_.range_g_ = Get<float>(h + 28);
+  for (int i = 0; i < 3; i++) header_.offset_g_[i] = Get<float>(h + 32 + 4 * i);
+  header_.stream_ = GetName(h + 48, kStreamNameMax);
+
+  sizes_.clear();
+  for (uint16_t c = 0; c < n; c++) {
+    std::byte col[kColumnBytes];
+    if (fread(col, 1, sizeof(col), file_) != sizeof(col)) return Fail("truncated header");
+
+    const auto type = static_cast<ColumnType>(col[0]);
+    if (!ColumnSize(type)) return Fail("unknown column type");
+    header_.columns_.push_back(Column{.name_ = GetName(col + 4, kColumnNameMax), .type_ = type});
+    sizes_.push_back(ColumnSize(type));
+  }
+  return true;
+}
+
+bool RecordReader::Next(RecordChunk& chunk) {
+  if (!file_ || !error_.empty()) return false;
+
+  ChunkHeader h;
+  const size_t got = fread(&h, 1, sizeof(h), file_);
+  if (got == 0 && feof(file_)) return false;  // clean end
+  if (got != sizeof(h)) return Fail("truncated chunk header");
+  if (h.magic_ != kChunkMagic) return Fail("bad chunk magic");
+
+  size_t row_bytes = 0;
+  for (size_t s : sizes_) row_bytes += s;
+  if (static_cast<uint64_t>(h.rows_) * row_bytes != h.raw_bytes_) return Fail("chunk size mismatch");
+
+  stored_.resize(h.stored_bytes_);
+  if (fread(stored_.data(), 1, stored_.size(), file_) != stored_.size()) return Fail("truncated chunk");
+
+  if (const char* err = DecodeChunk(h, stored_, sizes_, chunk.raw_)) return Fail(err);
+
+  chunk.rows_ = h.rows_;
+  chunk.first_row_ = h.first_row_;
+  chunk.size_ = sizes_;
+  chunk.offset_.clear();
+  chunk.type_.clear();
+  size_t off = 0;
+  for (size_t c = 0; c < sizes_.size(); c++) {
+    chunk.offset_.push_back(off);
+    chunk.type_.push_back(header_.columns_[c].type_);
+    off += sizes_[c] * h.rows_;
+  }
+  return true;
+}
+
+/* converters */
+
+bool WriteCsv(RecordReader& reader, FILE* out) {
+  const auto& cols = reader.Header().columns_;
+  spdlog::memory_buf_t buf;
+
+  for (size_t c = 0; c < cols.size(); c++) {
+    if (c) buf.push_back(',');
+    Append(buf, cols[c].name_);
+  }
+  buf.push_back('\n');
+
+  RecordChunk chunk;
+  while (reader.Next(chunk)) {
+    for (uint32_t r = 0; r < chunk.Rows(); r++) {
+      for (size_t c = 0; c < cols.size(); c++) {
+        if (c) buf.push_back(',');
+        AppendValue(buf, chunk.raw_.data() + chunk.offset_[c] + r * chunk.size_[c], cols[c].type_);
+      }
+      buf.push_back('\n');
+      if (buf.size() > 65536) Drain(buf, out);
+    }
+  }
+  Drain(buf, out);
+  return reader.Error().empty();
+}
+
+bool WriteJson(RecordReader& reader, FILE* out) {
+  const RecordHeader& h = reader.Header();
+  spdlog::memory_buf_t buf;
+
+  spdlog::fmt_lib::format_to(std::back_inserter(buf),
+                             "{{\"stream\": \"{}\", \"start_ns\": {}, \"odr\": {}, \"range\": {}, "
+                             "\"offset\": [{}, {}, {}], \"{}\": [",
+                             h.stream_, h.start_ns_, h.odr_hz_, h.range_g_, h.offset_g_[0], h.offset_g_[1],
+                             h.offset_g_[2], h.stream_);
+
+  bool first = true;
+  RecordChunk chunk;
+  while (reader.Next(chunk)) {
+    for (uint32_t r = 0; r < chunk.Rows(); r++) {
+      Append(buf, first ? "\n{" : ",\n{");
+      first = false;
+      for (size_t c = 0; c < h.columns_.size(); c++) {
+        if (c) Append(buf, ", ");
+        buf.push_back('"');
+        Append(buf, h.columns_[c].name_);
+        Append(buf, "\": ");
+        AppendValue(buf, chunk.raw_.data() + chunk.offset_[c] + r * chunk.size_[c], h.columns_[c].type_);
+      }
+      buf.push_back('}');
+      if (buf.size() > 65536) Drain(buf, out);
+    }
+  }
+  Append(buf, "\n]}\n");
+  Drain(buf, out);
+  return reader.Error().empty();
+}
+
+}  // namespace lra::recorder_util
@@ -0,0 +1,97 @@
+#ifndef LRA_UTIL_RECORDER_RECORD_READER_H_
+#define LRA_UTIL_RECORDER_RECORD_READER_H_
+
+#include <util/recorder/record_format.h>
+
+#include <array>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lra::recorder_util {
+
+struct RecordHeader {
+  uint16_t version_{0};
+  uint32_t chunk_rows_{0};
+  int64_t start_ns_{0};
+  float odr_hz_{0};
+  float range_g_{0};
+  std::array<float, 3> offset_g_{};
+  std::string stream_;
+  std::vector<Column> columns_;
+};
+
+// decoded chunk, column-wise
+class RecordReader;
+
+class RecordChunk {
+ public:
+  inline uint32_t Rows() const { return rows_; }
+  inline uint64_t FirstRow() const { return first_row_; }
+
+  // column c as T, empty if T does not have the column's size
+  template <typename T>
+  std::span<const T> Values(size_t c) const {
+    if (c >= size_.size() || size_[c] != sizeof(T)) return {};
+    return std::span<const T>(reinterpret_cast<const T*>(raw_.data() + offset_[c]), rows_);
+  }
+
+  // any column type as double
+  double Get(size_t c, uint32_t r) const;
+
+ private:
+  friend class RecordReader;
+  friend bool WriteCsv(RecordReader& reader, FILE* out);
+  friend bool WriteJson(RecordReader& reader, FILE* out);
+
+  std::vector<std::byte> raw_;
+  std::vector<size_t> offset_;
+  std::vector<size_t> size_;
+  std::vector<ColumnType> type_;
+  uint32_t rows_{0};
+  uint64_t first_row_{0};
+};
+
+/**
+ * @brief Reads a record file (record_format.h) chunk by chunk.
+ * A file cut short by a crash reads up to its last complete chunk, Error() then tells what was left.
+ */
+class RecordReader {
+ public:
+  RecordReader() = default;
+  RecordReader(const RecordReader&) = delete;
+  RecordReader& operator=(const RecordReader&) = delete;
+  ~RecordReader();
+
+  bool Open(const std::string& path);
+  void Close();
+
+  inline const RecordHeader& Header() const { return header_; }
+
+  // false at the end of the file or at a damaged chunk (Error() not empty)
+  bool Next(RecordChunk& chunk);
+
+  inline std::string_view Error() const { return error_; }
+
+ private:
+  FILE* file_{nullptr};
+  RecordHeader header_;
+  std::vector<size_t> sizes_;
+  std::vector<std::byte> stored_;
+  std::string error_;
+
+  bool Fail(std::string_view what);
+};
+
+// rest of the reader as text, one row per line / object; false if the reader stopped at a damaged chunk
+// csv: header line of column names
+bool WriteCsv(RecordReader& reader, FILE* out);
+
+// {"stream": .., "start_ns": .., "odr": .., "range": .., "offset": [..], "<stream>": [{"<column>": value, ..}, ..]}
+bool WriteJson(RecordReader& reader, FILE* out);
+
+}  // namespace lra::recorder_util
+
+#endif
@@ -0,0 +1,233 @@
+#include <util/recorder/recorder.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace lra::recorder_util {
+
+using ::lra::log_util::loglevel;
+
+namespace {
+
+template <typename T>
+inline void PutBytes(std::vector<std::byte>& out, const T& v) {
+  const auto* p = reinterpret_cast<const std::byte*>(&v);
+  out.insert(out.end(), p, p + sizeof(T));
+}
+
+inline void PutName(std::vector<std::byte>& out, const std::string& name, size_t max) {
+  for (size_t i = 0; i < max; i++) out.push_back(i < name.size() ? static_cast<std::byte>(name[i]) : std::byte{0});
+}
+
+inline int64_t UnixNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+Recorder::~Recorder() { Close(); }
+
+bool Recorder::Open(const RecorderInit_S& init_s) {
+  if (IsOpen() || init_s.columns_.empty() || init_s.chunk_rows_ == 0) return false;
+
+  init_s_ = init_s;
+  if (!init_s_.start_ns_) init_s_.start_ns_ = UnixNs();
+  logunit_ = lra::log_util::LogUnit::CreateLogUnit(init_s_.stream_);
+
+  col_size_.clear();
+  col_offset_.clear();
+  col_type_.clear();
+  size_t row_bytes = 0;
+  for (const auto& col : init_s_.columns_) {
+    col_offset_.push_back(row_bytes * init_s_.chunk_rows_);
+    col_size_.push_back(ColumnSize(col.type_));
+    col_type_.push_back(col.type_);
+    row_bytes += ColumnSize(col.type_);
+  }
+
+  for (auto& buf : buffers_) {
+    buf.data_.assign(row_bytes * init_s_.chunk_rows_, std::byte{0});
+    buf.rows_ = 0;
+    buf.state_.store(kFree);
+  }
+  active_ = nullptr;
+  next_fill_ = 0;
+  next_row_ = 0;
+
+  const std::vector<std::byte> header = HeaderBytes();
+  if (init_s_.ring_bytes_) {
+    if (!ring_.Open(RingInit_S{.path_ = init_s_.path_,
+                               .bytes_ = init_s_.ring_bytes_,
+                               .block_bytes_ = init_s_.ring_block_bytes_},
+                    header, col_size_)) {
+      logunit_->LogToDefault(loglevel::err, "recorder {}: ring {} failed: {}\n", init_s_.stream_, init_s_.path_,
+                             ring_.Error());
+      return false;
+    }
+    next_row_ = ring_.NextRow();
+    if (!ring_.GetMovedAside().empty())
+      logunit_->LogToDefault(loglevel::warn, "recorder {}: {} is not a ring of this stream / size, moved to {}\n",
+                             init_s_.stream_, init_s_.path_, ring_.GetMovedAside());
+    logunit_->LogToDefault(loglevel::info, "recorder {}: ring {}, {} blocks, {} kept, {} chunks recovered\n",
+                           init_s_.stream_, init_s_.path_, ring_.GetBlockCount(), ring_.GetKeptBlocks(),
+                           ring_.GetRecoveredChunks());
+  } else {
+    file_ = fopen(init_s_.path_.c_str(), "wb");
+    if (!file_ || fwrite(header.data(), 1, header.size(), file_) != header.size() || fflush(file_) != 0) {
+      logunit_->LogToDefault(loglevel::err, "recorder {}: open {} failed: {}\n", init_s_.stream_, init_s_.path_,
+                             strerror(errno));
+      if (file_) fclose(file_);
+      file_ = nullptr;
+      return false;
+    }
+    stored_bytes_.fetch_add(header.size(), std::memory_order_relaxed);
+  }
+
+  run_.store(true);
+  t_ = std::thread(&Recorder::Run, this);
+  return true;
+}
+
+void Recorder::Close() {
+  if (!IsOpen()) return;
+
+  Flush();
+  run_.store(false);
+  seq_.fetch_add(1, std::memory_order_release);
+  seq_.notify_one();
+  if (t_.joinable()) t_.join();
+
+  if (file_) fclose(file_);
+  file_ = nullptr;
+  ring_.Close();
+
+  logunit_->LogToDefault(loglevel::info, "recorder {}: {} rows, {} dropped, {} -> {} bytes\n", init_s_.stream_,
+                         GetRows(), GetDroppedRows(), GetRawBytes(), GetStoredBytes());
+}
+
+void Recorder::Flush() {
+  if (active_ && active_->rows_) Publish();
+}
+
+void Recorder::Drain() {
+  Flush();
+  for (auto& buf : buffers_) {
+    while (buf.state_.load(std::memory_order_acquire) == kFull) buf.state_.wait(kFull, std::memory_order_acquire);
+  }
+}
+
+bool Recorder::Acquire() {
+  if (!IsOpen()) return false;
+
+  Buffer& buf = buffers_[next_fill_];
+  if (buf.state_.load(std::memory_order_acquire) != kFree) return false;
+
+  buf.rows_ = 0;
+  buf.first_row_ = next_row_;
+  if (ring_.IsOpen()) buf.t_first_ns_ = UnixNs();
+  active_ = &buf;
+  return true;
+}
+
+void Recorder::Publish() {
+  if (ring_.IsOpen()) active_->t_last_ns_ = UnixNs();
+  next_row_ += active_->rows_;
+  active_->state_.store(kFull, std::memory_order_release);
+  active_ = nullptr;
+  next_fill_ ^= 1;
+
+  seq_.fetch_add(1, std::memory_order_release);
+  seq_.notify_one();
+}
+
+// chunks are published alternately, written in the same order
+void Recorder::Run() {
+  uint32_t next_write = 0;
+
+  while (true) {
+    const uint32_t seen = seq_.load(std::memory_order_acquire);
+
+    while (buffers_[next_write].state_.load(std::memory_order_acquire) == kFull) {
+      WriteChunk(buffers_[next_write]);
+      buffers_[next_write].state_.store(kFree, std::memory_order_release);
+      buffers_[next_write].state_.notify_all();
+      next_write ^= 1;
+    }
+
+    if (!run_.load(std::memory_order_acquire)) break;
+    seq_.wait(seen, std::memory_order_acquire);
+  }
+}
+
+void Recorder::WriteChunk(Buffer& buf) {
+  const auto t0 = std::chrono::steady_clock::now();
+  const uint32_t rows = buf.rows_;
+
+  // partial chunk: columns to rows * size apart, offsets only shrink so front to back is safe
+  size_t raw_bytes = 0;
+  for (size_t c = 0; c < col_size_.size(); c++) {
+    if (raw_bytes != col_offset_[c]) memmove(buf.data_.data() + raw_bytes, buf.data_.data() + col_offset_[c],
+                                             col_size_[c] * rows);
+    raw_bytes += col_size_[c] * rows;
+  }
+  const std::span<const std::byte> raw(buf.data_.data(), raw_bytes);
+
+  ChunkHeader h;
+  h.rows_ = rows;
+  h.first_row_ = buf.first_row_;
+  h.raw_bytes_ = raw_bytes;
+  h.checksum_ = Fnv1a(raw);
+
+  EncodeXorShuffleRle(raw, col_size_, rows, encoded_);
+  std::span<const std::byte> payload(encoded_);
+  h.codec_ = static_cast<uint16_t>(Codec::kXorShuffleRle);
+  if (encoded_.size() >= raw_bytes) {
+    payload = raw;
+    h.codec_ = static_cast<uint16_t>(Codec::kRaw);
+  }
+  h.stored_bytes_ = payload.size();
+
+  if (ring_.IsOpen()) {
+    if (!ring_.Append(h, payload, buf.t_first_ns_, buf.t_last_ns_) &&
+        write_errors_.fetch_add(1, std::memory_order_relaxed) == 0)
+      logunit_->LogToDefault(loglevel::err, "recorder {}: ring append failed: {}\n", init_s_.stream_, ring_.Error());
+  } else if (fwrite(&h, sizeof(h), 1, file_) != 1 ||
+             fwrite(payload.data(), 1, payload.size(), file_) != payload.size() || fflush(file_) != 0) {
+    if (write_errors_.fetch_add(1, std::memory_order_relaxed) == 0)
+      logunit_->LogToDefault(loglevel::err, "recorder {}: write failed: {}\n", init_s_.stream_, strerror(errno));
+  }
+
+  raw_bytes_.fetch_add(raw_bytes, std::memory_order_relaxed);
+  stored_bytes_.fetch_add(sizeof(h) + payload.size(), std::memory_order_relaxed);
+  write_time_.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0)
+                         .count());
+}
+
+std::vector<std::byte> Recorder::HeaderBytes() const {
+  std::vector<std::byte> h;
+  h.reserve(kRecordHeaderBytes + kColumnBytes * init_s_.columns_.size());
+
+  PutBytes(h, kRecordMagic);
+  PutBytes(h, kRecordVersion);
+  PutBytes(h, static_cast<uint16_t>(init_s_.columns_.size()));
+  PutBytes(h, static_cast<uint32_t>(kRecordHeaderBytes + kColumnBytes * init_s_.columns_.size()));
+  PutBytes(h, init_s_.chunk_rows_);
+  PutBytes(h, init_s_.start_ns_);
+  PutBytes(h, init_s_.odr_hz_);
+  PutBytes(h, init_s_.range_g_);
+  for (float v : init_s_.offset_g_) PutBytes(h, v);
+  PutBytes(h, uint32_t{0});
+  PutName(h, init_s_.stream_, kStreamNameMax);
+
+  for (const auto& col : init_s_.columns_) {
+    PutBytes(h, static_cast<uint8_t>(col.type_));
+    for (int i = 0; i < 3; i++) PutBytes(h, uint8_t{0});
+    PutName(h, col.name_, kColumnNameMax);
+  }
+
+  return h;
+}
+
+}  // namespace lra::recorder_util
@@ -0,0 +1,182 @@
+#ifndef LRA_UTIL_RECORDER_RECORDER_H_
+#define LRA_UTIL_RECORDER_RECORDER_H_
+
+#include <util/log/logunit.h>
+#include <util/recorder/record_format.h>
+#include <util/recorder/ring_file.h>
+#include <util/stats/stats.h>
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace lra::recorder_util {
+
+struct RecorderInit_S {
+  std::string path_;
+  std::string stream_{"data"};  // up to kStreamNameMax chars
+  std::vector<Column> columns_;
+  uint32_t chunk_rows_{4096};
+
+  // > 0: path_ is a ring file of this size (ring_file.h) keeping the newest data, reopened and continued by the next
+  // run; 0: a record file growing until Close()
+  uint64_t ring_bytes_{0};
+  uint32_t ring_block_bytes_{1 << 20};
+
+  // header metadata of sampled streams
+  float odr_hz_{0};
+  float range_g_{0};
+  std::array<float, 3> offset_g_{};
+  int64_t start_ns_{0};  // ns since unix epoch, 0: now
+};
+
+/**
+ * @brief Writes rows of fixed-type columns to a record file (record_format.h) from a background thread.
+ *
+ * @note
+ *   1. Two chunk buffers: the producer fills one while the writer compresses and writes the other. Append() never
+ *      blocks, a row that finds both buffers busy (storage slower than the data) is dropped and counted.
+ *   2. Append() / Flush() from one thread only, Close() after it stopped appending.
+ *   3. A chunk is written when full, on Flush() and on Close().
+ *   4. In a ring file a chunk also carries the wall clock of its first / last Append(), the time index of the ring.
+ */
+class Recorder {
+ public:
+  Recorder() = default;
+  Recorder(const Recorder&) = delete;
+  Recorder& operator=(const Recorder&) = delete;
+  ~Recorder();
+
+  bool Open(const RecorderInit_S& init_s);
+
+  // flush, write what is left, join
+  void Close();
+
+  inline bool IsOpen() const { return file_ != nullptr || ring_.IsOpen(); }
+
+  // one value per column, in column order, converted to the column's type; false if dropped
+  template <typename... T>
+    requires(std::is_arithmetic_v<T> && ...)
+  bool Append(T... values) {
+    if (sizeof...(T) != col_size_.size()) return false;
+    if (!active_ && !Acquire()) {
+      next_row_++;  // the next chunk's first_row_ shows the gap
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    std::byte* base = active_->data_.data();
+    const uint32_t r = active_->rows_;
+    size_t c = 0;
+    (PutValue(base + col_offset_[c] + r * col_size_[c], col_type_[c], values, c), ...);
+
+    rows_.fetch_add(1, std::memory_order_relaxed);
+    if (++active_->rows_ == init_s_.chunk_rows_) Publish();
+    return true;
+  }
+
+  // hand a partial chunk to the writer
+  void Flush();
+
+  // Flush() and wait until the writer wrote every chunk, e.g. before the file is read; producer thread
+  void Drain();
+
+  // stats, readable from other threads
+  inline uint64_t GetRows() const { return rows_.load(std::memory_order_relaxed); }
+  inline uint64_t GetDroppedRows() const { return dropped_.load(std::memory_order_relaxed); }
+  inline uint64_t GetRawBytes() const { return raw_bytes_.load(std::memory_order_relaxed); }
+  inline uint64_t GetStoredBytes() const { return stored_bytes_.load(std::memory_order_relaxed); }
+  inline uint64_t GetWriteErrors() const { return write_errors_.load(std::memory_order_relaxed); }
+
+  // compress + write of one chunk (ns)
+  inline const lra::stats_util::LatencyHistogram& GetWriteTime() const { return write_time_; }
+
+  // ring file mode: recovery on Open(), block msync time
+  inline const RingFile& GetRing() const { return ring_; }
+
+ private:
+  enum State : uint8_t { kFree, kFull };
+
+  struct Buffer {
+    std::vector<std::byte> data_;  // column i at col_offset_[i], room for chunk_rows_ values
+    uint32_t rows_{0};
+    uint64_t first_row_{0};
+    int64_t t_first_ns_{0};  // unix ns of the first / last row
+    int64_t t_last_ns_{0};
+    std::atomic<uint8_t> state_{kFree};
+  };
+
+  std::shared_ptr<lra::log_util::LogUnit> logunit_{nullptr};
+  RecorderInit_S init_s_;
+  FILE* file_{nullptr};
+  RingFile ring_;
+  std::thread t_;
+  std::atomic<bool> run_{false};
+  std::atomic<uint32_t> seq_{0};  // +1 per published chunk, the writer sleeps on it
+
+  std::vector<size_t> col_size_;
+  std::vector<size_t> col_offset_;
+  std::vector<ColumnType> col_type_;
+
+  Buffer buffers_[2];
+  Buffer* active_{nullptr};  // producer only
+  uint32_t next_fill_{0};    // producer only
+  uint64_t next_row_{0};     // producer only
+
+  std::atomic<uint64_t> rows_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> raw_bytes_{0};
+  std::atomic<uint64_t> stored_bytes_{0};
+  std::atomic<uint64_t> write_errors_{0};
+  lra::stats_util::LatencyHistogram write_time_;
+
+  // writer only
+  std::vector<std::byte> encoded_;
+
+  bool Acquire();
+  void Publish();
+  void Run();
+  void WriteChunk(Buffer& buf);
+  std::vector<std::byte> HeaderBytes() const;
+
+  template <typename T>
+  static inline void PutValue(std::byte* dst, ColumnType type, T v, size_t& c) {
+    switch (type) {
+      case ColumnType::kF32: {
+        const float f = static_cast<float>(v);
+        memcpy(dst, &f, sizeof(f));
+        break;
+      }
+      case ColumnType::kF64: {
+        const double d = static_cast<double>(v);
+        memcpy(dst, &d, sizeof(d));
+        break;
+      }
+      case ColumnType::kU8: {
+        const uint8_t u = static_cast<uint8_t>(v);
+        memcpy(dst, &u, sizeof(u));
+        break;
+      }
+      case ColumnType::kU32: {
+        const uint32_t u = static_cast<uint32_t>(v);
+        memcpy(dst, &u, sizeof(u));
+        break;
+      }
+      case ColumnType::kI64: {
+        const int64_t i = static_cast<int64_t>(v);
+        memcpy(dst, &i, sizeof(i));
+        break;
+      }
+    }
+    c++;
+  }
+};
+
+}  // namespace lra::recorder_util
+
+#endif
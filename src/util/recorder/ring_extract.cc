@@ -0,0 +1,105 @@
+// ring file (.lrg) to a record file (.lrr) of a time range, lra_record_convert turns that into csv / json
+// usage: lra_ring_extract <file.lrg>                                  list the blocks and runs
+//        lra_ring_extract <file.lrg> <out.lrr> <last hours>
+//        lra_ring_extract <file.lrg> <out.lrr> <from unix s> <to unix s>
+// a range over several runs (program restarts) gives one file per run, out.1.lrr, out.2.lrr, ... oldest first
+
+#include <util/recorder/ring_file.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+using lra::recorder_util::RingExtractStats;
+using lra::recorder_util::RingReader;
+using lra::recorder_util::RingRun;
+
+static void PrintTime(int64_t ns) {
+  const time_t s = ns / 1000000000;
+  char buf[32];
+  strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", localtime(&s));
+  printf("%s.%03ld", buf, (long)(ns / 1000000 % 1000));
+}
+
+int main(int argc, char** argv) {
+  if (argc != 2 && argc != 4 && argc != 5) {
+    fprintf(stderr, "usage: %s <file.lrg> [<out.lrr> <last hours> | <out.lrr> <from unix s> <to unix s>]\n", argv[0]);
+    return 2;
+  }
+
+  RingReader reader;
+  if (!reader.Open(argv[1])) {
+    fprintf(stderr, "%s: %.*s\n", argv[1], (int)reader.Error().size(), reader.Error().data());
+    return 1;
+  }
+
+  const auto& blocks = reader.Blocks();
+  if (argc == 2) {
+    uint64_t rows = 0;
+    for (const auto& b : blocks) rows += b.entry_.rows_;
+    printf("%zu blocks, %lu rows\n", blocks.size(), rows);
+    if (!blocks.empty()) {
+      printf("from ");
+      PrintTime(blocks.front().entry_.t_first_ns_);
+      printf(" to ");
+      PrintTime(blocks.back().entry_.t_last_ns_);
+      printf("%s\n", blocks.back().sealed_ ? "" : " (last block not sealed yet)");
+    }
+    for (const RingRun& run : reader.Runs(INT64_MIN, INT64_MAX)) {
+      printf("run ");
+      PrintTime(run.start_ns_);
+      printf(": odr %g Hz, range %g g, offset %g %g %g g\n", run.odr_hz_, run.range_g_, run.offset_g_[0],
+             run.offset_g_[1], run.offset_g_[2]);
+    }
+    return 0;
+  }
+
+  int64_t from_ns, to_ns;
+  if (argc == 4) {
+    to_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch())
+                .count();
+    from_ns = to_ns - static_cast<int64_t>(atof(argv[3]) * 3600e9);
+  } else {
+    from_ns = static_cast<int64_t>(atof(argv[3]) * 1e9);
+    to_ns = static_cast<int64_t>(atof(argv[4]) * 1e9);
+  }
+
+  // time columns count from each run's start, which the record header has: a file per run
+  const std::vector<RingRun> runs = reader.Runs(from_ns, to_ns);
+  const std::string path = argv[2];
+  const size_t slash = path.rfind('/');
+  size_t dot = path.rfind('.');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = path.size();
+  RingExtractStats stats;
+  uint64_t rows = 0, chunks = 0;
+  for (size_t k = 0; k < std::max<size_t>(runs.size(), 1); k++) {
+    const std::string out_path =
+        runs.size() > 1 ? path.substr(0, dot) + "." + std::to_string(k + 1) + path.substr(dot) : path;
+    FILE* out = fopen(out_path.c_str(), "wb");
+    if (!out) {
+      fprintf(stderr, "%s: cannot open\n", out_path.c_str());
+      return 1;
+    }
+
+    // nothing in range: still a valid (empty) record file
+    const bool ok = reader.Extract(from_ns, to_ns, runs.empty() ? RingRun{} : runs[k], out, stats);
+    fclose(out);
+    if (!ok) {
+      fprintf(stderr, "%s: %.*s\n", argv[1], (int)reader.Error().size(), reader.Error().data());
+      return 1;
+    }
+    if (runs.size() > 1) printf("%s: %lu rows in %lu chunks\n", out_path.c_str(), stats.rows_, stats.chunks_);
+    rows += stats.rows_;
+    chunks += stats.chunks_;
+  }
+
+  printf("%lu rows in %lu chunks", rows, chunks);
+  if (runs.size() > 1) printf(", %zu runs (program restarts) in the range", runs.size());
+  printf("\n");
+  return 0;
+}
@@ -0,0 +1,478 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <util/recorder/ring_file.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace lra::recorder_util {
+
+namespace {
+
+constexpr size_t kChunkEntryHead = sizeof(ChunkHeader) + sizeof(RingChunkTime);
+
+inline uint64_t RoundUp(uint64_t v, uint64_t to) { return (v + to - 1) / to * to; }
+
+// FNV-1a of the bytes before checksum_
+template <typename T>
+inline uint32_t ChecksumOf(const T& v) {
+  return Fnv1a(std::span<const std::byte>(reinterpret_cast<const std::byte*>(&v), offsetof(T, checksum_)));
+}
+
+template <typename T>
+inline T Load(const std::byte* p) {
+  T v;
+  memcpy(&v, p, sizeof(T));
+  return v;
+}
+
+uint32_t SuperChecksum(const RingSuper& s, std::span<const std::byte> record_header) {
+  std::vector<std::byte> b(offsetof(RingSuper, checksum_));
+  memcpy(b.data(), &s, b.size());
+  b.insert(b.end(), record_header.begin(), record_header.end());
+  return Fnv1a(b);
+}
+
+// superblock and record header checked against each other and the file size
+bool LoadSuper(const std::byte* base, size_t file_bytes, RingSuper& s, std::span<const std::byte>& record_header) {
+  if (file_bytes < kRingSuperBytes) return false;
+  s = Load<RingSuper>(base);
+  if (s.magic_ != kRingMagic || s.version_ != kRingVersion) return false;
+  if (s.header_bytes_ < kRecordHeaderBytes || s.header_bytes_ > kRingSuperBytes - kRingHeaderOffset) return false;
+  if (s.block_count_ < 2 || s.block_bytes_ < sizeof(RingBlockHeader) + kChunkEntryHead) return false;
+  if (s.index_offset_ < kRingSuperBytes || s.data_offset_ < s.index_offset_ + uint64_t{s.block_count_} * 64) return false;
+  if (s.data_offset_ + uint64_t{s.block_count_} * s.block_bytes_ > file_bytes) return false;
+
+  record_header = std::span<const std::byte>(base + kRingHeaderOffset, s.header_bytes_);
+  return SuperChecksum(s, record_header) == s.checksum_;
+}
+
+// start / odr / range / offset of a record header, the part a run may change
+constexpr size_t kRunOffset = 16;
+
+RingRun RunOf(std::span<const std::byte> record_header) { return Load<RingRun>(record_header.data() + kRunOffset); }
+
+// a ring of that geometry with that stream schema, what the runs wrote is kept
+bool SameLayout(const std::byte* base, size_t file_bytes, const RingSuper& want,
+                std::span<const std::byte> record_header) {
+  RingSuper have;
+  std::span<const std::byte> have_header;
+  constexpr size_t run_end = kRunOffset + sizeof(RingRun);
+  return LoadSuper(base, file_bytes, have, have_header) && have.block_bytes_ == want.block_bytes_ &&
+         have.block_count_ == want.block_count_ && have.index_offset_ == want.index_offset_ &&
+         have.data_offset_ == want.data_offset_ && have_header.size() == record_header.size() &&
+         !memcmp(have_header.data(), record_header.data(), kRunOffset) &&
+         !memcmp(have_header.data() + run_end, record_header.data() + run_end, record_header.size() - run_end);
+}
+
+bool ColumnSizes(std::span<const std::byte> record_header, std::vector<size_t>& sizes) {
+  const uint16_t n = Load<uint16_t>(record_header.data() + 6);
+  if (record_header.size() != kRecordHeaderBytes + kColumnBytes * n) return false;
+
+  sizes.clear();
+  for (uint16_t c = 0; c < n; c++) {
+    const size_t size = ColumnSize(static_cast<ColumnType>(record_header[kRecordHeaderBytes + kColumnBytes * c]));
+    if (!size) return false;
+    sizes.push_back(size);
+  }
+  return true;
+}
+
+// index entry and block header agree, the block was sealed
+bool LoadSealed(const std::byte* index, const std::byte* block, uint32_t block_bytes, RingIndexEntry& e,
+                RingBlockHeader& bh) {
+  e = Load<RingIndexEntry>(index);
+  if (e.seq_ == 0 || ChecksumOf(e) != e.checksum_) return false;
+  if (e.used_bytes_ > block_bytes || e.chunks_ == 0) return false;
+
+  bh = Load<RingBlockHeader>(block);
+  return bh.magic_ == kBlockMagic && ChecksumOf(bh) == bh.checksum_ && bh.seq_ == e.seq_ &&
+         bh.used_bytes_ == e.used_bytes_ && bh.chunks_ == e.chunks_;
+}
+
+struct ScannedChunk {
+  ChunkHeader h_;
+  RingChunkTime t_;
+  std::span<const std::byte> payload_;
+};
+
+// chunks of a block from its first one, until limit bytes, a bad chunk or a row going back (stale chunks of the
+// last lap); a row gap forward is rows the recorder dropped.
+// verify: decode + checksum each (a block not sealed). Returns the bytes used.
+template <typename F>
+uint32_t ScanChunks(const std::byte* block, uint32_t limit, std::span<const size_t> sizes, uint64_t expected_row,
+                    bool verify, F&& on_chunk) {
+  std::vector<std::byte> raw;
+  uint32_t off = sizeof(RingBlockHeader);
+
+  while (off + kChunkEntryHead <= limit) {
+    ScannedChunk c;
+    c.h_ = Load<ChunkHeader>(block + off);
+    c.t_ = Load<RingChunkTime>(block + off + sizeof(ChunkHeader));
+    if (c.h_.magic_ != kChunkMagic || c.h_.rows_ == 0 || c.h_.first_row_ < expected_row) break;
+    if (c.h_.stored_bytes_ > limit - off - kChunkEntryHead) break;
+
+    c.payload_ = std::span<const std::byte>(block + off + kChunkEntryHead, c.h_.stored_bytes_);
+    if (verify && DecodeChunk(c.h_, c.payload_, sizes, raw) != nullptr) break;
+
+    on_chunk(c);
+    expected_row = c.h_.first_row_ + c.h_.rows_;
+    off += RoundUp(kChunkEntryHead + c.h_.stored_bytes_, 8);
+  }
+  return off;
+}
+
+}  // namespace
+
+/* RingFile */
+
+RingFile::~RingFile() { Close(); }
+
+bool RingFile::Fail(std::string_view what) {
+  error_ = what;
+  if (errno) error_ += std::string(": ") + strerror(errno);
+  Close();
+  return false;
+}
+
+bool RingFile::Open(const RingInit_S& init_s, std::span<const std::byte> record_header,
+                    std::span<const size_t> sizes) {
+  Close();
+  error_.clear();
+  errno = 0;
+  kept_blocks_ = 0;
+  recovered_chunks_ = 0;
+  moved_aside_.clear();
+  sync_time_.Reset();
+  sizes_.assign(sizes.begin(), sizes.end());
+
+  if (record_header.size() > kRingSuperBytes - kRingHeaderOffset) return Fail("too many columns for a ring file");
+  run_ = RunOf(record_header);
+
+  // geometry: superblock, index, blocks, each part page aligned (msync works on pages)
+  page_bytes_ = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  RingSuper want;
+  want.block_bytes_ = RoundUp(std::max<uint64_t>(init_s.block_bytes_, kRingSuperBytes), page_bytes_);
+  want.index_offset_ = RoundUp(kRingSuperBytes, page_bytes_);
+  uint64_t count = (init_s.bytes_ > want.index_offset_) ? (init_s.bytes_ - want.index_offset_) / want.block_bytes_ : 0;
+  while (count && RoundUp(want.index_offset_ + count * 64, page_bytes_) + count * want.block_bytes_ > init_s.bytes_)
+    count--;
+  if (count < 2) return Fail("ring smaller than two blocks");
+  want.block_count_ = count;
+  want.data_offset_ = RoundUp(want.index_offset_ + count * 64, page_bytes_);
+  want.header_bytes_ = record_header.size();
+  want.checksum_ = SuperChecksum(want, record_header);
+  const uint64_t total = want.data_offset_ + count * want.block_bytes_;
+
+  fd_ = open(init_s.path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd_ < 0) return Fail("open");
+
+  struct stat st;
+  if (fstat(fd_, &st) != 0) return Fail("stat");
+
+  // same geometry and schema (the run fields of the record header may differ): keep the data
+  bool reuse = false;
+  if (st.st_size > 0) {
+    if (static_cast<uint64_t>(st.st_size) == total) {
+      void* old = mmap(nullptr, total, PROT_READ, MAP_SHARED, fd_, 0);
+      if (old == MAP_FAILED) return Fail("mmap");
+      reuse = SameLayout(static_cast<const std::byte*>(old), total, want, record_header);
+      munmap(old, total);
+    }
+
+    // anything else (another schema / size, a damaged superblock) is kept for a look, the ring starts anew
+    if (!reuse) {
+      close(fd_);
+      fd_ = -1;
+      moved_aside_ = init_s.path_ + ".old";
+      if (rename(init_s.path_.c_str(), moved_aside_.c_str()) != 0) return Fail("move aside");
+      fd_ = open(init_s.path_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+      if (fd_ < 0) return Fail("open");
+    }
+  }
+
+  // reserve every block now, a full card fails here and not with SIGBUS on a page fault later
+  if (!reuse) {
+    if (ftruncate(fd_, 0) != 0 || ftruncate(fd_, total) != 0) return Fail("truncate");
+    if (int err = posix_fallocate(fd_, 0, total); err) {
+      errno = err;
+      return Fail("reserve");
+    }
+  }
+
+  void* p = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (p == MAP_FAILED) return Fail("mmap");
+  base_ = static_cast<std::byte*>(p);
+  map_bytes_ = total;
+
+  super_ = want;
+  if (reuse) {
+    Recover();
+  } else if (!Format(record_header)) {
+    return false;
+  }
+  return true;
+}
+
+void RingFile::Close() {
+  if (base_) {
+    Seal();
+    munmap(base_, map_bytes_);
+  }
+  if (fd_ >= 0) close(fd_);
+  base_ = nullptr;
+  map_bytes_ = 0;
+  fd_ = -1;
+}
+
+bool RingFile::Format(std::span<const std::byte> record_header) {
+  memset(base_, 0, super_.data_offset_);
+  memcpy(base_, &super_, sizeof(super_));
+  memcpy(base_ + kRingHeaderOffset, record_header.data(), record_header.size());
+  if (msync(base_, super_.data_offset_, MS_SYNC) != 0) return Fail("msync");
+
+  cur_ = 0;
+  next_row_ = 0;
+  StartBlock(1);
+  return true;
+}
+
+// go on after the newest sealed block; the block after it was being filled, keep its good chunks
+void RingFile::Recover() {
+  RingIndexEntry newest;
+  uint32_t newest_idx = 0;
+  RingIndexEntry e;
+  RingBlockHeader bh;
+
+  for (uint32_t i = 0; i < super_.block_count_; i++) {
+    if (!LoadSealed(reinterpret_cast<const std::byte*>(Entry(i)), Block(i), super_.block_bytes_, e, bh)) continue;
+    kept_blocks_++;
+    if (e.seq_ > newest.seq_) {
+      newest = e;
+      newest_idx = i;
+    }
+  }
+
+  cur_ = newest.seq_ ? (newest_idx + 1) % super_.block_count_ : 0;
+  next_row_ = newest.first_row_ + newest.rows_;
+
+  // a block still sealed is the oldest one, not reused yet: nothing was written there
+  const bool untouched =
+      LoadSealed(reinterpret_cast<const std::byte*>(Entry(cur_)), Block(cur_), super_.block_bytes_, e, bh);
+  StartBlock(newest.seq_ + 1);
+  if (untouched) return;
+
+  const uint32_t used =
+      ScanChunks(Block(cur_), super_.block_bytes_, sizes_, next_row_, true, [this](const ScannedChunk& c) {
+        if (entry_.chunks_ == 0) {
+          entry_.t_first_ns_ = c.t_.t_first_ns_;
+          entry_.first_row_ = c.h_.first_row_;
+          block_run_ = c.t_.run_;
+        }
+        entry_.t_last_ns_ = c.t_.t_last_ns_;
+        entry_.rows_ = c.h_.first_row_ + c.h_.rows_ - entry_.first_row_;
+        entry_.chunks_++;
+        next_row_ = c.h_.first_row_ + c.h_.rows_;
+      });
+  if (entry_.chunks_ == 0) return;
+
+  recovered_chunks_ = entry_.chunks_;
+  entry_.used_bytes_ = used;
+  Seal();
+  cur_ = (cur_ + 1) % super_.block_count_;
+  StartBlock(entry_.seq_ + 1);
+}
+
+// the entry goes first: from here the block's old content is not named by the index any more
+void RingFile::StartBlock(uint64_t seq) {
+  entry_ = RingIndexEntry{};
+  entry_.seq_ = seq;
+  entry_.first_row_ = next_row_;
+  entry_.used_bytes_ = sizeof(RingBlockHeader);
+  block_run_ = run_;
+
+  *Entry(cur_) = RingIndexEntry{};
+  Sync(reinterpret_cast<const std::byte*>(Entry(cur_)), sizeof(RingIndexEntry));
+}
+
+bool RingFile::Append(const ChunkHeader& h, std::span<const std::byte> payload, int64_t t_first_ns,
+                      int64_t t_last_ns) {
+  if (!base_) return false;
+
+  const uint64_t need = RoundUp(kChunkEntryHead + payload.size(), 8);
+  if (need > super_.block_bytes_ - sizeof(RingBlockHeader)) {
+    error_ = "chunk larger than a block";
+    return false;
+  }
+
+  if (entry_.used_bytes_ + need > super_.block_bytes_) {
+    Seal();
+    cur_ = (cur_ + 1) % super_.block_count_;
+    StartBlock(entry_.seq_ + 1);
+  }
+
+  std::byte* p = Block(cur_) + entry_.used_bytes_;
+  const RingChunkTime t{.t_first_ns_ = t_first_ns, .t_last_ns_ = t_last_ns, .run_ = run_};
+  memcpy(p, &h, sizeof(h));
+  memcpy(p + sizeof(h), &t, sizeof(t));
+  memcpy(p + kChunkEntryHead, payload.data(), payload.size());
+
+  if (entry_.chunks_ == 0) {
+    entry_.t_first_ns_ = t_first_ns;
+    entry_.first_row_ = h.first_row_;
+  }
+  entry_.t_last_ns_ = t_last_ns;
+  entry_.rows_ = h.first_row_ + h.rows_ - entry_.first_row_;
+  entry_.chunks_++;
+  entry_.used_bytes_ += need;
+  next_row_ = h.first_row_ + h.rows_;
+  return true;
+}
+
+// block to storage, then the entry that names it
+void RingFile::Seal() {
+  if (!base_ || entry_.chunks_ == 0) return;
+  const auto t0 = std::chrono::steady_clock::now();
+
+  RingBlockHeader bh{.chunks_ = entry_.chunks_,
+                     .seq_ = entry_.seq_,
+                     .start_ns_ = block_run_.start_ns_,
+                     .used_bytes_ = entry_.used_bytes_};
+  bh.checksum_ = ChecksumOf(bh);
+  memcpy(Block(cur_), &bh, sizeof(bh));
+  Sync(Block(cur_), entry_.used_bytes_);
+
+  entry_.checksum_ = ChecksumOf(entry_);
+  memcpy(Entry(cur_), &entry_, sizeof(entry_));
+  Sync(reinterpret_cast<const std::byte*>(Entry(cur_)), sizeof(RingIndexEntry));
+
+  entry_.chunks_ = 0;  // sealed once
+  sync_time_.Record(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+}
+
+void RingFile::Sync(const std::byte* p, size_t bytes) {
+  const size_t off = static_cast<size_t>(p - base_);
+  const size_t from = off / page_bytes_ * page_bytes_;
+  msync(base_ + from, off + bytes - from, MS_SYNC);
+}
+
+/* RingReader */
+
+RingReader::~RingReader() { Close(); }
+
+void RingReader::Close() {
+  if (base_) munmap(const_cast<std::byte*>(base_), map_bytes_);
+  if (fd_ >= 0) close(fd_);
+  base_ = nullptr;
+  map_bytes_ = 0;
+  fd_ = -1;
+  blocks_.clear();
+}
+
+bool RingReader::Fail(std::string_view what) {
+  error_ = what;
+  return false;
+}
+
+bool RingReader::Open(const std::string& path) {
+  Close();
+  error_.clear();
+
+  fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0) return Fail("cannot open file");
+
+  struct stat st;
+  if (fstat(fd_, &st) != 0 || st.st_size < static_cast<off_t>(kRingSuperBytes)) return Fail("not a ring file");
+
+  void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd_, 0);
+  if (p == MAP_FAILED) return Fail("mmap failed");
+  base_ = static_cast<const std::byte*>(p);
+  map_bytes_ = st.st_size;
+
+  std::span<const std::byte> record_header;
+  if (!LoadSuper(base_, map_bytes_, super_, record_header)) return Fail("not a ring file");
+  if (!ColumnSizes(record_header, sizes_)) return Fail("bad record header");
+
+  // sealed blocks, by the index
+  RingBlockInfo info;
+  RingBlockHeader bh;
+  for (uint32_t i = 0; i < super_.block_count_; i++) {
+    const std::byte* entry = base_ + super_.index_offset_ + uint64_t{i} * sizeof(RingIndexEntry);
+    if (!LoadSealed(entry, Block(i), super_.block_bytes_, info.entry_, bh)) continue;
+    info.block_ = i;
+    info.run_ = Load<RingChunkTime>(Block(i) + sizeof(RingBlockHeader) + sizeof(ChunkHeader)).run_;
+    info.sealed_ = true;
+    blocks_.push_back(info);
+  }
+  std::sort(blocks_.begin(), blocks_.end(),
+            [](const RingBlockInfo& a, const RingBlockInfo& b) { return a.entry_.seq_ < b.entry_.seq_; });
+
+  // the block being filled follows the newest sealed one, its entry is cleared
+  const uint32_t open_block = blocks_.empty() ? 0 : (blocks_.back().block_ + 1) % super_.block_count_;
+  const std::byte* entry = base_ + super_.index_offset_ + uint64_t{open_block} * sizeof(RingIndexEntry);
+  if (Load<RingIndexEntry>(entry).seq_ == 0) {
+    RingBlockInfo live;
+    live.block_ = open_block;
+    live.sealed_ = false;
+    live.entry_.seq_ = blocks_.empty() ? 1 : blocks_.back().entry_.seq_ + 1;
+    live.entry_.first_row_ = blocks_.empty() ? 0 : blocks_.back().entry_.first_row_ + blocks_.back().entry_.rows_;
+
+    live.entry_.used_bytes_ = ScanChunks(Block(open_block), super_.block_bytes_, sizes_, live.entry_.first_row_, true,
+                                         [&live](const ScannedChunk& c) {
+                                           if (live.entry_.chunks_ == 0) {
+                                             live.entry_.t_first_ns_ = c.t_.t_first_ns_;
+                                             live.entry_.first_row_ = c.h_.first_row_;
+                                             live.run_ = c.t_.run_;
+                                           }
+                                           live.entry_.t_last_ns_ = c.t_.t_last_ns_;
+                                           live.entry_.rows_ = c.h_.first_row_ + c.h_.rows_ - live.entry_.first_row_;
+                                           live.entry_.chunks_++;
+                                         });
+    if (live.entry_.chunks_) blocks_.push_back(live);
+  }
+  return true;
+}
+
+std::vector<RingRun> RingReader::Runs(int64_t from_ns, int64_t to_ns) const {
+  std::vector<RingRun> runs;
+  for (const auto& info : blocks_) {
+    if (info.entry_.t_last_ns_ < from_ns || info.entry_.t_first_ns_ > to_ns) continue;
+    if (runs.empty() || runs.back().start_ns_ != info.run_.start_ns_) runs.push_back(info.run_);
+  }
+  return runs;
+}
+
+// the index picks the blocks (clock steps, e.g. NTP after boot, keep a linear pass over it), then chunk times
+bool RingReader::Extract(int64_t from_ns, int64_t to_ns, const RingRun& run, FILE* out, RingExtractStats& stats) {
+  stats = RingExtractStats{};
+  if (!base_) return Fail("not open");
+
+  // the superblock's record header is the one of the run that formatted the file, this run's fields go in
+  std::vector<std::byte> header(base_ + kRingHeaderOffset, base_ + kRingHeaderOffset + super_.header_bytes_);
+  memcpy(header.data() + kRunOffset, &run, sizeof(run));
+  if (fwrite(header.data(), 1, header.size(), out) != header.size()) return Fail("write failed");
+
+  for (const auto& info : blocks_) {
+    const auto& e = info.entry_;
+    if (info.run_.start_ns_ != run.start_ns_ || e.t_last_ns_ < from_ns || e.t_first_ns_ > to_ns) continue;
+
+    bool ok = true;
+    ScanChunks(Block(info.block_), e.used_bytes_, sizes_, e.first_row_, !info.sealed_, [&](const ScannedChunk& c) {
+      if (!ok || c.t_.t_last_ns_ < from_ns || c.t_.t_first_ns_ > to_ns) return;
+      ok = fwrite(&c.h_, sizeof(c.h_), 1, out) == 1 &&
+           fwrite(c.payload_.data(), 1, c.payload_.size(), out) == c.payload_.size();
+      stats.chunks_++;
+      stats.rows_ += c.h_.rows_;
+    });
+    if (!ok) return Fail("write failed");
+  }
+  return true;
+}
+
+}  // namespace lra::recorder_util
@@ -0,0 +1,233 @@
+#ifndef LRA_UTIL_RECORDER_RING_FILE_H_
+#define LRA_UTIL_RECORDER_RING_FILE_H_
+
+#include <util/recorder/record_format.h>
+#include <util/stats/stats.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lra::recorder_util {
+
+/**
+ * Ring file (.lrg), fixed size and memory mapped, keeps the newest blocks of a stream, the oldest block is reused
+ *
+ * little endian (host order), offsets are multiples of the page size
+ *
+ * superblock (RingSuper) at 0, the record header (record_format.h) of the stream at 64
+ * index at index_offset_, one RingIndexEntry (64 B, never across a page) per block, seq_ 0: not sealed
+ * block i at data_offset_ + i * block_bytes_
+ *  0       RingBlockHeader (32 B), written when the block is sealed
+ *  32      chunks until used_bytes_: ChunkHeader (record_format.h), RingChunkTime, payload, each 8 byte aligned
+ *
+ * runs: every Open() of the writer is a run, it goes on after the last one if the stream schema (record header but
+ * its start / odr / range / offset) and the geometry are the same. Each chunk carries its run (RingRun), the record
+ * header in the superblock is the one of the run that formatted the file. A file of another layout is moved aside
+ * (path + ".old") before a new ring is made, never formatted in place.
+ *
+ * crash safety
+ *  1. a full block is sealed: header written, block msync'ed, then its index entry written and msync'ed
+ *  2. the entry of a block is cleared and msync'ed before the block is reused
+ *  so after power loss the index names complete blocks only. Chunks of the block being filled are in the page cache;
+ *  after a process crash Open() keeps those that pass their checksum and follow on the last sealed block.
+ */
+constexpr uint32_t kRingMagic = 0x3147524C;   // "LRG1"
+constexpr uint32_t kBlockMagic = 0x3142524C;  // "LRB1"
+constexpr uint16_t kRingVersion = 2;
+constexpr size_t kRingSuperBytes = 4096;
+constexpr size_t kRingHeaderOffset = 64;  // record header in the superblock
+
+struct RingSuper {
+  uint32_t magic_{kRingMagic};
+  uint16_t version_{kRingVersion};
+  uint16_t reserved_{0};
+  uint32_t block_bytes_{0};
+  uint32_t block_count_{0};
+  uint64_t index_offset_{0};
+  uint64_t data_offset_{0};
+  uint32_t header_bytes_{0};  // record header
+  uint32_t checksum_{0};      // FNV-1a of the fields above and the record header
+};
+static_assert(sizeof(RingSuper) <= kRingHeaderOffset);
+
+struct RingIndexEntry {
+  uint64_t seq_{0};  // 1, 2, ... in write order
+  int64_t t_first_ns_{0};  // unix ns, first / last chunk of the block
+  int64_t t_last_ns_{0};
+  uint64_t first_row_{0};
+  uint32_t rows_{0};  // first_row_ .. the last row, dropped rows in between included
+  uint32_t used_bytes_{0};
+  uint32_t chunks_{0};
+  uint32_t reserved_[4]{};
+  uint32_t checksum_{0};  // FNV-1a of the bytes before
+};
+static_assert(sizeof(RingIndexEntry) == 64);
+
+struct RingBlockHeader {
+  uint32_t magic_{kBlockMagic};
+  uint32_t chunks_{0};
+  uint64_t seq_{0};
+  int64_t start_ns_{0};  // run that wrote the block, as RingRun
+  uint32_t used_bytes_{0};
+  uint32_t checksum_{0};  // FNV-1a of the bytes before
+};
+static_assert(sizeof(RingBlockHeader) == 32);
+
+// record header fields that change from run to run (offset 16 .. 44 of record_format.h)
+struct RingRun {
+  int64_t start_ns_{0};  // unix ns, time columns count from it
+  float odr_hz_{0};
+  float range_g_{0};
+  float offset_g_[3]{};
+  uint32_t reserved_{0};
+};
+static_assert(sizeof(RingRun) == 32);
+
+struct RingChunkTime {
+  int64_t t_first_ns_{0};  // unix ns, first / last row appended
+  int64_t t_last_ns_{0};
+  RingRun run_;  // run that wrote the chunk
+};
+static_assert(sizeof(RingChunkTime) == 48);
+
+struct RingInit_S {
+  std::string path_;
+  uint64_t bytes_{256ull << 20};   // whole file, blocks * block bytes + superblock / index
+  uint32_t block_bytes_{1 << 20};  // msync unit, rounded up to pages, holds at least one full chunk
+};
+
+/**
+ * @brief Writer side of a ring file, used by Recorder's writer thread (one thread).
+ * Open() reuses a file of the same geometry and stream schema (recovering it), anything else is moved aside.
+ */
+class RingFile {
+ public:
+  RingFile() = default;
+  RingFile(const RingFile&) = delete;
+  RingFile& operator=(const RingFile&) = delete;
+  ~RingFile();
+
+  // record_header: record_format.h header of the stream, its start / odr / range / offset are this run's
+  // sizes: column sizes
+  bool Open(const RingInit_S& init_s, std::span<const std::byte> record_header, std::span<const size_t> sizes);
+
+  // seal the block being filled, unmap
+  void Close();
+
+  inline bool IsOpen() const { return base_ != nullptr; }
+
+  // chunk header + stored payload, rows appended between t_first_ns and t_last_ns (unix ns)
+  bool Append(const ChunkHeader& h, std::span<const std::byte> payload, int64_t t_first_ns, int64_t t_last_ns);
+
+  // first row index of the next chunk, rows go on from the last run
+  inline uint64_t NextRow() const { return next_row_; }
+
+  // from Open(): sealed blocks kept, chunks of an unsealed block recovered
+  inline uint32_t GetKeptBlocks() const { return kept_blocks_; }
+  inline uint32_t GetRecoveredChunks() const { return recovered_chunks_; }
+  inline uint32_t GetBlockCount() const { return super_.block_count_; }
+
+  // from Open(): where a file of another layout was moved, empty if none
+  inline const std::string& GetMovedAside() const { return moved_aside_; }
+
+  // msync of a sealed block + its index entry (ns)
+  inline const lra::stats_util::LatencyHistogram& GetSyncTime() const { return sync_time_; }
+
+  inline std::string_view Error() const { return error_; }
+
+ private:
+  int fd_{-1};
+  std::byte* base_{nullptr};
+  size_t map_bytes_{0};
+  size_t page_bytes_{4096};
+  RingSuper super_;
+  std::vector<size_t> sizes_;
+  RingRun run_;
+  std::string error_;
+
+  // block being filled
+  uint32_t cur_{0};
+  RingIndexEntry entry_;
+  RingRun block_run_;  // of its chunks, a recovered block keeps the run that wrote it
+  uint64_t next_row_{0};
+
+  uint32_t kept_blocks_{0};
+  uint32_t recovered_chunks_{0};
+  std::string moved_aside_;
+  lra::stats_util::LatencyHistogram sync_time_;
+
+  bool Fail(std::string_view what);
+  bool Format(std::span<const std::byte> record_header);
+  void Recover();
+  void StartBlock(uint64_t seq);
+  void Seal();
+  void Sync(const std::byte* p, size_t bytes);
+
+  inline std::byte* Block(uint32_t i) const { return base_ + super_.data_offset_ + uint64_t{i} * super_.block_bytes_; }
+  inline RingIndexEntry* Entry(uint32_t i) const {
+    return reinterpret_cast<RingIndexEntry*>(base_ + super_.index_offset_) + i;
+  }
+};
+
+// what a ring file holds, see RingReader
+struct RingBlockInfo {
+  RingIndexEntry entry_;
+  uint32_t block_{0};
+  RingRun run_;        // a block holds chunks of one run
+  bool sealed_{true};  // false: the block being filled, chunks checked one by one
+};
+
+struct RingExtractStats {
+  uint64_t chunks_{0};
+  uint64_t rows_{0};
+};
+
+/**
+ * @brief Read side of a ring file, safe on a file that is being written (read only mapping).
+ * The index gives the blocks of a time range without touching the others.
+ */
+class RingReader {
+ public:
+  RingReader() = default;
+  RingReader(const RingReader&) = delete;
+  RingReader& operator=(const RingReader&) = delete;
+  ~RingReader();
+
+  bool Open(const std::string& path);
+  void Close();
+
+  // oldest first
+  inline const std::vector<RingBlockInfo>& Blocks() const { return blocks_; }
+
+  // runs with blocks in [from_ns, to_ns] (unix ns), oldest first
+  std::vector<RingRun> Runs(int64_t from_ns, int64_t to_ns) const;
+
+  // chunks of run with rows in [from_ns, to_ns] (unix ns) as a record file (.lrr) with that run's header,
+  // RecordReader / lra_record_convert read it
+  bool Extract(int64_t from_ns, int64_t to_ns, const RingRun& run, FILE* out, RingExtractStats& stats);
+
+  inline std::string_view Error() const { return error_; }
+
+ private:
+  int fd_{-1};
+  const std::byte* base_{nullptr};
+  size_t map_bytes_{0};
+  RingSuper super_;
+  std::vector<size_t> sizes_;
+  std::vector<RingBlockInfo> blocks_;
+  std::string error_;
+
+  bool Fail(std::string_view what);
+
+  inline const std::byte* Block(uint32_t i) const {
+    return base_ + super_.data_offset_ + uint64_t{i} * super_.block_bytes_;
+  }
+};
+
+}  // namespace lra::recorder_util
+
+#endif
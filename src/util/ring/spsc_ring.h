@@ -0,0 +1,124 @@
+#ifndef LRA_UTIL_SPSC_RING_H_
+#define LRA_UTIL_SPSC_RING_H_
+
+/**
+ * @brief Fixed capacity single producer / single consumer ring, overwrite oldest when full.
+ *
+ * @note
+ *   1. head_ is only written by producer, tail_ is advanced by consumer and by producer when dropping the oldest,
+ *      both with CAS, so a consumer commit fails if the producer overwrote what it was reading.
+ *   2. Peek() gives at most two contiguous spans (wrap around) without allocation, Commit() validates them.
+ *   3. Counters are monotonic 64-bit, no ABA in practice.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+namespace lra::ring_util {
+
+constexpr size_t kCacheLineSize = 64;
+
+template <typename T, size_t N>
+  requires std::is_trivially_copyable_v<T> && (N > 0) && ((N & (N - 1)) == 0)
+class SpscRing {
+ public:
+  struct ReadView {
+    std::span<const T> first{};
+    std::span<const T> second{};
+    uint64_t tail{0};
+
+    inline size_t size() const { return first.size() + second.size(); }
+  };
+
+  SpscRing() : buf_(std::make_unique<T[]>(N)) {}
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  static constexpr size_t Capacity() { return N; }
+
+  // producer only, never blocks
+  void Push(const T& val) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+
+    if (head - tail >= N) {  // full, drop oldest; CAS fails only if consumer freed space meanwhile
+      if (tail_.compare_exchange_strong(tail, tail + 1, std::memory_order_acq_rel)) {
+        overflow_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    buf_[head & kMask] = val;
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  // producer only
+  void PushN(std::span<const T> vals) {
+    for (const auto& v : vals) Push(v);
+  }
+
+  // consumer only, copy up to dst.size() oldest elements, return number popped
+  size_t PopInto(std::span<T> dst) {
+    while (true) {
+      ReadView view = Peek(dst.size());
+      if (view.size() == 0) return 0;
+
+      memcpy(dst.data(), view.first.data(), view.first.size_bytes());
+      if (!view.second.empty()) memcpy(dst.data() + view.first.size(), view.second.data(), view.second.size_bytes());
+
+      if (Commit(view)) return view.size();
+      // producer overwrote part of the view, copy again from new tail
+    }
+  }
+
+  // consumer only, zero copy view of up to max oldest elements
+  ReadView Peek(size_t max) const {
+    ReadView view;
+    view.tail = tail_.load(std::memory_order_acquire);
+    uint64_t head = head_.load(std::memory_order_acquire);
+
+    size_t n = head - view.tail;
+    if (n > max) n = max;
+    if (n == 0) return view;
+
+    size_t begin = view.tail & kMask;
+    size_t first_len = (begin + n > N) ? N - begin : n;
+
+    view.first = std::span<const T>(buf_.get() + begin, first_len);
+    view.second = std::span<const T>(buf_.get(), n - first_len);
+    return view;
+  }
+
+  // consumer only, release a view from Peek(); false if producer overwrote it, data in view should be discarded
+  bool Commit(const ReadView& view) {
+    uint64_t expected = view.tail;
+    return tail_.compare_exchange_strong(expected, view.tail + view.size(), std::memory_order_acq_rel);
+  }
+
+  inline size_t Size() const {
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    return (head - tail > N) ? N : head - tail;
+  }
+
+  inline bool Empty() const { return Size() == 0; }
+
+  // number of elements dropped because ring was full
+  inline uint64_t OverflowCount() const { return overflow_.load(std::memory_order_relaxed); }
+
+ private:
+  static constexpr uint64_t kMask = N - 1;
+
+  alignas(kCacheLineSize) std::atomic<uint64_t> head_{0};
+  alignas(kCacheLineSize) std::atomic<uint64_t> tail_{0};
+  alignas(kCacheLineSize) std::atomic<uint64_t> overflow_{0};
+  alignas(kCacheLineSize) std::unique_ptr<T[]> buf_;
+};
+
+}  // namespace lra::ring_util
+
+#endif
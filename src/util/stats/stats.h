@@ -0,0 +1,98 @@
+#ifndef LRA_UTIL_STATS_H_
+#define LRA_UTIL_STATS_H_
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+namespace lra::stats_util {
+
+/**
+ * @brief Log-linear histogram for latency / jitter (ns), 4 sub buckets per power of 2 (< 25% error).
+ * Record() is lock free and safe from multiple threads, readers get a relaxed snapshot.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBits = 2;
+  static constexpr int kSubBuckets = 1 << kSubBits;
+  static constexpr int kBuckets = 64 << kSubBits;
+
+  void Record(uint64_t ns) {
+    buckets_[BucketIdx(ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t cur = min_.load(std::memory_order_relaxed);
+    while (ns < cur && !min_.compare_exchange_weak(cur, ns, std::memory_order_relaxed)) {
+    }
+    cur = max_.load(std::memory_order_relaxed);
+    while (ns > cur && !max_.compare_exchange_weak(cur, ns, std::memory_order_relaxed)) {
+    }
+  }
+
+  uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+
+  uint64_t Min() const { return Count() ? min_.load(std::memory_order_relaxed) : 0; }
+
+  uint64_t Max() const { return max_.load(std::memory_order_relaxed); }
+
+  double Mean() const {
+    uint64_t n = Count();
+    return n ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / n : 0.0;
+  }
+
+  // upper bound of the bucket which holds the p-th percentile, p in [0, 100]
+  uint64_t Percentile(double p) const {
+    uint64_t n = Count();
+    if (n == 0) return 0;
+
+    uint64_t target = static_cast<uint64_t>(p / 100.0 * n);
+    if (target >= n) target = n - 1;
+
+    uint64_t acc = 0;
+    for (int i = 0; i < kBuckets; i++) {
+      acc += buckets_[i].load(std::memory_order_relaxed);
+      if (acc > target) {
+        uint64_t upper = BucketUpper(i);
+        uint64_t max = Max();
+        return (upper > max) ? max : upper;
+      }
+    }
+    return Max();
+  }
+
+  void Reset() {
+    for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+  static constexpr int BucketIdx(uint64_t v) {
+    if (v < kSubBuckets) return static_cast<int>(v);
+    int msb = 63 - std::countl_zero(v);
+    return ((msb - kSubBits + 1) << kSubBits) + static_cast<int>((v >> (msb - kSubBits)) & (kSubBuckets - 1));
+  }
+
+  static constexpr uint64_t BucketUpper(int idx) {
+    if (idx < kSubBuckets) return idx;
+    int msb = (idx >> kSubBits) + kSubBits - 1;
+    uint64_t width = uint64_t{1} << (msb - kSubBits);
+    uint64_t lower = (uint64_t{1} << msb) | (static_cast<uint64_t>(idx & (kSubBuckets - 1)) << (msb - kSubBits));
+    return lower + width - 1;
+  }
+
+ private:
+  std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> min_{std::numeric_limits<uint64_t>::max()};
+  std::atomic<uint64_t> max_{0};
+};
+
+}  // namespace lra::stats_util
+
+#endif
@@ -0,0 +1,41 @@
+#include <pthread.h>
+#include <sched.h>
+#include <util/log/async_log.h>
+#include <util/thread/thread.h>
+
+#include <cstring>
+
+namespace lra::thread_util {
+
+using ::lra::log_util::loglevel;
+
+bool ApplyThreadSchedule(const std::string& name, int rt_priority, int cpu, lra::log_util::LogUnit& log) {
+  lra::log_util::AsyncLog::SetThreadBudget(0);
+
+  pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+
+  bool ok = true;
+  if (cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err) {
+      log.LogToDefault(loglevel::warn, "{}: pin to cpu {} failed: {}\n", name, cpu, strerror(err));
+      ok = false;
+    }
+  }
+
+  if (rt_priority > 0) {
+    sched_param param{.sched_priority = rt_priority};
+    int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (err) {
+      log.LogToDefault(loglevel::warn, "{}: SCHED_FIFO {} failed: {}, keep SCHED_OTHER\n", name, rt_priority,
+                       strerror(err));
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+}  // namespace lra::thread_util
@@ -0,0 +1,26 @@
+#ifndef LRA_UTIL_THREAD_H_
+#define LRA_UTIL_THREAD_H_
+
+#include <util/log/logunit.h>
+
+#include <string>
+
+namespace lra::thread_util {
+
+/**
+ * @brief Set up the calling thread as a dedicated worker (control loop, rtp actuator, timer executor), call it first
+ * thing on that thread.
+ *
+ * @note
+ *   1. name_ is cut to 15 chars (pthread_setname_np), shows in top -H / ps -L.
+ *   2. rt_priority_ 1 ~ 99 switches to SCHED_FIFO (needs CAP_SYS_NICE), cpu_ >= 0 pins it; a refused one is logged
+ *      through log and the thread goes on as SCHED_OTHER / unpinned.
+ *   3. Log budget 0, see AsyncLog::SetThreadBudget().
+ *
+ * @return false if the priority or the affinity was refused
+ */
+bool ApplyThreadSchedule(const std::string& name, int rt_priority, int cpu, lra::log_util::LogUnit& log);
+
+}  // namespace lra::thread_util
+
+#endif
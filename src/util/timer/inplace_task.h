@@ -0,0 +1,94 @@
+#ifndef LRA_UTIL_TIMER_INPLACE_TASK_H_
+#define LRA_UTIL_TIMER_INPLACE_TASK_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace lra::timer_util {
+
+/**
+ * @brief void() callable stored in place, never allocates (std::function only keeps 16 bytes in place).
+ * Callables bigger than kCapacity do not compile, capture a pointer instead.
+ */
+class InplaceTask {
+ public:
+  static constexpr size_t kCapacity = 48;
+
+  InplaceTask() = default;
+
+  template <typename F>
+    requires(!std::is_same_v<std::decay_t<F>, InplaceTask> && std::is_invocable_v<std::decay_t<F>&> &&
+             std::is_copy_constructible_v<std::decay_t<F>>)
+  InplaceTask(F&& f) {  // NOLINT: implicit, as std::function
+    using T = std::decay_t<F>;
+    static_assert(sizeof(T) <= kCapacity, "callable too large for InplaceTask, capture a pointer instead");
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over aligned callable");
+
+    ::new (static_cast<void*>(buf_)) T(std::forward<F>(f));
+    ops_ = &kOps<T>;
+  }
+
+  InplaceTask(const InplaceTask& other) : ops_(other.ops_) {
+    if (ops_) ops_->copy(buf_, other.buf_);
+  }
+
+  InplaceTask(InplaceTask&& other) noexcept : ops_(other.ops_) {
+    if (ops_) ops_->move(buf_, other.buf_);
+    other.Reset();
+  }
+
+  InplaceTask& operator=(const InplaceTask& other) {
+    if (this != &other) {
+      Reset();
+      ops_ = other.ops_;
+      if (ops_) ops_->copy(buf_, other.buf_);
+    }
+    return *this;
+  }
+
+  InplaceTask& operator=(InplaceTask&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      ops_ = other.ops_;
+      if (ops_) ops_->move(buf_, other.buf_);
+      other.Reset();
+    }
+    return *this;
+  }
+
+  ~InplaceTask() { Reset(); }
+
+  void operator()() { ops_->invoke(buf_); }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  void Reset() {
+    if (ops_) ops_->destroy(buf_);
+    ops_ = nullptr;
+  }
+
+ private:
+  struct Ops {
+    void (*invoke)(void*);
+    void (*copy)(void* dst, const void* src);
+    void (*move)(void* dst, void* src);
+    void (*destroy)(void*);
+  };
+
+  template <typename T>
+  static constexpr Ops kOps = {
+      [](void* p) { (*static_cast<T*>(p))(); },
+      [](void* dst, const void* src) { ::new (dst) T(*static_cast<const T*>(src)); },
+      [](void* dst, void* src) { ::new (dst) T(std::move(*static_cast<T*>(src))); },
+      [](void* p) { static_cast<T*>(p)->~T(); },
+  };
+
+  alignas(std::max_align_t) unsigned char buf_[kCapacity];
+  const Ops* ops_{nullptr};
+};
+
+}  // namespace lra::timer_util
+
+#endif
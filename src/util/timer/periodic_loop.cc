@@ -0,0 +1,91 @@
+#include <util/thread/thread.h>
+#include <util/timer/periodic_loop.h>
+
+#include <cerrno>
+#include <ctime>
+
+namespace lra::timer_util {
+
+using ::lra::log_util::loglevel;
+
+namespace {
+
+constexpr int64_t kNsPerSec = 1000000000;
+
+inline int64_t ToNs(const timespec& ts) { return ts.tv_sec * kNsPerSec + ts.tv_nsec; }
+
+inline timespec FromNs(int64_t ns) { return timespec{.tv_sec = ns / kNsPerSec, .tv_nsec = ns % kNsPerSec}; }
+
+inline int64_t MonotonicNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ToNs(ts);
+}
+
+}  // namespace
+
+PeriodicLoop::~PeriodicLoop() { Stop(); }
+
+bool PeriodicLoop::Start(const PeriodicLoopInit_S& init_s, Task task) {
+  if (run_.load() || t_.joinable()) return false;
+  if (init_s.period_ms_ <= 0 || !task) return false;
+
+  init_s_ = init_s;
+  task_ = std::move(task);
+  logunit_ = lra::log_util::LogUnit::CreateLogUnit(init_s_.name_);
+
+  run_.store(true);
+  t_ = std::thread(&PeriodicLoop::Run, this);
+  return true;
+}
+
+void PeriodicLoop::Stop() {
+  run_.store(false);
+  if (t_.joinable()) t_.join();
+}
+
+void PeriodicLoop::ResetStats() {
+  jitter_.Reset();
+  exec_.Reset();
+  overruns_.store(0, std::memory_order_relaxed);
+  missed_.store(0, std::memory_order_relaxed);
+}
+
+void PeriodicLoop::Run() {
+  lra::thread_util::ApplyThreadSchedule(init_s_.name_, init_s_.rt_priority_, init_s_.cpu_, *logunit_);
+
+  const int64_t period_ns = static_cast<int64_t>(init_s_.period_ms_ * 1e6);
+  int64_t deadline = MonotonicNs() + period_ns;
+  uint64_t tick = 0;
+
+  logunit_->LogToDefault(loglevel::info, "{}: started, period {:.3f} ms\n", init_s_.name_, init_s_.period_ms_);
+
+  while (run_.load(std::memory_order_relaxed)) {
+    timespec ts = FromNs(deadline);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+
+    const int64_t wake = MonotonicNs();
+    jitter_.Record(wake > deadline ? wake - deadline : 0);
+
+    if (!run_.load(std::memory_order_relaxed)) break;
+
+    task_(tick++);
+
+    const int64_t done = MonotonicNs();
+    exec_.Record(done - wake);
+
+    deadline += period_ns;
+    if (done > deadline) {  // overrun, skip to the next deadline in the future, keep phase
+      int64_t skip = (done - deadline) / period_ns + 1;
+      overruns_.fetch_add(1, std::memory_order_relaxed);
+      missed_.fetch_add(skip, std::memory_order_relaxed);
+      deadline += skip * period_ns;
+    }
+  }
+
+  logunit_->LogToDefault(loglevel::info, "{}: stopped after {} cycles, overruns: {}\n", init_s_.name_, tick,
+                         GetOverrunCount());
+}
+
+}  // namespace lra::timer_util
@@ -0,0 +1,73 @@
+#ifndef LRA_UTIL_PERIODIC_LOOP_H_
+#define LRA_UTIL_PERIODIC_LOOP_H_
+
+#include <util/log/logunit.h>
+#include <util/stats/stats.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace lra::timer_util {
+
+struct PeriodicLoopInit_S {
+  std::string name_{"periodic_loop"};
+  double period_ms_{10.0};
+  int rt_priority_{0};  // SCHED_FIFO priority 1 ~ 99, 0 keeps SCHED_OTHER (needs CAP_SYS_NICE)
+  int cpu_{-1};         // pin to this cpu, -1 for no affinity
+};
+
+/**
+ * @brief Fixed rate loop on its own thread, wakes at absolute CLOCK_MONOTONIC deadlines (clock_nanosleep), no drift.
+ * A cycle that runs past the next deadline is an overrun, the missed deadlines are skipped (not replayed) so the
+ * phase of later cycles is kept.
+ */
+class PeriodicLoop {
+ public:
+  // tick counts cycles that ran, starts from 0
+  using Task = std::function<void(uint64_t tick)>;
+
+  PeriodicLoop() = default;
+  PeriodicLoop(const PeriodicLoop&) = delete;
+  PeriodicLoop& operator=(const PeriodicLoop&) = delete;
+  ~PeriodicLoop();
+
+  bool Start(const PeriodicLoopInit_S& init_s, Task task);
+
+  // wait for the running cycle to finish and join
+  void Stop();
+
+  inline bool IsRunning() const { return run_.load(std::memory_order_relaxed); }
+
+  // stats, readable from other threads
+  // wake-up latency after the deadline (ns)
+  inline const lra::stats_util::LatencyHistogram& GetJitter() const { return jitter_; }
+
+  // task execution time (ns)
+  inline const lra::stats_util::LatencyHistogram& GetExecTime() const { return exec_; }
+
+  inline uint64_t GetOverrunCount() const { return overruns_.load(std::memory_order_relaxed); }
+
+  inline uint64_t GetMissedCount() const { return missed_.load(std::memory_order_relaxed); }
+
+  void ResetStats();
+
+ private:
+  std::shared_ptr<lra::log_util::LogUnit> logunit_{nullptr};
+  PeriodicLoopInit_S init_s_;
+  Task task_;
+  std::thread t_;
+  std::atomic<bool> run_{false};
+
+  lra::stats_util::LatencyHistogram jitter_;
+  lra::stats_util::LatencyHistogram exec_;
+  std::atomic<uint64_t> overruns_{0};  // cycles that ended after the next deadline
+  std::atomic<uint64_t> missed_{0};    // deadlines skipped because of overruns
+
+  void Run();
+};
+
+}  // namespace lra::timer_util
+
+#endif
@@ -0,0 +1,170 @@
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <util/timer/precise_wait.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+
+namespace lra::timer_util {
+
+namespace {
+
+constexpr int64_t kNsPerSec = 1000000000;
+constexpr int kCalibrationWaits = 30;
+constexpr int64_t kCalibrationWaitNs = 2000000;
+constexpr double kAdaptWeight = 1.0 / 16;
+
+inline timespec FromNs(int64_t ns) { return timespec{.tv_sec = ns / kNsPerSec, .tv_nsec = ns % kNsPerSec}; }
+
+std::string KernelRelease() {
+  utsname u;
+  return uname(&u) ? std::string("unknown") : std::string(u.release);
+}
+
+}  // namespace
+
+PreciseWaiter::PreciseWaiter(const PreciseWaitInit_S& init_s) : init_s_(init_s) {
+  timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+  event_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  slack_ns_.store(init_s_.max_spin_ns_ ? std::min(init_s_.initial_slack_ns_, init_s_.max_spin_ns_) : 0);
+}
+
+PreciseWaiter::~PreciseWaiter() {
+  if (timer_fd_ >= 0) close(timer_fd_);
+  if (event_fd_ >= 0) close(event_fd_);
+}
+
+int64_t PreciseWaiter::NowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * kNsPerSec + ts.tv_nsec;
+}
+
+void PreciseWaiter::Interrupt() {
+  // one eventfd write until the waiter consumed it
+  if (pending_.exchange(true, std::memory_order_acq_rel)) return;
+  const uint64_t one = 1;
+  while (write(event_fd_, &one, sizeof(one)) < 0 && errno == EINTR) {
+  }
+}
+
+bool PreciseWaiter::ConsumeInterrupt() {
+  if (!pending_.load(std::memory_order_acquire)) return false;
+
+  uint64_t v;
+  while (read(event_fd_, &v, sizeof(v)) < 0 && errno == EINTR) {
+  }
+  pending_.store(false, std::memory_order_release);
+  return true;
+}
+
+bool PreciseWaiter::WaitUntil(int64_t deadline_ns, bool interruptible) {
+  if (interruptible && ConsumeInterrupt()) return false;
+
+  const int64_t slack = slack_ns_.load(std::memory_order_relaxed);
+  const int64_t target = (deadline_ns == kForever) ? kForever : deadline_ns - slack;
+
+  if (target > NowNs()) {
+    if (target != kForever) {
+      itimerspec its{.it_interval = {0, 0}, .it_value = FromNs(target)};
+      timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &its, nullptr);
+    }
+
+    pollfd fds[2] = {{.fd = timer_fd_, .events = POLLIN, .revents = 0},
+                     {.fd = event_fd_, .events = POLLIN, .revents = 0}};
+    pollfd* first = (target == kForever) ? &fds[1] : &fds[0];
+    const nfds_t n = (target == kForever) ? 1 : (interruptible ? 2 : 1);
+    if (target == kForever && !interruptible) return false;  // would never return
+
+    while (poll(first, n, -1) < 0 && errno == EINTR) {
+    }
+
+    if (interruptible && (fds[1].revents & POLLIN)) {
+      if (target != kForever) {
+        itimerspec off{};
+        timerfd_settime(timer_fd_, 0, &off, nullptr);
+      }
+      ConsumeInterrupt();
+      return false;
+    }
+
+    uint64_t expirations;
+    while (read(timer_fd_, &expirations, sizeof(expirations)) < 0 && errno == EINTR) {
+    }
+    Adapt(NowNs() - target);
+  }
+
+  // spin tail, the slack left before the deadline
+  if (init_s_.max_spin_ns_ > 0) {
+    while (NowNs() < deadline_ns) {
+      if (interruptible && ConsumeInterrupt()) return false;
+    }
+  }
+  return true;
+}
+
+void PreciseWaiter::Adapt(int64_t overshoot_ns) {
+  overshoot_.Record(overshoot_ns > 0 ? overshoot_ns : 0);
+  if (init_s_.max_spin_ns_ <= 0) return;
+
+  // first samples set the averages directly
+  const double x = static_cast<double>(overshoot_ns);
+  const double w = (samples_ < 16) ? 1.0 / (samples_ + 1) : kAdaptWeight;
+  samples_++;
+  mean_ns_ += (x - mean_ns_) * w;
+  dev_ns_ += (std::abs(x - mean_ns_) - dev_ns_) * w;
+  UpdateSlack();
+}
+
+void PreciseWaiter::UpdateSlack() {
+  const int64_t slack = static_cast<int64_t>(mean_ns_ + 4 * dev_ns_);
+  slack_ns_.store(std::clamp<int64_t>(slack, 0, init_s_.max_spin_ns_), std::memory_order_relaxed);
+}
+
+std::string PreciseWaiter::DefaultCalibrationPath() {
+  if (const char* env = getenv("LRA_TIMER_CALIBRATION")) return env;
+  if (const char* home = getenv("HOME")) return std::string(home) + "/.cache/lra/timer_calibration";
+  return "/tmp/lra_timer_calibration";
+}
+
+bool PreciseWaiter::LoadOrCalibrate(const std::string& path) {
+  const std::string kernel = KernelRelease();
+
+  // "v1 <kernel release> <mean ns> <mean deviation ns>"
+  {
+    std::ifstream in(path);
+    std::string version, release;
+    double mean, dev;
+    if (in >> version >> release >> mean >> dev && version == "v1" && release == kernel) {
+      mean_ns_ = mean;
+      dev_ns_ = dev;
+      samples_ = 16;
+      if (init_s_.max_spin_ns_ > 0) UpdateSlack();
+      return true;
+    }
+  }
+
+  // measure: short non interruptible waits, the slack adapts on each
+  for (int i = 0; i < kCalibrationWaits; i++) {
+    WaitUntil(NowNs() + kCalibrationWaitNs, false);
+  }
+
+  std::error_code ec;
+  std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+  std::ofstream out(path, std::ios::trunc);
+  if (out) out << "v1 " << kernel << " " << std::llround(mean_ns_) << " " << std::llround(dev_ns_) << "\n";
+  mean_ns_ = std::round(mean_ns_);  // as a later run loads it
+  dev_ns_ = std::round(dev_ns_);
+  if (init_s_.max_spin_ns_ > 0) UpdateSlack();
+  return false;
+}
+
+}  // namespace lra::timer_util
@@ -0,0 +1,75 @@
+#ifndef LRA_UTIL_TIMER_PRECISE_WAIT_H_
+#define LRA_UTIL_TIMER_PRECISE_WAIT_H_
+
+#include <util/stats/stats.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace lra::timer_util {
+
+struct PreciseWaitInit_S {
+  int64_t initial_slack_ns_{70000};  // until the first wake ups were measured
+  int64_t max_spin_ns_{200000};      // spin tail cap, 0: no spin, wake on the timer only
+};
+
+/**
+ * @brief Waits for an absolute CLOCK_MONOTONIC deadline: timerfd (TFD_TIMER_ABSTIME) wakes up slack early, a short
+ * spin covers the rest. Interrupt() from any thread ends a wait through an eventfd, nothing is polled.
+ *
+ * @note
+ *   1. The slack follows this instance's own wake up overshoot (mean + 4 * mean deviation, moving averages).
+ *   2. One thread waits on an instance at a time.
+ *   3. LoadOrCalibrate() seeds the slack from a file kept across runs (per kernel release), measures ~60 ms if absent.
+ */
+class PreciseWaiter {
+ public:
+  static constexpr int64_t kForever = INT64_MAX;
+
+  PreciseWaiter() : PreciseWaiter(PreciseWaitInit_S{}) {}
+  explicit PreciseWaiter(const PreciseWaitInit_S& init_s);
+  PreciseWaiter(const PreciseWaiter&) = delete;
+  PreciseWaiter& operator=(const PreciseWaiter&) = delete;
+  ~PreciseWaiter();
+
+  // true: deadline reached, false: interrupted (only if interruptible), kForever waits for Interrupt()
+  bool WaitUntil(int64_t deadline_ns, bool interruptible = true);
+
+  // ends the current / next interruptible wait, calls coalesce until it was consumed
+  void Interrupt();
+
+  // true if the slack came from the cache file
+  bool LoadOrCalibrate(const std::string& path = DefaultCalibrationPath());
+
+  inline int64_t GetSlackNs() const { return slack_ns_.load(std::memory_order_relaxed); }
+
+  // timer wake up - wake up target, before the spin tail
+  inline const lra::stats_util::LatencyHistogram& GetOvershoot() const { return overshoot_; }
+
+  // $LRA_TIMER_CALIBRATION, else ~/.cache/lra/timer_calibration
+  static std::string DefaultCalibrationPath();
+
+  static int64_t NowNs();
+
+ private:
+  PreciseWaitInit_S init_s_;
+  int timer_fd_{-1};
+  int event_fd_{-1};
+  std::atomic<bool> pending_{false};
+
+  // adaptive slack, waiting thread only (slack_ns_ readable anywhere)
+  double mean_ns_{0};
+  double dev_ns_{0};
+  uint64_t samples_{0};
+  std::atomic<int64_t> slack_ns_{0};
+  lra::stats_util::LatencyHistogram overshoot_;
+
+  bool ConsumeInterrupt();
+  void Adapt(int64_t overshoot_ns);
+  void UpdateSlack();
+};
+
+}  // namespace lra::timer_util
+
+#endif
@@ -1,308 +1,525 @@
-#include <sys/time.h>
+#include <util/thread/thread.h>
 #include <util/timer/timer.h>
 
-// #include <array>
 // #include <algorithm>
-// #include <chrono>
-#include <cmath>
-#include <unistd.h>
 // #include <functional>
-// #include <queue>
 
 namespace lra::timer_util {
 
 namespace chrono = std::chrono;
 
-Timer::Timer() {
-  nanosleep_delay_us_ = static_cast<uint32_t>(Value::kDefaultDelay);
-  // open a background thread
-  std::function<void()> daemon = std::bind(&Timer::Run, this, std::thread::hardware_concurrency() / 2);
+/**
+ * @brief Exec::kExecutor thread, jobs come from the daemon only (bounded SPSC queue, never blocks the daemon),
+ * run in order, the thread sleeps on seq_ (futex) when the queue is empty.
+ */
+class Timer::Executor {
+ public:
+  static constexpr uint32_t kCapacity = 256;
+
+  Executor(Timer& timer, const TimerExecutorInit_S& init_s) : timer_(timer), init_s_(init_s) {
+    jobs_ = std::make_unique<Job[]>(kCapacity);
+    logunit_ = lra::log_util::LogUnit::CreateLogUnit(init_s_.name_);
+    t_ = std::thread(&Executor::Run, this);
+  }
+
+  ~Executor() {
+    run_.store(false);
+    seq_.fetch_add(1, std::memory_order_release);
+    seq_.notify_one();
+    if (t_.joinable()) t_.join();
+  }
+
+  // daemon only, false if full
+  bool TryPost(const InplaceTask& task, Exec exec, int64_t due_ns, EventStats* stats) {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= kCapacity) return false;
+
+    jobs_[head % kCapacity] = Job{.task_ = task, .exec_ = exec, .due_ns_ = due_ns, .stats_ = stats};
+    head_.store(head + 1, std::memory_order_release);
+    seq_.fetch_add(1, std::memory_order_release);
+    seq_.notify_one();
+    return true;
+  }
+
+ private:
+  struct Job {
+    InplaceTask task_;
+    Exec exec_{Exec::kExecutor};
+    int64_t due_ns_{0};
+    EventStats* stats_{nullptr};
+  };
+
+  Timer& timer_;
+  TimerExecutorInit_S init_s_;
+  std::shared_ptr<lra::log_util::LogUnit> logunit_;
+  std::unique_ptr<Job[]> jobs_;
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> tail_{0};
+  std::atomic<uint32_t> seq_{0};
+  std::atomic<bool> run_{true};
+  std::thread t_;
+
+  void Run() {
+    lra::thread_util::ApplyThreadSchedule(init_s_.name_, init_s_.rt_priority_, init_s_.cpu_, *logunit_);
+
+    while (run_.load(std::memory_order_relaxed)) {
+      const uint32_t seen = seq_.load(std::memory_order_acquire);
+      uint64_t tail = tail_.load(std::memory_order_relaxed);
+
+      while (tail != head_.load(std::memory_order_acquire)) {
+        Job& job = jobs_[tail % kCapacity];
+        timer_.RecordDispatch(job.exec_, job.due_ns_, job.stats_);
+        job.task_();
+        job.task_.Reset();
+        tail_.store(++tail, std::memory_order_release);
+      }
+
+      seq_.wait(seen, std::memory_order_acquire);
+    }
+  }
+};
+
+Timer::Timer() : waiter_(PreciseWaitInit_S{.initial_slack_ns_ = static_cast<int64_t>(Value::kDefaultDelay) * 1000}) {
   logunit = lra::log_util::LogUnit::CreateLogUnit(*this);
+  Init();
+
+  // open a background thread
+  daemon_ = std::thread(&Timer::Run, this, std::thread::hardware_concurrency() / 2);
   logunit->LogToAll(spdlog::level::debug, "Timer daemon started");
-  std::thread t1(daemon);
-  t1.detach();
 }
 
-Timer::Timer(uint32_t thread_num, DelayOpt opt = DelayOpt::kDefaultDelay) {
-  if (opt == DelayOpt::kDefaultDelay) {
-    nanosleep_delay_us_ = static_cast<uint32_t>(Value::kDefaultDelay);
-  }
+Timer::Timer(uint32_t thread_num, DelayOpt opt = DelayOpt::kDefaultDelay)
+    : waiter_(PreciseWaitInit_S{.initial_slack_ns_ = static_cast<int64_t>(Value::kDefaultDelay) * 1000}) {
+  logunit = lra::log_util::LogUnit::CreateLogUnit();
 
-  if (nanosleep_delay_us_ == 0) {  // get nanosleep average delay ~ thread::sleep_for
-    nanosleep_delay_us_ = GetErrorOfNanosleep();
+  if (opt == DelayOpt::kMeasureDelay) {  // timer wake up overshoot, measured once per kernel and kept in a file
+    const bool cached = waiter_.LoadOrCalibrate();
+    logunit->LogToAll(spdlog::level::info, "timer slack: {} (us), {}", waiter_.GetSlackNs() / 1000,
+                      cached ? "cached" : "measured");
   }
 
+  Init();
+
   // open a thread for run (background)
-  std::function<void()> daemon = std::bind(&Timer::Run, this, thread_num);
-  logunit = lra::log_util::LogUnit::CreateLogUnit();
-  std::thread t1(daemon);
-  t1.detach();
+  daemon_ = std::thread(&Timer::Run, this, thread_num);
 }
 
 Timer::~Timer() {
-  run_flag_ = false;
-  while (!can_destroy_) {
-    ;
-  }
+  Delete();
+  for (uint32_t i = 0; i < kMaxEvents; i++) delete slots_[i].stats_.load(std::memory_order_relaxed);
 }
 
-template <typename F>
-uint32_t Timer::SetEvent(const F& task, double duration_ms) {
-  TimerEvent te = CreateTimerEvent(task, duration_ms);
-
-  event_queue_.push(te);
-  push_flag_ = true;
+void Timer::Init() {
+  // all slots on the free list, heap storage reserved: no allocation after construction
+  slots_ = std::make_unique<Slot[]>(kMaxEvents);
+  for (uint32_t i = 0; i < kMaxEvents; i++) {
+    slots_[i].next_.store(i + 1 < kMaxEvents ? i + 1 : kNil, std::memory_order_relaxed);
+  }
+  free_head_.store(0, std::memory_order_release);
 
-  return te.uid;
+  heap_.reserve(kMaxEvents);
+  rearm_.reserve(kMaxEvents);
 }
 
-template <typename F>
-uint32_t Timer::SetLoopEvent(const F& task, double period_ms) {
-  TimerEvent te = CreateTimerEvent(task, period_ms);
-  te.is_loop_event = true;
+TimerHandle Timer::AddEvent(InplaceTask&& task, double period_ms, bool is_loop_event, CatchUp catch_up, Exec exec) {
+  const uint32_t idx = PopFree();
+  if (idx == kNil) {
+    logunit->LogToAll(spdlog::level::warn, "event pool full ({} events), event dropped", kMaxEvents);
+    return kInvalidTimer;
+  }
+  event_count_.fetch_add(1, std::memory_order_relaxed);
+
+  Slot& s = slots_[idx];
+  s.task_ = std::move(task);
+  s.period_ns_ = static_cast<int64_t>(period_ms * 1e6);
+  s.due_ns_ = NowNs() + s.period_ns_;
+  s.is_loop_event_ = is_loop_event;
+  s.catch_up_ = catch_up;
+  s.exec_ = exec;
+
+  if (is_loop_event) {
+    EventStats* stats = s.stats_.load(std::memory_order_relaxed);
+    if (!stats) {
+      s.stats_.store(new EventStats, std::memory_order_release);
+    } else {
+      stats->lateness_.Reset();
+      stats->dispatch_.Reset();
+      stats->fired_.store(0, std::memory_order_relaxed);
+      stats->overruns_.store(0, std::memory_order_relaxed);
+      stats->missed_.store(0, std::memory_order_relaxed);
+    }
+  }
+  s.where_ = Slot::Where::kQueued;
+  s.cancel_seen_ = false;
+
+  // read before publishing, the daemon may finish the event right after
+  const TimerHandle handle = ((s.tag_.load(std::memory_order_relaxed) >> 1) << 32) | idx;
+  if (period_ms < 1.0) {
+    logunit->LogToAll(spdlog::level::warn, "uid: {}'s period is {:.4f} < 1.0 (ms), timer may crushed", handle,
+                      period_ms);
+  }
 
-  event_queue_.push(te);
-  push_flag_ = true;
-  return te.uid;
+  // wake the daemon only if this deadline is earlier than the one it waits for
+  const int64_t due = s.due_ns_;
+  PushList(add_head_, &Slot::next_, slots_.get(), idx);
+  if (due < wake_at_ns_.load(std::memory_order_seq_cst)) waiter_.Interrupt();
+  return handle;
 }
 
-// event will be removed at next pop
-bool Timer::CancelEvent(uint32_t uid) {
-  if (uid >= uid_for_next_event_) {
-    logunit->LogToAll(spdlog::level::warn, "uid: {} invalid - exceeds uid_for_next_event_", uid);
+// event will be removed by the daemon, O(1) here
+bool Timer::CancelEvent(TimerHandle handle) {
+  const uint32_t idx = static_cast<uint32_t>(handle);
+  const uint32_t gen = static_cast<uint32_t>(handle >> 32);
+  if (handle == kInvalidTimer || idx >= kMaxEvents) {
+    logunit->LogToAll(spdlog::level::warn, "handle: {} invalid", handle);
     return false;
   }
-  bool ret = RemoveUid(uid);
-  if (!ret) {
-    logunit->LogToAll(spdlog::level::warn, "this uid: {} was already been removed", uid);
-  }
-  return ret;
+
+  // mark cancelled only if the handle is still the slot's current event
+  Slot& s = slots_[idx];
+  uint64_t tag = s.tag_.load(std::memory_order_acquire);
+  do {
+    if ((tag & 1) || static_cast<uint32_t>(tag >> 1) != gen) return false;
+  } while (!s.tag_.compare_exchange_weak(tag, tag | 1, std::memory_order_acq_rel, std::memory_order_acquire));
+
+  PushList(cancel_head_, &Slot::cancel_next_, slots_.get(), idx);
+  waiter_.Interrupt();  // slot back to the free list soon
+  return true;
+}
+
+bool Timer::GetEventStats(TimerHandle handle, TimerEventStats& out) const {
+  const uint32_t idx = static_cast<uint32_t>(handle);
+  const uint32_t gen = static_cast<uint32_t>(handle >> 32);
+  if (handle == kInvalidTimer || idx >= kMaxEvents) return false;
+
+  const Slot& s = slots_[idx];
+  auto is_current = [&]() {
+    const uint64_t tag = s.tag_.load(std::memory_order_acquire);
+    return !(tag & 1) && static_cast<uint32_t>(tag >> 1) == gen;
+  };
+  if (!is_current()) return false;
+
+  const EventStats* stats = s.stats_.load(std::memory_order_acquire);
+  if (!stats) return false;
+
+  out.fired_ = stats->fired_.load(std::memory_order_relaxed);
+  out.overruns_ = stats->overruns_.load(std::memory_order_relaxed);
+  out.missed_ = stats->missed_.load(std::memory_order_relaxed);
+  out.late_p50_ns_ = stats->lateness_.Percentile(50);
+  out.late_p99_ns_ = stats->lateness_.Percentile(99);
+  out.late_max_ns_ = stats->lateness_.Max();
+  out.late_mean_ns_ = stats->lateness_.Mean();
+  out.dispatch_p50_ns_ = stats->dispatch_.Percentile(50);
+  out.dispatch_p99_ns_ = stats->dispatch_.Percentile(99);
+  out.dispatch_max_ns_ = stats->dispatch_.Max();
+
+  // the slot may have been reused while copying
+  return is_current() && s.is_loop_event_;
 }
 
 // delete the timer instance
 void Timer::Delete() {
-  // stop subthread first, or can_destroy_ will lead segmentation fault
-  run_flag_ = false;
-  while (!can_destroy_) {
-  }
+  run_flag_.store(false);
+  waiter_.Interrupt();  // leave the wait
+  if (daemon_.joinable()) daemon_.join();
+  executor_.reset();  // after the daemon, its only producer
 }
 
-// return interrupted or not
-bool Timer::PreciseSleepms(double ms, bool enable_interrupted_by_new_event = 0) {
-  if (ms < 0.0) return false;
-
-  // critical value for raspberry 4b
-  bool larger_than_7ms = (ms >= 7.0);
-  static double mean, estimate = (larger_than_7ms) ? 5 : 0.5;
-  mean = estimate;
-  static double m2 = 0;
-  static uint64_t count = 1;
-  auto sleep_period = (larger_than_7ms) ? chrono::milliseconds(1) : chrono::microseconds(nanosleep_delay_us_);
-  double X = (larger_than_7ms) ? 1 : 2;
-
-  while (ms > estimate) {                                 // thread sleep
-    if (enable_interrupted_by_new_event && push_flag_) {  // leave because of event push interrupting
-      push_flag_ = false;
-      return true;
-    }
-    auto start = chrono::high_resolution_clock::now();
-    std::this_thread::sleep_for(sleep_period);
-    auto end = chrono::high_resolution_clock::now();
-
-    double observed = (end - start).count() / 1e6;  // to ms
-    ms -= observed;
-
-    count++;  // put here for below calculationf
+// before any kExecutor event is due, the daemon reads executor_ unsynchronized
+bool Timer::StartExecutor(const TimerExecutorInit_S& init_s) {
+  if (executor_) return false;
+  executor_ = std::make_unique<Executor>(*this, init_s);
+  return true;
+}
 
-    double delta = observed - mean;
-    mean += delta / count;
-    m2 += delta * (observed - mean);
-    double stddev = sqrt(m2 / (count - 1));
-    estimate = mean + X * stddev;
-  }
+void Timer::PreciseSleepms(double ms) {
+  if (ms <= 0.0) return;
 
-  // spin lock
-  auto start = chrono::high_resolution_clock::now();
-  while ((chrono::high_resolution_clock::now() - start).count() / 1e6 < ms) {
-    if (enable_interrupted_by_new_event && push_flag_) {
-      push_flag_ = false;
-      return true;
-    }
-  };
-  return false;
+  thread_local PreciseWaiter waiter(PreciseWaitInit_S{.initial_slack_ns_ = waiter_.GetSlackNs()});
+  waiter.WaitUntil(NowNs() + static_cast<int64_t>(ms * 1e6), false);
 }
 
 // private
 
-// create a bcakground thread to monitor event_queue_
+// create a bcakground thread to monitor the events
 void Timer::Run(uint32_t thread_num) {
+  // inline events log from here too
+  lra::log_util::AsyncLog::SetThreadBudget(0);
+
   // make thread pool
   BS::thread_pool pool(thread_num);
 
-  t_now_ = chrono::high_resolution_clock::now();
-
   // main
-  while (run_flag_) {
-    static double sleep_time_ms = 0.0;
+  while (run_flag_.load(std::memory_order_relaxed)) {
+    DrainIngress();
+    HandleExpiredEvents(pool);
 
-    if (event_queue_.empty()) {  // if event_queue_ is empty, sleep 1 sec
-      sleep_time_ms = static_cast<double>(Value::kIdleSleepMs);
-      sleep((uint32_t)sleep_time_ms / 1000);
-    } else {  // expired check(not empty), do task if poll ok, sort the events, calculate next closest interval
+    // publish the deadline before the last look at the add list, an add either sees it or is seen here
+    const int64_t deadline = EvalNextDeadline();
+    wake_at_ns_.store(deadline, std::memory_order_seq_cst);
+    if (add_head_.load(std::memory_order_seq_cst) != kNil) continue;
 
-      HandleExpiredEvents(pool);
-      sleep_time_ms = EvalNextInterval();  // update t_now_ here too
+    // idle (no event) waits for an add / cancel
+    waiter_.WaitUntil(deadline, true);
+  }
+}
 
-      PreciseSleepms(sleep_time_ms, true);  // can be interrupted
-    }
+uint32_t Timer::PopFree() {
+  uint64_t head = free_head_.load(std::memory_order_acquire);
+  while (true) {
+    const uint32_t idx = static_cast<uint32_t>(head);
+    if (idx == kNil) return kNil;
 
-    
-    t_now_ = chrono::high_resolution_clock::now();
+    const uint64_t next = slots_[idx].next_.load(std::memory_order_relaxed);
+    if (free_head_.compare_exchange_weak(head, (((head >> 32) + 1) << 32) | next, std::memory_order_acq_rel,
+                                         std::memory_order_acquire))
+      return idx;
   }
+}
 
-  can_destroy_ = true;
+void Timer::PushFree(uint32_t idx) {
+  uint64_t head = free_head_.load(std::memory_order_relaxed);
+  do {
+    slots_[idx].next_.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+  } while (!free_head_.compare_exchange_weak(head, (((head >> 32) + 1) << 32) | idx, std::memory_order_release,
+                                             std::memory_order_relaxed));
 }
 
-template <typename F>
-TimerEvent Timer::CreateTimerEvent(const F& task, double period_ms) {
-  TimerEvent te;
-  te.is_loop_event = false;
-  te.period_ms = period_ms;
-  te.task = task;
-  // TODO: Add a mutex for valid_uid_
-  valid_uid_.push_back(uid_for_next_event_);  // register uid
-  te.uid = uid_for_next_event_++;             // increment 1 after assign to te.uid
-  te.t = std::chrono::high_resolution_clock::now();
-  if (period_ms < 1.0) {
-    logunit->LogToAll(spdlog::level::warn, "uid: {}'s period is {:.4f} < 1.0 (ms), timer may crushed", te.uid, period_ms);
-  }
-  return te;
+// next generation, stale handles stop matching
+void Timer::FreeSlot(uint32_t idx, uint64_t tag) {
+  Slot& s = slots_[idx];
+  s.task_.Reset();
+  s.where_ = Slot::Where::kDone;
+  s.tag_.store(((tag >> 1) + 1) << 1, std::memory_order_release);
+  event_count_.fetch_sub(1, std::memory_order_relaxed);
+  PushFree(idx);
 }
 
-// From valid_uid_ remove target uid
-bool Timer::RemoveUid(uint32_t uid) {
-  // TODO: Add a mutex here to lock
-  // uid in valid_uid_ 100% < uid_for_next_event_
+void Timer::PushList(std::atomic<uint32_t>& head, std::atomic<uint32_t> Slot::*next, Slot* slots, uint32_t idx) {
+  uint32_t h = head.load(std::memory_order_relaxed);
+  do {
+    (slots[idx].*next).store(h, std::memory_order_relaxed);
+  } while (!head.compare_exchange_weak(h, idx, std::memory_order_seq_cst, std::memory_order_relaxed));  // see Run()
+}
 
-  // find and pop
-  auto it = std::find(valid_uid_.begin(), valid_uid_.end(), uid);
-  if (valid_uid_.end() == it) {  // this uid was removed already
-    return false;
+// A cancelled slot is freed exactly once, by whichever of its add / cancel entry the daemon handles last
+void Timer::DrainIngress() {
+  // adds, the list is newest first
+  uint32_t idx = add_head_.exchange(kNil, std::memory_order_acquire);
+  uint32_t oldest = kNil;
+  while (idx != kNil) {
+    const uint32_t next = slots_[idx].next_.load(std::memory_order_relaxed);
+    slots_[idx].next_.store(oldest, std::memory_order_relaxed);
+    oldest = idx;
+    idx = next;
   }
 
-  // TODO: add a mutex here
-  valid_uid_.erase(it);
-  return true;
-}
-
-// use gettimeofday() to evaluate delay(us) in nanosleep
-// pass unit test
-uint32_t Timer::GetErrorOfNanosleep() {
-  constexpr std::array<uint32_t, 20> delay = {500000, 100000, 50000, 10000, 1000, 900, 500, 100, 10, 1};
-
-  timespec req;
-  timeval tval_begin, tval_end;
-  uint32_t t_diff = 0;
-
-  for (auto& it : delay) {
-    req.tv_sec = it / 1000000;
-    // ref : https://www.zhihu.com/question/22747596
-    // general optimization of mod: a%b ~ (a - a/b * b) if b is a constant
-    req.tv_nsec = (it - it / 1000000 * 1000000) * 1000;
-
-    gettimeofday(&tval_begin, nullptr);
-    int ret = nanosleep(&req, nullptr);
-    if (-1 == ret) {
-      logunit->LogToAll(spdlog::level::err, "nanosleep doesn't support in this OS, return delay to default value: {} (us)",
-                                   static_cast<uint32_t>(Value::kDefaultDelay));
-      return static_cast<uint32_t>(Value::kDefaultDelay);
+  for (idx = oldest; idx != kNil;) {
+    Slot& s = slots_[idx];
+    const uint32_t next = s.next_.load(std::memory_order_relaxed);
+    const uint64_t tag = s.tag_.load(std::memory_order_acquire);
+
+    if (!(tag & 1)) {
+      HeapPush(idx);
+    } else if (s.cancel_seen_) {
+      FreeSlot(idx, tag);
+    } else {
+      s.where_ = Slot::Where::kDone;
     }
-    gettimeofday(&tval_end, nullptr);
-    t_diff += (tval_end.tv_sec - tval_begin.tv_sec) * 1000000 + tval_end.tv_usec - tval_begin.tv_usec - it;
+    idx = next;
   }
 
-  t_diff /= delay.size();
-  logunit->LogToAll(spdlog::level::info, "nanosleep delay: {} (us)", t_diff);
-
-  return t_diff;
+  // cancels
+  idx = cancel_head_.exchange(kNil, std::memory_order_acquire);
+  while (idx != kNil) {
+    Slot& s = slots_[idx];
+    const uint32_t next = s.cancel_next_.load(std::memory_order_relaxed);
+
+    switch (s.where_) {
+      case Slot::Where::kQueued:  // add not drained yet
+        s.cancel_seen_ = true;
+        break;
+      case Slot::Where::kHeap:
+        HeapRemove(s.heap_pos_);
+        [[fallthrough]];
+      case Slot::Where::kDone:
+        FreeSlot(idx, s.tag_.load(std::memory_order_relaxed));
+        break;
+    }
+    idx = next;
+  }
 }
 
-double Timer::GetErrorOfTimerMs(double duration_ms) {
-  // TODO:shared_ptr?;
-  return 0.0;
-}
+void Timer::HandleExpiredEvents(BS::thread_pool& pool) {  // heap top is the closest deadline
+  if (heap_.empty()) return;
 
-void Timer::HandleExpiredEvents(BS::thread_pool& pool) {  // events should be well sorted in queue
+  const int64_t tolerance_ns = static_cast<int64_t>(min_valid_interval_ * 1e6);
+  const int64_t now = NowNs();
 
-  if (event_queue_.empty()) return;
+  while (!heap_.empty()) {  // dispatch expired tasks (Exec), loop events are re-armed afterwards
+    const uint32_t idx = heap_[0];
+    Slot& s = slots_[idx];
 
-  static uint64_t overloading_count = 0;
+    if (s.due_ns_ - now > tolerance_ns) {  // leave this loop when no event expired
+      break;
+    }
 
-  // construct a tmp queue to store popped loop events
-  std::queue<TimerEvent> popped_loop_events_queue;
+    HeapRemove(0);
+    s.where_ = Slot::Where::kDone;
+    const int64_t due = s.due_ns_;  // AdvanceLoopEvent() moves it
 
-  do {  // assign expired tasks to thread pool, and store loop events to tmp queue
-    TimerEvent event = event_queue_.top();
+    uint64_t tag = s.tag_.load(std::memory_order_acquire);
+    if (tag & 1) continue;  // cancelled, its cancel entry frees the slot
 
-    if (!IsValidUid(event.uid)) {  // top is not valid event anymore, pop
-      event_queue_.pop();
+    if (s.is_loop_event_) {
+      if (AdvanceLoopEvent(s, now)) {
+        Dispatch(s.task_, s.exec_, due, s.stats_.load(std::memory_order_relaxed), pool);
+      }
+      rearm_.push_back(idx);
       continue;
     }
 
-    if (!(IsNearExpired(event))) {  // leave this loop when no event expired
+    // one-shot: take the slot back unless a cancel got there first
+    InplaceTask task = std::move(s.task_);
+    const Exec exec = s.exec_;
+    if (!s.tag_.compare_exchange_strong(tag, ((tag >> 1) + 1) << 1, std::memory_order_acq_rel)) continue;
+
+    FreeSlot(idx, tag);
+    Dispatch(task, exec, due, nullptr, pool);
+  }
+
+  // re-arm loop events, deadlines were advanced on the grid already
+  for (uint32_t idx : rearm_) {
+    HeapPush(idx);
+  }
+  rearm_.clear();
+}
+
+void Timer::Dispatch(InplaceTask& task, Exec exec, int64_t due_ns, EventStats* stats, BS::thread_pool& pool) {
+  switch (exec) {
+    case Exec::kInline:
+      RecordDispatch(exec, due_ns, stats);
+      task();
+      return;
+
+    case Exec::kExecutor:
+      if (executor_ && executor_->TryPost(task, exec, due_ns, stats)) return;
+      CountOverload();  // not started / queue full, the pool takes it
       break;
-    }
 
-    if (event.is_loop_event) {
-      popped_loop_events_queue.push(event);
-    }
+    case Exec::kPool:
+      if (!HasIdleThread(pool)) CountOverload();
+      break;
+  }
 
-    if (!HasIdleThread(pool)) {  // overloading record
-      overloading_count++;
-      if ((overloading_count - overloading_count / 10 * 10)) {  // send debug log every ten times
-        logunit->LogToAll(spdlog::level::warn, "Timer Overloading: {}", overloading_count);
-      }
-    }
+  pool.push_task([this, task, exec, due_ns, stats]() mutable {
+    RecordDispatch(exec, due_ns, stats);
+    task();
+  });
+}
 
-    // push_task to thread pool
-    pool.push_task(event.task);
+void Timer::RecordDispatch(Exec exec, int64_t due_ns, EventStats* stats) {
+  const int64_t late = NowNs() - due_ns;
+  const uint64_t ns = late > 0 ? late : 0;
+  dispatch_[static_cast<size_t>(exec)].Record(ns);
+  if (stats) stats->dispatch_.Record(ns);
+}
 
-    event_queue_.pop();
-  } while (!event_queue_.empty());
+void Timer::CountOverload() {
+  const uint64_t count = overloading_count_.fetch_add(1, std::memory_order_relaxed) + 1;
+  if ((count - count / 10 * 10) == 0) {  // send debug log every ten times
+    logunit->LogToAll(spdlog::level::warn, "Timer Overloading: {}", count);
+  }
+}
 
-  t_now_ = chrono::high_resolution_clock::now();
+bool Timer::AdvanceLoopEvent(Slot& s, int64_t now) {
+  EventStats& stats = *s.stats_.load(std::memory_order_relaxed);
+  const int64_t late = now - s.due_ns_;
+  stats.lateness_.Record(late > 0 ? late : 0);
 
-  // push tmp queue elements to event_queue_
-  while (!popped_loop_events_queue.empty()) {
-    // update time
-    TimerEvent event = popped_loop_events_queue.front();
-    event.t = chrono::high_resolution_clock::now();
+  // whole periods behind, deadlines due + period .. due + behind * period have passed too
+  const int64_t behind = (late > 0 && s.period_ns_ > 0) ? late / s.period_ns_ : 0;
+  if (behind) stats.overruns_.fetch_add(1, std::memory_order_relaxed);
 
-    event_queue_.push(event);
-    popped_loop_events_queue.pop();
+  bool run = true;
+  switch (s.catch_up_) {
+    case CatchUp::kBurst:
+      s.due_ns_ += s.period_ns_;
+      break;
+    case CatchUp::kCoalesce:
+      s.due_ns_ += (behind + 1) * s.period_ns_;
+      stats.missed_.fetch_add(behind, std::memory_order_relaxed);
+      break;
+    case CatchUp::kSkip:
+      s.due_ns_ += (behind + 1) * s.period_ns_;
+      stats.missed_.fetch_add(behind ? behind + 1 : 0, std::memory_order_relaxed);
+      run = (behind == 0);
+      break;
   }
+
+  // a zero period would stay due forever
+  if (s.period_ns_ <= 0) s.due_ns_ = now + 1;
+
+  if (run) stats.fired_.fetch_add(1, std::memory_order_relaxed);
+  return run;
 }
 
-double Timer::EvalNextInterval() {
-  if (event_queue_.empty()) {
-    return static_cast<double>(Value::kIdleSleepMs);
+int64_t Timer::EvalNextDeadline() const {
+  if (heap_.empty()) {
+    return PreciseWaiter::kForever;
   }
 
-  auto event = event_queue_.top();
-  return event.period_ms - EvalTimeDiffFromNow(event.t);
+  return slots_[heap_[0]].due_ns_;
 }
 
-double Timer::EvalTimeDiffFromNow(chrono::system_clock::time_point& t) {
-  t_now_ = chrono::high_resolution_clock::now();
-  return (t_now_ - t).count() / 1e6;
+void Timer::HeapPush(uint32_t idx) {
+  slots_[idx].where_ = Slot::Where::kHeap;
+  heap_.push_back(idx);
+  slots_[idx].heap_pos_ = heap_.size() - 1;
+  HeapUp(heap_.size() - 1);
+}
+
+void Timer::HeapRemove(uint32_t pos) {
+  const uint32_t idx = heap_[pos];
+  const uint32_t last = heap_.back();
+  heap_.pop_back();
+  slots_[idx].heap_pos_ = kNil;
+
+  if (pos < heap_.size()) {
+    HeapSet(pos, last);
+    HeapUp(pos);
+    HeapDown(slots_[last].heap_pos_);
+  }
+}
+
+void Timer::HeapUp(uint32_t pos) {
+  const uint32_t idx = heap_[pos];
+  while (pos > 0) {
+    const uint32_t parent = (pos - 1) / kHeapArity;
+    if (!HeapLess(idx, heap_[parent])) break;
+    HeapSet(pos, heap_[parent]);
+    pos = parent;
+  }
+  HeapSet(pos, idx);
+}
+
+void Timer::HeapDown(uint32_t pos) {
+  const uint32_t idx = heap_[pos];
+  const uint32_t n = heap_.size();
+  while (true) {
+    const uint32_t first = pos * kHeapArity + 1;
+    if (first >= n) break;
+
+    uint32_t best = first;
+    for (uint32_t c = first + 1; c < std::min(first + kHeapArity, n); c++) {
+      if (HeapLess(heap_[c], heap_[best])) best = c;
+    }
+    if (!HeapLess(heap_[best], idx)) break;
+
+    HeapSet(pos, heap_[best]);
+    pos = best;
+  }
+  HeapSet(pos, idx);
 }
 
-// you should notice that
-// - no const keyword
-// - if you don't know how to write, compiler will tell you
-// e.g. undefined reference to `unsigned int lra::timer_util::Timer::SetLoopEvent<void ()>(void ( const&)(), double)'
-// --> template uint32_t Timer::SetLoopEvent<void ()>(void(&task)(), double);
-template uint32_t Timer::SetEvent<void()>(void (&task)(), double);
-template uint32_t Timer::SetLoopEvent<void()>(void (&task)(), double);
-template TimerEvent Timer::CreateTimerEvent<void()>(void (&task)(), double);
 };  // namespace lra::timer_util
@@ -2,110 +2,231 @@
 #define LRA_UTIL_TIMER_H_
 
 #include <util/log/logunit.h>
+#include <util/stats/stats.h>
+#include <util/timer/inplace_task.h>
+#include <util/timer/precise_wait.h>
+
 #include <thread-pool/BS_thread_pool.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <array>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace lra::timer_util {
 
 // namespace of util/timer
 
-struct TimerEvent {
-  bool is_loop_event;
-  int uid;
-  double period_ms;
-  std::chrono::system_clock::time_point t;
-  std::function<void()> task;  // TODO: enable non-void function
-
-  bool operator<(const TimerEvent& rhs) const {  // t + delta_t < rhs.t + rhs.delta_t --> (t-rhs.t) < rhs.delta_t - delta_t;
-    // note that the priority queue order from larger to smaller
-    // so we reverse to (t-rhs.t) > rhs.delta_t - delta_t;
-    // make high freq tasks high priority
-    return ((t - rhs.t).count() / 1e6) > (rhs.period_ms - period_ms);
-  }
+// (generation << 32) | slot, a handle of a finished / cancelled event never matches its reused slot
+using TimerHandle = uint64_t;
+constexpr TimerHandle kInvalidTimer = 0;
+
+// What a loop event does after it fell a period or more behind its deadline grid (t0 + k * period)
+enum class CatchUp : uint8_t {
+  kBurst,     // every missed deadline runs, back to back, until caught up
+  kCoalesce,  // missed deadlines fold into one run now, then back on the grid
+  kSkip,      // the late run is dropped too, resume at the next deadline in the future
+};
+
+// Where an event's task runs once due
+enum class Exec : uint8_t {
+  kInline,    // on the timer thread, no handoff: short, non blocking, non throwing tasks only (set a flag, notify),
+              // may add / cancel events but never Delete() the timer
+  kExecutor,  // on the timer's executor thread (StartExecutor(), pinned / SCHED_FIFO), in deadline order
+  kPool,      // on the thread pool (BS::thread_pool), may run in parallel with other events
+};
+
+// snapshot of a loop event
+// lateness = daemon dispatch time - deadline, dispatch latency = task start - deadline (handoff included)
+struct TimerEventStats {
+  uint64_t fired_{0};
+  uint64_t overruns_{0};  // runs a period or more late
+  uint64_t missed_{0};    // deadlines not run (kCoalesce, kSkip)
+  uint64_t late_p50_ns_{0};
+  uint64_t late_p99_ns_{0};
+  uint64_t late_max_ns_{0};
+  double late_mean_ns_{0};
+  uint64_t dispatch_p50_ns_{0};
+  uint64_t dispatch_p99_ns_{0};
+  uint64_t dispatch_max_ns_{0};
 };
 
-// Movable but not copyable class
+struct TimerExecutorInit_S {
+  std::string name_{"timer_executor"};
+  int rt_priority_{0};  // SCHED_FIFO priority 1 ~ 99, 0 keeps SCHED_OTHER (needs CAP_SYS_NICE)
+  int cpu_{-1};         // pin to this cpu, -1 for no affinity
+};
+
+// Not copyable, not movable (the daemon thread holds this)
 // Can do precise sleep and schedule task by
+//
+// Events live in a fixed slot pool. Any thread adds / cancels them through lock-free lists, only the daemon thread
+// touches the deadline heap (4-ary, indexed by slot, O(log n) removal of a cancelled event).
+// Loop events run on absolute deadlines t0 + k * period (no drift from dispatch latency), see CatchUp.
+// The daemon waits on a PreciseWaiter (timerfd + spin tail), an add earlier than its wake up / a cancel interrupts it.
+// Each event runs inline, on the executor thread or on the pool (Exec), dispatch latency is kept per policy.
+// Cancel of a one-shot event that returns true guarantees it never runs, a loop event firing already handed to the
+// pool still runs.
 class Timer {
  public:
   // enum of init args
   enum class DelayOpt { kMeasureDelay,
                         kDefaultDelay };
-  enum class Value { kDefaultDelay = 70,
-                     kIdleSleepMs = 1000 };
+  enum class Value { kDefaultDelay = 70 };  // initial slack (us)
+
+  static constexpr uint32_t kMaxEvents = 1024;
 
   // constructor
   Timer();
   explicit Timer(uint32_t thread_num, DelayOpt opt);
-  Timer(Timer&& movable_timer) = default;
+  Timer(Timer&& movable_timer) = delete;
   Timer(const Timer& copyable_timer) = delete;
 
   // assign operator
-  Timer& operator=(Timer&& movable_timer) = default;
+  Timer& operator=(Timer&& movable_timer) = delete;
   Timer& operator=(const Timer& copyable_timer) = delete;
 
   // destructor
   ~Timer();
 
+  // kInvalidTimer if kMaxEvents events are pending
   template <typename F>
-  uint32_t SetEvent(const F& task, double duration_ms);
+  TimerHandle SetEvent(F&& task, double duration_ms, Exec exec = Exec::kPool) {
+    return AddEvent(InplaceTask(std::forward<F>(task)), duration_ms, false, CatchUp::kCoalesce, exec);
+  }
 
   template <typename F>
-  uint32_t SetLoopEvent(const F& task, double period_ms);
+  TimerHandle SetLoopEvent(F&& task, double period_ms, CatchUp catch_up = CatchUp::kCoalesce,
+                           Exec exec = Exec::kPool) {
+    return AddEvent(InplaceTask(std::forward<F>(task)), period_ms, true, catch_up, exec);
+  }
+
+  // thread for Exec::kExecutor events, until then (or when its queue is full) they run on the pool
+  bool StartExecutor(const TimerExecutorInit_S& init_s);
 
-  bool CancelEvent(uint32_t uid);
+  // false if the event already fired (one-shot), was cancelled or the handle is stale
+  bool CancelEvent(TimerHandle handle);
 
   void Delete();
 
-  // return interrupted or not
-  bool PreciseSleepms(double ms, bool enable_interrupted_by_new_event);
+  // waits on the calling thread's own PreciseWaiter, seeded with this timer's slack
+  void PreciseSleepms(double ms);
+
+  // current wake up slack of the daemon
+  inline int64_t GetSlackNs() const { return waiter_.GetSlackNs(); }
+
+  // false for a one-shot, finished or cancelled event
+  bool GetEventStats(TimerHandle handle, TimerEventStats& out) const;
+
+  // events added and not finished / cancelled yet
+  inline uint32_t GetEventCount() const { return event_count_.load(std::memory_order_relaxed); }
+
+  // task start - deadline (ns) of every event run with this policy
+  inline const lra::stats_util::LatencyHistogram& GetDispatchLatency(Exec exec) const {
+    return dispatch_[static_cast<size_t>(exec)];
+  }
+
+  // kExecutor / kPool dispatches that found no idle thread / a full queue
+  inline uint64_t GetOverloadCount() const { return overloading_count_.load(std::memory_order_relaxed); }
 
  private:
   static constexpr double min_valid_interval_ = 0.01;  // 10 us
+  static constexpr uint32_t kNil = UINT32_MAX;
+  static constexpr uint32_t kHeapArity = 4;
 
-  std::shared_ptr<lra::log_util::LogUnit> logunit;
-  uint32_t nanosleep_delay_us_ = 0;
-  volatile bool run_flag_ = true;
-  volatile bool can_destroy_ = false;
-  volatile bool push_flag_ = false;
-  std::chrono::system_clock::time_point t_now_;
-  uint32_t uid_for_next_event_ = 0;
-  // issue 1: share private member among different threads
-  // ref: https://hackmd.io/gAsWsT1RSUulPcq4de_HGQ#Test
-  // issue 2: reference type in STL
-  // ref: https://hackmd.io/h7i1FlqvS9iIh8FU0usJZQ#Constructor-speed-of-STL-vector-on-Pi4b
-
-  std::priority_queue<TimerEvent> event_queue_;
-  std::vector<uint32_t> valid_uid_;
+  class Executor;
+
+  struct EventStats {
+    lra::stats_util::LatencyHistogram lateness_;
+    lra::stats_util::LatencyHistogram dispatch_;
+    std::atomic<uint64_t> fired_{0};
+    std::atomic<uint64_t> overruns_{0};
+    std::atomic<uint64_t> missed_{0};
+  };
+
+  struct Slot {
+    std::atomic<uint64_t> tag_{1 << 1};  // generation << 1 | cancelled
+    std::atomic<uint32_t> next_{kNil};  // free list / add list
+    std::atomic<uint32_t> cancel_next_{kNil};
+
+    // written by the adding thread before it publishes the slot, then daemon only
+    InplaceTask task_;
+    int64_t due_ns_{0};
+    int64_t period_ns_{0};
+    bool is_loop_event_{false};
+    CatchUp catch_up_{CatchUp::kCoalesce};
+    Exec exec_{Exec::kPool};
+    std::atomic<EventStats*> stats_{nullptr};  // loop events, allocated on first use of the slot, kept until ~Timer
+
+    // daemon only
+    enum class Where : uint8_t { kQueued, kHeap, kDone } where_{Where::kDone};
+    bool cancel_seen_{false};
+    uint32_t heap_pos_{kNil};
+  };
 
+  std::shared_ptr<lra::log_util::LogUnit> logunit;
+  PreciseWaiter waiter_;
+  std::atomic<bool> run_flag_{true};
+  std::atomic<int64_t> wake_at_ns_{PreciseWaiter::kForever};  // deadline the daemon waits for
+  std::thread daemon_;
+  std::unique_ptr<Executor> executor_;
+
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<uint64_t> free_head_{kNil};  // tag << 32 | slot, tag against ABA of concurrent pops
+  std::atomic<uint32_t> add_head_{kNil};
+  std::atomic<uint32_t> cancel_head_{kNil};
+  std::atomic<uint32_t> event_count_{0};
+
+  // daemon only, reserved to kMaxEvents
+  std::vector<uint32_t> heap_;
+  std::vector<uint32_t> rearm_;  // loop events handled this round, back into the heap afterwards
+  std::atomic<uint64_t> overloading_count_{0};
+  std::array<lra::stats_util::LatencyHistogram, 3> dispatch_;
+
+  void Init();
   void Run(uint32_t thread_num);
-  bool RemoveUid(uint32_t uid);
-  uint32_t GetErrorOfNanosleep();
-  double GetErrorOfTimerMs(double duration_ms);
 
-  // template create a Timerevent and return
-  template <typename F>
-  TimerEvent CreateTimerEvent(const F& task, double period_ms);
+  TimerHandle AddEvent(InplaceTask&& task, double period_ms, bool is_loop_event, CatchUp catch_up, Exec exec);
+
+  // next deadline of a loop event due at s.due_ns_ and dispatched at now, false: skip this run
+  bool AdvanceLoopEvent(Slot& s, int64_t now);
 
+  // slot lists
+  uint32_t PopFree();
+  void PushFree(uint32_t idx);
+  void FreeSlot(uint32_t idx, uint64_t tag);
+  static void PushList(std::atomic<uint32_t>& head, std::atomic<uint32_t> Slot::*next, Slot* slots, uint32_t idx);
+
+  // daemon
+  void DrainIngress();
   void HandleExpiredEvents(BS::thread_pool& pool);
-  double EvalNextInterval();
-  double EvalTimeDiffFromNow(std::chrono::system_clock::time_point& t);
 
-  // @aborted
-  inline bool IsExpired(TimerEvent& event) {
-    return (EvalTimeDiffFromNow(event.t) > event.period_ms);
+  // run / hand off a due task, stats: loop events only
+  void Dispatch(InplaceTask& task, Exec exec, int64_t due_ns, EventStats* stats, BS::thread_pool& pool);
+  void RecordDispatch(Exec exec, int64_t due_ns, EventStats* stats);
+  void CountOverload();
+  int64_t EvalNextDeadline() const;
+
+  // heap of slot indices ordered by due_ns_
+  void HeapPush(uint32_t idx);
+  void HeapRemove(uint32_t pos);
+  void HeapUp(uint32_t pos);
+  void HeapDown(uint32_t pos);
+  inline bool HeapLess(uint32_t a, uint32_t b) const { return slots_[a].due_ns_ < slots_[b].due_ns_; }
+  inline void HeapSet(uint32_t pos, uint32_t idx) {
+    heap_[pos] = idx;
+    slots_[idx].heap_pos_ = pos;
   }
 
-  inline bool IsNearExpired(TimerEvent& event) {
-    return (EvalTimeDiffFromNow(event.t) > (event.period_ms + min_valid_interval_));
-  }
+  // CLOCK_MONOTONIC, as the waiter's deadlines
+  static inline int64_t NowNs() { return PreciseWaiter::NowNs(); }
 
   inline bool HasIdleThread(BS::thread_pool& pool) {
     return (pool.get_thread_count() > pool.get_tasks_running());
   };
-
-  inline bool IsValidUid(uint32_t uid) {  // note that uid vector should be sorted (always push_back)
-    return std::binary_search(valid_uid_.begin(), valid_uid_.end(), uid);
-  };
 };
 
 }  // namespace lra::timer_util
@@ -0,0 +1,91 @@
+#include <websocket/dispatcher.h>
+
+#include <chrono>
+
+namespace lra::websocket {
+
+namespace {
+
+inline int64_t SteadyNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+thread_local int64_t posted_ns = 0;
+
+}  // namespace
+
+WsDispatcher::WsDispatcher() {
+  for (auto& lane : lanes_) lane.work_ = std::make_unique<asio::io_service::work>(lane.io_);
+}
+
+WsDispatcher::~WsDispatcher() {
+  Stop();
+  for (auto& lane : lanes_) {
+    if (lane.t_.joinable()) lane.t_.join();
+  }
+}
+
+uint32_t WsDispatcher::Route(WebsocketServer& server, const std::string& messageType, WsLane lane, Handler handler) {
+  const uint32_t id = routes_.size();
+  routes_.push_back(RouteEntry{messageType, lane, std::move(handler)});
+
+  server.messageView(messageType,
+                     [this, id](ClientConnection conn, const JsonView&, const WebsocketEndpoint::message_ptr& frame) {
+                       Dispatch(id, conn, frame);
+                     });
+  return id;
+}
+
+void WsDispatcher::Dispatch(uint32_t id, ClientConnection conn, const WebsocketEndpoint::message_ptr& frame) {
+  const RouteEntry& route = routes_[id];
+  Post(route.lane_, [&route, conn, frame]() {
+    thread_local JsonDoc doc;
+    doc.Parse(frame->get_payload());
+    route.handler_(conn, doc.Root());
+  });
+}
+
+void WsDispatcher::Post(WsLane lane, std::function<void()> job) {
+  Lane& l = lanes_[Idx(lane)];
+  l.pending_.fetch_add(1, std::memory_order_relaxed);
+
+  l.io_.post([&l, job = std::move(job), posted = SteadyNs()]() {
+    l.wait_.Record(SteadyNs() - posted);
+    l.pending_.fetch_sub(1, std::memory_order_relaxed);
+    posted_ns = posted;
+    job();
+  });
+}
+
+void WsDispatcher::Run() {
+  for (auto lane : {WsLane::kControl, WsLane::kLong}) {
+    Lane& l = lanes_[Idx(lane)];
+    if (!l.t_.joinable()) l.t_ = std::thread([&l]() { l.io_.run(); });
+  }
+
+  lanes_[Idx(WsLane::kDefault)].io_.run();
+}
+
+void WsDispatcher::Stop() {
+  for (auto& lane : lanes_) {
+    lane.work_.reset();
+    lane.io_.stop();
+  }
+}
+
+int64_t WsDispatcher::PostedNs() { return posted_ns; }
+
+const char* WsDispatcher::LaneName(WsLane lane) {
+  switch (lane) {
+    case WsLane::kControl:
+      return "control";
+    case WsLane::kDefault:
+      return "default";
+    case WsLane::kLong:
+      return "long";
+  }
+  return "unknown";
+}
+
+}  // namespace lra::websocket
@@ -0,0 +1,86 @@
+#ifndef LRA_WEBSOCKET_DISPATCHER_H_
+#define LRA_WEBSOCKET_DISPATCHER_H_
+
+#include <util/stats/stats.h>
+#include <websocket/websocket.h>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lra::websocket {
+
+enum class WsLane : uint8_t {
+  kControl,  // latency critical commands (drvCmdUpdate ...), never queued behind anything slow
+  kDefault,  // info, connection events
+  kLong,     // jobs of seconds (calibration) and register access that must not overlap them, one at a time
+};
+
+constexpr size_t kWsLaneCount = 3;
+
+/**
+ * @brief Routes websocket messages to handler lanes, each lane is one thread (handlers of a lane run in order).
+ * Message types get an integer id when routed, the server looks the type up once per message.
+ * Jobs keep the received frame (no copy of the payload) and tokenize it again on the lane thread.
+ * Route() everything before the server runs, Run() blocks and runs kDefault on the calling thread.
+ */
+class WsDispatcher {
+ public:
+  // args views the message payload, valid during the call
+  using Handler = std::function<void(ClientConnection, const JsonView&)>;
+
+  WsDispatcher();
+  WsDispatcher(const WsDispatcher&) = delete;
+  WsDispatcher& operator=(const WsDispatcher&) = delete;
+  ~WsDispatcher();
+
+  // returns the id of messageType
+  uint32_t Route(WebsocketServer& server, const std::string& messageType, WsLane lane, Handler handler);
+
+  void Post(WsLane lane, std::function<void()> job);
+
+  void Run();
+
+  // lets the running jobs finish, Run() returns
+  void Stop();
+
+  // time from receive to handler start (ns)
+  inline const lra::stats_util::LatencyHistogram& GetWait(WsLane lane) const { return lanes_[Idx(lane)].wait_; }
+
+  inline size_t GetPending(WsLane lane) const { return lanes_[Idx(lane)].pending_.load(std::memory_order_relaxed); }
+
+  static const char* LaneName(WsLane lane);
+
+  // steady clock ns when the job running on this thread was posted, the receive time for routed messages
+  static int64_t PostedNs();
+
+ private:
+  struct Lane {
+    asio::io_service io_;
+    std::unique_ptr<asio::io_service::work> work_;
+    std::thread t_;
+    lra::stats_util::LatencyHistogram wait_;
+    std::atomic<size_t> pending_{0};
+  };
+
+  struct RouteEntry {
+    std::string type_;
+    WsLane lane_;
+    Handler handler_;
+  };
+
+  std::array<Lane, kWsLaneCount> lanes_;
+  std::vector<RouteEntry> routes_;  // indexed by id, fixed once the server runs
+
+  static constexpr size_t Idx(WsLane lane) { return static_cast<size_t>(lane); }
+
+  void Dispatch(uint32_t id, ClientConnection conn, const WebsocketEndpoint::message_ptr& frame);
+};
+
+}  // namespace lra::websocket
+
+#endif
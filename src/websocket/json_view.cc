@@ -0,0 +1,332 @@
+#include <websocket/json_view.h>
+
+#include <charconv>
+
+namespace lra::websocket {
+
+namespace {
+
+inline bool IsSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+inline void AppendUtf8(std::string& out, uint32_t cp) {
+  if (cp < 0x80) {
+    out.push_back(static_cast<char>(cp));
+  } else if (cp < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  } else if (cp < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  }
+}
+
+inline bool Hex4(std::string_view s, size_t pos, uint32_t& out) {
+  if (pos + 4 > s.size()) return false;
+  auto [p, ec] = std::from_chars(s.data() + pos, s.data() + pos + 4, out, 16);
+  return ec == std::errc() && p == s.data() + pos + 4;
+}
+
+}  // namespace
+
+/* JsonDoc */
+
+bool JsonDoc::Parse(std::string_view json) {
+  json_ = json;
+  tokens_.clear();
+  ok_ = false;
+
+  enum class Expect { kValue, kValueOrClose, kKey, kKeyOrClose, kColon, kCommaOrClose };
+
+  uint32_t stack[kMaxDepth];
+  size_t depth = 0;
+  Expect expect = Expect::kValue;
+  bool done = false;
+  size_t pos = 0;
+
+  // a value (scalar or closed container) just ended
+  auto complete = [&]() {
+    if (depth == 0)
+      done = true;
+    else
+      expect = Expect::kCommaOrClose;
+  };
+
+  while (true) {
+    while (pos < json.size() && IsSpace(json[pos])) pos++;
+    if (pos == json.size()) break;
+    if (done) return false;  // trailing data
+
+    const char c = json[pos];
+    const Token* top = depth ? &tokens_[stack[depth - 1]] : nullptr;
+
+    switch (expect) {
+      case Expect::kColon:
+        if (c != ':') return false;
+        pos++;
+        expect = Expect::kValue;
+        continue;
+
+      case Expect::kCommaOrClose:
+        if (c == ',') {
+          pos++;
+          expect = (top->type_ == Type::kObject) ? Expect::kKey : Expect::kValue;
+          continue;
+        }
+        [[fallthrough]];
+
+      case Expect::kKeyOrClose:
+      case Expect::kValueOrClose:
+        if ((c == '}' && top->type_ == Type::kObject && expect != Expect::kValueOrClose) ||
+            (c == ']' && top->type_ == Type::kArray && expect != Expect::kKeyOrClose)) {
+          Token& container = tokens_[stack[--depth]];
+          container.end_ = ++pos;
+          container.next_ = tokens_.size();
+          complete();
+          continue;
+        }
+        if (expect == Expect::kCommaOrClose) return false;
+        if (expect == Expect::kValueOrClose) break;  // first array element
+        [[fallthrough]];
+
+      case Expect::kKey: {
+        if (c != '"') return false;
+        Token key{.type_ = Type::kString};
+        if (!ParseString(pos, key)) return false;
+        key.next_ = tokens_.size() + 1;
+        tokens_.push_back(key);
+        tokens_[stack[depth - 1]].size_++;
+        expect = Expect::kColon;
+        continue;
+      }
+
+      case Expect::kValue:
+        break;
+    }
+
+    /* value */
+    if (top && top->type_ == Type::kArray) tokens_[stack[depth - 1]].size_++;
+
+    if (c == '{' || c == '[') {
+      if (depth == kMaxDepth) return false;
+      stack[depth++] = tokens_.size();
+      tokens_.push_back(Token{.type_ = (c == '{') ? Type::kObject : Type::kArray, .start_ = (uint32_t)pos});
+      pos++;
+      expect = (c == '{') ? Expect::kKeyOrClose : Expect::kValueOrClose;
+      continue;
+    }
+
+    Token tok;
+    bool ok = (c == '"') ? ParseString(pos, tok) : (c == '-' || (c >= '0' && c <= '9')) ? ParseNumber(pos, tok)
+                                                                                         : ParseLiteral(pos, tok);
+    if (!ok) return false;
+    tok.next_ = tokens_.size() + 1;
+    tokens_.push_back(tok);
+    complete();
+  }
+
+  ok_ = done;
+  return ok_;
+}
+
+bool JsonDoc::ParseString(size_t& pos, Token& tok) {
+  tok.type_ = Type::kString;
+  tok.start_ = ++pos;  // skip quote
+
+  while (pos < json_.size()) {
+    const char c = json_[pos];
+    if (c == '"') {
+      tok.end_ = pos++;
+      return true;
+    }
+    if (static_cast<unsigned char>(c) < 0x20) return false;
+    if (c == '\\') {
+      tok.escaped_ = true;
+      pos++;
+    }
+    pos++;
+  }
+  return false;
+}
+
+bool JsonDoc::ParseLiteral(size_t& pos, Token& tok) {
+  const std::string_view rest = json_.substr(pos);
+  std::string_view lit;
+  if (rest.starts_with("true") || rest.starts_with("false")) {
+    tok.type_ = Type::kBool;
+    lit = (rest[0] == 't') ? "true" : "false";
+  } else if (rest.starts_with("null")) {
+    tok.type_ = Type::kNull;
+    lit = "null";
+  } else {
+    return false;
+  }
+
+  tok.start_ = pos;
+  pos += lit.size();
+  tok.end_ = pos;
+  return true;
+}
+
+bool JsonDoc::ParseNumber(size_t& pos, Token& tok) {
+  tok.type_ = Type::kNumber;
+  tok.start_ = pos;
+  while (pos < json_.size() && (json_[pos] == '-' || json_[pos] == '+' || json_[pos] == '.' || json_[pos] == 'e' ||
+                                json_[pos] == 'E' || (json_[pos] >= '0' && json_[pos] <= '9')))
+    pos++;
+  tok.end_ = pos;
+
+  // plain integers (register values) need no float check
+  const size_t digits_from = tok.start_ + (json_[tok.start_] == '-');
+  if (digits_from < tok.end_ && json_.find_first_not_of("0123456789", digits_from) >= tok.end_) return true;
+
+  double v;
+  auto [p, ec] = std::from_chars(json_.data() + tok.start_, json_.data() + tok.end_, v);
+  return ec == std::errc() && p == json_.data() + tok.end_;
+}
+
+JsonView JsonDoc::Root() const { return (ok_ && !tokens_.empty()) ? JsonView(this, 0) : JsonView(); }
+
+/* JsonView */
+
+JsonView JsonView::operator[](std::string_view key) const {
+  if (!isObject()) return JsonView();
+
+  const auto& tokens = doc_->Tokens();
+  uint32_t k = idx_ + 1;
+  for (uint32_t m = 0; m < tok().size_; m++) {
+    const JsonDoc::Token& key_tok = tokens[k];
+    if (doc_->Payload().substr(key_tok.start_, key_tok.end_ - key_tok.start_) == key) return JsonView(doc_, k + 1);
+    k = tokens[k + 1].next_;
+  }
+  return JsonView();
+}
+
+JsonView JsonView::operator[](size_t i) const {
+  if (!isArray() || i >= tok().size_) return JsonView();
+
+  uint32_t e = idx_ + 1;
+  while (i--) e = doc_->Tokens()[e].next_;
+  return JsonView(doc_, e);
+}
+
+size_t JsonView::size() const { return (isArray() || isObject()) ? tok().size_ : 0; }
+
+bool JsonView::asBool(bool def) const {
+  switch (type()) {
+    case JsonDoc::Type::kBool:
+      return raw()[0] == 't';
+    case JsonDoc::Type::kNumber:
+      return asDouble() != 0;
+    default:
+      return def;
+  }
+}
+
+int64_t JsonView::asInt64(int64_t def) const {
+  if (isBool()) return asBool();
+  if (!isNumeric()) return def;
+
+  const std::string_view s = raw();
+  int64_t v;
+  auto [p, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+  if (ec == std::errc() && p == s.data() + s.size()) return v;
+  return static_cast<int64_t>(asDouble());  // 1.0, 1e3
+}
+
+uint64_t JsonView::asUInt64(uint64_t def) const {
+  if (isBool()) return asBool();
+  if (!isNumeric()) return def;
+
+  const std::string_view s = raw();
+  uint64_t v;
+  auto [p, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+  if (ec == std::errc() && p == s.data() + s.size()) return v;
+  return static_cast<uint64_t>(asInt64());
+}
+
+double JsonView::asDouble(double def) const {
+  if (isBool()) return asBool();
+  if (!isNumeric()) return def;
+
+  const std::string_view s = raw();
+  double v = def;
+  std::from_chars(s.data(), s.data() + s.size(), v);
+  return v;
+}
+
+std::string_view JsonView::asStringView() const { return isString() ? raw() : std::string_view(); }
+
+std::string JsonView::asString() const {
+  if (isNumeric() || isBool()) return std::string(raw());
+  if (!isString()) return std::string();
+  if (!tok().escaped_) return std::string(raw());
+
+  const std::string_view s = raw();
+  std::string out;
+  out.reserve(s.size());
+  for (size_t i = 0; i < s.size(); i++) {
+    if (s[i] != '\\' || i + 1 == s.size()) {
+      out.push_back(s[i]);
+      continue;
+    }
+
+    switch (s[++i]) {
+      case 'b':
+        out.push_back('\b');
+        break;
+      case 'f':
+        out.push_back('\f');
+        break;
+      case 'n':
+        out.push_back('\n');
+        break;
+      case 'r':
+        out.push_back('\r');
+        break;
+      case 't':
+        out.push_back('\t');
+        break;
+      case 'u': {
+        uint32_t cp;
+        if (!Hex4(s, i + 1, cp)) return out;
+        i += 4;
+        // surrogate pair
+        uint32_t lo;
+        if (cp >= 0xD800 && cp < 0xDC00 && i + 2 < s.size() && s[i + 1] == '\\' && s[i + 2] == 'u' &&
+            Hex4(s, i + 3, lo) && lo >= 0xDC00 && lo < 0xE000) {
+          cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+          i += 6;
+        }
+        AppendUtf8(out, cp);
+        break;
+      }
+      default:  // " \ /
+        out.push_back(s[i]);
+        break;
+    }
+  }
+  return out;
+}
+
+std::span<uint8_t> JsonView::asU8(std::span<uint8_t> out) const {
+  size_t n = 0;
+  for (JsonView e : *this) {
+    if (n == out.size()) break;
+    out[n++] = static_cast<uint8_t>(e.asUInt());
+  }
+  return out.first(n);
+}
+
+JsonView::Iterator JsonView::begin() const {
+  return isArray() ? Iterator(doc_, idx_ + 1) : Iterator(doc_, 0);
+}
+
+JsonView::Iterator JsonView::end() const { return isArray() ? Iterator(doc_, tok().next_) : Iterator(doc_, 0); }
+
+}  // namespace lra::websocket
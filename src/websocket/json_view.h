@@ -0,0 +1,134 @@
+#ifndef LRA_WEBSOCKET_JSON_VIEW_H_
+#define LRA_WEBSOCKET_JSON_VIEW_H_
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lra::websocket {
+
+class JsonView;
+
+/**
+ * @brief In place JSON tokenizer for the websocket ingress, no DOM: one flat token array over the payload.
+ *
+ * @note
+ *   1. The payload is not copied, every view points into it, keep it alive while views are used.
+ *   2. Strings are kept raw (quotes stripped), only asString() unescapes.
+ *   3. The token array is reused between Parse() calls, no allocation once it fits the largest message.
+ */
+class JsonDoc {
+ public:
+  enum class Type : uint8_t { kNull, kBool, kNumber, kString, kArray, kObject };
+
+  struct Token {
+    Type type_{Type::kNull};
+    bool escaped_{false};  // string with backslashes
+    uint32_t start_{0};    // payload offsets, [start_, end_)
+    uint32_t end_{0};
+    uint32_t size_{0};     // array elements / object members
+    uint32_t next_{0};     // index after this token's subtree
+  };
+
+  static constexpr size_t kMaxDepth = 32;
+
+  // false on malformed JSON (views of a failed parse are all missing)
+  bool Parse(std::string_view json);
+
+  JsonView Root() const;
+
+  inline std::string_view Payload() const { return json_; }
+
+  inline const std::vector<Token>& Tokens() const { return tokens_; }
+
+ private:
+  std::string_view json_;
+  std::vector<Token> tokens_;
+  bool ok_{false};
+
+  bool ParseString(size_t& pos, Token& tok);
+  bool ParseLiteral(size_t& pos, Token& tok);
+  bool ParseNumber(size_t& pos, Token& tok);
+};
+
+/**
+ * @brief Read only view of one token, a missing member / element gives a null view.
+ * Accessors follow Json::Value (asUInt, asBool, ...) so handlers keep their shape, defaults match jsoncpp on null.
+ */
+class JsonView {
+ public:
+  JsonView() = default;
+  JsonView(const JsonDoc* doc, uint32_t idx) : doc_(doc), idx_(idx) {}
+
+  bool isNull() const { return type() == JsonDoc::Type::kNull; }
+  bool isBool() const { return type() == JsonDoc::Type::kBool; }
+  bool isNumeric() const { return type() == JsonDoc::Type::kNumber; }
+  bool isString() const { return type() == JsonDoc::Type::kString; }
+  bool isArray() const { return type() == JsonDoc::Type::kArray; }
+  bool isObject() const { return type() == JsonDoc::Type::kObject; }
+
+  // present in the payload, also for a literal null
+  bool exists() const { return doc_ != nullptr; }
+
+  // object member, null view if missing or not an object
+  JsonView operator[](std::string_view key) const;
+  JsonView operator[](const char* key) const { return (*this)[std::string_view(key)]; }
+
+  // array element, null view if out of range
+  JsonView operator[](size_t i) const;
+  JsonView operator[](int i) const { return (*this)[static_cast<size_t>(i)]; }
+
+  bool isMember(std::string_view key) const { return (*this)[key].exists(); }
+
+  // array elements / object members, 0 otherwise
+  size_t size() const;
+
+  bool asBool(bool def = false) const;
+  int64_t asInt64(int64_t def = 0) const;
+  uint64_t asUInt64(uint64_t def = 0) const;
+  int asInt(int def = 0) const { return static_cast<int>(asInt64(def)); }
+  unsigned asUInt(unsigned def = 0) const { return static_cast<unsigned>(asUInt64(def)); }
+  double asDouble(double def = 0) const;
+
+  // raw string (escapes kept), empty if not a string
+  std::string_view asStringView() const;
+
+  // unescaped copy
+  std::string asString() const;
+
+  // array of numbers to uint8 (each & 0xff, as asUInt), returns the filled part of out
+  std::span<uint8_t> asU8(std::span<uint8_t> out) const;
+
+  class Iterator {
+   public:
+    Iterator(const JsonDoc* doc, uint32_t idx) : doc_(doc), idx_(idx) {}
+    JsonView operator*() const { return JsonView(doc_, idx_); }
+    Iterator& operator++() {
+      idx_ = doc_->Tokens()[idx_].next_;
+      return *this;
+    }
+    bool operator!=(const Iterator& other) const { return idx_ != other.idx_; }
+
+   private:
+    const JsonDoc* doc_;
+    uint32_t idx_;
+  };
+
+  // array elements
+  Iterator begin() const;
+  Iterator end() const;
+
+ private:
+  const JsonDoc* doc_{nullptr};
+  uint32_t idx_{0};
+
+  JsonDoc::Type type() const { return doc_ ? doc_->Tokens()[idx_].type_ : JsonDoc::Type::kNull; }
+  const JsonDoc::Token& tok() const { return doc_->Tokens()[idx_]; }
+  std::string_view raw() const { return doc_->Payload().substr(tok().start_, tok().end_ - tok().start_); }
+};
+
+}  // namespace lra::websocket
+
+#endif
@@ -0,0 +1,231 @@
+#include <spdlog/common.h>
+#include <spdlog/fmt/chrono.h>
+#include <websocket/json_writer.h>
+
+#include <charconv>
+#include <cmath>
+
+namespace lra::websocket {
+
+namespace {
+
+constexpr int64_t kNsPerSec = 1000000000;
+constexpr int64_t kNsPerMin = 60 * kNsPerSec;
+
+inline void AppendDigits(char* p, int64_t v, int width) {
+  for (int i = width - 1; i >= 0; i--) {
+    p[i] = static_cast<char>('0' + v % 10);
+    v /= 10;
+  }
+}
+
+}  // namespace
+
+/* TimestampCache */
+
+void TimestampCache::Append(std::string& out, std::chrono::system_clock::time_point now) {
+  const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+  int64_t minute = ns / kNsPerMin;
+  if (ns % kNsPerMin < 0) minute--;
+
+  // minute boundaries are the same in local time (whole minute zone offsets)
+  if (minute != minute_) {
+    auto res = spdlog::fmt_lib::format_to_n(prefix_, sizeof(prefix_), "{:%Y-%m-%d %H:%M:}", now);
+    prefix_size_ = std::min(res.size, sizeof(prefix_));
+    minute_ = minute;
+  }
+
+  // "SS.nnnnnnnnn"
+  const int64_t in_minute = ns - minute * kNsPerMin;
+  char sec[12];
+  AppendDigits(sec, in_minute / kNsPerSec, 2);
+  sec[2] = '.';
+  AppendDigits(sec + 3, in_minute % kNsPerSec, 9);
+
+  out.append(prefix_, prefix_size_);
+  out.append(sec, sizeof(sec));
+}
+
+/* JsonWriter */
+
+JsonWriter& JsonWriter::ThisThread() {
+  thread_local JsonWriter writer;
+  return writer;
+}
+
+const JsonWriter::Envelope& JsonWriter::EnvelopeOf(std::string_view type, std::string_view uuid) {
+  // a handful of message types per thread, linear search
+  Envelope* env = nullptr;
+  for (auto& e : envelopes_) {
+    if (e.type_ == type) {
+      env = &e;
+      break;
+    }
+  }
+
+  if (!env) {
+    env = &envelopes_.emplace_back();
+    env->type_ = type;
+  } else if (env->uuid_ == uuid) {
+    return *env;
+  }
+
+  env->uuid_ = uuid;
+  env->head_ = "{\"type\":";
+  AppendString(env->head_, type);
+  env->head_ += ",\"uuid\":";
+  AppendString(env->head_, uuid);
+  env->head_ += ",\"timestamp\":\"";
+  return *env;
+}
+
+JsonWriter& JsonWriter::BeginMessage(std::string_view type, std::string_view uuid,
+                                     std::chrono::system_clock::time_point now) {
+  buf_.clear();
+  buf_ += EnvelopeOf(type, uuid).head_;
+  timestamp_.Append(buf_, now);
+  buf_ += "\",\"data\":{";
+  comma_ = false;
+  return *this;
+}
+
+std::string_view JsonWriter::EndMessage() {
+  buf_ += "}}";
+  comma_ = true;
+  return buf_;
+}
+
+void JsonWriter::Clear() {
+  buf_.clear();
+  comma_ = false;
+}
+
+JsonWriter& JsonWriter::Key(std::string_view key) {
+  Separate();
+  AppendString(buf_, key);
+  buf_.push_back(':');
+  comma_ = false;
+  return *this;
+}
+
+JsonWriter& JsonWriter::BeginObject() {
+  Separate();
+  buf_.push_back('{');
+  comma_ = false;
+  return *this;
+}
+
+JsonWriter& JsonWriter::EndObject() {
+  buf_.push_back('}');
+  comma_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::BeginArray() {
+  Separate();
+  buf_.push_back('[');
+  comma_ = false;
+  return *this;
+}
+
+JsonWriter& JsonWriter::EndArray() {
+  buf_.push_back(']');
+  comma_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::Value(bool v) {
+  Separate();
+  buf_ += v ? "true" : "false";
+  return *this;
+}
+
+JsonWriter& JsonWriter::Value(double v) {
+  if (!std::isfinite(v)) return Null();
+
+  Separate();
+  char tmp[32];
+  auto [p, ec] = std::to_chars(tmp, tmp + sizeof(tmp), v);
+  buf_.append(tmp, p);
+  return *this;
+}
+
+JsonWriter& JsonWriter::Value(float v) {
+  if (!std::isfinite(v)) return Null();
+
+  Separate();
+  char tmp[32];
+  auto [p, ec] = std::to_chars(tmp, tmp + sizeof(tmp), v);
+  buf_.append(tmp, p);
+  return *this;
+}
+
+JsonWriter& JsonWriter::Value(std::string_view v) {
+  Separate();
+  AppendString(buf_, v);
+  return *this;
+}
+
+JsonWriter& JsonWriter::Null() {
+  Separate();
+  buf_ += "null";
+  return *this;
+}
+
+JsonWriter& JsonWriter::Value(std::span<const uint8_t> v) {
+  BeginArray();
+  for (uint8_t e : v) Value(e);
+  return EndArray();
+}
+
+void JsonWriter::AppendInt(int64_t v) {
+  char tmp[24];
+  auto [p, ec] = std::to_chars(tmp, tmp + sizeof(tmp), v);
+  buf_.append(tmp, p);
+}
+
+void JsonWriter::AppendInt(uint64_t v) {
+  char tmp[24];
+  auto [p, ec] = std::to_chars(tmp, tmp + sizeof(tmp), v);
+  buf_.append(tmp, p);
+}
+
+void JsonWriter::AppendString(std::string& out, std::string_view s) {
+  static constexpr char kHex[] = "0123456789abcdef";
+
+  out.push_back('"');
+  size_t plain = 0;  // start of the run not written yet
+  for (size_t i = 0; i < s.size(); i++) {
+    const unsigned char c = s[i];
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+    out.append(s.data() + plain, i - plain);
+    plain = i + 1;
+    switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\r':
+        out += "\\r";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default: {
+        const char esc[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF]};
+        out.append(esc, sizeof(esc));
+        break;
+      }
+    }
+  }
+  out.append(s.data() + plain, s.size() - plain);
+  out.push_back('"');
+}
+
+}  // namespace lra::websocket
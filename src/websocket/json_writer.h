@@ -0,0 +1,115 @@
+#ifndef LRA_WEBSOCKET_JSON_WRITER_H_
+#define LRA_WEBSOCKET_JSON_WRITER_H_
+
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace lra::websocket {
+
+/**
+ * @brief Message timestamp, same text as format("{:%Y-%m-%d %H:%M:}{:%S}", now, now.time_since_epoch()),
+ * e.g. "2023-05-01 12:34:56.123456789" (local time, ns).
+ * The date part goes through fmt once per minute, within the minute only the seconds field is written.
+ */
+class TimestampCache {
+ public:
+  void Append(std::string& out, std::chrono::system_clock::time_point now);
+
+ private:
+  int64_t minute_{INT64_MIN};
+  char prefix_[32]{};
+  size_t prefix_size_{0};
+};
+
+/**
+ * @brief Streaming JSON emitter for outbound messages, writes straight into a reused buffer (no DOM).
+ *
+ * @note
+ *   1. BeginMessage() writes the envelope {"type":..,"uuid":..,"timestamp":..,"data":{ , the constant part (type,
+ *      uuid) is kept per message type and only rebuilt when the uuid changes.
+ *   2. Members of "data" follow, EndMessage() closes it and returns the text, valid until the next BeginMessage().
+ *   3. No allocation once the buffer reached the largest message, use one writer per thread (ThisThread()).
+ */
+class JsonWriter {
+ public:
+  // writer of the calling thread
+  static JsonWriter& ThisThread();
+
+  JsonWriter& BeginMessage(std::string_view type, std::string_view uuid, std::chrono::system_clock::time_point now);
+  std::string_view EndMessage();
+
+  // plain document, no envelope
+  void Clear();
+  inline std::string_view View() const { return buf_; }
+
+  JsonWriter& Key(std::string_view key);
+
+  JsonWriter& BeginObject();
+  JsonWriter& EndObject();
+  JsonWriter& BeginArray();
+  JsonWriter& EndArray();
+
+  JsonWriter& Value(bool v);
+  JsonWriter& Value(double v);  // non finite as null (as jsoncpp)
+  JsonWriter& Value(float v);
+  JsonWriter& Value(std::string_view v);
+  JsonWriter& Value(const char* v) { return Value(std::string_view(v)); }
+  JsonWriter& Value(const std::string& v) { return Value(std::string_view(v)); }
+  JsonWriter& Null();
+
+  template <std::integral T>
+  JsonWriter& Value(T v) {
+    Separate();
+    AppendInt(v);
+    return *this;
+  }
+
+  // array of numbers
+  JsonWriter& Value(std::span<const uint8_t> v);
+  JsonWriter& Value(const std::vector<uint8_t>& v) { return Value(std::span<const uint8_t>(v)); }
+
+  template <class T>
+  JsonWriter& Member(std::string_view key, const T& v) {
+    return Key(key).Value(v);
+  }
+
+ private:
+  struct Envelope {
+    std::string type_;
+    std::string uuid_;
+    std::string head_;  // {"type":"..","uuid":"..","timestamp":"
+  };
+
+  std::string buf_;
+  bool comma_{false};  // a value ended, the next key / element needs a ','
+  std::vector<Envelope> envelopes_;
+  TimestampCache timestamp_;
+
+  inline void Separate() {
+    if (comma_) buf_.push_back(',');
+    comma_ = true;
+  }
+
+  void AppendInt(int64_t v);
+  void AppendInt(uint64_t v);
+  template <std::integral T>
+  void AppendInt(T v) {
+    if constexpr (std::is_signed_v<T>)
+      AppendInt(static_cast<int64_t>(v));
+    else
+      AppendInt(static_cast<uint64_t>(v));
+  }
+
+  static void AppendString(std::string& out, std::string_view s);
+  const Envelope& EnvelopeOf(std::string_view type, std::string_view uuid);
+};
+
+}  // namespace lra::websocket
+
+#endif
@@ -0,0 +1,44 @@
+#include <websocket/rt_frame.h>
+
+namespace lra::websocket {
+
+bool DecodeRtFrame(std::string_view payload, RtFrameView& out) {
+  if (payload.size() < kRtHeaderBytes) return false;
+
+  const char* p = payload.data();
+  auto get = [&p](auto& v) {
+    memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+  };
+
+  uint32_t magic;
+  uint16_t version, flags;
+  get(magic);
+  get(version);
+  get(flags);
+  if (magic != kRtMagic || version > kRtVersion) return false;
+
+  get(out.seq_);
+  get(out.acc_n_);
+  get(out.t0_);
+
+  const size_t need = kRtHeaderBytes + ((flags & kRtFlagDrv) ? kRtDrvBytes : 0) + out.acc_n_ * 4 * sizeof(float);
+  if (payload.size() < need) return false;
+
+  out.has_drv_ = flags & kRtFlagDrv;
+  if (out.has_drv_) {
+    uint8_t rtp[4];
+    get(rtp);
+    memcpy(out.drv_.rtp_, rtp, sizeof(out.drv_.rtp_));
+    get(out.drv_.freq_);
+  }
+
+  const float* acc = reinterpret_cast<const float*>(p);
+  out.acc_t_ = acc;
+  out.acc_x_ = acc + out.acc_n_;
+  out.acc_y_ = acc + 2 * out.acc_n_;
+  out.acc_z_ = acc + 3 * out.acc_n_;
+  return true;
+}
+
+}  // namespace lra::websocket
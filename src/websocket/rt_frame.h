@@ -0,0 +1,112 @@
+#ifndef LRA_WEBSOCKET_RT_FRAME_H_
+#define LRA_WEBSOCKET_RT_FRAME_H_
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace lra::websocket {
+
+/**
+ * Binary real-time frame, replaces the JSON dataRTKeepRequireResponse for clients that negotiated it
+ * (subprotocol kRtBinarySubprotocol on connect, or "format": "binary" in dataRTKeepRequire).
+ *
+ * little endian, every block 4-byte aligned so a client can map it with Float32Array without copying
+ *
+ *  offset  type       field
+ *  0       u32        magic 'LRT1'
+ *  4       u16        version
+ *  6       u16        flags, kRtFlagDrv | kRtFlagAcc
+ *  8       u32        seq, +1 per frame, gaps mean dropped frames
+ *  12      u32        acc_n
+ *  16      f64        t0, ns since controller start (same clock as JSON "t")
+ *  24      drv block  u8 rtp[4] (x, y, z, pad), f32 freq[3]                      if kRtFlagDrv
+ *  ..      acc block  f32 t[acc_n] (ns relative to t0), f32 x[acc_n], y[acc_n], z[acc_n]  if kRtFlagAcc
+ */
+constexpr uint32_t kRtMagic = 0x3154524C;  // "LRT1"
+constexpr uint16_t kRtVersion = 1;
+constexpr uint16_t kRtFlagDrv = 0x01;
+constexpr uint16_t kRtFlagAcc = 0x02;
+constexpr size_t kRtHeaderBytes = 24;
+constexpr size_t kRtDrvBytes = 16;
+constexpr const char* kRtBinarySubprotocol = "lra.rt.v1";
+
+static_assert(std::endian::native == std::endian::little, "rt frame is written in host order");
+
+struct RtDrv {
+  uint8_t rtp_[3]{};
+  float freq_[3]{};
+};
+
+class RtFrameEncoder {
+ public:
+  // acc sample type T needs data.x, data.y, data.z, time (ns since controller start), e.g. Adxl355::Acc3
+  // buffer is kept between frames, no allocation once it reached the largest frame
+  template <class T>
+  std::string_view Encode(uint32_t seq, double t0, const RtDrv* drv, std::span<const T> acc) {
+    const size_t n = acc.size();
+    const uint16_t flags = (drv ? kRtFlagDrv : 0) | (n ? kRtFlagAcc : 0);
+    const size_t bytes = kRtHeaderBytes + (drv ? kRtDrvBytes : 0) + n * 4 * sizeof(float);
+    buf_.resize(bytes);
+
+    char* p = buf_.data();
+    Put(p, kRtMagic);
+    Put(p, kRtVersion);
+    Put(p, flags);
+    Put(p, seq);
+    Put(p, static_cast<uint32_t>(n));
+    Put(p, t0);
+
+    if (drv) {
+      const uint8_t rtp[4] = {drv->rtp_[0], drv->rtp_[1], drv->rtp_[2], 0};
+      Put(p, rtp);
+      Put(p, drv->freq_);
+    }
+
+    // planar, one array per field
+    float* t = reinterpret_cast<float*>(p);
+    float* x = t + n;
+    float* y = x + n;
+    float* z = y + n;
+    for (size_t i = 0; i < n; i++) {
+      t[i] = static_cast<float>(acc[i].time - t0);
+      x[i] = acc[i].data.x;
+      y[i] = acc[i].data.y;
+      z[i] = acc[i].data.z;
+    }
+
+    return std::string_view(buf_);
+  }
+
+ private:
+  std::string buf_;
+
+  template <class V>
+  static void Put(char*& p, const V& v) {
+    memcpy(p, &v, sizeof(v));
+    p += sizeof(v);
+  }
+};
+
+// parsed frame, acc arrays point into the payload (4-byte aligned buffer)
+struct RtFrameView {
+  uint32_t seq_{0};
+  double t0_{0};
+  uint32_t acc_n_{0};
+  bool has_drv_{false};
+  RtDrv drv_{};
+  const float* acc_t_{nullptr};
+  const float* acc_x_{nullptr};
+  const float* acc_y_{nullptr};
+  const float* acc_z_{nullptr};
+};
+
+// false for a short / foreign / newer frame
+bool DecodeRtFrame(std::string_view payload, RtFrameView& out);
+
+}  // namespace lra::websocket
+
+#endif
@@ -1,6 +1,7 @@
 #include <websocket/websocket.h>
 
 #include <algorithm>
+#include <sstream>
 
 namespace lra::websocket {
 
@@ -13,15 +14,81 @@ Json::Value WebsocketServer::parseJson(const string& json) {
 
 string WebsocketServer::stringifyJson(const Json::Value& val) {
   // When we transmit JSON data, we omit all whitespace
-  Json::StreamWriterBuilder wbuilder;
-  wbuilder["commentStyle"] = "None";
-  wbuilder["indentation"] = "";
+  // the writer is built once per thread, building it costs more than writing a small message
+  thread_local std::unique_ptr<Json::StreamWriter> writer = [] {
+    Json::StreamWriterBuilder wbuilder;
+    wbuilder["commentStyle"] = "None";
+    wbuilder["indentation"] = "";
+    return std::unique_ptr<Json::StreamWriter>(wbuilder.newStreamWriter());
+  }();
 
-  return Json::writeString(wbuilder, val);
+  thread_local std::ostringstream sout;
+  sout.str("");
+  writer->write(val, &sout);
+  return sout.str();
+}
+
+string WebsocketServer::serializeMessage(const string& messageType, const Json::Value& arguments) {
+  // Objects get the type field spliced in after '{', anything else (or an existing type field) takes the copy
+  if (arguments.isObject() && !arguments.isMember(MESSAGE_FIELD)) {
+    string json = WebsocketServer::stringifyJson(arguments);
+    string field = "\"" MESSAGE_FIELD "\":" + Json::valueToQuotedString(messageType.c_str());
+    if (json.size() > 2) field += ',';
+    json.insert(1, field);
+    return json;
+  }
+
+  Json::Value messageData = arguments.isNull() ? Json::Value(Json::objectValue) : arguments;
+  messageData[MESSAGE_FIELD] = messageType;
+  return WebsocketServer::stringifyJson(messageData);
+}
+
+WebsocketEndpoint::message_ptr WebsocketServer::prepareMessage(string&& payload,
+                                                               websocketpp::frame::opcode::value opcode) {
+  auto in = this->framerMsgManager->get_message(opcode, 0);
+  auto out = this->framerMsgManager->get_message();
+  if (!in || !out) return nullptr;
+
+  in->get_raw_payload().swap(payload);
+  if (this->framer->prepare_data_frame(in, out)) return nullptr;  // e.g. invalid utf-8 in a text frame
+
+  return out;
+}
+
+WebsocketEndpoint::message_ptr WebsocketServer::prepareMessage(std::string_view payload,
+                                                               websocketpp::frame::opcode::value opcode) {
+  // the input message is only read by the framer, keep one per thread so its payload buffer is reused
+  thread_local WebsocketEndpoint::message_ptr in;
+  if (!in) in = this->framerMsgManager->get_message(opcode, payload.size());
+  auto out = this->framerMsgManager->get_message();
+  if (!in || !out) return nullptr;
+
+  in->set_opcode(opcode);
+  in->get_raw_payload().assign(payload);
+  if (this->framer->prepare_data_frame(in, out)) return nullptr;
+
+  return out;
+}
+
+vector<ClientConnection> WebsocketServer::snapshotConnections() {
+  // Prevent concurrent access to the list of open connections from multiple threads
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  return this->openConnections;
+}
+
+void WebsocketServer::fanOut(const vector<ClientConnection>& conns, const WebsocketEndpoint::message_ptr& msg) {
+  if (!msg) return;
+
+  for (auto& conn : conns) {
+    websocketpp::lib::error_code ec;
+    this->endpoint.send(conn, msg, ec);
+  }
 }
 
 WebsocketServer::WebsocketServer() {
   // Wire up our event handlers
+  this->endpoint.set_validate_handler(std::bind(&WebsocketServer::onValidate, this, std::placeholders::_1));
   this->endpoint.set_open_handler(std::bind(&WebsocketServer::onOpen, this, std::placeholders::_1));
   this->endpoint.set_close_handler(std::bind(&WebsocketServer::onClose, this, std::placeholders::_1));
   this->endpoint.set_message_handler(
@@ -29,6 +96,10 @@ WebsocketServer::WebsocketServer() {
 
   // Initialise the Asio library, using our own event loop object
   this->endpoint.init_asio(&(this->eventLoop));
+
+  // Server side framing of broadcast messages (unmasked, so one framed buffer fits every connection)
+  this->framerMsgManager = std::make_shared<websocketpp::config::asio::con_msg_manager_type>();
+  this->framer = std::make_unique<WebsocketFramer>(false, true, this->framerMsgManager, this->framerRng);
 }
 
 void WebsocketServer::run(int port) {
@@ -48,21 +119,175 @@ size_t WebsocketServer::numConnections() {
 }
 
 void WebsocketServer::sendMessage(ClientConnection conn, const string& messageType, const Json::Value& arguments) {
-  // Copy the argument values, and bundle the message type into the object
-  Json::Value messageData = arguments;
-  messageData[MESSAGE_FIELD] = messageType;
-
   // Send the JSON data to the client (will happen on the networking thread's event loop)
-  this->endpoint.send(conn, WebsocketServer::stringifyJson(messageData), websocketpp::frame::opcode::text);
+  this->endpoint.send(conn, WebsocketServer::serializeMessage(messageType, arguments), websocketpp::frame::opcode::text);
+}
+
+void WebsocketServer::sendMessage(ClientConnection conn, std::string_view payload) {
+  websocketpp::lib::error_code ec;
+  this->endpoint.send(conn, payload.data(), payload.size(), websocketpp::frame::opcode::text, ec);
 }
 
 void WebsocketServer::broadcastMessage(const string& messageType, const Json::Value& arguments) {
-  // Prevent concurrent access to the list of open connections from multiple threads
+  auto msg = this->prepareMessage(WebsocketServer::serializeMessage(messageType, arguments),
+                                  websocketpp::frame::opcode::text);
+  this->fanOut(this->snapshotConnections(), msg);
+}
+
+void WebsocketServer::setRtBinary(ClientConnection conn, bool binary) {
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  auto it = this->clientStates.find(conn);
+  if (it == this->clientStates.end()) return;
+
+  it->second.rtBinary = binary;
+  if (auto rt = it->second.rt) {
+    std::lock_guard<std::mutex> rtLock(rt->mutex);
+    rt->binary = binary;
+    rt->queue.clear();  // queued frames are in the old format
+  }
+}
+
+void WebsocketServer::subscribeRt(ClientConnection conn, const RtSubscription& sub) {
   std::lock_guard<std::mutex> lock(this->connectionListMutex);
 
-  for (auto conn : this->openConnections) {
-    this->sendMessage(conn, messageType, arguments);
+  auto it = this->clientStates.find(conn);
+  if (it == this->clientStates.end()) return;
+
+  auto& rt = it->second.rt;
+  if (!rt) {
+    rt = std::make_shared<RtClient>();
+    rt->conn = conn;
   }
+
+  std::lock_guard<std::mutex> rtLock(rt->mutex);
+  rt->binary = it->second.rtBinary;
+  rt->sub = sub;
+  rt->sub.decimation = std::clamp<uint32_t>(sub.decimation, 1, kRtMaxDecimation);
+  rt->sub.queueFrames = std::max<size_t>(sub.queueFrames, 1);
+  rt->decimation = rt->sub.decimation;
+  rt->calmTicks = 0;
+  rt->queue.clear();
+}
+
+void WebsocketServer::unsubscribeRt(ClientConnection conn) {
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  auto it = this->clientStates.find(conn);
+  if (it != this->clientStates.end()) it->second.rt.reset();
+}
+
+size_t WebsocketServer::numRtSubscribers() {
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  return std::count_if(this->clientStates.begin(), this->clientStates.end(),
+                       [](const auto& kv) { return kv.second.rt != nullptr; });
+}
+
+vector<std::shared_ptr<WebsocketServer::RtClient>> WebsocketServer::snapshotRtClients() {
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  vector<std::shared_ptr<RtClient>> clients;
+  clients.reserve(this->clientStates.size());
+  for (auto& [conn, state] : this->clientStates) {
+    if (state.rt) clients.push_back(state.rt);
+  }
+  return clients;
+}
+
+void WebsocketServer::publishRt(const std::function<std::string_view(RtChannels)>& toJson,
+                                const std::function<std::string_view(RtChannels)>& toBinary) {
+  const uint64_t tick = this->rtTick++;
+
+  // one prepared message per (binary, drv, acc), built for the first client that needs it
+  WebsocketEndpoint::message_ptr variants[8];
+
+  for (auto& client : this->snapshotRtClients()) {
+    std::lock_guard<std::mutex> lock(client->mutex);
+
+    if (tick % client->decimation == 0) {
+      const RtChannels ch = client->sub.channels;
+      auto& msg = variants[(client->binary << 2) | (ch.drv << 1) | ch.acc];
+      if (!msg) {
+        msg = client->binary ? this->prepareMessage(toBinary(ch), websocketpp::frame::opcode::binary)
+                             : this->prepareMessage(toJson(ch), websocketpp::frame::opcode::text);
+      }
+      if (msg) this->enqueueRt(*client, msg);
+    }
+
+    this->pumpRt(*client);
+  }
+}
+
+void WebsocketServer::enqueueRt(RtClient& client, const WebsocketEndpoint::message_ptr& msg) {
+  if (client.queue.size() >= client.sub.queueFrames) {
+    client.queue.pop_front();
+    client.dropped++;
+    client.calmTicks = 0;
+
+    if (client.sub.policy == RtOverflowPolicy::kDecimate)
+      client.decimation = std::min(client.decimation * 2, kRtMaxDecimation);
+  }
+
+  client.queue.emplace_back(msg, std::chrono::steady_clock::now());
+}
+
+void WebsocketServer::pumpRt(RtClient& client) {
+  websocketpp::lib::error_code ec;
+  auto con = this->endpoint.get_con_from_hdl(client.conn, ec);
+  if (ec) {  // closing, onClose drops the client
+    client.queue.clear();
+    return;
+  }
+
+  // hand frames to websocketpp only while its buffer for this client is small, the rest wait (bounded) here
+  client.bufferedBytes = con->get_buffered_amount();
+  while (!client.queue.empty() && client.bufferedBytes < kRtMaxBufferedBytes) {
+    auto& msg = client.queue.front().first;
+    if (con->send(msg)) break;
+    client.bufferedBytes += msg->get_payload().size();
+    client.queue.pop_front();
+    client.sent++;
+  }
+
+  // recover the subscribed rate after a quiet period
+  if (client.queue.empty() && client.decimation > client.sub.decimation && ++client.calmTicks >= kRtCalmTicks) {
+    client.decimation = std::max(client.decimation / 2, client.sub.decimation);
+    client.calmTicks = 0;
+  }
+}
+
+vector<RtClientStats> WebsocketServer::rtClientStats() {
+  vector<RtClientStats> stats;
+  const auto now = std::chrono::steady_clock::now();
+
+  for (auto& client : this->snapshotRtClients()) {
+    std::lock_guard<std::mutex> lock(client->mutex);
+
+    RtClientStats s;
+    s.binary = client->binary;
+    s.queued = client->queue.size();
+    s.bufferedBytes = client->bufferedBytes;
+    s.sent = client->sent;
+    s.dropped = client->dropped;
+    s.decimation = client->decimation;
+    if (!client->queue.empty())
+      s.lagMs = std::chrono::duration<double, std::milli>(now - client->queue.front().second).count();
+    stats.push_back(s);
+  }
+  return stats;
+}
+
+bool WebsocketServer::onValidate(ClientConnection conn) {
+  // Accept the binary real-time subprotocol if the client offers it, plain connections stay JSON
+  auto con = this->endpoint.get_con_from_hdl(conn);
+  for (auto& protocol : con->get_requested_subprotocols()) {
+    if (protocol == kRtBinarySubprotocol) {
+      con->select_subprotocol(protocol);
+      break;
+    }
+  }
+  return true;
 }
 
 void WebsocketServer::onOpen(ClientConnection conn) {
@@ -72,6 +297,7 @@ void WebsocketServer::onOpen(ClientConnection conn) {
 
     // Add the connection handle to our list of open connections
     this->openConnections.push_back(conn);
+    this->clientStates[conn].rtBinary = (this->endpoint.get_con_from_hdl(conn)->get_subprotocol() == kRtBinarySubprotocol);
   }
 
   // Invoke any registered handlers
@@ -105,6 +331,8 @@ void WebsocketServer::onClose(ClientConnection conn) {
 
     // Truncate the connections vector to erase the removed elements
     this->openConnections.resize(std::distance(openConnections.begin(), newEnd));
+
+    this->clientStates.erase(conn);
   }
 
   // Invoke any registered handlers
@@ -113,22 +341,28 @@ void WebsocketServer::onClose(ClientConnection conn) {
   }
 }
 
-/* rewrite this: Dennis */
 void WebsocketServer::onMessage(ClientConnection conn, WebsocketEndpoint::message_ptr msg) {
-  // Validate that the incoming message contains valid JSON
-  Json::Value messageObject = WebsocketServer::parseJson(msg->get_payload());
-  if (messageObject.isNull() == false) {
-    // Validate that the JSON object contains the message type field
-    if (messageObject.isMember(MESSAGE_FIELD)) {
-      // Extract the message type and remove it from the payload
-      std::string messageType = messageObject[MESSAGE_FIELD].asString();
-      messageObject.removeMember(MESSAGE_FIELD);
-
-      // If any handlers are registered for the message type, invoke them
-      auto& handlers = this->messageHandlers[messageType];
-      for (auto handler : handlers) {
-        handler(conn, messageObject);
-      }
+  // Tokenize in place, the token buffer is reused for every message of this thread
+  thread_local JsonDoc doc;
+  if (!doc.Parse(msg->get_payload())) return;
+
+  // Validate that the JSON object contains the message type field
+  JsonView messageObject = doc.Root();
+  auto it = this->messageTypeIds.find(messageObject[MESSAGE_FIELD].asStringView());
+  if (it == this->messageTypeIds.end()) return;
+
+  // Invoke the handlers registered for the message type
+  const MessageHandlers& handlers = this->messageHandlers[it->second];
+  for (auto& handler : handlers.views) {
+    handler(conn, messageObject, msg);
+  }
+
+  // jsoncpp DOM only for handlers that still want one, without the message type field
+  if (!handlers.legacy.empty()) {
+    Json::Value dom = WebsocketServer::parseJson(msg->get_payload());
+    dom.removeMember(MESSAGE_FIELD);
+    for (auto& handler : handlers.legacy) {
+      handler(conn, dom);
     }
   }
 }
@@ -8,13 +8,21 @@
 
 #include <json/json.h>
 #include <util/log/logunit.h>
+#include <websocket/json_view.h>
+#include <websocket/rt_frame.h>
 
+#include <chrono>
+#include <deque>
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/processors/hybi13.hpp>
 #include <websocketpp/server.hpp>
 
 namespace lra::websocket {
@@ -24,6 +32,36 @@ using ::std::vector;
 
 typedef websocketpp::server<websocketpp::config::asio> WebsocketEndpoint;
 typedef websocketpp::connection_hdl ClientConnection;
+typedef websocketpp::processor::hybi13<websocketpp::config::asio> WebsocketFramer;
+
+// what a real-time client gets when its send queue is full
+enum class RtOverflowPolicy {
+  kDropOldest,  // keep the newest frames
+  kDecimate,    // also halve the client's frame rate until the queue stays empty again
+};
+
+// channels of a real-time frame
+struct RtChannels {
+  bool drv{true};
+  bool acc{true};
+};
+
+struct RtSubscription {
+  RtChannels channels;
+  uint32_t decimation{1};  // every n-th frame
+  RtOverflowPolicy policy{RtOverflowPolicy::kDropOldest};
+  size_t queueFrames{16};  // frames held back while the socket is congested
+};
+
+struct RtClientStats {
+  bool binary{false};
+  size_t queued{0};
+  size_t bufferedBytes{0};  // accepted by websocketpp, not written to the socket yet
+  uint64_t sent{0};
+  uint64_t dropped{0};
+  uint32_t decimation{1};  // effective, kDecimate raises it under backpressure
+  double lagMs{0};         // age of the oldest queued frame
+};
 
 class WebsocketServer {
  public:
@@ -47,37 +85,137 @@ class WebsocketServer {
     this->eventLoop.post([this, handler]() { this->disconnectHandlers.push_back(handler); });
   }
 
-  // Registers a callback for when a particular type of message is received
+  // Registers a callback for when a particular type of message is received, gets a jsoncpp DOM of the message
   template <typename CallbackTy>
   void message(const string& messageType, CallbackTy handler) {
     // Make sure we only access the handlers list from the networking thread
-    this->eventLoop.post([this, messageType, handler]() { this->messageHandlers[messageType].push_back(handler); });
+    this->eventLoop.post([this, messageType, handler]() { this->handlersOf(messageType).legacy.push_back(handler); });
+  }
+
+  // Same, without a DOM: handler(conn, args, frame) gets a view into the payload (json_view.h), valid during the call.
+  // frame holds the payload, keep it to read the message later or on another thread
+  template <typename CallbackTy>
+  void messageView(const string& messageType, CallbackTy handler) {
+    this->eventLoop.post([this, messageType, handler]() { this->handlersOf(messageType).views.push_back(handler); });
   }
 
   // Sends a message to an individual client
   //(Note: the data transmission will take place on the thread that called WebsocketServer::run())
   void sendMessage(ClientConnection conn, const string& messageType, const Json::Value& arguments);
 
-  // Sends a message to all connected clients
+  // Sends an already serialized message (e.g. JsonWriter::EndMessage(), type field included)
+  void sendMessage(ClientConnection conn, std::string_view payload);
+
+  // Sends a message to all connected clients, serialized and framed once, every connection queues the same buffer
   //(Note: the data transmission will take place on the thread that called WebsocketServer::run())
   void broadcastMessage(const string& messageType, const Json::Value& arguments);
 
+  // Real-time data format of a client, JSON by default, binary (rt_frame.h) if negotiated on connect through the
+  // kRtBinarySubprotocol subprotocol or switched later (e.g. "format": "binary" in dataRTKeepRequire)
+  void setRtBinary(ClientConnection conn, bool binary);
+
+  // Starts (or changes) / stops real-time data for one client
+  void subscribeRt(ClientConnection conn, const RtSubscription& sub);
+  void unsubscribeRt(ClientConnection conn);
+
+  // Returns the number of clients subscribed to real-time data
+  size_t numRtSubscribers();
+
+  // Sends one real-time frame to every due subscriber. Each (format, channels) variant is built by toJson (whole
+  // message text, e.g. JsonWriter) / toBinary and framed at most once, then queued per client, a congested client only
+  // fills its own bounded queue
+  void publishRt(const std::function<std::string_view(RtChannels)>& toJson,
+                 const std::function<std::string_view(RtChannels)>& toBinary);
+
+  vector<RtClientStats> rtClientStats();
+
  protected:
   static Json::Value parseJson(const string& json);
   static string stringifyJson(const Json::Value& val);
 
+  // arguments with the message type field, same as stringifyJson of the merged object without copying arguments
+  static string serializeMessage(const string& messageType, const Json::Value& arguments);
+
+  // Frames the payload once (header + payload), the result can be sent to any number of connections
+  WebsocketEndpoint::message_ptr prepareMessage(string&& payload, websocketpp::frame::opcode::value opcode);
+
+  // Same, the payload is copied into a per thread input message instead of taking a string
+  WebsocketEndpoint::message_ptr prepareMessage(std::string_view payload, websocketpp::frame::opcode::value opcode);
+
+  // Copies the connection handles (all, or the clients of one real-time format) so sending happens outside the lock
+  vector<ClientConnection> snapshotConnections();
+
+  // Queues a prepared message on every connection, a closing connection only drops it
+  void fanOut(const vector<ClientConnection>& conns, const WebsocketEndpoint::message_ptr& msg);
+
+  bool onValidate(ClientConnection conn);
   void onOpen(ClientConnection conn);
   void onClose(ClientConnection conn);
   void onMessage(ClientConnection conn, WebsocketEndpoint::message_ptr msg);
 
   asio::io_service eventLoop;
   WebsocketEndpoint endpoint;
+
+  // frames broadcast messages, no per connection state for a server without extensions
+  websocketpp::config::asio::rng_type framerRng;
+  std::shared_ptr<websocketpp::config::asio::con_msg_manager_type> framerMsgManager;
+  std::unique_ptr<WebsocketFramer> framer;
   vector<ClientConnection> openConnections;
   std::mutex connectionListMutex;
 
+  // real-time subscriber, its own lock so publishing never holds connectionListMutex
+  struct RtClient {
+    std::mutex mutex;
+    ClientConnection conn;
+    bool binary{false};
+    RtSubscription sub;
+    uint32_t decimation{1};
+    uint32_t calmTicks{0};
+    std::deque<std::pair<WebsocketEndpoint::message_ptr, std::chrono::steady_clock::time_point>> queue;
+    size_t bufferedBytes{0};
+    uint64_t sent{0};
+    uint64_t dropped{0};
+  };
+
+  // bytes websocketpp may hold for a client before frames wait in the client's own queue
+  static constexpr size_t kRtMaxBufferedBytes = 256 * 1024;
+  static constexpr uint32_t kRtMaxDecimation = 64;
+  // ticks with an empty queue before kDecimate lowers the decimation again
+  static constexpr uint32_t kRtCalmTicks = 100;
+
+  vector<std::shared_ptr<RtClient>> snapshotRtClients();
+  void enqueueRt(RtClient& client, const WebsocketEndpoint::message_ptr& msg);
+  void pumpRt(RtClient& client);
+
+  uint64_t rtTick{0};
+
+  // per connection state, guarded by connectionListMutex
+  struct ClientState {
+    bool rtBinary{false};
+    std::shared_ptr<RtClient> rt;  // set while subscribed
+  };
+  map<ClientConnection, ClientState, std::owner_less<ClientConnection>> clientStates;
+
   vector<std::function<void(ClientConnection)>> connectHandlers;
   vector<std::function<void(ClientConnection)>> disconnectHandlers;
-  map<string, vector<std::function<void(ClientConnection, const Json::Value&)>>> messageHandlers;
+  // message type -> index into messageHandlers, looked up with the string_view of the incoming type
+  struct TypeHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+  };
+  struct MessageHandlers {
+    vector<std::function<void(ClientConnection, const Json::Value&)>> legacy;
+    vector<std::function<void(ClientConnection, const JsonView&, const WebsocketEndpoint::message_ptr&)>> views;
+  };
+  std::unordered_map<string, uint32_t, TypeHash, std::equal_to<>> messageTypeIds;
+  vector<MessageHandlers> messageHandlers;
+
+  // networking thread only
+  MessageHandlers& handlersOf(const string& messageType) {
+    auto [it, added] = this->messageTypeIds.try_emplace(messageType, this->messageHandlers.size());
+    if (added) this->messageHandlers.emplace_back();
+    return this->messageHandlers[it->second];
+  }
 };
 
 const vector<string> wsLraMsgLraRequireType{"regAllRequire",       "regDrvRequire",     "regAdxlRequire",
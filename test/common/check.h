@@ -0,0 +1,29 @@
+#ifndef LRA_TEST_COMMON_CHECK_H_
+#define LRA_TEST_COMMON_CHECK_H_
+
+// Shared by the self-checking tests: Check() prints [PASS] / [FAIL], main() returns failed so CTest sees it
+
+#include <time.h>
+
+#include <cstdint>
+#include <cstdio>
+
+namespace lra::test {
+
+inline int failed = 0;
+
+inline void Check(bool ok, const char* what) {
+  printf("[%s] %s\n", ok ? "PASS" : "FAIL", what);
+  if (!ok) failed++;
+}
+
+// CLOCK_MONOTONIC, same clock as PreciseWaiter / PeriodicLoop deadlines
+inline int64_t NowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+}  // namespace lra::test
+
+#endif
@@ -0,0 +1,129 @@
+// Heap allocations and time per sample on the Adxl355 acquisition path, simulated SPI backend
+// usage: lra_device_test_adxl355_alloc [samples]
+
+#include <device/adxl355/adxl355.h>
+
+#include <atomic>
+#include <chrono>
+#include <new>
+
+#include "adxl355_sim.h"
+
+using ::lra::bus::Spi;
+using ::lra::bus::SpiInit_S;
+using ::lra::bus_adapter::spi::SpiAdapter_S;
+using ::lra::device::Adxl355;
+using ::lra::test::Adxl355Sim;
+
+/* count global operator new / new[] while counting_ is set */
+static std::atomic<bool> counting_{false};
+static std::atomic<uint64_t> n_alloc_{0};
+
+static void* CountedAlloc(size_t size) {
+  if (counting_.load(std::memory_order_relaxed)) n_alloc_.fetch_add(1, std::memory_order_relaxed);
+  void* p = malloc(size ? size : 1);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new(size_t size) { return CountedAlloc(size); }
+void* operator new[](size_t size) { return CountedAlloc(size); }
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+struct Result {
+  uint64_t allocs{0};
+  uint64_t samples{0};
+  double ns{0};
+};
+
+// fn is called with counting enabled and returns number of samples acquired
+template <typename Fn>
+static void Measure(Result& r, Fn&& fn) {
+  auto t0 = std::chrono::steady_clock::now();
+  n_alloc_ = 0;
+  counting_ = true;
+  r.samples += fn();
+  counting_ = false;
+  r.allocs += n_alloc_;
+  r.ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void Print(const char* name, const Result& r) {
+  printf("  %-28s %8.3f allocs/sample %8.1f ns/sample\n", name, static_cast<double>(r.allocs) / r.samples,
+         r.ns / r.samples);
+}
+
+int main(int argc, char* argv[]) {
+  int samples = (argc > 1) ? atoi(argv[1]) : 100000;
+  int failed = 0;
+
+  Adxl355Sim sim;
+  SpiInit_S spi_init;
+  spi_init.name_ = "spi_sim";
+  spi_init.mock_xfer_ = [&sim](const spi_ioc_transfer* xfer, uint16_t n) { return sim.Xfer(xfer, n); };
+
+  auto bus = std::make_shared<Spi>();
+  bus->Init(spi_init);
+
+  SpiAdapter_S init;
+  init.bus_ = bus;
+
+  Adxl355 adxl;
+  adxl.Init(init, "acc_alloc");
+
+  /* data ready path */
+  Result r_frame, r_acc;
+  Adxl355::AccFrame frame;
+  for (int i = 0; i < samples; i++) {
+    sim.PushSample(i, -i, 256000);  // sim FIFO drops oldest when full
+    Measure(r_frame, [&]() {
+      adxl.AccPushBack(adxl.GetAcc(frame));
+      return 1;
+    });
+    Measure(r_acc, [&]() {
+      adxl.AccPushBack(adxl.GetAcc());
+      return 1;
+    });
+  }
+
+  /* FIFO watermark path */
+  constexpr int watermark = 20;
+  adxl.SetFifoMode(true, watermark);
+
+  Result r_span, r_vec;
+  std::array<Adxl355::Acc3, Adxl355::kFifoMaxSamples> fifo_buf;
+  for (int i = 0; i < samples / watermark; i++) {
+    for (int k = 0; k < watermark; k++) sim.PushSample(k, -k, 256000);
+    Measure(r_span, [&]() {
+      size_t n = adxl.GetAccFifo(fifo_buf, 1e9);
+      for (size_t k = 0; k < n; k++) adxl.AccPushBack(fifo_buf[k]);
+      return n;
+    });
+
+    for (int k = 0; k < watermark; k++) sim.PushSample(k, -k, 256000);
+    Measure(r_vec, [&]() {
+      auto v = adxl.GetAccFifo(1e9);
+      for (auto& e : v) adxl.AccPushBack(e);
+      return v.size();
+    });
+  }
+
+  printf("adxl355 acquisition, %d samples\n", samples);
+  Print("GetAcc(frame)", r_frame);
+  Print("GetAcc()", r_acc);
+  Print("GetAccFifo(span)", r_span);
+  Print("GetAccFifo() -> vector", r_vec);
+
+  if (r_frame.allocs != 0 || r_acc.allocs != 0 || r_span.allocs != 0) {
+    printf("[FAIL] sample path allocates\n");
+    failed++;
+  } else {
+    printf("[PASS] zero allocation per sample\n");
+  }
+
+  return failed;
+}
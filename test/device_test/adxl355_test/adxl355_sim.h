@@ -0,0 +1,141 @@
+#ifndef LRA_TEST_ADXL355_SIM_H_
+#define LRA_TEST_ADXL355_SIM_H_
+
+// Simulated ADXL355 register file and FIFO, plug into SpiInit_S::mock_xfer_ to run Adxl355 without the Pi
+
+#include <linux/spi/spidev.h>
+
+#include <array>
+#include <cstdint>
+#include <deque>
+
+namespace lra::test {
+
+class Adxl355Sim {
+ public:
+  static constexpr uint8_t kStatus = 0x04;
+  static constexpr uint8_t kFifoEntries = 0x05;
+  static constexpr uint8_t kXdata3 = 0x08;
+  static constexpr uint8_t kFifoData = 0x11;
+  static constexpr uint8_t kReset = 0x2F;
+  static constexpr size_t kFifoMaxEntries = 96;
+
+  uint64_t xfer_count_{0};
+
+  Adxl355Sim() { Reset(); }
+
+  // one SPI_IOC_MESSAGE, every CS frame starts with cmd = addr << 1 | R/W, cs_change ends a frame
+  ssize_t Xfer(const spi_ioc_transfer* xfer, uint16_t n) {
+    xfer_count_++;
+    ssize_t total = 0;
+    bool frame_start = true;
+    uint8_t addr = 0;
+    bool read = false;
+
+    for (uint16_t i = 0; i < n; i++) {
+      auto tx = reinterpret_cast<const uint8_t*>(xfer[i].tx_buf);
+      auto rx = reinterpret_cast<uint8_t*>(xfer[i].rx_buf);
+
+      for (uint32_t b = 0; b < xfer[i].len; b++) {
+        uint8_t in = tx ? tx[b] : 0;
+        uint8_t out = 0;
+        if (frame_start) {
+          addr = in >> 1;
+          read = in & 0x01;
+          frame_start = false;
+        } else if (read) {
+          out = (addr == kFifoData) ? PopFifoByte() : ReadReg(addr++);
+        } else {
+          Store(addr++, in);
+        }
+        if (rx) rx[b] = out;
+      }
+
+      total += xfer[i].len;
+      if (xfer[i].cs_change) frame_start = true;
+    }
+    return total;
+  }
+
+  // push one sample (20 bits signed, LSB) into FIFO and data registers
+  void PushSample(int32_t x, int32_t y, int32_t z) {
+    const int32_t axes[3] = {x, y, z};
+    for (int i = 0; i < 3; i++) {
+      auto e = Encode(axes[i], i == 0);
+      for (int j = 0; j < 3; j++) regs_[kXdata3 + i * 3 + j] = e[j];
+      PushEntry(e);
+    }
+    regs_[kFifoEntries] = fifo_.size();
+  }
+
+  // push a single entry, used to make FIFO misaligned
+  void PushEntry(std::array<uint8_t, 3> e) {
+    if (fifo_.size() == kFifoMaxEntries) {  // overflow, drop oldest, STATUS FIFO_OVR until read
+      fifo_.pop_front();
+      regs_[kStatus] |= 0x04;
+    }
+    fifo_.push_back(e);
+    regs_[kFifoEntries] = fifo_.size();
+  }
+
+  static std::array<uint8_t, 3> Encode(int32_t val, bool x_marker) {
+    uint32_t u = static_cast<uint32_t>(val) & ((1 << 20) - 1);
+    return {static_cast<uint8_t>(u >> 12), static_cast<uint8_t>(u >> 4),
+            static_cast<uint8_t>(((u & 0x0F) << 4) | (x_marker ? 0x01 : 0x00))};
+  }
+
+  uint8_t Reg(uint8_t addr) { return regs_[addr & 0x3F]; }
+
+  size_t FifoSize() { return fifo_.size(); }
+
+ private:
+  std::array<uint8_t, 64> regs_{};
+  std::deque<std::array<uint8_t, 3>> fifo_{};
+  uint8_t fifo_byte_idx_{0};
+
+  void Reset() {
+    regs_.fill(0);
+    regs_[0x00] = 0xAD;
+    regs_[0x01] = 0x1D;
+    regs_[0x02] = 0xED;
+    regs_[0x03] = 0x01;
+    regs_[0x29] = 0x60;  // FIFO_SAMPLES
+    regs_[0x2C] = 0x81;  // Range
+    regs_[0x2D] = 0x01;  // POWER_CTL, standby
+    fifo_.clear();
+    fifo_byte_idx_ = 0;
+  }
+
+  void Store(uint8_t addr, uint8_t val) {
+    if (addr == kReset) {
+      if (val == 0x52) Reset();
+      return;
+    }
+    if (addr < 0x1E) return;  // read only
+    regs_[addr & 0x3F] = val;
+  }
+
+  // STATUS is cleared by reading it
+  uint8_t ReadReg(uint8_t addr) {
+    const uint8_t v = regs_[addr & 0x3F];
+    if ((addr & 0x3F) == kStatus) regs_[kStatus] = 0;
+    return v;
+  }
+
+  // empty FIFO returns entries with empty indicator
+  uint8_t PopFifoByte() {
+    if (fifo_.empty()) return (fifo_byte_idx_ = (fifo_byte_idx_ + 1) % 3) == 0 ? 0x02 : 0x00;
+
+    uint8_t b = fifo_.front()[fifo_byte_idx_++];
+    if (fifo_byte_idx_ == 3) {
+      fifo_byte_idx_ = 0;
+      fifo_.pop_front();
+      regs_[kFifoEntries] = fifo_.size();
+    }
+    return b;
+  }
+};
+
+}  // namespace lra::test
+
+#endif
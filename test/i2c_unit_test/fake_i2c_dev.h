@@ -0,0 +1,172 @@
+#ifndef LRA_TEST_FAKE_I2C_DEV_H_
+#define LRA_TEST_FAKE_I2C_DEV_H_
+
+// fake /dev/i2c-X for I2cInit_S::mock_ioctl_: one TCA9548A (0x70) and three DRV2605L (0x5A) behind channels 7/4/3
+// counts every ioctl, handles I2C_FUNCS, I2C_SLAVE, I2C_SMBUS (byte, i2c block) and I2C_RDWR (with I2C_M_STOP)
+
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+struct FakeI2cDev {
+  static constexpr uint16_t kTcaAddr = 0x70;
+  static constexpr uint16_t kDrvAddr = 0x5A;
+  static constexpr uint8_t kDrvRegs = 0x23;
+  static constexpr std::array<uint8_t, 3> kDrvCh{0x80, 0x10, 0x08};  // x, y, z
+
+  bool mangling_{false};  // I2C_FUNC_PROTOCOL_MANGLING, bcm2835 doesn't have it
+
+  // TCA control register, the new value only takes effect on STOP
+  uint8_t tca_ctrl_{0};
+  int16_t tca_pending_{-1};
+
+  std::array<std::array<uint8_t, kDrvRegs>, 3> drv_regs_{};
+  std::array<uint8_t, 3> drv_ptr_{};
+
+  // autocalibration (MODE 0x07 + GO) keeps GO set for this many GO reads
+  uint16_t cal_go_reads_{3};
+  std::array<uint16_t, 3> cal_left_{};
+
+  uint16_t slave_{0};
+
+  // counters
+  uint64_t ioctls_{0};
+  uint64_t rdwr_{0};
+  uint64_t smbus_{0};
+  uint64_t slave_switch_{0};
+  uint64_t nack_{0};
+
+  void ResetCounters() { ioctls_ = rdwr_ = smbus_ = slave_switch_ = nack_ = 0; }
+
+  int Ioctl(unsigned long request, void* arg) {
+    ioctls_++;
+    switch (request) {
+      case I2C_FUNCS: {
+        uint64_t funcs = I2C_FUNC_I2C | I2C_FUNC_SMBUS_BYTE | I2C_FUNC_SMBUS_I2C_BLOCK;
+        if (mangling_) funcs |= I2C_FUNC_PROTOCOL_MANGLING;
+        *static_cast<uint64_t*>(arg) = funcs;
+        return 0;
+      }
+      case I2C_SLAVE:
+        slave_switch_++;
+        slave_ = (uint16_t)(unsigned long)arg;
+        return 0;
+      case I2C_SMBUS:
+        smbus_++;
+        return Smbus(static_cast<i2c_smbus_ioctl_data*>(arg));
+      case I2C_RDWR:
+        rdwr_++;
+        return Rdwr(static_cast<i2c_rdwr_ioctl_data*>(arg));
+      default:
+        return -1;
+    }
+  }
+
+ private:
+  void Stop() {
+    if (tca_pending_ >= 0) tca_ctrl_ = tca_pending_;
+    tca_pending_ = -1;
+  }
+
+  // every enabled drv sees a write, a read needs exactly one
+  bool Write(uint16_t addr, const uint8_t* buf, uint16_t len) {
+    if (len == 0) return true;
+    if (addr == kTcaAddr) {
+      tca_pending_ = buf[len - 1];
+      return true;
+    }
+    if (addr != kDrvAddr) return false;
+
+    bool acked = false;
+    for (size_t d = 0; d < kDrvCh.size(); d++) {
+      if (!(tca_ctrl_ & kDrvCh[d])) continue;
+      acked = true;
+      drv_ptr_[d] = buf[0];
+      for (uint16_t i = 1; i < len; i++) {
+        uint8_t reg = (drv_ptr_[d]++) % kDrvRegs;
+        drv_regs_[d][reg] = buf[i];
+        if (reg == 0x0c && (buf[i] & 0x01) && (drv_regs_[d][0x01] & 0x07) == 0x07) cal_left_[d] = cal_go_reads_;
+      }
+    }
+    return acked;
+  }
+
+  bool Read(uint16_t addr, uint8_t* buf, uint16_t len) {
+    if (addr == kTcaAddr) {
+      memset(buf, tca_ctrl_, len);
+      return true;
+    }
+    if (addr != kDrvAddr) return false;
+
+    int sel = -1;
+    for (size_t d = 0; d < kDrvCh.size(); d++) {
+      if (!(tca_ctrl_ & kDrvCh[d])) continue;
+      if (sel >= 0) return false;  // two drivers on one bus, contention
+      sel = d;
+    }
+    if (sel < 0) return false;
+
+    for (uint16_t i = 0; i < len; i++) {
+      uint8_t reg = (drv_ptr_[sel]++) % kDrvRegs;
+      if (reg == 0x0c && cal_left_[sel] && --cal_left_[sel] == 0) drv_regs_[sel][reg] = 0;  // GO cleared when done
+      buf[i] = drv_regs_[sel][reg];
+    }
+    return true;
+  }
+
+  int Rdwr(i2c_rdwr_ioctl_data* data) {
+    int ret = data->nmsgs;
+    for (uint32_t i = 0; i < data->nmsgs; i++) {
+      i2c_msg& m = data->msgs[i];
+      if ((m.flags & I2C_M_STOP) && !mangling_) {
+        ret = -1;
+        break;
+      }
+
+      bool ok = (m.flags & I2C_M_RD) ? Read(m.addr, m.buf, m.len) : Write(m.addr, m.buf, m.len);
+      if (!ok) {
+        nack_++;
+        ret = -1;
+        break;
+      }
+      if (m.flags & I2C_M_STOP) Stop();
+    }
+    Stop();
+    return ret;
+  }
+
+  int Smbus(i2c_smbus_ioctl_data* args) {
+    bool ok = false;
+    const bool rd = args->read_write == I2C_SMBUS_READ;
+
+    switch (args->size) {
+      case I2C_SMBUS_BYTE:
+        ok = rd ? Read(slave_, &args->data->byte, 1) : Write(slave_, &args->command, 1);
+        break;
+      case I2C_SMBUS_I2C_BLOCK_BROKEN:
+      case I2C_SMBUS_I2C_BLOCK_DATA: {
+        uint8_t* block = args->data->block;
+        if (rd) {
+          ok = Write(slave_, &args->command, 1) && Read(slave_, block + 1, block[0]);
+        } else {
+          uint8_t buf[I2C_SMBUS_BLOCK_MAX + 1];
+          buf[0] = args->command;
+          memcpy(buf + 1, block + 1, block[0]);
+          ok = Write(slave_, buf, block[0] + 1);
+        }
+        break;
+      }
+      default:
+        break;
+    }
+
+    if (!ok) nack_++;
+    Stop();
+    return ok ? 0 : -1;
+  }
+};
+
+#endif
@@ -0,0 +1,283 @@
+// Controller's DRV2605L triplet paths on a fake i2c-dev (TCA9548A + 3 x DRV2605L) and a simulated ADXL355:
+// one I2cBatch / broadcast per operation vs the per-register smbus path they replaced
+// usage: lra_i2c_batch_bench [iterations]
+
+#include <controller/controller.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "common/check.h"
+#include "device_test/adxl355_test/adxl355_sim.h"
+#include "fake_i2c_dev.h"
+
+using lra::bus::I2c;
+using lra::bus::I2cBatch;
+using lra::bus::I2cInit_S;
+using lra::bus_adapter::i2c::I2cAdapter_S;
+using lra::controller::Controller;
+using lra::controller::ControllerInit_S;
+using lra::device::Adxl355;
+using lra::device::Drv2605l;
+using lra::device::Drv2605lRtInfo;
+using lra::device::I2cDeviceInfo;
+using lra::device::Tca9548a;
+using lra::interrupt_util::SimIrq;
+using lra::test::Adxl355Sim;
+using lra::test::Check;
+using lra::test::failed;
+
+// real Controller on fake buses, Init() runs the broadcast LRA defaults and the parallel calibration
+struct Rig {
+  FakeI2cDev dev;
+  Adxl355Sim acc;
+  std::mutex acc_mutex;  // measure thread and test thread share the simulated spidev
+  bool feed{true};       // keep the FIFO over the watermark while measuring
+  std::unique_ptr<Controller> controller;
+
+  explicit Rig(bool mangling) {
+    dev.mangling_ = mangling;
+
+    ControllerInit_S init_s;
+    init_s.i2c_ = I2cInit_S{.name_ = "/dev/i2c-fake",
+                            .mock_ioctl_ = [this](unsigned long req, void* arg) { return dev.Ioctl(req, arg); }};
+    init_s.spi_.name_ = "spi_sim";
+    init_s.spi_.mock_xfer_ = [this](const spi_ioc_transfer* xfer, uint16_t n) {
+      std::lock_guard<std::mutex> lock(acc_mutex);
+      Feed();
+      return acc.Xfer(xfer, n);
+    };
+    init_s.acc_irq_ = std::make_shared<SimIrq>(4000.0 / Adxl355::kFifoDefaultWatermark);  // FIFO full at 4 kHz ODR
+
+    controller = std::make_unique<Controller>(init_s);
+    controller->Init();
+    Seed(dev);
+  }
+
+  // 1 g on z, POWER_CTL standby bit clear means measuring
+  void Feed() {
+    if (!feed || (acc.Reg(0x2D) & 0x01)) return;
+    while (acc.FifoSize() < Adxl355::kFifoDefaultWatermark * Adxl355::kFifoEntriesPerSample)
+      acc.PushSample(0, 0, 256000);
+  }
+
+  static void Seed(FakeI2cDev& dev) {
+    for (int i = 0; i < 3; i++) {
+      dev.drv_regs_[i][0x02] = 0x10 * (i + 1);  // RTP_INPUT
+      dev.drv_regs_[i][0x22] = 0x30 + i;        // LRA_PERIOD
+    }
+  }
+
+  Drv2605l& Drv(int i) { return i == 0 ? *controller->drv_x_ : i == 1 ? *controller->drv_y_ : *controller->drv_z_; }
+};
+
+// per-register smbus path, one mux write + one transfer per register and axis, baseline for values and ioctl count
+struct Legacy {
+  FakeI2cDev dev;
+  std::shared_ptr<I2c> bus{std::make_shared<I2c>()};
+  I2cDeviceInfo info_tca{.iaddr_bytes_ = 1, .addr_ = 0x70, .page_bytes_ = 16};
+  I2cDeviceInfo info_drv{.iaddr_bytes_ = 1, .addr_ = 0x5a, .page_bytes_ = 32};
+  Tca9548a tca{info_tca};
+  std::array<std::unique_ptr<Drv2605l>, 3> drv;
+
+  Legacy() {
+    bus->Init(I2cInit_S{.name_ = "/dev/i2c-fake",
+                        .mock_ioctl_ = [this](unsigned long req, void* arg) { return dev.Ioctl(req, arg); }});
+
+    I2cAdapter_S s;
+    s.bus_ = bus;
+    s.delay_ = 0;
+    s.method_ = I2c::I2cMethod::kSmbus;
+    tca.Init(s);
+    const char* names[3] = {"drv_x", "drv_y", "drv_z"};
+    for (int i = 0; i < 3; i++) {
+      drv[i] = std::make_unique<Drv2605l>(info_drv, names[i]);
+      drv[i]->Init(s);
+    }
+    for (int i = 0; i < 3; i++) {
+      Select(i);
+      drv[i]->SetToLraDefault();
+    }
+    Rig::Seed(dev);
+  }
+
+  void Select(int i) { tca.Write(tca.CONTROL, FakeI2cDev::kDrvCh[i]); }
+
+  std::array<Drv2605lRtInfo, 3> GetRt() {
+    std::array<Drv2605lRtInfo, 3> r;
+    for (int i = 0; i < 3; i++) {
+      Select(i);
+      r[i] = drv[i]->GetRt();
+    }
+    return r;
+  }
+
+  void UpdateAllRtp(const std::array<uint8_t, 3>& v) {
+    for (int i = 0; i < 3; i++) {
+      Select(i);
+      drv[i]->UpdateRTP(v[i]);
+    }
+  }
+
+  void Run(bool run) {
+    for (int i = 0; i < 3; i++) {
+      if (drv[i]->GetRun() == run) continue;
+      Select(i);
+      drv[i]->Run(run);
+    }
+  }
+};
+
+template <class F>
+static double Bench(FakeI2cDev& dev, int iters, F&& fn, double& ioctls_per_op) {
+  dev.ResetCounters();
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < iters; i++) fn(i);
+  auto t1 = std::chrono::steady_clock::now();
+  ioctls_per_op = (double)dev.ioctls_ / iters;
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / iters;
+}
+
+static void Report(const char* name, Legacy& legacy, Rig& rig, int iters, auto&& fl, auto&& fb) {
+  double il, ib;
+  double tl = Bench(legacy.dev, iters, fl, il);
+  double tb = Bench(rig.dev, iters, fb, ib);
+  printf("%-14s legacy: %5.1f ioctl/op %8.0f ns/op | batch: %5.1f ioctl/op %8.0f ns/op\n", name, il, tl, ib, tb);
+}
+
+int main(int argc, char** argv) {
+  const int iters = (argc > 1) ? atoi(argv[1]) : 20000;
+
+  for (bool mangling : {true, false}) {
+    printf("-- protocol mangling: %s\n", mangling ? "yes" : "no (split at mux writes)");
+    Legacy legacy;
+    Rig rig(mangling);
+    Controller& c = *rig.controller;
+
+    // Init(): broadcast SetDrvToLraDefault, then autocalibration on all three
+    bool same_regs = true;
+    for (int i = 0; i < 3; i++)  // up to LRA_PERIOD, which the fake seeds per driver
+      same_regs &= std::equal(rig.dev.drv_regs_[i].begin(), rig.dev.drv_regs_[i].begin() + 0x22,
+                              legacy.dev.drv_regs_[i].begin());
+    Check(same_regs && rig.dev.drv_regs_[2][0x01] == 0x45, "broadcast SetDrvToLraDefault reaches every driver");
+    Check(rig.dev.drv_regs_[0][0x0c] == 0 && rig.dev.drv_regs_[1][0x0c] == 0 && rig.dev.drv_regs_[2][0x0c] == 0 &&
+              !rig.Drv(0).GetRun(),
+          "autocalibration completes on GO clear and restores MODE");
+
+    auto rt_l = legacy.GetRt();
+    auto [rt_x, rt_y, rt_z] = c.GetRt();
+    const Drv2605lRtInfo rt_b[3] = {rt_x, rt_y, rt_z};
+    bool same = true;
+    for (int i = 0; i < 3; i++) same &= rt_l[i].rtp_ == rt_b[i].rtp_ && rt_l[i].lra_freq_ == rt_b[i].lra_freq_;
+    Check(same && rt_b[1].rtp_ == 0x20, "GetRt batch == legacy");
+
+    rig.dev.ResetCounters();
+    Check(c.UpdateAllRtp({0x7f, 0x40, 0x01}), "UpdateAllRtp committed");
+    Check(rig.dev.drv_regs_[0][0x02] == 0x7f && rig.dev.drv_regs_[1][0x02] == 0x40 && rig.dev.drv_regs_[2][0x02] == 0x01,
+          "UpdateAllRtp batch lands on each channel");
+    Check(rig.dev.ioctls_ <= (mangling ? 1u : 4u), "UpdateAllRtp ioctl count");
+
+    rig.dev.ResetCounters();
+    c.RunDrv();
+    bool running = true;
+    for (int i = 0; i < 3; i++)
+      running &= rig.Drv(i).GetRun() && !(rig.dev.drv_regs_[i][0x01] & 0x40) && rig.dev.drv_regs_[i][0x0c] == 1;
+    Check(running, "Run broadcast clears standby and sets GO");
+    Check(rig.dev.ioctls_ <= (mangling ? 1u : 2u), "Run broadcast ioctl count");
+    c.PauseDrv();
+    Check(!rig.Drv(2).GetRun() && (rig.dev.drv_regs_[2][0x01] & 0x40), "Pause broadcast");
+
+    // modes differ -> per-axis batch
+    c.UpdateRegisters<void>("drv_y", std::vector<uint8_t>(Drv2605l::LRA_PERIOD.addr_, 0x43));
+    rig.dev.ResetCounters();
+    c.RunDrv();
+    Check(rig.Drv(1).GetRun() && rig.dev.ioctls_ == (mangling ? 1u : 4u) && rig.dev.drv_regs_[1][0x01] == 0x03 &&
+              rig.dev.drv_regs_[0][0x01] == 0x05,
+          "Run falls back to per-axis when MODE differs");
+    c.PauseDrv();
+    rig.dev.ResetCounters();
+    c.UpdateAllRtp({0, 0, 0});
+    Check(rig.dev.drv_regs_[0][0x02] == 0 && rig.dev.drv_regs_[1][0x02] == 0 && rig.dev.drv_regs_[2][0x02] == 0 &&
+              rig.dev.ioctls_ <= (mangling ? 1u : 2u),
+          "UpdateAllRtp broadcasts identical values");
+    Check(rig.dev.nack_ == 0, "no NACK on batch paths");
+
+    // calibrationRequire: Controller::RunCalibration with the measure thread running
+    rig.dev.cal_go_reads_ = 60;  // GO polled every 5 ms, ~0.3 s
+    auto cal = std::async(std::launch::async, [&c]() {
+      bool acc_ok = false;
+      auto r = c.RunCalibration(&acc_ok);
+      return std::make_pair(acc_ok, r);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    Check(c.UpdateAllRtp({0x11, 0x11, 0x11}) && cal.wait_for(std::chrono::seconds(0)) == std::future_status::timeout,
+          "drv access not held off while calibrating");
+    auto [acc_ok, cal_res] = cal.get();
+    auto [cal_x, cal_y, cal_z, cal_acc] = cal_res;
+    bool cal_done =
+        acc_ok && cal_x.calibration_time_s_ > 0 && cal_y.calibration_time_s_ > 0 && cal_z.calibration_time_s_ > 0;
+    for (int i = 0; i < 3; i++)  // MODE back from auto calibration (7)
+      cal_done &= rig.dev.drv_regs_[i][0x0c] == 0 && (rig.dev.drv_regs_[i][0x01] & 0x07) != 0x07;
+    Check(cal_done, "autocalibration on all three, GO cleared, MODE restored");
+    auto offset = c.adxl_->GetOffSet();
+    Check(std::isfinite(cal_acc.data.z) && std::fabs(offset.data.z - cal_acc.data.z) < 1e-3, "acc offset written");
+
+    {  // no acc sample (irq / spi dead): error, old offset kept
+      std::lock_guard<std::mutex> lock(rig.acc_mutex);
+      rig.feed = false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));  // measure thread drains what is left in the FIFO
+    std::vector<Adxl355::Acc3> stale(Adxl355::kAccRingCapacity);
+    c.adxl_->AccPopInto(std::span(stale));
+    std::tie(cal_x, cal_y, cal_z, cal_acc) = c.RunCalibration(&acc_ok);
+    auto kept = c.adxl_->GetOffSet();
+    Check(!acc_ok && kept.data.x == offset.data.x && kept.data.y == offset.data.y && kept.data.z == offset.data.z &&
+              cal_acc.data.z == offset.data.z,
+          "acc timeout: error returned, offset kept");
+    {
+      std::lock_guard<std::mutex> lock(rig.acc_mutex);
+      rig.feed = true;
+    }
+
+    // mux channel cache
+    c.ChangeDrvCh('z');
+    auto [writes, skips] = c.GetMuxWriteCount();
+    c.ChangeDrvCh('z');
+    c.ChangeDrvCh('x');
+    c.ChangeDrvCh('x');
+    auto [writes_after, skips_after] = c.GetMuxWriteCount();
+    Check(writes_after - writes == 1 && skips_after - skips == 2 && rig.dev.tca_ctrl_ == FakeI2cDev::kDrvCh[0],
+          "ChangeDrvCh writes CONTROL only on change");
+
+    Tca9548a& tca = legacy.tca;
+    I2cBatch batch;
+    tca.Select(FakeI2cDev::kDrvCh[0]);
+    tca.QueueSelect(batch, FakeI2cDev::kDrvCh[0]);
+    Check(batch.Empty(), "QueueSelect skips the selected channel");
+    tca.Select(FakeI2cDev::kDrvCh[0] | FakeI2cDev::kDrvCh[1] | FakeI2cDev::kDrvCh[2]);
+    uint8_t go = 1;
+    legacy.drv[0]->Write(legacy.drv[0]->GO.addr_, &go, 1);
+    Check(legacy.dev.drv_regs_[0][0x0c] == 1 && legacy.dev.drv_regs_[1][0x0c] == 1 &&
+              legacy.dev.drv_regs_[2][0x0c] == 1,
+          "multi-channel Select broadcasts a write");
+    tca.Write(tca.CONTROL, FakeI2cDev::kDrvCh[1]);
+    Check(tca.GetSelect() == -1, "raw CONTROL write invalidates the cache");
+    go = 0;
+    legacy.drv[1]->Write(legacy.drv[1]->GO.addr_, &go, 1);
+
+    // timing, the fake has no bus time, so ns/op is syscall-free overhead only, ioctl/op is what counts on hardware
+    Report("GetRt", legacy, rig, iters, [&](int) { legacy.GetRt(); }, [&](int) { c.GetRt(); });
+    Report("UpdateAllRtp", legacy, rig, iters, [&](int i) { legacy.UpdateAllRtp({(uint8_t)i, 0, 0}); },
+           [&](int i) { c.UpdateAllRtp({(uint8_t)i, 0, 0}); });
+    Report("Run/Pause", legacy, rig, iters, [&](int i) { legacy.Run(i & 1); },
+           [&](int i) { i & 1 ? c.RunDrv() : c.PauseDrv(); });
+  }
+
+  return failed;
+}
@@ -0,0 +1,87 @@
+// Event driven acquisition loop against SimIrq, reports CPU usage and edge to wakeup latency
+// usage: lra_interrupt_util_test [rate_hz] [seconds]
+
+#include <util/interrupt/interrupt.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+
+using ::lra::interrupt_util::MonotonicNs;
+using ::lra::interrupt_util::SimIrq;
+using ::lra::interrupt_util::WaitResult;
+
+static uint64_t ThreadCpuNs() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+int main(int argc, char* argv[]) {
+  double rate_hz = (argc > 1) ? atof(argv[1]) : 4000.0;
+  double seconds = (argc > 2) ? atof(argv[2]) : 2.0;
+  int failed = 0;
+
+  SimIrq irq(rate_hz, 20.0);
+  if (!irq.Open()) {
+    printf("[FAIL] SimIrq open\n");
+    return 1;
+  }
+
+  /* acquisition loop, same shape as Controller::AccMeasureTask */
+  std::atomic<bool> exit{false};
+  uint64_t cpu_ns = 0, wall_ns = 0, handled = 0;
+
+  std::thread t([&]() {
+    uint64_t cpu0 = ThreadCpuNs(), wall0 = MonotonicNs();
+    while (!exit) {
+      uint64_t n = 0;
+      if (irq.Wait(100, &n) != WaitResult::kEdge) continue;
+      handled += n;
+    }
+    cpu_ns = ThreadCpuNs() - cpu0;
+    wall_ns = MonotonicNs() - wall0;
+  });
+
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  exit = true;
+  irq.Wake();
+  t.join();
+
+  const auto& lat = irq.GetLatency();
+  printf("rate: %.0f Hz, fired: %lu, edges: %lu, missed: %lu\n", rate_hz, irq.GetFiredCount(), irq.GetEdgeCount(),
+         irq.GetMissedCount());
+  printf("cpu: %.2f %% of one core\n", 100.0 * cpu_ns / wall_ns);
+  printf("latency (us): min %.1f, mean %.1f, p50 %.1f, p99 %.1f, max %.1f\n", lat.Min() / 1e3, lat.Mean() / 1e3,
+         lat.Percentile(50) / 1e3, lat.Percentile(99) / 1e3, lat.Max() / 1e3);
+
+  if (handled == 0 || handled + 1 < irq.GetFiredCount()) {
+    printf("[FAIL] edges lost: handled %lu of %lu\n", handled, irq.GetFiredCount());
+    failed++;
+  }
+
+  /* timeout path, slow generator */
+  irq.Close();
+  SimIrq idle(1.0);
+  idle.Open();
+  idle.Wait(2000);  // consume first edge
+  uint64_t t0 = MonotonicNs();
+  auto rtn = idle.Wait(50);
+  uint64_t dt_ms = (MonotonicNs() - t0) / 1000000;
+  bool timeout_ok = (rtn == WaitResult::kTimeout) && dt_ms >= 45 && idle.GetTimeoutCount() == 1;
+  printf("[%s] timeout after %lu ms\n", timeout_ok ? "PASS" : "FAIL", dt_ms);
+  failed += !timeout_ok;
+
+  /* wake path */
+  std::thread waker([&idle]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    idle.Wake();
+  });
+  bool wake_ok = (idle.Wait(-1) == WaitResult::kWoken);
+  waker.join();
+  printf("[%s] woken by Wake()\n", wake_ok ? "PASS" : "FAIL");
+  failed += !wake_ok;
+
+  return failed;
+}
@@ -0,0 +1,242 @@
+// AsyncLog: p99 / max latency of log calls from several threads at once (a log storm) against synchronous _mt
+// loggers, with a file sink that stalls now and then as an SD card does; overflow policies and what reaches the file
+// usage: lra_async_log_bench [calls per thread] [threads]
+
+#include <spdlog/sinks/base_sink.h>
+#include <spdlog/sinks/basic_file_sink.h>
+#include <unistd.h>
+#include <util/log/async_log.h>
+#include <util/log/logunit.h>
+#include <util/stats/stats.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/check.h"
+
+using lra::log_util::AsyncLog;
+using lra::log_util::AsyncLogInit_S;
+using lra::log_util::LogOverflow;
+using lra::log_util::LogUnit;
+using lra::log_util::loglevel;
+using lra::stats_util::LatencyHistogram;
+using lra::test::Check;
+using lra::test::failed;
+
+// file sink, every stall_every_ messages the write takes stall_us_ longer (SD card erase / journal commit)
+class StallingFileSink : public spdlog::sinks::base_sink<std::mutex> {
+ public:
+  StallingFileSink(const std::string& path, int stall_every, int stall_us)
+      : stall_every_(stall_every), stall_us_(stall_us) {
+    file_.open(path, true);
+  }
+
+ protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override {
+    spdlog::memory_buf_t formatted;
+    formatter_->format(msg, formatted);
+    file_.write(formatted);
+    if (++n_ % stall_every_ == 0) std::this_thread::sleep_for(std::chrono::microseconds(stall_us_));
+  }
+  void flush_() override { file_.flush(); }
+
+ private:
+  spdlog::details::file_helper file_;
+  int stall_every_;
+  int stall_us_;
+  uint64_t n_{0};
+};
+
+struct StormResult {
+  LatencyHistogram call_;
+  double wall_ms_{0};
+};
+
+// every thread logs calls messages back to back, each call timed
+static void Storm(LogUnit& unit, int threads, int calls, StormResult& res, int64_t budget_ns = -1) {
+  std::vector<std::thread> ts;
+  const auto t0 = std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; t++) {
+    ts.emplace_back([&, t] {
+      AsyncLog::SetThreadBudget(budget_ns);
+      for (int i = 0; i < calls; i++) {
+        const auto c0 = std::chrono::steady_clock::now();
+        unit.LogToLoggers(loglevel::info, "thread {} seq {} acc x: {:.4f}, y: {:.4f}, z: {:.4f}", t, i, 0.001 * i,
+                          -0.002 * i, 1.0 + 0.0001 * i);
+        res.call_.Record(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - c0).count());
+      }
+    });
+  }
+  for (auto& th : ts) th.join();
+  res.wall_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void Print(const char* name, const StormResult& res) {
+  printf("%-28s p50 %7lu ns, p99 %8lu ns, max %9lu ns, %8.1f ms\n", name, res.call_.Percentile(50),
+         res.call_.Percentile(99), res.call_.Max(), res.wall_ms_);
+}
+
+// lines of the file, per thread the seq numbers have to come in order
+static bool ReadBack(const std::string& path, int threads, size_t& lines) {
+  std::ifstream in(path);
+  std::vector<long> last(threads, -1);
+  std::string line;
+  bool ordered = true;
+  lines = 0;
+  while (std::getline(in, line)) {
+    int t;
+    long seq;
+    if (sscanf(line.c_str(), "thread %d seq %ld", &t, &seq) == 2 && t >= 0 && t < threads) {
+      ordered = ordered && seq > last[t];
+      last[t] = seq;
+      lines++;
+    }
+  }
+  return ordered;
+}
+
+static std::shared_ptr<spdlog::logger> MakeLogger(const std::string& name, const std::string& path) {
+  std::remove(path.c_str());
+  auto logger = std::make_shared<spdlog::logger>(name, std::make_shared<StallingFileSink>(path, 2000, 5000));
+  logger->set_pattern("%v");
+  spdlog::register_logger(logger);
+  return logger;
+}
+
+int main(int argc, char** argv) {
+  const int calls = (argc > 1) ? atoi(argv[1]) : 20000;
+  const int threads = (argc > 2) ? atoi(argv[2]) : 4;
+  const std::string dir = "/tmp/lra_async_log_bench_" + std::to_string(getpid());
+  const std::string path = dir + ".log";
+  const size_t total = static_cast<size_t>(calls) * threads;
+
+  printf("%d threads x %d calls, file sink stalls 5 ms every 2000 writes\n", threads, calls);
+
+  auto unit = LogUnit::CreateLogUnit("bench");
+  size_t lines;
+
+  /* synchronous: every call takes the sink mutex, a stall holds up all threads */
+  StormResult sync_res;
+  {
+    auto logger = MakeLogger("storm_sync", path);
+    unit->AddLogger(logger);
+    Storm(*unit, threads, calls, sync_res);
+    logger->flush();
+    unit->RemoveLogger(logger);
+    spdlog::drop("storm_sync");
+  }
+  Print("sync (_mt sink)", sync_res);
+
+  /* kBlock, ring big enough: nothing dropped, calls only format */
+  StormResult block_res;
+  {
+    auto logger = MakeLogger("storm_block", path);
+    unit->AddLogger(logger);
+    AsyncLog::Start(AsyncLogInit_S{.capacity_ = 1 << 16, .overflow_ = LogOverflow::kBlock});
+    Storm(*unit, threads, calls, block_res);
+    AsyncLog::Stop();
+    logger->flush();
+    unit->RemoveLogger(logger);
+    spdlog::drop("storm_block");
+  }
+  Print("async kBlock (64k ring)", block_res);
+  const auto block_stats = AsyncLog::Instance().GetStats();
+  Check(ReadBack(path, threads, lines) && lines == total, "kBlock: every line written, in order per thread");
+  Check(block_stats.dropped_ == 0, "kBlock: nothing dropped");
+  Check(block_res.call_.Percentile(99) < sync_res.call_.Percentile(99), "kBlock: p99 below sync");
+
+  /* small ring under kBlock: callers wait for the writer, still lossless */
+  StormResult small_res;
+  {
+    auto logger = MakeLogger("storm_small", path);
+    unit->AddLogger(logger);
+    AsyncLog::Start(AsyncLogInit_S{.capacity_ = 256, .overflow_ = LogOverflow::kBlock});
+    Storm(*unit, threads, calls, small_res);
+    AsyncLog::Stop();
+    logger->flush();
+    unit->RemoveLogger(logger);
+    spdlog::drop("storm_small");
+  }
+  Print("async kBlock (256 ring)", small_res);
+  const auto small_stats = AsyncLog::Instance().GetStats();
+  printf("  blocked calls: %lu, wait p99: %lu ns\n", small_stats.blocked_ - block_stats.blocked_,
+         AsyncLog::Instance().GetBlockTime().Percentile(99));
+  Check(ReadBack(path, threads, lines) && lines == total, "kBlock small ring: every line written");
+
+  /* hot threads, budget 0: a full ring drops instead of waiting, the drops are counted */
+  StormResult hot_res;
+  {
+    auto logger = MakeLogger("storm_hot", path);
+    unit->AddLogger(logger);
+    AsyncLog::Start(AsyncLogInit_S{.capacity_ = 256, .overflow_ = LogOverflow::kBlock});
+    Storm(*unit, threads, calls, hot_res, 0);
+    AsyncLog::Stop();
+    logger->flush();
+    unit->RemoveLogger(logger);
+    spdlog::drop("storm_hot");
+  }
+  Print("async budget 0 (256 ring)", hot_res);
+  const auto hot_stats = AsyncLog::Instance().GetStats();
+  const uint64_t hot_dropped = hot_stats.dropped_ - small_stats.dropped_;
+  const uint64_t hot_written = hot_stats.written_ - small_stats.written_;
+  printf("  written: %lu, dropped: %lu\n", hot_written, hot_dropped);
+  Check(ReadBack(path, threads, lines) && lines == hot_written && hot_written + hot_dropped == total,
+        "budget 0: written + dropped == calls, in order per thread");
+  Check(hot_stats.blocked_ == small_stats.blocked_, "budget 0: no call waited");
+  Check(hot_res.call_.Max() < sync_res.call_.Max(), "budget 0: max below sync (no call sees a sink stall)");
+
+  /* thread id and time of the call are kept */
+  {
+    const std::string tid_path = dir + "_tid.log";
+    auto logger = MakeLogger("tid", tid_path);
+    logger->set_pattern("%t %v");
+    unit->AddLogger(logger);
+    AsyncLog::Start(AsyncLogInit_S{});
+    size_t tid = 0;
+    std::thread([&] {
+      tid = spdlog::details::os::thread_id();
+      unit->LogToLoggers(loglevel::info, "from another thread");
+    }).join();
+    AsyncLog::Stop();
+    logger->flush();
+    unit->RemoveLogger(logger);
+    spdlog::drop("tid");
+
+    std::ifstream in(tid_path);
+    std::string line;
+    std::getline(in, line);
+    Check(line == std::to_string(tid) + " from another thread", "thread id of the call, not of the writer");
+    std::remove(tid_path.c_str());
+  }
+
+  /* long messages are cut at kTextMax */
+  {
+    auto logger = MakeLogger("long", path);
+    unit->AddLogger(logger);
+    AsyncLog::Start(AsyncLogInit_S{});
+    const uint64_t before = AsyncLog::Instance().GetStats().truncated_;
+    unit->LogToLoggers(loglevel::info, "{}", std::string(2000, 'x'));
+    AsyncLog::Stop();
+    logger->flush();
+    unit->RemoveLogger(logger);
+    spdlog::drop("long");
+
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    Check(line.size() == AsyncLog::kTextMax && AsyncLog::Instance().GetStats().truncated_ == before + 1,
+          "message cut at kTextMax, counted");
+  }
+
+  std::remove(path.c_str());
+
+  printf("%s (%d failed)\n", failed ? "FAILED" : "ALL PASSED", failed);
+  return failed;
+}
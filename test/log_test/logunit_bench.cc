@@ -0,0 +1,115 @@
+// LogUnit: cost of disabled / enabled log calls, against the old path (location string + spdlog::get per call),
+// and the filter / logger cache staying right after level changes
+// usage: lra_logunit_bench [calls]
+
+#include <spdlog/sinks/null_sink.h>
+#include <spdlog/sinks/ostream_sink.h>
+#include <util/log/logunit.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+
+#include "common/check.h"
+
+using lra::log_util::LogUnit;
+using lra::log_util::loglevel;
+using lra::test::Check;
+using lra::test::failed;
+
+// what LogToLoggers() did per call before the logger / location cache
+static void LegacyLogToLoggers(const std::string& unit_name, const std::vector<std::string>& loggers, loglevel level,
+                               int v, const std::experimental::source_location& loc =
+                                          std::experimental::source_location::current()) {
+  std::string new_function_name = spdlog::fmt_lib::format("{} -> {}", loc.function_name(), unit_name);
+  for (const auto& name : loggers) {
+    if (auto logger = spdlog::get(name); logger != nullptr) {
+      if (logger->level() > level) continue;
+      logger->log(spdlog::source_loc{loc.file_name(), (int)loc.line(), new_function_name.c_str()}, level, "{}", v);
+    }
+  }
+}
+
+template <typename F>
+static double NsPerCall(int calls, F&& f) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < calls; i++) f(i);
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / calls;
+}
+
+int main(int argc, char** argv) {
+  const int calls = (argc > 1) ? atoi(argv[1]) : 1000000;
+
+  auto null_logger = std::make_shared<spdlog::logger>("bench_null", std::make_shared<spdlog::sinks::null_sink_mt>());
+  null_logger->set_level(loglevel::info);
+  spdlog::register_logger(null_logger);
+
+  auto unit = LogUnit::CreateLogUnit("bench");
+  unit->AddLogger(null_logger);
+  const std::vector<std::string> names{"bench_null"};
+
+  /* disabled: below the logger level */
+  const double legacy_off = NsPerCall(calls, [&](int i) { LegacyLogToLoggers(unit->getName(), names, loglevel::debug, i); });
+  const double off = NsPerCall(calls, [&](int i) { unit->LogToLoggers(loglevel::debug, "{}", i); });
+  printf("disabled: %.1f ns -> %.1f ns per call\n", legacy_off, off);
+  Check(off * 5 < legacy_off, "disabled call skips formatting and the registry");
+
+  /* enabled, null sink */
+  const double legacy_on = NsPerCall(calls, [&](int i) { LegacyLogToLoggers(unit->getName(), names, loglevel::info, i); });
+  const double on = NsPerCall(calls, [&](int i) { unit->LogToLoggers(loglevel::info, "{}", i); });
+  printf("enabled:  %.1f ns -> %.1f ns per call\n", legacy_on, on);
+  Check(on < legacy_on, "enabled call cheaper");
+
+  /* sink level raises the effective level */
+  std::ostringstream oss;
+  auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(oss);
+  sink->set_pattern("%! %v");
+  sink->set_level(loglevel::warn);
+  auto os_logger = std::make_shared<spdlog::logger>("bench_os", sink);
+  os_logger->set_level(loglevel::trace);
+  spdlog::register_logger(os_logger);
+
+  auto unit2 = LogUnit::CreateLogUnit("bench2");
+  unit2->AddLogger("bench_os");
+  Check(!unit2->ShouldLogToLoggers(loglevel::info) && unit2->ShouldLogToLoggers(loglevel::warn),
+        "effective level = max(logger, lowest sink)");
+
+  unit2->LogToLoggers(loglevel::warn, "hello {}", 1);
+  Check(oss.str().find(" -> " + unit2->getName() + " hello 1") != std::string::npos, "location names the unit");
+
+  /* location cache is per thread and per unit: same function, another thread, another unit */
+  auto unit3 = LogUnit::CreateLogUnit("bench3");
+  unit3->AddLogger("bench_os");
+  oss.str("");
+  std::thread([&] {
+    unit2->LogToLoggers(loglevel::warn, "hello {}", 2);
+    unit3->LogToLoggers(loglevel::warn, "hello {}", 3);
+  }).join();
+  Check(oss.str().find(" -> " + unit2->getName() + " hello 2") != std::string::npos &&
+            oss.str().find(" -> " + unit3->getName() + " hello 3") != std::string::npos,
+        "location per unit from another thread");
+
+  sink->set_level(loglevel::info);
+  Check(!unit2->ShouldLogToLoggers(loglevel::info), "level change not seen before Refresh()");
+  LogUnit::RefreshAll();
+  Check(unit2->ShouldLogToLoggers(loglevel::info), "Refresh() picks it up");
+
+  spdlog::drop("bench_os");
+  unit2->Refresh();
+  Check(!unit2->ShouldLogToLoggers(loglevel::critical), "dropped logger removed on Refresh()");
+
+  unit2->AddLogger("not_registered");
+  Check(!unit2->ShouldLogToLoggers(loglevel::critical), "unknown logger name ignored");
+
+  spdlog::drop_all();  // resets the default logger too
+  Check(!LogUnit::ShouldLogToDefault(loglevel::critical), "no default logger after drop_all()");
+  unit2->LogToDefault(loglevel::critical, "to nowhere");
+  Check(true, "LogToDefault without a default logger returns");
+
+  LogUnit::DropAllLogUnits();
+
+  printf("%s (%d failed)\n", failed ? "FAILED" : "ALL PASSED", failed);
+  return failed;
+}
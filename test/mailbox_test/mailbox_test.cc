@@ -0,0 +1,115 @@
+// SeqlockMailbox: no torn reads under a busy writer; RtpActuator: immediate apply, coalescing, gate, latency trace
+// usage: lra_mailbox_test [rt_priority]
+
+#include <controller/rtp_actuator.h>
+#include <util/mailbox/mailbox.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "common/check.h"
+
+using lra::controller::RtpActuator;
+using lra::controller::RtpActuatorInit_S;
+using lra::mailbox_util::SeqlockMailbox;
+using lra::test::Check;
+using lra::test::failed;
+
+struct Quad {
+  uint64_t a, b, c, d;
+};
+
+int main(int argc, char** argv) {
+  /* mailbox */
+  {
+    SeqlockMailbox<Quad> box;
+    Quad q{};
+    Check(box.Read(q) == 0, "empty mailbox seq 0");
+
+    std::atomic<bool> stop{false};
+    std::thread writer([&]() {
+      for (uint64_t i = 1; !stop.load(std::memory_order_relaxed); i++) box.Publish(Quad{i, i, i, i});
+    });
+
+    uint64_t reads = 0, torn = 0, backwards = 0, last = 0;
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    while (std::chrono::steady_clock::now() < until) {
+      box.Read(q);
+      reads++;
+      if (q.a != q.b || q.b != q.c || q.c != q.d) torn++;
+      if (q.a < last) backwards++;
+      last = q.a;
+    }
+    stop = true;
+    writer.join();
+
+    printf("mailbox: %lu reads, last value %lu\n", reads, last);
+    Check(torn == 0, "no torn read");
+    Check(backwards == 0, "values never go back");
+  }
+
+  /* actuator */
+  RtpActuatorInit_S init_s;
+  init_s.rt_priority_ = (argc > 1) ? atoi(argv[1]) : 0;
+
+  std::atomic<int> apply_us{200};  // one batched RTP write on the bus
+  std::atomic<bool> gate{true};
+  std::atomic<uint32_t> last_applied{0};
+
+  RtpActuator actuator;
+  Check(actuator.Start(
+            init_s,
+            [&](const std::array<uint8_t, 3>& rtp) {
+              std::this_thread::sleep_for(std::chrono::microseconds(apply_us.load()));
+              last_applied = rtp[0] | rtp[1] << 8 | rtp[2] << 16;
+              return true;
+            },
+            [&]() { return gate.load(); }),
+        "start");
+
+  // one command every 2 ms, each written right away
+  constexpr int kCmds = 200;
+  for (int i = 0; i < kCmds; i++) {
+    actuator.Submit({(uint8_t)i, 1, 2});
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  auto& e2e = actuator.GetEndToEnd();
+  printf("spaced: applied %lu, e2e p50 %.1f us p99 %.1f us max %.1f us, wake p99 %.1f us, apply p99 %.1f us\n",
+         actuator.GetAppliedCount(), e2e.Percentile(50) / 1e3, e2e.Percentile(99) / 1e3, e2e.Max() / 1e3,
+         actuator.GetWakeLatency().Percentile(99) / 1e3, actuator.GetApplyTime().Percentile(99) / 1e3);
+  Check(actuator.GetAppliedCount() == kCmds && actuator.GetCoalescedCount() == 0, "every spaced command applied");
+  Check(e2e.Percentile(50) < 2000000, "median receive to write done well inside one 10 ms tick");
+
+  // burst while the bus is busy: only the newest is written after the running write
+  actuator.ResetStats();
+  apply_us = 5000;
+  for (int i = 0; i < 50; i++) actuator.Submit({(uint8_t)i, 3, 4});
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  printf("burst: applied %lu, coalesced %lu\n", actuator.GetAppliedCount(), actuator.GetCoalescedCount());
+  Check(actuator.GetCoalescedCount() > 0 && actuator.GetAppliedCount() + actuator.GetCoalescedCount() == 50,
+        "burst coalesced, nothing lost from the count");
+  Check(last_applied == (49u | 3u << 8 | 4u << 16), "newest command written last");
+
+  // gate closed (calibration): held, newest written once it opens
+  apply_us = 200;
+  gate = false;
+  const uint64_t before = actuator.GetAppliedCount();
+  actuator.Submit({7, 7, 7});
+  actuator.Submit({8, 8, 8});
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  Check(actuator.GetAppliedCount() == before, "held while gate closed");
+  gate = true;
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  Check(actuator.GetAppliedCount() == before + 1 && last_applied == (8u | 8u << 8 | 8u << 16),
+        "newest written after gate opens");
+
+  actuator.Stop();
+  Check(true, "stop joins");
+
+  return failed;
+}
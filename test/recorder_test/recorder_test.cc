@@ -0,0 +1,213 @@
+// Recorder: round trip of acc / drv style streams, size against the old JSON text log, truncated file, converters
+// usage: lra_recorder_test [seconds of 4 kHz acc]
+
+#include <spdlog/common.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <util/recorder/record_reader.h>
+#include <util/recorder/recorder.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/check.h"
+
+using lra::recorder_util::Column;
+using lra::recorder_util::ColumnType;
+using lra::recorder_util::RecordChunk;
+using lra::recorder_util::Recorder;
+using lra::recorder_util::RecorderInit_S;
+using lra::recorder_util::RecordReader;
+using lra::test::Check;
+using lra::test::failed;
+
+struct AccRow {
+  float t, x, y, z;
+};
+
+int main(int argc, char** argv) {
+  const int seconds = (argc > 1) ? atoi(argv[1]) : 60;
+  const float odr = 4000.0f;
+  const size_t n = static_cast<size_t>(seconds * odr);
+  const std::string dir = "/tmp/lra_recorder_test_" + std::to_string(getpid());
+  mkdir(dir.c_str(), 0755);
+  const std::string path = dir + "/acc_data.lrr";
+
+  // 50 Hz vibration + noise, 20 bit ADC steps of the 4 g range (as ADXL355)
+  std::mt19937 rng(1);
+  std::normal_distribution<float> noise(0.0f, 0.002f);
+  const float lsb = 8.192f / (1 << 20);
+  std::vector<AccRow> rows(n);
+  for (size_t i = 0; i < n; i++) {
+    const float t = i * (1e9f / odr);
+    auto q = [&](float v) { return std::round(v / lsb) * lsb; };
+    rows[i] = {t, q(0.3f * std::sin(2 * M_PI * 50 * i / odr) + noise(rng)),
+               q(0.1f * std::cos(2 * M_PI * 50 * i / odr) + noise(rng)), q(1.0f + noise(rng))};
+  }
+
+  /* write: 40 rows per 10 ms tick, as the control loop */
+  Recorder rec;
+  RecorderInit_S init_s{.path_ = path,
+                        .stream_ = "acc",
+                        .columns_ = {Column{"t", ColumnType::kF32}, Column{"x", ColumnType::kF32},
+                                     Column{"y", ColumnType::kF32}, Column{"z", ColumnType::kF32}},
+                        .odr_hz_ = odr,
+                        .range_g_ = 4.0f,
+                        .offset_g_ = {0.01f, -0.02f, 0.03f}};
+  Check(rec.Open(init_s), "open");
+
+  uint64_t append_ns = 0;
+  for (size_t i = 0; i < n; i += 40) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t k = i; k < std::min(n, i + 40); k++) rec.Append(rows[k].t, rows[k].x, rows[k].y, rows[k].z);
+    append_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+    if ((i / 40) % 20 == 0) usleep(100);  // let the writer keep up, as 10 ms ticks would
+  }
+  rec.Close();
+
+  // the same rows as the old acc_data.log text
+  const std::string acc_format_str = "{{\"t\": \"{:.4f}\", \"x\": \"{:.4f}\", \"y\": \"{:.4f}\", \"z\": \"{:.4f}\"}},";
+  size_t json_bytes = 0;
+  for (const auto& r : rows)
+    json_bytes += spdlog::fmt_lib::formatted_size(spdlog::fmt_lib::runtime(acc_format_str), r.t, r.x, r.y, r.z) + 1;
+
+  printf("%zu rows: append %.1f ns/row, dropped %lu, raw %lu B, file %lu B (%.2fx), old json text %zu B (%.1fx), "
+         "chunk write p99 %.2f ms\n",
+         n, (double)append_ns / n, rec.GetDroppedRows(), rec.GetRawBytes(), rec.GetStoredBytes(),
+         (double)rec.GetRawBytes() / rec.GetStoredBytes(), json_bytes, (double)json_bytes / rec.GetStoredBytes(),
+         rec.GetWriteTime().Percentile(99) / 1e6);
+  Check(rec.GetDroppedRows() == 0 && rec.GetRows() == n, "every row written");
+  Check(rec.GetStoredBytes() < rec.GetRawBytes(), "chunks compressed");
+
+  /* read back */
+  {
+    RecordReader reader;
+    Check(reader.Open(path), "reader open");
+    const auto& h = reader.Header();
+    Check(h.stream_ == "acc" && h.odr_hz_ == odr && h.range_g_ == 4.0f && h.offset_g_[2] == 0.03f &&
+              h.columns_.size() == 4 && h.columns_[3].name_ == "z",
+          "header schema / odr / range / offset");
+
+    auto t0 = std::chrono::steady_clock::now();
+    RecordChunk chunk;
+    size_t got = 0;
+    bool same = true;
+    while (reader.Next(chunk)) {
+      auto t = chunk.Values<float>(0), x = chunk.Values<float>(1), y = chunk.Values<float>(2),
+           z = chunk.Values<float>(3);
+      same = same && chunk.FirstRow() == got;
+      for (uint32_t r = 0; r < chunk.Rows(); r++, got++) {
+        same = same && t[r] == rows[got].t && x[r] == rows[got].x && y[r] == rows[got].y && z[r] == rows[got].z;
+      }
+    }
+    const double read_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    printf("read back %zu rows in %.1f ms\n", got, read_ms);
+    Check(got == n && same && reader.Error().empty(), "read back bit exact");
+  }
+
+  /* mixed column types, partial chunk on Close() */
+  {
+    const std::string drv_path = dir + "/drv_data.lrr";
+    Recorder drv;
+    drv.Open(RecorderInit_S{.path_ = drv_path,
+                            .stream_ = "drv",
+                            .columns_ = {Column{"t", ColumnType::kF64}, Column{"rtp_x", ColumnType::kU8},
+                                         Column{"freq_x", ColumnType::kF32}},
+                            .chunk_rows_ = 64});
+    for (int i = 0; i < 100; i++) drv.Append(i * 1e7, i % 128, 170.5f + i);
+    drv.Close();
+
+    RecordReader reader;
+    reader.Open(drv_path);
+    RecordChunk chunk;
+    size_t got = 0;
+    bool same = true;
+    while (reader.Next(chunk)) {
+      for (uint32_t r = 0; r < chunk.Rows(); r++, got++) {
+        same = same && chunk.Get(0, r) == got * 1e7 && chunk.Values<uint8_t>(1)[r] == got % 128 &&
+               chunk.Get(2, r) == 170.5f + got;
+      }
+    }
+    Check(got == 100 && same, "f64 / u8 / f32 columns, partial last chunk");
+
+    FILE* csv = tmpfile();
+    reader.Open(drv_path);
+    Check(WriteCsv(reader, csv), "csv written");
+    rewind(csv);
+    char line[128] = {};
+    fgets(line, sizeof(line), csv);
+    Check(std::string(line) == "t,rtp_x,freq_x\n", "csv header line");
+    fgets(line, sizeof(line), csv);
+    fgets(line, sizeof(line), csv);
+    Check(std::string(line) == "10000000,1,171.5\n", "csv row");
+    fclose(csv);
+
+    FILE* json = tmpfile();
+    reader.Open(drv_path);
+    Check(WriteJson(reader, json), "json written");
+    rewind(json);
+    std::string text(4096, '\0');
+    text.resize(fread(text.data(), 1, text.size(), json));
+    Check(text.starts_with("{\"stream\": \"drv\"") && text.find("\"drv\": [\n{\"t\": 0, \"rtp_x\": 0, \"freq_x\": 170.5}") !=
+                                                        std::string::npos,
+          "json rows");
+    fclose(json);
+  }
+
+  /* burst faster than the writer: a dropped row still takes its row number, the gap shows in first_row_ */
+  {
+    const std::string burst_path = dir + "/burst.lrr";
+    Recorder burst;
+    burst.Open(RecorderInit_S{.path_ = burst_path,
+                              .stream_ = "burst",
+                              .columns_ = {Column{"row", ColumnType::kI64}},
+                              .chunk_rows_ = 16});
+    constexpr int64_t kBurst = 200000;
+    for (int64_t i = 0; i < kBurst; i++) burst.Append(i);
+    burst.Close();
+
+    RecordReader reader;
+    reader.Open(burst_path);
+    RecordChunk chunk;
+    uint64_t got = 0, end = 0;
+    bool same = true;
+    while (reader.Next(chunk)) {
+      same = same && chunk.FirstRow() >= end;
+      for (uint32_t r = 0; r < chunk.Rows(); r++, got++)
+        same = same && chunk.Values<int64_t>(0)[r] == static_cast<int64_t>(chunk.FirstRow() + r);
+      end = chunk.FirstRow() + chunk.Rows();
+    }
+    printf("burst: %lu rows written, %lu dropped\n", got, burst.GetDroppedRows());
+    Check(same && got + burst.GetDroppedRows() == kBurst, "dropped rows leave a row number gap");
+    std::remove(burst_path.c_str());
+  }
+
+  /* crash mid write: everything up to the last complete chunk is readable */
+  {
+    FILE* f = fopen(path.c_str(), "rb");
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fclose(f);
+    truncate(path.c_str(), size - 100);
+
+    RecordReader reader;
+    reader.Open(path);
+    RecordChunk chunk;
+    size_t got = 0;
+    while (reader.Next(chunk)) got += chunk.Rows();
+    printf("truncated file: %zu rows, error: %.*s\n", got, (int)reader.Error().size(), reader.Error().data());
+    Check(got > 0 && got < n && !reader.Error().empty(), "truncated file reads up to the cut");
+  }
+
+  std::remove((dir + "/drv_data.lrr").c_str());
+  std::remove(path.c_str());
+  rmdir(dir.c_str());
+
+  printf("%s (%d failed)\n", failed ? "FAILED" : "ALL PASSED", failed);
+  return failed;
+}
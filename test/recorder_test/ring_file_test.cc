@@ -0,0 +1,282 @@
+// Recorder in ring file mode: fixed size, oldest blocks reused, time range extraction by the index, reopen,
+// recovery after a process crash (unsealed block) and after damage (power loss mid write)
+// usage: lra_ring_file_test
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <util/recorder/record_reader.h>
+#include <util/recorder/recorder.h>
+#include <util/recorder/ring_file.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "common/check.h"
+
+using lra::recorder_util::Column;
+using lra::recorder_util::ColumnType;
+using lra::recorder_util::RecordChunk;
+using lra::recorder_util::Recorder;
+using lra::recorder_util::RecorderInit_S;
+using lra::recorder_util::RecordReader;
+using lra::recorder_util::RingExtractStats;
+using lra::recorder_util::RingIndexEntry;
+using lra::recorder_util::RingReader;
+using lra::recorder_util::RingRun;
+using lra::test::Check;
+using lra::test::failed;
+
+static int64_t UnixNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+static off_t FileSize(const std::string& path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 ? st.st_size : -1;
+}
+
+// 16 blocks of 64 KiB, 1024 row chunks of (i64 row, f32 x, f32 y, f32 z), ~3 per block
+static RecorderInit_S RingInit(const std::string& path) {
+  return RecorderInit_S{.path_ = path,
+                        .stream_ = "acc",
+                        .columns_ = {Column{"row", ColumnType::kI64}, Column{"x", ColumnType::kF32},
+                                     Column{"y", ColumnType::kF32}, Column{"z", ColumnType::kF32}},
+                        .chunk_rows_ = 1024,
+                        .ring_bytes_ = 16 * 65536 + 8192,
+                        .ring_block_bytes_ = 65536,
+                        .odr_hz_ = 4000};
+}
+
+// row i has values derived from i, noisy enough to keep chunks near raw size
+static void AppendRows(Recorder& rec, uint64_t from, uint64_t n) {
+  for (uint64_t i = from; i < from + n; i++) {
+    const uint32_t h = static_cast<uint32_t>(i * 2654435761u);
+    rec.Append(static_cast<int64_t>(i), (h & 0xFFFF) * 1e-4f, (h >> 16) * 1e-4f, 1.0f + (h & 0xFF) * 1e-5f);
+  }
+}
+
+// extract [from_ns, to_ns] run by run and read it back: each file with its run's header, rows in order (a gap only
+// where rows were dropped), values as written
+static bool ExtractCheck(const std::string& ring, const std::string& out, int64_t from_ns, int64_t to_ns,
+                         RingExtractStats& stats, uint64_t& first, uint64_t& last,
+                         std::vector<RingRun>* runs_out = nullptr) {
+  RingReader reader;
+  if (!reader.Open(ring)) return false;
+  const std::vector<RingRun> runs = reader.Runs(from_ns, to_ns);
+  if (runs_out) *runs_out = runs;
+
+  RingExtractStats total;
+  bool same = true;
+  uint64_t rows = 0, expect = 0;
+  for (const RingRun& run : runs) {
+    FILE* f = fopen(out.c_str(), "wb");
+    const bool ok = reader.Extract(from_ns, to_ns, run, f, stats);
+    fclose(f);
+    if (!ok) return false;
+    total.chunks_ += stats.chunks_;
+    total.rows_ += stats.rows_;
+
+    RecordReader rr;
+    if (!rr.Open(out) || rr.Header().stream_ != "acc" || rr.Header().start_ns_ != run.start_ns_ ||
+        rr.Header().odr_hz_ != run.odr_hz_ || rr.Header().offset_g_[0] != run.offset_g_[0])
+      return false;
+    RecordChunk chunk;
+    while (rr.Next(chunk)) {
+      auto row = chunk.Values<int64_t>(0);
+      auto x = chunk.Values<float>(1);
+      for (uint32_t r = 0; r < chunk.Rows(); r++, rows++) {
+        const uint64_t i = row[r];
+        if (rows == 0) first = i;
+        else same = same && i >= expect;
+        same = same && x[r] == (static_cast<uint32_t>(i * 2654435761u) & 0xFFFF) * 1e-4f && chunk.FirstRow() + r == i;
+        expect = i + 1;
+        last = i;
+      }
+    }
+    same = same && rr.Error().empty();
+  }
+  stats = total;
+  return same && rows == stats.rows_;
+}
+
+int main() {
+  const std::string dir = "/tmp/lra_ring_test_" + std::to_string(getpid());
+  mkdir(dir.c_str(), 0755);
+  const std::string path = dir + "/acc_data.lrg";
+  const std::string out = dir + "/out.lrr";
+  RingExtractStats stats;
+  uint64_t first = 0, last = 0;
+
+  /* fill about twice: file size fixed, the newest rows kept */
+  int64_t t_mid = 0;
+  uint64_t rows_written = 0;
+  off_t size0 = 0;
+  {
+    Recorder rec;
+    Check(rec.Open(RingInit(path)), "ring open");
+    size0 = FileSize(path);
+    for (int k = 0; k < 90; k++) {
+      AppendRows(rec, rows_written, 1024);
+      rows_written += 1024;
+      if (k == 60) t_mid = UnixNs();
+      rec.Drain();  // a block msync may take longer than the next chunk, not what this test is about
+    }
+    rec.Close();
+    printf("block msync p99: %.2f ms, file %ld bytes, %lu rows dropped\n",
+           rec.GetRing().GetSyncTime().Percentile(99) / 1e6, (long)FileSize(path), rec.GetDroppedRows());
+    Check(rec.GetWriteErrors() == 0, "no write error");
+  }
+  Check(FileSize(path) == size0 && size0 <= 16 * 65536 + 8192, "file size fixed");
+
+  {
+    RingReader reader;
+    reader.Open(path);
+    const auto& blocks = reader.Blocks();
+    bool ordered = true;
+    for (size_t i = 1; i < blocks.size(); i++)
+      ordered = ordered && blocks[i].entry_.first_row_ >= blocks[i - 1].entry_.first_row_ + blocks[i - 1].entry_.rows_;
+    printf("%zu blocks, rows %lu .. %lu\n", blocks.size(), blocks.front().entry_.first_row_,
+           blocks.back().entry_.first_row_ + blocks.back().entry_.rows_ - 1);
+    Check(blocks.size() >= 14 && blocks.size() <= 16 && ordered, "blocks oldest first, rows in order");
+    Check(blocks.back().entry_.first_row_ + blocks.back().entry_.rows_ == rows_written, "newest row kept");
+  }
+
+  Check(ExtractCheck(path, out, 0, INT64_MAX, stats, first, last) && last == rows_written - 1 && first > 0,
+        "extract all: the newest rows, bit exact");
+  const uint64_t kept_first = first;
+
+  Check(ExtractCheck(path, out, t_mid, INT64_MAX, stats, first, last) && last == rows_written - 1 &&
+            first > kept_first && first <= 61 * 1024,
+        "extract by time: from t_mid on");
+  Check(ExtractCheck(path, out, 0, 1, stats, first, last) && stats.rows_ == 0, "extract before the ring: empty");
+
+  /* reopen with another odr / offset (a calibration at boot): kept, rows go on, the run carries its own */
+  {
+    RecorderInit_S init_s = RingInit(path);
+    init_s.odr_hz_ = 2000;
+    init_s.offset_g_ = {0.01f, -0.02f, 0.03f};
+    Recorder rec;
+    rec.Open(init_s);
+    Check(rec.GetRing().GetKeptBlocks() >= 14 && rec.GetRing().GetMovedAside().empty(),
+          "reopen keeps the sealed blocks");
+    AppendRows(rec, rows_written, 1024);
+    rows_written += 1024;
+    rec.Close();
+  }
+  std::vector<RingRun> runs;
+  Check(ExtractCheck(path, out, 0, INT64_MAX, stats, first, last, &runs) && last == rows_written - 1 &&
+            runs.size() == 2,
+        "second run appended, two runs in range");
+  Check(runs.size() == 2 && runs[0].odr_hz_ == 4000 && runs[0].offset_g_[0] == 0 && runs[1].odr_hz_ == 2000 &&
+            runs[1].offset_g_[0] == 0.01f && runs[1].start_ns_ > runs[0].start_ns_,
+        "each run extracted with its own start / odr / offset");
+
+  /* process crash: chunks in the unsealed block are in the page cache, the next Open() keeps them */
+  {
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == 0) {
+      Recorder rec;
+      rec.Open(RingInit(path));
+      AppendRows(rec, rows_written, 2048);
+      rec.Drain();  // writer wrote both chunks
+      _exit(0);     // no Close(): block not sealed
+    }
+    waitpid(pid, nullptr, 0);
+
+    RingReader live;
+    live.Open(path);
+    Check(!live.Blocks().empty() && !live.Blocks().back().sealed_ && live.Blocks().back().entry_.rows_ == 2048,
+          "reader sees the unsealed block");
+
+    Recorder rec;
+    rec.Open(RingInit(path));
+    Check(rec.GetRing().GetRecoveredChunks() == 2, "crash: unsealed chunks recovered");
+    rows_written += 2048;
+    AppendRows(rec, rows_written, 1024);
+    rows_written += 1024;
+    rec.Close();
+  }
+  Check(ExtractCheck(path, out, 0, INT64_MAX, stats, first, last) && last == rows_written - 1,
+        "crash: rows contiguous after recovery");
+
+  /* power loss mid write: the last chunk of the unsealed block reached the card half way */
+  {
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == 0) {
+      Recorder rec;
+      rec.Open(RingInit(path));
+      AppendRows(rec, rows_written, 2048);
+      rec.Drain();
+      _exit(0);
+    }
+    waitpid(pid, nullptr, 0);
+
+    // damage the second chunk of the unsealed block
+    RingReader reader;
+    reader.Open(path);
+    const auto b = reader.Blocks().back();
+    reader.Close();
+    FILE* f = fopen(path.c_str(), "r+b");
+    lra::recorder_util::RingSuper s;
+    fread(&s, sizeof(s), 1, f);
+    fseek(f, s.data_offset_ + uint64_t{b.block_} * s.block_bytes_ + b.entry_.used_bytes_ - 64, SEEK_SET);
+    fputc(0x5A, f);
+    fclose(f);
+
+    Recorder rec;
+    rec.Open(RingInit(path));
+    Check(rec.GetRing().GetRecoveredChunks() == 1, "power loss: good chunk kept, damaged one dropped");
+    rows_written += 1024;  // only the first chunk of that run is kept
+    rec.Close();
+  }
+  Check(ExtractCheck(path, out, 0, INT64_MAX, stats, first, last) && last == rows_written - 1,
+        "power loss: readable up to the last good chunk");
+
+  /* a damaged index entry: that block is dropped, the others stay */
+  {
+    RingReader reader;
+    reader.Open(path);
+    const size_t before = reader.Blocks().size();
+    const uint32_t victim = reader.Blocks()[before / 2].block_;
+    reader.Close();
+
+    FILE* f = fopen(path.c_str(), "r+b");
+    lra::recorder_util::RingSuper s;
+    fread(&s, sizeof(s), 1, f);
+    fseek(f, s.index_offset_ + uint64_t{victim} * sizeof(RingIndexEntry) + 8, SEEK_SET);
+    fputc(0xFF, f);
+    fclose(f);
+
+    reader.Open(path);
+    Check(reader.Blocks().size() == before - 1, "damaged index entry: only its block dropped");
+  }
+
+  /* another schema: the old ring moved aside, not formatted */
+  {
+    RecorderInit_S init_s = RingInit(path);
+    init_s.columns_.pop_back();
+    Recorder rec;
+    rec.Open(init_s);
+    Check(rec.GetRing().GetKeptBlocks() == 0 && rec.GetRing().GetRecoveredChunks() == 0, "other schema: new ring");
+    Check(rec.GetRing().GetMovedAside() == path + ".old", "other schema: old ring moved aside");
+    rec.Close();
+
+    RingReader old;
+    Check(old.Open(path + ".old") && old.Blocks().size() >= 14, "moved ring still readable");
+  }
+
+  std::remove(out.c_str());
+  std::remove(path.c_str());
+  std::remove((path + ".old").c_str());
+  rmdir(dir.c_str());
+
+  printf("%s (%d failed)\n", failed ? "FAILED" : "ALL PASSED", failed);
+  return failed;
+}
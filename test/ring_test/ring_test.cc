@@ -0,0 +1,155 @@
+// SpscRing correctness (order, wrap, overwrite, concurrent producer / consumer) and
+// producer side cost compared with std::deque + std::mutex
+// usage: lra_ring_util_test [samples]
+
+#include <util/ring/spsc_ring.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/check.h"
+
+using ::lra::ring_util::SpscRing;
+using lra::test::Check;
+using lra::test::failed;
+using lra::test::NowNs;
+
+struct Sample {  // same size as Adxl355::Acc3
+  float x, y, z;
+  uint32_t seq;
+};
+
+int main(int argc, char* argv[]) {
+  uint32_t total = (argc > 1) ? atoi(argv[1]) : 4000000;
+
+  /* order and wrap */
+  {
+    SpscRing<Sample, 8> ring;
+    std::vector<Sample> out(8);
+    bool ok = true;
+    uint32_t expect = 0;
+    for (uint32_t round = 0; round < 10; round++) {
+      for (uint32_t k = 0; k < 5; k++) ring.Push({0, 0, 0, round * 5 + k});
+      size_t n = ring.PopInto(out);
+      ok &= (n == 5);
+      for (size_t k = 0; k < n; k++) ok &= (out[k].seq == expect++);
+    }
+    Check(ok && ring.Empty() && ring.OverflowCount() == 0, "order across wrap around");
+  }
+
+  /* overwrite oldest */
+  {
+    SpscRing<Sample, 8> ring;
+    for (uint32_t k = 0; k < 20; k++) ring.Push({0, 0, 0, k});
+    std::vector<Sample> out(16);
+    size_t n = ring.PopInto(out);
+    bool ok = (n == 8) && (ring.OverflowCount() == 12);
+    for (size_t k = 0; k < n; k++) ok &= (out[k].seq == 12 + k);
+    Check(ok, "full ring drops oldest and counts overflow");
+  }
+
+  /* peek / commit */
+  {
+    SpscRing<Sample, 8> ring;
+    for (uint32_t k = 0; k < 6; k++) ring.Push({0, 0, 0, k});
+    auto view = ring.Peek(4);
+    bool ok = (view.size() == 4) && (view.first[0].seq == 0) && ring.Commit(view) && (ring.Size() == 2);
+
+    for (uint32_t k = 6; k < 12; k++) ring.Push({0, 0, 0, k});  // wraps, second span non empty
+    view = ring.Peek(8);
+    ok &= (view.size() == 8) && !view.second.empty() && (view.first[0].seq == 4);
+
+    ring.Push({0, 0, 0, 12});  // overwrites seq 4 while viewed
+    ok &= !ring.Commit(view);
+    view = ring.Peek(8);
+    ok &= (view.first[0].seq == 5) && ring.Commit(view);
+    Check(ok, "peek spans and commit rejected after overwrite");
+  }
+
+  /* concurrent: every sample is either popped once in order or counted as overflow */
+  {
+    SpscRing<Sample, 1024> ring;
+    std::atomic<bool> done{false};
+    uint64_t popped = 0;
+    bool in_order = true;
+
+    std::thread consumer([&]() {
+      std::vector<Sample> out(256);
+      int64_t last = -1;
+      while (true) {
+        bool fin = done.load();
+        size_t n = ring.PopInto(out);
+        for (size_t k = 0; k < n; k++) {
+          if (static_cast<int64_t>(out[k].seq) <= last) in_order = false;
+          last = out[k].seq;
+        }
+        popped += n;
+        if (fin && n == 0) break;
+      }
+    });
+
+    for (uint32_t k = 0; k < total; k++) ring.Push({1, 2, 3, k});
+    done = true;
+    consumer.join();
+
+    printf("  pushed %u, popped %lu, overflow %lu\n", total, popped, ring.OverflowCount());
+    Check(in_order, "concurrent pop keeps order without duplicates");
+    Check(popped + ring.OverflowCount() == total, "concurrent popped + overflow == pushed");
+  }
+
+  /* producer cost while consumer drains, ring vs deque + mutex */
+  {
+    constexpr size_t kCap = 1 << 18;
+    auto ring = std::make_unique<SpscRing<Sample, kCap>>();
+    std::deque<Sample> dq;
+    std::mutex dq_mutex;
+    uint64_t ring_max = 0, dq_max = 0, ring_ns = 0, dq_ns = 0;
+
+    std::atomic<bool> done{false};
+    std::thread consumer([&]() {
+      std::vector<Sample> out(1024);
+      while (!done) ring->PopInto(out);
+    });
+    for (uint32_t k = 0; k < total; k++) {
+      uint64_t t0 = NowNs();
+      ring->Push({1, 2, 3, k});
+      uint64_t dt = NowNs() - t0;
+      ring_ns += dt;
+      if (dt > ring_max) ring_max = dt;
+    }
+    done = true;
+    consumer.join();
+
+    done = false;
+    consumer = std::thread([&]() {
+      while (!done) {
+        std::lock_guard<std::mutex> lock(dq_mutex);
+        size_t n = dq.size() < 1024 ? dq.size() : 1024;
+        while (n--) dq.pop_front();
+      }
+    });
+    for (uint32_t k = 0; k < total; k++) {
+      uint64_t t0 = NowNs();
+      {
+        std::lock_guard<std::mutex> lock(dq_mutex);
+        dq.push_back({1, 2, 3, k});
+      }
+      uint64_t dt = NowNs() - t0;
+      dq_ns += dt;
+      if (dt > dq_max) dq_max = dt;
+    }
+    done = true;
+    consumer.join();
+
+    printf("  push mean / max (ns): ring %.1f / %lu, deque+mutex %.1f / %lu\n", static_cast<double>(ring_ns) / total,
+           ring_max, static_cast<double>(dq_ns) / total, dq_max);
+  }
+
+  printf("%s (%d failed)\n", failed ? "FAILED" : "ALL PASSED", failed);
+  return failed;
+}
@@ -0,0 +1,181 @@
+// Spi bus and SpiAdapter against Spi::Loopback and a recording mock, no device needed
+// usage: lra_spi_unit_test [/dev/spidevX.Y]  (optional, MOSI wired to MISO)
+
+#include <bus_adapter/spi_adapter/spi_adapter.h>
+#include <memory/registers/registers.h>
+
+#include <cstring>
+#include <vector>
+
+#include "common/check.h"
+
+using lra::bus::Spi;
+using lra::bus::SpiInit_S;
+using lra::bus_adapter::spi::SpiAdapter;
+using lra::bus_adapter::spi::SpiAdapter_S;
+using lra::bus_adapter::spi::SpiRegXfer;
+using lra::memory::registers::Register_16;
+using lra::test::Check;
+using lra::test::failed;
+
+// keeps a copy of every segment of the last messages
+struct Recorder {
+  struct Seg {
+    std::vector<uint8_t> tx;
+    bool has_rx{false};
+    bool cs_change{false};
+    uint32_t speed_hz{0};
+  };
+  std::vector<std::vector<Seg>> msgs;
+
+  ssize_t Xfer(const spi_ioc_transfer* xfer, uint16_t n) {
+    auto& m = msgs.emplace_back();
+    ssize_t total = 0;
+    for (uint16_t i = 0; i < n; i++) {
+      Seg s;
+      auto tx = reinterpret_cast<const uint8_t*>(xfer[i].tx_buf);
+      if (tx) s.tx.assign(tx, tx + xfer[i].len);
+      s.has_rx = xfer[i].rx_buf != 0;
+      s.cs_change = xfer[i].cs_change;
+      s.speed_hz = xfer[i].speed_hz;
+      if (s.has_rx) memset(reinterpret_cast<uint8_t*>(xfer[i].rx_buf), 0xA5, xfer[i].len);
+      m.push_back(std::move(s));
+      total += xfer[i].len;
+    }
+    return total;
+  }
+};
+
+static void LoopbackTests(std::shared_ptr<Spi> bus, const char* tag) {
+  SpiAdapter_S s;
+  s.bus_ = bus;
+  s.speed_hz_ = 1000000;
+  s.name_ = "spi_loopback";
+  SpiAdapter adapter;
+  adapter.Init(s);
+
+  char what[128];
+
+  /* single in place transfer */
+  uint8_t buf[16];
+  for (int i = 0; i < 16; i++) buf[i] = i * 3;
+  uint64_t ioctl_before = bus->GetIoctlCount();
+  ssize_t ret = adapter.Xfer(buf, sizeof(buf));
+  bool ok = (ret == sizeof(buf)) && (bus->GetIoctlCount() - ioctl_before == 1);
+  for (int i = 0; i < 16; i++) ok &= (buf[i] == i * 3);
+  snprintf(what, sizeof(what), "%s: Xfer loops tx back to rx", tag);
+  Check(ok, what);
+
+  /* 512 segments, one ioctl */
+  constexpr uint16_t n = Spi::kMaxXfers;
+  std::vector<std::array<uint8_t, 4>> data(n);
+  std::vector<uint8_t*> bufs(n);
+  std::vector<uint32_t> lens(n, 4);
+  std::unique_ptr<bool[]> cs(new bool[n]);
+  for (uint16_t i = 0; i < n; i++) {
+    data[i] = {uint8_t(i), uint8_t(i >> 8), 0x55, 0xAA};
+    bufs[i] = data[i].data();
+    cs[i] = (i % 2 == 1);
+  }
+  ioctl_before = bus->GetIoctlCount();
+  ret = adapter.XferMulti(bufs.data(), lens.data(), cs.get(), n);
+  ok = (ret == n * 4) && (bus->GetIoctlCount() - ioctl_before == 1);
+  for (uint16_t i = 0; i < n; i++) ok &= (data[i][0] == uint8_t(i) && data[i][3] == 0xAA);
+  snprintf(what, sizeof(what), "%s: XferMulti 512 segments in one ioctl", tag);
+  Check(ok, what);
+}
+
+int main(int argc, char* argv[]) {
+  /* 1. loopback mock */
+  {
+    SpiInit_S init;
+    init.name_ = "loopback";
+    init.mock_xfer_ = Spi::Loopback;
+    auto bus = std::make_shared<Spi>();
+    Check(bus->Init(init), "loopback: init");
+    LoopbackTests(bus, "loopback");
+
+    SpiAdapter_S s;
+    s.bus_ = bus;
+    SpiAdapter adapter;
+    adapter.Init(s);
+    std::vector<uint8_t> big(4);
+    std::vector<uint8_t*> bufs(Spi::kMaxXfers + 1, big.data());
+    std::vector<uint32_t> lens(Spi::kMaxXfers + 1, 4);
+    Check(adapter.XferMulti(bufs.data(), lens.data(), nullptr, Spi::kMaxXfers + 1) == -1, "loopback: reject 513");
+  }
+
+  /* 2. frame layout of register access */
+  {
+    Recorder rec;
+    SpiInit_S init;
+    init.mock_xfer_ = [&rec](const spi_ioc_transfer* x, uint16_t n) { return rec.Xfer(x, n); };
+    auto bus = std::make_shared<Spi>();
+    bus->Init(init);
+
+    SpiAdapter_S s;
+    s.bus_ = bus;
+    s.speed_hz_ = 10000000;
+    s.isRWbitFirst_ = false;  // adxl355 style
+    SpiAdapter adapter;
+    adapter.Init(s);
+
+    uint8_t val[3] = {0};
+    ssize_t ret = adapter.Read(0x08, val, sizeof(val));
+    auto m = rec.msgs.back();
+    Check(ret == 3 && m.size() == 2 && m[0].tx == std::vector<uint8_t>{0x11} && m[1].tx.empty() && m[1].has_rx &&
+              !m[1].cs_change && m[1].speed_hz == 10000000 && val[0] == 0xA5,
+          "read: cmd (addr << 1 | 1) + rx segment, zero copy");
+
+    constexpr static Register_16 R16{0x1E, 0x0};
+    ret = adapter.Write(R16, 0x1234);
+    m = rec.msgs.back();
+    Check(ret == 2 && m[0].tx == std::vector<uint8_t>{0x3C} && m[1].tx == std::vector<uint8_t>{0x12, 0x34} &&
+              !m[1].has_rx,
+          "register write: cmd (addr << 1 | 0) + big endian value");
+
+    s.isRWbitFirst_ = true;
+    SpiAdapter adapter_rw;
+    adapter_rw.Init(s);
+    uint8_t one = 0;
+    adapter_rw.Read(0x05, one);
+    Check(rec.msgs.back()[0].tx == std::vector<uint8_t>{0x85}, "read: cmd (1 << 7 | addr)");
+
+    /* batch, every register its own CS frame, chunked by kMaxRegXfers */
+    constexpr uint16_t n = 300;
+    std::vector<uint8_t> out(n);
+    std::vector<SpiRegXfer> regs(n);
+    for (uint16_t i = 0; i < n; i++) regs[i] = {.iaddr_{uint64_t(i % 0x40)}, .val_{&out[i]}, .len_{1}, .read_{true}};
+
+    rec.msgs.clear();
+    ret = adapter.XferRegMulti(regs.data(), n);
+    bool ok = (ret == n) && (rec.msgs.size() == 2) && (rec.msgs[0].size() == 2 * SpiAdapter::kMaxRegXfers) &&
+              (rec.msgs[1].size() == 2 * (n - SpiAdapter::kMaxRegXfers));
+    for (auto& msg : rec.msgs) {
+      for (size_t i = 0; i < msg.size(); i++) {
+        bool last = (i == msg.size() - 1);
+        ok &= (i % 2 == 0) ? !msg[i].cs_change : (msg[i].cs_change != last);
+      }
+    }
+    Check(ok, "XferRegMulti: 300 registers in 2 ioctls, cs_change between frames only");
+
+    SpiRegXfer bad{.iaddr_{0x80}, .val_{&one}, .len_{1}, .read_{true}};
+    Check(adapter.XferRegMulti(&bad, 1) == -1, "reject address > 0x7F");
+  }
+
+  /* 3. real spidev with MOSI wired to MISO */
+  if (argc > 1) {
+    SpiInit_S init;
+    init.name_ = argv[1];
+    auto bus = std::make_shared<Spi>();
+    if (bus->Init(init)) {
+      printf("%s: mode %u, bits %u, speed %u Hz\n", argv[1], bus->mode_, bus->bits_per_word_, bus->speed_hz_);
+      LoopbackTests(bus, argv[1]);
+    } else {
+      Check(false, "spidev open");
+    }
+  }
+
+  printf("%s (%d failed)\n", failed ? "FAILED" : "ALL PASSED", failed);
+  return failed;
+}
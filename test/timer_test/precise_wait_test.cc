@@ -0,0 +1,127 @@
+// PreciseWaiter: deadline accuracy, eventfd interrupt, calibration cache, per instance slack, Timer daemon wake ups
+// usage: lra_precise_wait_test [waits]
+
+#include <util/timer/precise_wait.h>
+#include <util/timer/timer.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/check.h"
+
+using lra::timer_util::PreciseWaiter;
+using lra::timer_util::PreciseWaitInit_S;
+using lra::timer_util::Timer;
+using lra::test::Check;
+using lra::test::failed;
+
+// late (ns) of n waits of period_ns, sorted
+static std::vector<int64_t> Lateness(PreciseWaiter& waiter, int n, int64_t period_ns) {
+  std::vector<int64_t> late;
+  int64_t deadline = PreciseWaiter::NowNs();
+  for (int i = 0; i < n; i++) {
+    deadline += period_ns;
+    waiter.WaitUntil(deadline, false);
+    late.push_back(PreciseWaiter::NowNs() - deadline);
+  }
+  std::sort(late.begin(), late.end());
+  return late;
+}
+
+int main(int argc, char** argv) {
+  const int waits = (argc > 1) ? atoi(argv[1]) : 500;
+
+  /* accuracy: spin tail against timer only */
+  {
+    PreciseWaiter spin;
+    PreciseWaiter plain(PreciseWaitInit_S{.max_spin_ns_ = 0});
+    auto a = Lateness(spin, waits, 1000000);
+    auto b = Lateness(plain, waits, 1000000);
+    const int64_t p50a = a[a.size() / 2], p99a = a[a.size() * 99 / 100];
+    const int64_t p50b = b[b.size() / 2], p99b = b[b.size() * 99 / 100];
+    printf("spin tail: late p50 %ld ns, p99 %ld ns, slack %ld ns | timer only: p50 %ld ns, p99 %ld ns\n", p50a, p99a,
+           spin.GetSlackNs(), p50b, p99b);
+    Check(a.front() >= 0 && b.front() >= 0, "never wakes before the deadline");
+    Check(p50a < p50b, "spin tail lands closer to the deadline");
+    Check(plain.GetSlackNs() == 0, "no slack without a spin tail");
+  }
+
+  /* per instance: a waiter's slack only follows its own wake ups */
+  {
+    PreciseWaiter busy(PreciseWaitInit_S{.initial_slack_ns_ = 150000});
+    PreciseWaiter idle(PreciseWaitInit_S{.initial_slack_ns_ = 150000});
+    Lateness(busy, 100, 500000);
+    Check(idle.GetSlackNs() == 150000 && busy.GetSlackNs() != 150000, "slack adapts per instance");
+  }
+
+  /* interrupt */
+  {
+    PreciseWaiter waiter;
+    std::atomic<int64_t> sent{0};
+    std::thread t([&] {
+      usleep(20000);
+      sent.store(PreciseWaiter::NowNs());
+      waiter.Interrupt();
+    });
+    const bool reached = waiter.WaitUntil(PreciseWaiter::kForever, true);
+    const int64_t woke = PreciseWaiter::NowNs();
+    t.join();
+    printf("interrupt -> wake: %ld us\n", (woke - sent.load()) / 1000);
+    Check(!reached, "kForever wait ends on Interrupt()");
+
+    waiter.Interrupt();
+    waiter.Interrupt();
+    Check(!waiter.WaitUntil(PreciseWaiter::NowNs() + 1000000, true), "interrupt before the wait is kept");
+    Check(waiter.WaitUntil(PreciseWaiter::NowNs() + 1000000, true), "repeated interrupts coalesce into one");
+    waiter.Interrupt();
+    Check(waiter.WaitUntil(PreciseWaiter::NowNs() + 1000000, false), "non interruptible wait ignores it");
+    Check(!waiter.WaitUntil(PreciseWaiter::NowNs() + 1000000, true), "and leaves it pending");
+  }
+
+  /* calibration cache */
+  {
+    const std::string path = "/tmp/lra_precise_wait_test_" + std::to_string(getpid()) + "/timer_calibration";
+    PreciseWaiter first, second;
+
+    auto t0 = PreciseWaiter::NowNs();
+    const bool cached_first = first.LoadOrCalibrate(path);
+    auto t1 = PreciseWaiter::NowNs();
+    const bool cached_second = second.LoadOrCalibrate(path);
+    auto t2 = PreciseWaiter::NowNs();
+    printf("calibrate: %ld ms, from cache: %ld us, slack %ld / %ld ns\n", (t1 - t0) / 1000000, (t2 - t1) / 1000,
+           first.GetSlackNs(), second.GetSlackNs());
+    Check(!cached_first && cached_second, "second calibration comes from the file");
+    Check(first.GetSlackNs() == second.GetSlackNs(), "cached slack equals the measured one");
+
+    std::ofstream(path) << "v1 other-kernel 1 1\n";
+    PreciseWaiter third;
+    Check(!third.LoadOrCalibrate(path), "other kernel release measures again");
+    std::remove(path.c_str());
+  }
+
+  /* Timer daemon: an earlier event interrupts the wait for a later one */
+  {
+    Timer timer(1, Timer::DelayOpt::kDefaultDelay);
+    std::atomic<int64_t> fired{0};
+    timer.SetEvent([] {}, 500.0);
+    usleep(10000);  // daemon waits for the 500 ms event
+
+    const int64_t t0 = PreciseWaiter::NowNs();
+    timer.SetEvent([&fired] { fired.store(PreciseWaiter::NowNs()); }, 5.0);
+    while (!fired.load()) usleep(100);
+    const int64_t late = fired.load() - t0 - 5000000;
+    printf("earlier event late: %ld us\n", late / 1000);
+    Check(late < 2000000, "earlier add wakes the daemon");
+  }
+
+  printf("%s (%d failed)\n", failed ? "FAILED" : "ALL PASSED", failed);
+  return failed;
+}
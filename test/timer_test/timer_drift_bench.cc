@@ -0,0 +1,97 @@
+// Timer loop events on absolute deadlines: drift after many periods, lateness, and the catch-up policies
+// usage: lra_timer_drift_bench [periods] [period_ms]
+
+#include <util/timer/timer.h>
+
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+#include "common/check.h"
+
+using lra::timer_util::CatchUp;
+using lra::timer_util::Exec;
+using lra::timer_util::Timer;
+using lra::timer_util::TimerEventStats;
+using lra::timer_util::TimerHandle;
+using lra::test::Check;
+using lra::test::failed;
+using lra::test::NowNs;
+
+struct Probe {
+  std::atomic<uint64_t> n{0};
+  std::atomic<int64_t> last{0};
+  int64_t stall_at{-1};  // run index that sleeps stall_us
+  int64_t stall_us{0};
+};
+
+static void Run(Probe* p) {
+  const int64_t now = NowNs();
+  const uint64_t k = p->n.fetch_add(1, std::memory_order_relaxed);
+  p->last.store(now, std::memory_order_relaxed);
+  if ((int64_t)k == p->stall_at) usleep(p->stall_us);
+}
+
+int main(int argc, char** argv) {
+  const uint64_t periods = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1000000;
+  const double period_ms = (argc > 2) ? atof(argv[2]) : 0.1;
+  const int64_t period_ns = static_cast<int64_t>(period_ms * 1e6);
+
+  Timer timer(1, Timer::DelayOpt::kDefaultDelay);
+
+  /* drift: the k-th run still sits on t0 + k * period after `periods` periods */
+  {
+    Probe p;
+    const int64_t t0 = NowNs();
+    TimerHandle h = timer.SetLoopEvent([&p] { Run(&p); }, period_ms, CatchUp::kBurst, Exec::kInline);
+    while (p.n.load() < periods) usleep(10000);
+
+    TimerEventStats st;
+    timer.GetEventStats(h, st);
+    timer.CancelEvent(h);
+
+    const uint64_t n = p.n.load();
+    const double drift_us = (p.last.load() - t0 - (double)n * period_ns) / 1e3;
+    // re-arming from now() instead adds the dispatch lateness of every period
+    const double rearm_drift_ms = st.late_mean_ns_ * n / 1e6;
+
+    printf("%lu periods of %.3f ms: drift %.1f us (re-arm from now would be ~%.1f ms), lateness p50 %.1f us, "
+           "p99 %.1f us, max %.1f us, overruns %lu\n",
+           n, period_ms, drift_us, rearm_drift_ms, st.late_p50_ns_ / 1e3, st.late_p99_ns_ / 1e3,
+           st.late_max_ns_ / 1e3, st.overruns_);
+    Check(st.fired_ == n, "every period ran (kBurst)");
+    Check(drift_us > -period_ns / 1e3 && drift_us < st.late_max_ns_ / 1e3 + period_ns / 1e3,
+          "no drift beyond one late run");
+  }
+
+  /* catch-up after a stall of 5.5 periods (10 ms period), inline: the stall holds the timer thread */
+  const double slow_ms = 10.0;
+  for (CatchUp policy : {CatchUp::kBurst, CatchUp::kCoalesce, CatchUp::kSkip}) {
+    Probe p;
+    p.stall_at = 5;
+    p.stall_us = 55000;
+
+    const int64_t t0 = NowNs();
+    TimerHandle h = timer.SetLoopEvent([&p] { Run(&p); }, slow_ms, policy, Exec::kInline);
+    usleep(305000);  // 30 deadlines
+
+    TimerEventStats st;
+    timer.GetEventStats(h, st);
+    timer.CancelEvent(h);
+    const double phase_ms = ((p.last.load() - t0) % (int64_t)(slow_ms * 1e6)) / 1e6;
+
+    const char* name = policy == CatchUp::kBurst ? "burst" : policy == CatchUp::kCoalesce ? "coalesce" : "skip";
+    printf("%-8s runs %lu, missed %lu, overruns %lu, last run %.2f ms off the grid\n", name, p.n.load(), st.missed_,
+           st.overruns_, phase_ms < slow_ms / 2 ? phase_ms : phase_ms - slow_ms);
+
+    // the stalled run (index 5) was late for the next 5 deadlines
+    if (policy == CatchUp::kBurst) Check(st.missed_ == 0 && p.n.load() >= 29, "burst: all deadlines ran");
+    if (policy == CatchUp::kCoalesce) Check(st.missed_ >= 4 && st.missed_ <= 6, "coalesce: missed folded into one");
+    if (policy == CatchUp::kSkip) Check(st.missed_ >= 5 && st.missed_ <= 7, "skip: late run dropped too");
+  }
+
+  return failed;
+}
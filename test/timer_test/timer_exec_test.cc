@@ -0,0 +1,89 @@
+// Timer execution policies: inline / executor / pool, where each runs and its dispatch latency (task start - deadline)
+// usage: lra_timer_exec_test [runs]
+
+#include <util/timer/timer.h>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "common/check.h"
+
+using lra::timer_util::CatchUp;
+using lra::timer_util::Exec;
+using lra::timer_util::Timer;
+using lra::timer_util::TimerEventStats;
+using lra::timer_util::TimerExecutorInit_S;
+using lra::timer_util::TimerHandle;
+using lra::test::Check;
+using lra::test::failed;
+
+struct Probe {
+  std::atomic<uint32_t> runs_{0};
+  std::atomic<bool> same_thread_{true};
+  std::atomic<std::thread::id> thread_{};
+
+  void Hit() {
+    const auto id = std::this_thread::get_id();
+    std::thread::id expected{};
+    if (!thread_.compare_exchange_strong(expected, id) && expected != id) same_thread_.store(false);
+    runs_.fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+int main(int argc, char** argv) {
+  const int runs = (argc > 1) ? atoi(argv[1]) : 500;
+  const double period_ms = 1.0;
+
+  Timer timer(2, Timer::DelayOpt::kDefaultDelay);
+  Check(timer.StartExecutor(TimerExecutorInit_S{.name_ = "timer_exec_test"}), "executor started");
+  Check(!timer.StartExecutor(TimerExecutorInit_S{}), "second executor refused");
+
+  Probe inline_probe, exec_probe, pool_probe, daemon_probe;
+
+  // the daemon's thread id, from an inline one-shot
+  timer.SetEvent([&] { daemon_probe.Hit(); }, 1.0, Exec::kInline);
+  while (!daemon_probe.runs_.load()) usleep(100);
+
+  TimerHandle h_inline = timer.SetLoopEvent([&] { inline_probe.Hit(); }, period_ms, CatchUp::kCoalesce, Exec::kInline);
+  TimerHandle h_exec = timer.SetLoopEvent([&] { exec_probe.Hit(); }, period_ms, CatchUp::kCoalesce, Exec::kExecutor);
+  TimerHandle h_pool = timer.SetLoopEvent([&] { pool_probe.Hit(); }, period_ms, CatchUp::kCoalesce, Exec::kPool);
+
+  usleep(static_cast<useconds_t>(runs * period_ms * 1000));
+
+  TimerEventStats st[3];
+  const char* names[3] = {"inline", "executor", "pool"};
+  TimerHandle handles[3] = {h_inline, h_exec, h_pool};
+  for (int i = 0; i < 3; i++) {
+    timer.GetEventStats(handles[i], st[i]);
+    printf("%-8s runs %5lu, dispatch p50 %6lu ns, p99 %7lu ns, max %8lu ns\n", names[i], st[i].fired_,
+           st[i].dispatch_p50_ns_, st[i].dispatch_p99_ns_, st[i].dispatch_max_ns_);
+  }
+  for (TimerHandle h : handles) timer.CancelEvent(h);
+  usleep(10000);
+
+  Check(inline_probe.runs_ > runs / 2u && exec_probe.runs_ > runs / 2u && pool_probe.runs_ > runs / 2u,
+        "every policy ran its loop event");
+  Check(inline_probe.same_thread_ && inline_probe.thread_.load() == daemon_probe.thread_.load(),
+        "inline runs on the timer thread");
+  Check(exec_probe.same_thread_ && exec_probe.thread_.load() != daemon_probe.thread_.load(),
+        "executor runs on its own single thread");
+  Check(pool_probe.thread_.load() != daemon_probe.thread_.load(), "pool runs off the timer thread");
+  Check(st[0].dispatch_p50_ns_ <= st[2].dispatch_p50_ns_, "inline skips the pool handoff");
+  Check(timer.GetDispatchLatency(Exec::kInline).Count() >= st[0].fired_, "per policy latency recorded");
+
+  // executor not started: falls back to the pool, counted as overload
+  {
+    Timer plain(1, Timer::DelayOpt::kDefaultDelay);
+    std::atomic<bool> ran{false};
+    plain.SetEvent([&ran] { ran.store(true); }, 1.0, Exec::kExecutor);
+    for (int i = 0; i < 1000 && !ran.load(); i++) usleep(1000);
+    Check(ran.load() && plain.GetOverloadCount() == 1, "kExecutor without executor runs on the pool");
+  }
+
+  printf("%s (%d failed)\n", failed ? "FAILED" : "ALL PASSED", failed);
+  return failed;
+}
@@ -0,0 +1,132 @@
+// Timer: add / cancel from many threads, every event runs once unless its cancel returned true, pool drains to empty
+// usage: lra_timer_stress_test [threads] [events_per_thread]
+
+#include <util/timer/timer.h>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "common/check.h"
+
+using lra::timer_util::kInvalidTimer;
+using lra::timer_util::Timer;
+using lra::timer_util::TimerHandle;
+using lra::test::Check;
+using lra::test::failed;
+
+enum class Fate : uint8_t { kRefused, kKept, kCancelled, kCancelLate };
+
+int main(int argc, char** argv) {
+  const int threads = (argc > 1) ? atoi(argv[1]) : 8;
+  const int per_thread = (argc > 2) ? atoi(argv[2]) : 4000;
+  const int total = threads * per_thread;
+
+  Timer timer(2, Timer::DelayOpt::kDefaultDelay);
+
+  std::vector<std::atomic<uint32_t>> runs(total);
+  std::vector<Fate> fate(total, Fate::kRefused);
+  std::atomic<uint32_t> loop_runs{0};
+  std::atomic<uint64_t> add_ns{0}, cancel_ns{0};
+  std::atomic<uint32_t> cancels{0};
+
+  auto worker = [&](int t) {
+    std::mt19937 rng(t);
+    std::vector<std::pair<int, TimerHandle>> recent;
+
+    // a loop event per thread, cancelled at the end
+    TimerHandle loop = timer.SetLoopEvent([&loop_runs] { loop_runs.fetch_add(1, std::memory_order_relaxed); }, 2.0);
+
+    for (int i = 0; i < per_thread; i++) {
+      const int id = t * per_thread + i;
+      const double delay_ms = 1.0 + (rng() % 4000) / 1000.0;
+
+      auto t0 = std::chrono::steady_clock::now();
+      TimerHandle h = timer.SetEvent([&runs, id] { runs[id].fetch_add(1, std::memory_order_relaxed); }, delay_ms);
+      add_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+
+      if (h == kInvalidTimer) continue;
+      fate[id] = Fate::kKept;
+      recent.emplace_back(id, h);
+
+      // cancel a third, some before and some after they fire
+      if (rng() % 3 == 0 && !recent.empty()) {
+        auto [cid, ch] = recent[rng() % recent.size()];
+        if (fate[cid] == Fate::kKept) {
+          t0 = std::chrono::steady_clock::now();
+          const bool ok = timer.CancelEvent(ch);
+          cancel_ns +=
+              std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+          cancels++;
+          fate[cid] = ok ? Fate::kCancelled : Fate::kCancelLate;
+          if (ok && timer.CancelEvent(ch)) fate[cid] = Fate::kRefused;  // second cancel must fail
+        }
+      }
+      if (recent.size() > 64) recent.erase(recent.begin());
+
+      usleep(rng() % 200);
+    }
+
+    if (!timer.CancelEvent(loop)) fate[t * per_thread] = Fate::kRefused;  // flagged below as a mismatch
+  };
+
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; t++) pool.emplace_back(worker, t);
+  for (auto& th : pool) th.join();
+
+  // longest delay 5 ms, leave time for the pool
+  usleep(100000);
+
+  int kept_ok = 0, kept_bad = 0, cancelled_ok = 0, cancelled_bad = 0, late_ok = 0, late_bad = 0, refused = 0;
+  for (int id = 0; id < total; id++) {
+    const uint32_t n = runs[id].load();
+    switch (fate[id]) {
+      case Fate::kKept:
+        (n == 1) ? kept_ok++ : kept_bad++;
+        break;
+      case Fate::kCancelled:
+        (n == 0) ? cancelled_ok++ : cancelled_bad++;
+        break;
+      case Fate::kCancelLate:  // cancel lost the race, it ran
+        (n == 1) ? late_ok++ : late_bad++;
+        break;
+      case Fate::kRefused:
+        refused++;
+        if (n) kept_bad++;
+        break;
+    }
+  }
+
+  printf("%d threads x %d events: kept %d, cancelled %d, cancel after run %d, refused %d, loop runs %u\n", threads,
+         per_thread, kept_ok, cancelled_ok, late_ok, refused, loop_runs.load());
+  printf("SetEvent %.0f ns, CancelEvent %.0f ns (avg)\n", (double)add_ns / total,
+         cancels ? (double)cancel_ns / cancels : 0.0);
+
+  Check(kept_bad == 0 && late_bad == 0, "every event not cancelled ran exactly once");
+  Check(cancelled_bad == 0, "an event whose cancel returned true never ran");
+  Check(refused == 0, "no event refused (pool big enough), double cancel refused, loop cancel ok");
+  Check(loop_runs.load() > 0, "loop events ran");
+
+  const uint32_t loop_after = loop_runs.load();
+  usleep(20000);
+  Check(loop_runs.load() == loop_after, "cancelled loop events stopped");
+  Check(timer.GetEventCount() == 0, "all slots back on the free list");
+  Check(!timer.CancelEvent(kInvalidTimer) && !timer.CancelEvent(12345), "invalid / stale handle refused");
+
+  // whole pool in use, then refused
+  std::vector<TimerHandle> held;
+  for (uint32_t i = 0; i <= Timer::kMaxEvents; i++) held.push_back(timer.SetEvent([] {}, 1000.0));
+  Check(held.back() == kInvalidTimer && held[Timer::kMaxEvents - 1] != kInvalidTimer, "pool exhaustion refused");
+  for (auto h : held)
+    if (h != kInvalidTimer) timer.CancelEvent(h);
+  usleep(20000);
+  Check(timer.GetEventCount() == 0, "cancelled pool released");
+
+  return failed;
+}
@@ -11,7 +11,7 @@ uint32_t t = 0;
 double nb = 10;
 double pa_v = 0.99;
 double total_time_ms = 1000.0;
-uint32_t unique_uid;
+lra::timer_util::TimerHandle unique_uid;
 
 void EasyPrint() {
   
@@ -48,7 +48,7 @@ int main() {
   
 
   auto start = std::chrono::high_resolution_clock::now();
-  // my_timer.PreciseSleepms(total_time_ms, 0);
-    my_timer.PreciseSleepms(100000, 0);
+  // my_timer.PreciseSleepms(total_time_ms);
+    my_timer.PreciseSleepms(100000);
   auto end = std::chrono::high_resolution_clock::now();
 }
\ No newline at end of file
@@ -0,0 +1,117 @@
+// broadcast cost against the number of clients: serialize-once broadcastMessage vs one sendMessage per client
+// N local websocketpp clients on 127.0.0.1, payload shaped like dataRTKeepRequireResponse (40 acc samples)
+// usage: lra_broadcast_bench [port] [rounds]
+
+#include <websocket/websocket.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <websocketpp/client.hpp>
+#include <websocketpp/config/asio_no_tls_client.hpp>
+
+using lra::websocket::WebsocketServer;
+
+typedef websocketpp::client<websocketpp::config::asio_client> BenchClient;
+
+// exposes the old per connection path for comparison
+class BenchServer : public WebsocketServer {
+ public:
+  BenchServer() {
+    this->endpoint.clear_access_channels(websocketpp::log::alevel::all);
+    this->endpoint.set_reuse_addr(true);
+  }
+
+  void broadcastPerClient(const std::string& messageType, const Json::Value& arguments) {
+    std::lock_guard<std::mutex> lock(this->connectionListMutex);
+    for (auto conn : this->openConnections) this->sendMessage(conn, messageType, arguments);
+  }
+
+  void stop() { this->endpoint.stop(); }
+};
+
+static Json::Value RtPayload() {
+  Json::Value payload, data, drv, acc, drv_1axis;
+  drv["t"] = 123456789000.0;
+  drv_1axis["rtp"] = 127;
+  drv_1axis["freq"] = 170.5;
+  drv["x"] = drv["y"] = drv["z"] = drv_1axis;
+  for (int k = 0; k < 40; k++) {
+    Json::Value v;
+    v["t"] = 123456789000.0 - k * 250000.0;
+    v["x"] = 0.01 * k;
+    v["y"] = -0.02 * k;
+    v["z"] = 1.0 + 0.001 * k;
+    acc.append(v);
+  }
+  data["drv"] = drv;
+  data["acc"] = acc;
+  payload["uuid"] = "00000000-0000-0000-0000-000000000000";
+  payload["timestamp"] = "2024-01-01 00:00:00.000000000";
+  payload["data"] = data;
+  return payload;
+}
+
+int main(int argc, char** argv) {
+  const int port = (argc > 1) ? atoi(argv[1]) : 9012;
+  const int rounds = (argc > 2) ? atoi(argv[2]) : 500;
+
+  BenchServer server;
+  std::thread server_t([&]() { server.run(port); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  // clients share one io thread, count every received message
+  std::atomic<uint64_t> received{0};
+  BenchClient client;
+  client.clear_access_channels(websocketpp::log::alevel::all);
+  client.clear_error_channels(websocketpp::log::elevel::all);
+  client.init_asio();
+  client.start_perpetual();
+  client.set_message_handler([&received](websocketpp::connection_hdl, BenchClient::message_ptr) { received++; });
+  std::thread client_t([&]() { client.run(); });
+
+  const Json::Value payload = RtPayload();
+  const std::string uri = "ws://127.0.0.1:" + std::to_string(port);
+
+  printf("%8s %16s %16s\n", "clients", "broadcast us", "per-client us");
+  for (size_t n : {1, 2, 4, 8, 16, 32, 64}) {
+    while (server.numConnections() < n) {
+      websocketpp::lib::error_code ec;
+      auto con = client.get_connection(uri, ec);
+      if (ec) {
+        printf("connect failed: %s\n", ec.message().c_str());
+        return 1;
+      }
+      client.connect(con);
+      const size_t want = server.numConnections() + 1;
+      while (server.numConnections() < want) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // caller side cost only (what the control loop pays), drained before the next call
+    auto bench = [&](auto&& send) {
+      double total_us = 0;
+      for (int r = 0; r < rounds; r++) {
+        const uint64_t target = received.load() + n;
+        auto t = std::chrono::steady_clock::now();
+        send();
+        total_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t).count();
+        while (received.load() < target) std::this_thread::yield();
+      }
+      return total_us / rounds;
+    };
+
+    double once_us = bench([&]() { server.broadcastMessage("dataRTKeepRequireResponse", payload); });
+    double each_us = bench([&]() { server.broadcastPerClient("dataRTKeepRequireResponse", payload); });
+    printf("%8zu %16.1f %16.1f\n", n, once_us, each_us);
+  }
+
+  client.stop_perpetual();
+  client.stop();
+  server.stop();
+  client_t.join();
+  server_t.join();
+  return 0;
+}
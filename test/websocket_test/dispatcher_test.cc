@@ -0,0 +1,69 @@
+// WsDispatcher: a seconds long kLong job must not delay kControl / kDefault, order kept inside a lane
+
+#include <websocket/dispatcher.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "common/check.h"
+
+using lra::websocket::WsDispatcher;
+using lra::websocket::WsLane;
+using lra::test::Check;
+using lra::test::failed;
+
+int main() {
+  using clock = std::chrono::steady_clock;
+
+  WsDispatcher dispatcher;
+  std::thread run_t([&]() { dispatcher.Run(); });
+
+  std::atomic<bool> long_done{false};
+  dispatcher.Post(WsLane::kLong, [&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));  // calibration
+    long_done = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // commands sent while the long job runs
+  std::atomic<int64_t> control_us{-1}, default_us{-1};
+  auto sent = clock::now();
+  dispatcher.Post(WsLane::kControl, [&]() {
+    control_us = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - sent).count();
+  });
+  dispatcher.Post(WsLane::kDefault, [&]() {
+    default_us = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - sent).count();
+  });
+
+  std::vector<int> order;
+  std::atomic<int> ran{0};
+  for (int i = 0; i < 100; i++) {
+    dispatcher.Post(WsLane::kControl, [&, i]() {
+      order.push_back(i);
+      ran++;
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  printf("control %ld us, default %ld us while kLong busy, kControl wait p99 %lu us\n", control_us.load(),
+         default_us.load(), dispatcher.GetWait(WsLane::kControl).Percentile(99) / 1000);
+
+  Check(!long_done, "long job still running");
+  Check(control_us >= 0 && control_us < 100000, "kControl not behind kLong");
+  Check(default_us >= 0 && default_us < 100000, "kDefault not behind kLong");
+  Check(ran == 100 && dispatcher.GetPending(WsLane::kControl) == 0, "kControl drained");
+
+  bool in_order = true;
+  for (int i = 0; i < (int)order.size(); i++) in_order = in_order && order[i] == i;
+  Check(in_order, "order kept in a lane");
+
+  while (!long_done) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  dispatcher.Stop();
+  run_t.join();
+  Check(true, "stop returns Run");
+
+  return failed;
+}
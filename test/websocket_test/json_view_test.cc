@@ -0,0 +1,131 @@
+// JsonDoc / JsonView: parse and accessors against jsoncpp, then parse time and allocations per ingress message
+// usage: lra_json_view_test [iterations]
+
+#include <json/json.h>
+#include <websocket/json_view.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "common/check.h"
+
+using lra::websocket::JsonDoc;
+using lra::websocket::JsonView;
+using lra::test::Check;
+using lra::test::failed;
+
+static std::atomic<uint64_t> allocs{0};
+
+void* operator new(size_t n) {
+  allocs.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+static std::string RegAllUpdate() {
+  std::string s = R"({"type":"regAllUpdate","uuid":"3f2c1a9e-0000-4000-8000-000000000001","data":{"drv":{)";
+  for (char axis : {'x', 'y', 'z'}) {
+    s += std::string("\"") + axis + "\":[";
+    for (int i = 0; i < 35; i++) s += std::to_string((i * 7 + axis) & 0xff) + (i < 34 ? "," : "");
+    s += axis == 'z' ? "]" : "],";
+  }
+  s += R"(},"acc":[)";
+  for (int i = 0; i < 16; i++) s += std::to_string(i * 3) + (i < 15 ? "," : "");
+  s += "]}}";
+  return s;
+}
+
+template <class F>
+static void Bench(const char* name, const std::string& msg, int iters, F&& parse) {
+  const uint64_t a0 = allocs.load();
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < iters; i++) parse(msg);
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / iters;
+  printf("  %-22s %8.0f ns/msg %8.1f allocs/msg\n", name, ns, (double)(allocs.load() - a0) / iters);
+}
+
+int main(int argc, char** argv) {
+  const int iters = (argc > 1) ? atoi(argv[1]) : 20000;
+
+  const std::string cmd = R"({"type":"drvCmdUpdate","data":{"x":127,"y":64,"z":1}})";
+  const std::string reg = RegAllUpdate();
+  const std::string rt =
+      R"({"type":"dataRTKeepRequire","data":{"format":"binary","drv":false,"decimation":4,"policy":"decimate"}})";
+  const std::string esc = R"({"type":"moduleInfoRequire","uuid":"a\"b\\cé😀","n":-1.5e2,"t":true,"z":null})";
+
+  JsonDoc doc;
+
+  /* semantics, same reads as the handlers */
+  Check(doc.Parse(cmd) && doc.Root()["type"].asStringView() == "drvCmdUpdate", "type field");
+  Check(doc.Root()["data"]["x"].asUInt() == 127 && doc.Root()["data"]["z"].asUInt() == 1, "drvCmdUpdate fields");
+  Check(doc.Root()["data"]["w"].isNull() && doc.Root()["data"]["w"].asUInt() == 0 && !doc.Root()["nope"]["x"].exists(),
+        "missing member is null, jsoncpp defaults");
+
+  Check(doc.Parse(rt), "dataRTKeepRequire parse");
+  JsonView req = doc.Root()["data"];
+  Check(req["format"].asString() == "binary" && !req["drv"].asBool(true) && req["acc"].asBool(true) &&
+            req["decimation"].asUInt(1) == 4 && req["policy"].asStringView() == "decimate",
+        "dataRTKeepRequire fields and defaults");
+
+  Json::Value dom;
+  Json::Reader().parse(esc, dom);
+  Check(doc.Parse(esc) && doc.Root()["uuid"].asString() == dom["uuid"].asString(), "string unescape as jsoncpp");
+  Check(doc.Root()["n"].asDouble() == -150.0 && doc.Root()["n"].asInt() == -150 && doc.Root()["t"].asBool() &&
+            doc.Root()["z"].isNull() && doc.Root()["z"].exists(),
+        "number / bool / null");
+
+  Check(doc.Parse(reg), "regAllUpdate parse");
+  Json::Reader().parse(reg, dom);
+  bool same = true;
+  for (const char* axis : {"x", "y", "z"}) {
+    std::array<uint8_t, 64> buf;
+    auto v = doc.Root()["data"]["drv"][axis].asU8(buf);
+    same = same && v.size() == dom["data"]["drv"][axis].size();
+    for (size_t i = 0; same && i < v.size(); i++) same = v[i] == dom["data"]["drv"][axis][(int)i].asUInt();
+  }
+  std::array<uint8_t, 8> small;
+  Check(same && doc.Root()["data"]["acc"].size() == 16, "regAllUpdate arrays as jsoncpp");
+  Check(doc.Root()["data"]["acc"].asU8(small).size() == 8 && doc.Root()["data"]["acc"][15].asUInt() == 45,
+        "asU8 clipped to the span, element access");
+
+  bool refused = true;
+  for (const char* bad : {"", "{", "{\"a\":}", "{\"a\" 1}", "[1,]", "{\"a\":1,}", "[1 2]", "{\"a\":tru}", "{} {}",
+                          "\"ab", "{\"a\":1]", "[\"\x01\"]", "{\"a\":-}", "{1:2}"}) {
+    refused = refused && !doc.Parse(bad) && !doc.Root().exists();
+  }
+  Check(refused, "malformed input refused");
+  Check(doc.Parse(" [ [], {}, [[1]], {\"a\":{\"b\":[true]}} ] ") && doc.Root().size() == 4 &&
+            doc.Root()[3]["a"]["b"][0].asBool() && doc.Root()[2][0][0].asInt() == 1,
+        "nested / empty containers");
+
+  /* parse time and allocations, the DOM path is what WebsocketServer::onMessage did */
+  for (auto& [name, msg] : {std::pair{"drvCmdUpdate", cmd}, std::pair{"regAllUpdate", reg}}) {
+    printf("%s (%zu B)\n", name, msg.size());
+    Bench("jsoncpp Reader", msg, iters, [](const std::string& m) {
+      Json::Value root;
+      Json::Reader reader;
+      reader.parse(m, root);
+    });
+    Bench("jsoncpp CharReader", msg, iters, [](const std::string& m) {
+      static std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+      Json::Value root;
+      reader->parse(m.data(), m.data() + m.size(), &root, nullptr);
+    });
+    Bench("JsonDoc", msg, iters, [&doc](const std::string& m) { doc.Parse(m); });
+    Bench("JsonDoc + fields", msg, iters, [&doc](const std::string& m) {
+      doc.Parse(m);
+      std::array<uint8_t, 64> buf;
+      volatile size_t n = doc.Root()["data"]["drv"]["z"].asU8(buf).size() + doc.Root()["data"]["x"].asUInt();
+      (void)n;
+    });
+  }
+
+  return failed;
+}
@@ -0,0 +1,179 @@
+// JsonWriter / TimestampCache: output against jsoncpp and fmt, then write time and allocations per outbound message
+// usage: lra_json_writer_test [iterations]
+
+#include <json/json.h>
+#include <spdlog/common.h>
+#include <spdlog/fmt/chrono.h>
+#include <websocket/json_view.h>
+#include <websocket/json_writer.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "common/check.h"
+
+using lra::websocket::JsonDoc;
+using lra::websocket::JsonWriter;
+using lra::websocket::TimestampCache;
+using lra::test::Check;
+using lra::test::failed;
+
+static std::atomic<uint64_t> allocs{0};
+
+void* operator new(size_t n) {
+  allocs.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+struct Sample {
+  float t, x, y, z;
+};
+
+constexpr const char* kUuid = "3f2c1a9e-0000-4000-8000-000000000001";
+
+// same shape as the control loop's dataRTKeepRequireResponse
+static std::string_view WriteRt(JsonWriter& w, std::chrono::system_clock::time_point now,
+                                const std::vector<Sample>& acc) {
+  w.BeginMessage("dataRTKeepRequireResponse", kUuid, now);
+  w.Key("drv").BeginObject().Member("t", 1234567.0);
+  for (const char* axis : {"x", "y", "z"})
+    w.Key(axis).BeginObject().Member("rtp", (uint8_t)127).Member("freq", 170.5f).EndObject();
+  w.EndObject();
+  w.Key("acc").BeginArray();
+  for (auto& s : acc) w.BeginObject().Member("t", s.t).Member("x", s.x).Member("y", s.y).Member("z", s.z).EndObject();
+  w.EndArray();
+  return w.EndMessage();
+}
+
+static std::string JsoncppRt(std::chrono::system_clock::time_point now, const std::vector<Sample>& acc) {
+  Json::Value payload, data, drv, arr, drv_1axis;
+  drv["t"] = 1234567.0;
+  drv_1axis["rtp"] = 127;
+  drv_1axis["freq"] = 170.5f;
+  drv["x"] = drv["y"] = drv["z"] = drv_1axis;
+  for (auto& s : acc) {
+    Json::Value v;
+    v["t"] = s.t;
+    v["x"] = s.x;
+    v["y"] = s.y;
+    v["z"] = s.z;
+    arr.append(v);
+  }
+  data["drv"] = drv;
+  data["acc"] = arr;
+  payload["uuid"] = kUuid;
+  payload["timestamp"] = spdlog::fmt_lib::format("{:%Y-%m-%d %H:%M:}{:%S}", now, now.time_since_epoch());
+  payload["data"] = data;
+  payload["type"] = "dataRTKeepRequireResponse";
+
+  Json::StreamWriterBuilder wbuilder;
+  wbuilder["indentation"] = "";
+  return Json::writeString(wbuilder, payload);
+}
+
+// floats are written shortest as float, compare numbers at float precision
+static bool Same(const Json::Value& a, const Json::Value& b) {
+  if (a.isNumeric() && b.isNumeric()) return (float)a.asDouble() == (float)b.asDouble();
+  if (a.type() != b.type() || a.size() != b.size()) return false;
+  if (a.isObject()) {
+    for (auto& name : a.getMemberNames())
+      if (!b.isMember(name) || !Same(a[name], b[name])) return false;
+    return true;
+  }
+  if (a.isArray()) {
+    for (Json::ArrayIndex i = 0; i < a.size(); i++)
+      if (!Same(a[i], b[i])) return false;
+    return true;
+  }
+  return a == b;
+}
+
+template <class F>
+static void Bench(const char* name, int iters, F&& write) {
+  const uint64_t a0 = allocs.load();
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < iters; i++) write();
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / iters;
+  printf("  %-22s %8.0f ns/msg %8.1f allocs/msg\n", name, ns, (double)(allocs.load() - a0) / iters);
+}
+
+int main(int argc, char** argv) {
+  const int iters = (argc > 1) ? atoi(argv[1]) : 5000;
+
+  std::vector<Sample> acc;
+  for (int i = 0; i < 40; i++) acc.push_back({i * 250000.f, 0.01f * i, -0.5f + i * 1e-3f, 9.81f});
+
+  /* timestamp, same text as the fmt format string, also across minutes */
+  TimestampCache ts;
+  bool same = true;
+  auto t = std::chrono::system_clock::now();
+  for (int i = 0; i < 400; i++, t += std::chrono::milliseconds(997)) {
+    std::string out;
+    ts.Append(out, t);
+    same = same && out == spdlog::fmt_lib::format("{:%Y-%m-%d %H:%M:}{:%S}", t, t.time_since_epoch());
+  }
+  Check(same, "timestamp matches fmt");
+
+  /* same document as jsoncpp */
+  JsonWriter w;
+  const auto now = std::chrono::system_clock::now();
+  Json::Value ours, ref;
+  Json::Reader reader;
+  reader.parse(std::string(WriteRt(w, now, acc)), ours);
+  reader.parse(JsoncppRt(now, acc), ref);
+  Check(Same(ours, ref), "rt message equals the jsoncpp one");
+
+  /* escapes, nested containers, non finite numbers */
+  w.BeginMessage("t", "a\"b\\c\n\x01é", now);
+  w.Member("v", std::vector<uint8_t>{1, 2, 255}).Member("e", std::vector<uint8_t>{}).Member("n", NAN);
+  w.Key("o").BeginObject().Key("a").BeginArray().BeginObject().EndObject().Value(-3).EndArray().EndObject();
+  JsonDoc doc;
+  Check(doc.Parse(w.EndMessage()) && doc.Root()["uuid"].asString() == "a\"b\\c\n\x01é" &&
+            doc.Root()["data"]["v"][2].asUInt() == 255 && doc.Root()["data"]["e"].size() == 0 &&
+            doc.Root()["data"]["n"].isNull() && doc.Root()["data"]["o"]["a"][1].asInt() == -3 &&
+            doc.Root()["type"].asStringView() == "t",
+        "escapes and nesting parse back");
+
+  /* envelope rebuilt on a new uuid */
+  w.BeginMessage("dataRTKeepRequireResponse", "other", now);
+  Check(doc.Parse(w.EndMessage()) && doc.Root()["uuid"].asStringView() == "other", "uuid change");
+
+  /* steady state */
+  WriteRt(w, now, acc);
+  const uint64_t a0 = allocs.load();
+  for (int i = 0; i < 100; i++) WriteRt(w, std::chrono::system_clock::now(), acc);
+  Check(allocs.load() == a0, "no allocation in steady state");
+
+  printf("dataRTKeepRequireResponse, %zu samples (%zu B)\n", acc.size(), WriteRt(w, now, acc).size());
+  Bench("jsoncpp DOM + write", iters, [&] { JsoncppRt(std::chrono::system_clock::now(), acc); });
+  Bench("JsonWriter", iters, [&] { WriteRt(w, std::chrono::system_clock::now(), acc); });
+
+  printf("drvCmdUpdateRecv\n");
+  Bench("jsoncpp DOM + write", iters, [&] {
+    Json::Value info, data;
+    data["msg"] = "ok";
+    auto n = std::chrono::system_clock::now();
+    info["uuid"] = kUuid;
+    info["timestamp"] = spdlog::fmt_lib::format("{:%Y-%m-%d %H:%M:}{:%S}", n, n.time_since_epoch());
+    info["data"] = data;
+    info["type"] = "drvCmdUpdateRecv";
+    Json::StreamWriterBuilder wbuilder;
+    wbuilder["indentation"] = "";
+    Json::writeString(wbuilder, info);
+  });
+  Bench("JsonWriter", iters, [&] {
+    w.BeginMessage("drvCmdUpdateRecv", kUuid, std::chrono::system_clock::now()).Member("msg", "ok");
+    w.EndMessage();
+  });
+
+  return failed;
+}
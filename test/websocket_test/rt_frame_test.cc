@@ -0,0 +1,123 @@
+// rt frame: encode / decode roundtrip, size and encode time against the JSON dataRTKeepRequireResponse
+// usage: lra_rt_frame_test [acc samples per frame] [frames]
+
+#include <json/json.h>
+#include <websocket/rt_frame.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "common/check.h"
+
+using lra::websocket::DecodeRtFrame;
+using lra::websocket::RtDrv;
+using lra::websocket::RtFrameEncoder;
+using lra::websocket::RtFrameView;
+using lra::test::Check;
+using lra::test::failed;
+
+// same layout as Adxl355::Acc3
+struct Acc3 {
+  struct {
+    float x, y, z;
+  } data;
+  int64_t time;
+};
+
+// mirrors the JSON branch of the control loop
+static std::string ToJson(double t0, const RtDrv& drv, std::span<const Acc3> acc) {
+  Json::Value payload, data, drv_json, acc_json, drv_1axis;
+  drv_json["t"] = t0;
+  const char* axis[3] = {"x", "y", "z"};
+  for (int i = 0; i < 3; i++) {
+    drv_1axis["rtp"] = drv.rtp_[i];
+    drv_1axis["freq"] = drv.freq_[i];
+    drv_json[axis[i]] = drv_1axis;
+  }
+  for (auto& a : acc) {
+    Json::Value v;
+    v["t"] = a.time;
+    v["x"] = a.data.x;
+    v["y"] = a.data.y;
+    v["z"] = a.data.z;
+    acc_json.append(v);
+  }
+  data["drv"] = drv_json;
+  data["acc"] = acc_json;
+  payload["uuid"] = "00000000-0000-0000-0000-000000000000";
+  payload["timestamp"] = "2024-01-01 00:00:00.000000000";
+  payload["data"] = data;
+
+  Json::Value msg;
+  msg["type"] = "dataRTKeepRequireResponse";
+  msg["args"] = payload;
+  Json::StreamWriterBuilder builder;
+  return Json::writeString(builder, msg);
+}
+
+int main(int argc, char** argv) {
+  const size_t n = (argc > 1) ? atoi(argv[1]) : 40;  // 4 kHz ODR, 10 ms loop
+  const int frames = (argc > 2) ? atoi(argv[2]) : 2000;
+
+  const int64_t t_newest = 12ll * 3600 * 1000000000;  // ns since start, 12 h in
+  const double t0 = t_newest;
+  RtDrv drv;
+  drv.rtp_[0] = 0x7f, drv.rtp_[1] = 0x20, drv.rtp_[2] = 0xff;
+  drv.freq_[0] = 170.5f, drv.freq_[1] = 171.25f, drv.freq_[2] = 169.0f;
+
+  std::vector<Acc3> acc(n);
+  for (size_t k = 0; k < n; k++) {
+    acc[k].time = t_newest - static_cast<int64_t>(n - 1 - k) * 250000;
+    acc[k].data = {0.01f * k, -0.02f * k, 1.0f + 0.001f * k};
+  }
+
+  RtFrameEncoder encoder;
+  std::string frame(encoder.Encode(7, t0, &drv, std::span<const Acc3>(acc)));
+
+  RtFrameView view;
+  Check(DecodeRtFrame(frame, view), "decode");
+  Check(view.seq_ == 7 && view.t0_ == t0 && view.acc_n_ == n && view.has_drv_, "header");
+  Check(view.drv_.rtp_[0] == 0x7f && view.drv_.rtp_[2] == 0xff && view.drv_.freq_[1] == 171.25f, "drv block");
+
+  bool acc_ok = view.acc_n_ == n;
+  for (size_t k = 0; acc_ok && k < n; k++) {
+    acc_ok = t0 + view.acc_t_[k] == acc[k].time &&
+             view.acc_x_[k] == acc[k].data.x && view.acc_y_[k] == acc[k].data.y && view.acc_z_[k] == acc[k].data.z;
+  }
+  Check(acc_ok, "acc block");
+
+  Check(!DecodeRtFrame(std::string_view(frame).substr(0, frame.size() - 1), view), "truncated frame refused");
+  std::string bad = frame;
+  bad[0] ^= 0xff;
+  Check(!DecodeRtFrame(bad, view), "foreign magic refused");
+
+  std::string empty(encoder.Encode(8, t0, static_cast<const RtDrv*>(nullptr), std::span<const Acc3>()));
+  Check(DecodeRtFrame(empty, view) && view.seq_ == 8 && !view.has_drv_ && view.acc_n_ == 0, "header only frame");
+
+  // size and time per frame
+  using clock = std::chrono::steady_clock;
+  size_t sink = 0;
+
+  auto t_bin = clock::now();
+  for (int i = 0; i < frames; i++) sink += encoder.Encode(i, t0, &drv, std::span<const Acc3>(acc)).size();
+  double bin_us = std::chrono::duration<double, std::micro>(clock::now() - t_bin).count() / frames;
+
+  std::string json;
+  auto t_json = clock::now();
+  for (int i = 0; i < frames; i++) {
+    json = ToJson(t0, drv, acc);
+    sink += json.size();
+  }
+  double json_us = std::chrono::duration<double, std::micro>(clock::now() - t_json).count() / frames;
+
+  printf("%zu samples: binary %zu B %.2f us, json %zu B %.2f us (x%.1f size, x%.1f time) [%zu]\n", n, frame.size(),
+         bin_us, json.size(), json_us, (double)json.size() / frame.size(), json_us / bin_us, sink);
+  Check(frame.size() * 4 < json.size(), "binary at least 4x smaller");
+
+  return failed;
+}